@@ -0,0 +1,46 @@
+"""
+Tests for the zig-3270 Python bindings.
+
+Needs the shared library (``zig build``, or ZIG3270_LIB_PATH); the tests
+are skipped when it cannot be found.
+
+    python -m unittest bindings/python/test_zig3270.py
+"""
+
+import sys
+import unittest
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).parent))
+
+try:
+    import zig3270
+except (RuntimeError, OSError) as exc:  # library not built
+    zig3270 = None
+    _skip_reason = str(exc)
+else:
+    _skip_reason = ""
+
+
+@unittest.skipIf(zig3270 is None, _skip_reason)
+class ScreenToStringTest(unittest.TestCase):
+    def test_round_trip(self):
+        screen = zig3270.Screen()
+        screen.write(2, 0, "HELLO")
+
+        text = screen.to_string()
+        lines = text.split("\n")
+
+        self.assertEqual(len(text), zig3270.Screen.ROWS * (zig3270.Screen.COLS + 1))
+        self.assertTrue(lines[2].startswith("HELLO"))
+        self.assertEqual(len(lines[0]), zig3270.Screen.COLS)
+
+    def test_repeated_calls_free_each_string(self):
+        screen = zig3270.Screen()
+        screen.write(0, 0, "X")
+        for _ in range(1000):
+            self.assertEqual(screen.to_string()[0], "X")
+
+
+if __name__ == "__main__":
+    unittest.main()
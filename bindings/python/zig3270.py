@@ -11,10 +11,22 @@ Example:
     >>> print(screen.get_text(0, 0, 10))
     >>> client.disconnect()
 
+Byte-oriented calls accept any object supporting the buffer protocol
+(bytes, bytearray, memoryview, array, mmap, ...) and pass a pointer to
+its memory straight to the library; the ``*_into`` variants write into a
+caller-owned writable buffer. ``Screen.buffer()`` exposes the screen as a
+read-only memoryview over the library's own storage.
+
+Every library call goes through ``ctypes.CDLL``, which releases the GIL
+for the duration of the call, so blocking client calls (``connect``,
+``read_response``) on separate clients can run on separate threads. A
+single client or screen must not be used from two threads at once.
+
 Version: 0.11.1-beta
 """
 
 import ctypes
+import functools
 import os
 import sys
 from pathlib import Path
@@ -90,6 +102,7 @@ class ErrorCode(IntEnum):
     INVALID_STATE = 5
     TIMEOUT = 6
     FIELD_NOT_FOUND = 7
+    WOULD_BLOCK = 8
 
 
 class TN3270Error(Exception):
@@ -116,9 +129,14 @@ class TimeoutError(TN3270Error):
 
 
 def _check_error(code: int, context: str = "") -> None:
-    """Check error code and raise appropriate exception."""
-    if code == ErrorCode.SUCCESS:
+    """Check error code and raise appropriate exception.
+
+    Failures are returned by the library as negated error codes; any
+    non-negative value (success or a byte count) passes through.
+    """
+    if code >= 0:
         return
+    code = -code
     
     error_messages = {
         ErrorCode.INVALID_ARG: "Invalid argument",
@@ -128,6 +146,7 @@ def _check_error(code: int, context: str = "") -> None:
         ErrorCode.INVALID_STATE: "Invalid state",
         ErrorCode.TIMEOUT: "Timeout",
         ErrorCode.FIELD_NOT_FOUND: "Field not found",
+        ErrorCode.WOULD_BLOCK: "Operation would block",
     }
     
     message = error_messages.get(code, f"Unknown error {code}")
@@ -168,12 +187,87 @@ class CAddress(ctypes.Structure):
         ("col", ctypes.c_uint8),
     ]
 
+class CBuffer(ctypes.Structure):
+    """C zig3270_buffer_t."""
+    _fields_ = [
+        ("data", ctypes.POINTER(ctypes.c_uint8)),
+        ("len", ctypes.c_size_t),
+    ]
+
 class CFieldAttr(ctypes.Structure):
     """C zig3270_field_attr_t."""
     _fields_ = [
         ("value", ctypes.c_uint8),
     ]
 
+# ============================================================================
+# Zero-Copy Buffer Access
+# ============================================================================
+
+class _PyBuffer(ctypes.Structure):
+    """CPython Py_buffer."""
+    _fields_ = [
+        ("buf", ctypes.c_void_p),
+        ("obj", ctypes.c_void_p),
+        ("len", ctypes.c_ssize_t),
+        ("itemsize", ctypes.c_ssize_t),
+        ("readonly", ctypes.c_int),
+        ("ndim", ctypes.c_int),
+        ("format", ctypes.c_char_p),
+        ("shape", ctypes.POINTER(ctypes.c_ssize_t)),
+        ("strides", ctypes.POINTER(ctypes.c_ssize_t)),
+        ("suboffsets", ctypes.POINTER(ctypes.c_ssize_t)),
+        ("internal", ctypes.c_void_p),
+    ]
+
+_PyBUF_SIMPLE = 0
+_PyBUF_WRITABLE = 0x0001
+
+# pythonapi holds the GIL and raises the Python error a call sets
+ctypes.pythonapi.PyObject_GetBuffer.argtypes = [
+    ctypes.py_object, ctypes.POINTER(_PyBuffer), ctypes.c_int
+]
+ctypes.pythonapi.PyObject_GetBuffer.restype = ctypes.c_int
+ctypes.pythonapi.PyBuffer_Release.argtypes = [ctypes.POINTER(_PyBuffer)]
+ctypes.pythonapi.PyBuffer_Release.restype = None
+
+
+class _Pinned:
+    """Export a buffer-protocol object as ``(address, length)``.
+
+    While pinned the exporter cannot resize or free the memory, so the
+    address stays valid across a call that releases the GIL. Raises
+    TypeError for objects without the buffer protocol and BufferError for
+    non-contiguous buffers (or read-only ones when ``writable``).
+    """
+    __slots__ = ("_obj", "_flags", "_view")
+
+    def __init__(self, obj, writable: bool = False):
+        self._obj = obj
+        self._flags = _PyBUF_WRITABLE if writable else _PyBUF_SIMPLE
+        self._view = _PyBuffer()
+
+    def __enter__(self) -> Tuple[int, int]:
+        ctypes.pythonapi.PyObject_GetBuffer(self._obj, ctypes.byref(self._view), self._flags)
+        return self._view.buf or 0, self._view.len
+
+    def __exit__(self, *exc) -> bool:
+        ctypes.pythonapi.PyBuffer_Release(ctypes.byref(self._view))
+        return False
+
+
+@functools.lru_cache(maxsize=None)
+def _plane_type(length: int):
+    """Array type over borrowed library memory that can hold its owner."""
+    class _Plane(ctypes.c_uint8 * length):
+        pass
+    return _Plane
+
+
+def _as_bytes_like(data):
+    """Encode text as ASCII; pass buffer-protocol objects through."""
+    return data.encode('ascii') if isinstance(data, str) else data
+
 # ============================================================================
 # C Function Bindings
 # ============================================================================
@@ -186,14 +280,14 @@ _lib.zig3270_ebcdic_encode_byte.argtypes = [ctypes.c_uint8]
 _lib.zig3270_ebcdic_encode_byte.restype = ctypes.c_int32
 
 _lib.zig3270_ebcdic_decode.argtypes = [
-    ctypes.c_char_p, ctypes.c_size_t,
-    ctypes.POINTER(ctypes.c_uint8), ctypes.c_size_t
+    ctypes.c_void_p, ctypes.c_size_t,
+    ctypes.c_void_p, ctypes.c_size_t
 ]
 _lib.zig3270_ebcdic_decode.restype = ctypes.c_int32
 
 _lib.zig3270_ebcdic_encode.argtypes = [
-    ctypes.c_char_p, ctypes.c_size_t,
-    ctypes.POINTER(ctypes.c_uint8), ctypes.c_size_t
+    ctypes.c_void_p, ctypes.c_size_t,
+    ctypes.c_void_p, ctypes.c_size_t
 ]
 _lib.zig3270_ebcdic_encode.restype = ctypes.c_int32
 
@@ -204,12 +298,14 @@ _lib.zig3270_malloc.restype = ctypes.POINTER(ctypes.c_uint8)
 _lib.zig3270_free.argtypes = [ctypes.POINTER(ctypes.c_uint8), ctypes.c_size_t]
 _lib.zig3270_free.restype = None
 
-_lib.zig3270_string_free.argtypes = [ctypes.c_char_p]
+# Takes the raw pointer returned by the library; a c_char_p argument would
+# pass a copy owned by Python
+_lib.zig3270_string_free.argtypes = [ctypes.c_void_p]
 _lib.zig3270_string_free.restype = None
 
 # Client functions
 _lib.zig3270_client_new.argtypes = [ctypes.c_char_p, ctypes.c_uint16]
-_lib.zig3270_client_new.restype = ctypes.c_int32
+_lib.zig3270_client_new.restype = ctypes.POINTER(CClient)
 
 _lib.zig3270_client_free.argtypes = [ctypes.POINTER(CClient)]
 _lib.zig3270_client_free.restype = None
@@ -222,22 +318,42 @@ _lib.zig3270_client_disconnect.restype = ctypes.c_int32
 
 _lib.zig3270_client_send_command.argtypes = [
     ctypes.POINTER(CClient),
-    ctypes.c_char_p,
+    ctypes.c_void_p,
     ctypes.c_size_t
 ]
 _lib.zig3270_client_send_command.restype = ctypes.c_int32
 
 _lib.zig3270_client_read_response.argtypes = [
     ctypes.POINTER(CClient),
-    ctypes.POINTER(ctypes.c_uint8),
+    ctypes.c_void_p,
     ctypes.c_size_t,
     ctypes.c_uint32
 ]
 _lib.zig3270_client_read_response.restype = ctypes.c_int32
 
+_lib.zig3270_client_get_fd.argtypes = [ctypes.POINTER(CClient)]
+_lib.zig3270_client_get_fd.restype = ctypes.c_int32
+
+_lib.zig3270_client_set_nonblocking.argtypes = [ctypes.POINTER(CClient), ctypes.c_bool]
+_lib.zig3270_client_set_nonblocking.restype = ctypes.c_int32
+
+_lib.zig3270_client_read_into.argtypes = [
+    ctypes.POINTER(CClient),
+    ctypes.c_void_p,
+    ctypes.c_size_t
+]
+_lib.zig3270_client_read_into.restype = ctypes.c_int32
+
+_lib.zig3270_client_send_batch.argtypes = [
+    ctypes.POINTER(CClient),
+    ctypes.POINTER(CBuffer),
+    ctypes.c_size_t
+]
+_lib.zig3270_client_send_batch.restype = ctypes.c_int32
+
 # Screen functions
 _lib.zig3270_screen_new.argtypes = []
-_lib.zig3270_screen_new.restype = ctypes.c_int32
+_lib.zig3270_screen_new.restype = ctypes.POINTER(CScreen)
 
 _lib.zig3270_screen_free.argtypes = [ctypes.POINTER(CScreen)]
 _lib.zig3270_screen_free.restype = None
@@ -248,26 +364,32 @@ _lib.zig3270_screen_clear.restype = ctypes.c_int32
 _lib.zig3270_screen_write.argtypes = [
     ctypes.POINTER(CScreen),
     ctypes.c_uint8, ctypes.c_uint8,
-    ctypes.c_char_p, ctypes.c_size_t
+    ctypes.c_void_p, ctypes.c_size_t
 ]
 _lib.zig3270_screen_write.restype = ctypes.c_int32
 
 _lib.zig3270_screen_read.argtypes = [
     ctypes.POINTER(CScreen),
     ctypes.c_uint8, ctypes.c_uint8,
-    ctypes.POINTER(ctypes.c_uint8), ctypes.c_size_t
+    ctypes.c_void_p, ctypes.c_size_t
 ]
 _lib.zig3270_screen_read.restype = ctypes.c_int32
 
 _lib.zig3270_screen_to_string.argtypes = [ctypes.POINTER(CScreen)]
-_lib.zig3270_screen_to_string.restype = ctypes.c_char_p
+_lib.zig3270_screen_to_string.restype = ctypes.c_void_p
+
+_lib.zig3270_screen_buffer.argtypes = [ctypes.POINTER(CScreen), ctypes.POINTER(CBuffer)]
+_lib.zig3270_screen_buffer.restype = ctypes.c_int32
+
+_lib.zig3270_screen_generation.argtypes = [ctypes.POINTER(CScreen)]
+_lib.zig3270_screen_generation.restype = ctypes.c_uint32
 
 _lib.zig3270_screen_get_cursor.argtypes = [ctypes.POINTER(CScreen), ctypes.POINTER(CAddress)]
 _lib.zig3270_screen_get_cursor.restype = ctypes.c_int32
 
 # Field functions
 _lib.zig3270_fields_new.argtypes = []
-_lib.zig3270_fields_new.restype = ctypes.c_int32
+_lib.zig3270_fields_new.restype = ctypes.POINTER(CFieldManager)
 
 _lib.zig3270_fields_free.argtypes = [ctypes.POINTER(CFieldManager)]
 _lib.zig3270_fields_free.restype = None
@@ -350,7 +472,9 @@ class Screen:
     COLS = 80
     
     def __init__(self):
-        self._screen = None
+        self._screen = _lib.zig3270_screen_new()
+        if not self._screen:
+            raise TN3270Error(ErrorCode.OUT_OF_MEMORY, "Failed to create screen")
     
     def clear(self) -> None:
         """Clear the screen."""
@@ -359,8 +483,8 @@ class Screen:
         code = _lib.zig3270_screen_clear(self._screen)
         _check_error(code, "Failed to clear screen")
     
-    def write(self, row: int, col: int, text: str) -> None:
-        """Write text to screen at position."""
+    def write(self, row: int, col: int, text) -> None:
+        """Write text (str, or any bytes-like object) to screen at position."""
         if self._screen is None:
             raise ValueError("Screen not initialized")
         if not 0 <= row < self.ROWS:
@@ -368,11 +492,8 @@ class Screen:
         if not 0 <= col < self.COLS:
             raise ValueError(f"Col {col} out of range [0, {self.COLS})")
         
-        text_bytes = text.encode('ascii')
-        code = _lib.zig3270_screen_write(
-            self._screen, row, col,
-            text_bytes, len(text_bytes)
-        )
+        with _Pinned(_as_bytes_like(text)) as (address, length):
+            code = _lib.zig3270_screen_write(self._screen, row, col, address, length)
         _check_error(code, f"Failed to write at ({row}, {col})")
     
     def read(self, row: int, col: int, length: int) -> str:
@@ -384,13 +505,37 @@ class Screen:
         if not 0 <= col < self.COLS:
             raise ValueError(f"Col {col} out of range [0, {self.COLS})")
         
-        buf = ctypes.create_string_buffer(length)
-        code = _lib.zig3270_screen_read(
-            self._screen, row, col,
-            buf, length
-        )
-        _check_error(code, f"Failed to read from ({row}, {col})")
-        return buf.raw[:code].decode('ascii', errors='replace')
+        start = row * self.COLS + col
+        return bytes(self.buffer()[start:start + length]).decode('ascii', errors='replace')
+
+    def buffer(self) -> memoryview:
+        """Read-only view of the whole character plane (ROWS * COLS bytes).
+
+        No data is copied: the view aliases the library's storage and shows
+        later writes. It keeps the screen alive while referenced.
+        """
+        if self._screen is None:
+            raise ValueError("Screen not initialized")
+        desc = CBuffer()
+        code = _lib.zig3270_screen_buffer(self._screen, ctypes.byref(desc))
+        _check_error(code, "Failed to get screen buffer")
+
+        plane = _plane_type(desc.len).from_address(ctypes.cast(desc.data, ctypes.c_void_p).value)
+        plane._owner = self
+        return memoryview(plane).cast('B').toreadonly()
+
+    def row(self, row: int) -> memoryview:
+        """Read-only view of one row."""
+        if not 0 <= row < self.ROWS:
+            raise ValueError(f"Row {row} out of range [0, {self.ROWS})")
+        return self.buffer()[row * self.COLS:(row + 1) * self.COLS]
+
+    @property
+    def generation(self) -> int:
+        """Change counter; equal values mean the screen was not written."""
+        if self._screen is None:
+            raise ValueError("Screen not initialized")
+        return _lib.zig3270_screen_generation(self._screen)
     
     def to_string(self) -> str:
         """Get entire screen as string."""
@@ -399,9 +544,10 @@ class Screen:
         ptr = _lib.zig3270_screen_to_string(self._screen)
         if not ptr:
             raise RuntimeError("Failed to get screen as string")
-        result = ctypes.c_char_p(ptr).value.decode('ascii', errors='replace')
-        _lib.zig3270_string_free(ptr)
-        return result
+        try:
+            return ctypes.string_at(ptr).decode('ascii', errors='replace')
+        finally:
+            _lib.zig3270_string_free(ptr)
     
     def get_cursor(self) -> Address:
         """Get current cursor position."""
@@ -496,11 +642,15 @@ class TN3270Client:
         if self._connected:
             raise ValueError("Already connected")
         
-        code = _lib.zig3270_client_new(
-            self.host.encode('ascii'),
-            self.port
-        )
-        _check_error(code, f"Failed to create client for {self.host}:{self.port}")
+        if self._client is None:
+            client = _lib.zig3270_client_new(
+                self.host.encode('ascii'),
+                self.port
+            )
+            if not client:
+                raise TN3270Error(ErrorCode.OUT_OF_MEMORY,
+                                  f"Failed to create client for {self.host}:{self.port}")
+            self._client = client
         
         code = _lib.zig3270_client_connect(self._client)
         _check_error(code, "Failed to connect")
@@ -519,20 +669,17 @@ class TN3270Client:
         self._connected = False
         logger.info(f"Disconnected from {self.host}:{self.port}")
     
-    def send_command(self, command: bytes) -> None:
+    def send_command(self, command) -> None:
         """Send a raw command to the mainframe.
         
         Args:
-            command: Raw command bytes
+            command: Raw command bytes (any bytes-like object; not copied)
         """
         if not self._connected:
             raise ValueError("Not connected")
         
-        code = _lib.zig3270_client_send_command(
-            self._client,
-            command,
-            len(command)
-        )
+        with _Pinned(command) as (address, length):
+            code = _lib.zig3270_client_send_command(self._client, address, length)
         _check_error(code, "Failed to send command")
     
     def read_response(self, timeout_ms: int = 5000) -> bytes:
@@ -547,16 +694,27 @@ class TN3270Client:
         if not self._connected:
             raise ValueError("Not connected")
         
-        buf = ctypes.create_string_buffer(4096)
-        code = _lib.zig3270_client_read_response(
-            self._client,
-            buf,
-            len(buf),
-            timeout_ms
-        )
-        _check_error(code, "Failed to read response")
+        buf = bytearray(4096)
+        count = self.read_response_into(buf, timeout_ms)
+        return bytes(memoryview(buf)[:count])
+
+    def read_response_into(self, buffer, timeout_ms: int = 5000) -> int:
+        """Read a response straight into a writable buffer.
         
-        return buf.raw[:code]
+        Args:
+            buffer: bytearray, writable memoryview or similar
+            timeout_ms: Read timeout in milliseconds (0 waits indefinitely)
+            
+        Returns:
+            Number of bytes written to the start of ``buffer``
+        """
+        if not self._connected:
+            raise ValueError("Not connected")
+        
+        with _Pinned(buffer, writable=True) as (address, length):
+            code = _lib.zig3270_client_read_response(self._client, address, length, timeout_ms)
+        _check_error(code, "Failed to read response")
+        return code
     
     def __repr__(self):
         status = "connected" if self._connected else "disconnected"
@@ -586,33 +744,46 @@ def get_protocol_version() -> str:
 # EBCDIC Encoding/Decoding (Convenience Functions)
 # ============================================================================
 
-def ebcdic_decode(data: bytes) -> str:
-    """Decode EBCDIC bytes to ASCII string."""
-    if not data:
-        return ""
+def ebcdic_decode_into(data, out) -> int:
+    """Decode EBCDIC from any bytes-like object into a writable buffer.
     
-    output = ctypes.create_string_buffer(len(data))
-    code = _lib.zig3270_ebcdic_decode(
-        data, len(data),
-        output, len(data)
-    )
+    Returns the number of ASCII bytes written to the start of ``out``.
+    """
+    with _Pinned(data) as (src, src_len), _Pinned(out, writable=True) as (dst, dst_len):
+        code = _lib.zig3270_ebcdic_decode(src, src_len, dst, dst_len)
     _check_error(code, "Failed to decode EBCDIC")
-    return output.raw[:code].decode('ascii', errors='replace')
+    return code
 
 
-def ebcdic_encode(text: str) -> bytes:
-    """Encode ASCII string to EBCDIC bytes."""
-    text_bytes = text.encode('ascii')
-    if not text_bytes:
-        return b""
+def ebcdic_encode_into(data, out) -> int:
+    """Encode ASCII (str or bytes-like) to EBCDIC into a writable buffer.
     
-    output = ctypes.create_string_buffer(len(text_bytes))
-    code = _lib.zig3270_ebcdic_encode(
-        text_bytes, len(text_bytes),
-        output, len(text_bytes)
-    )
+    Returns the number of EBCDIC bytes written to the start of ``out``.
+    """
+    with _Pinned(_as_bytes_like(data)) as (src, src_len), _Pinned(out, writable=True) as (dst, dst_len):
+        code = _lib.zig3270_ebcdic_encode(src, src_len, dst, dst_len)
     _check_error(code, "Failed to encode EBCDIC")
-    return output.raw[:code]
+    return code
+
+
+def ebcdic_decode(data) -> str:
+    """Decode EBCDIC bytes (any bytes-like object) to ASCII string."""
+    output = bytearray(memoryview(data).nbytes)
+    if not output:
+        return ""
+    count = ebcdic_decode_into(data, output)
+    return output[:count].decode('ascii', errors='replace')
+
+
+def ebcdic_encode(text) -> bytes:
+    """Encode ASCII string (or bytes-like object) to EBCDIC bytes."""
+    data = _as_bytes_like(text)
+    output = bytearray(memoryview(data).nbytes)
+    if not output:
+        return b""
+    count = ebcdic_encode_into(data, output)
+    del output[count:]
+    return bytes(output)
 
 
 if __name__ == "__main__":
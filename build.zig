@@ -112,6 +112,25 @@ pub fn build(b: *std.Build) void {
     const hex_viewer_step = b.step("hex-viewer", "Run hex viewer example");
     hex_viewer_step.dependOn(&run_hex_viewer.step);
 
+    // Replay benchmark, always optimized so timings mean something
+    const replay_bench_module = b.addModule("replay_bench", .{
+        .root_source_file = b.path("src/replay_bench.zig"),
+        .target = target,
+        .optimize = .ReleaseFast,
+    });
+
+    const replay_bench_exe = b.addExecutable(.{
+        .name = "replay-bench",
+        .root_module = replay_bench_module,
+    });
+
+    const run_replay_bench = b.addRunArtifact(replay_bench_exe);
+    if (b.args) |args| {
+        run_replay_bench.addArgs(args);
+    }
+    const bench_step = b.step("bench", "Replay captured sessions through the full pipeline");
+    bench_step.dependOn(&run_replay_bench.step);
+
     // Test step
     const test_module = b.addModule("test", .{
         .root_source_file = b.path("src/main.zig"),
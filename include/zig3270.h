@@ -34,8 +34,15 @@ typedef enum {
     ZIG3270_INVALID_STATE = 5,
     ZIG3270_TIMEOUT = 6,
     ZIG3270_FIELD_NOT_FOUND = 7,
+    ZIG3270_WOULD_BLOCK = 8,
 } zig3270_error_t;
 
+/*
+ * Functions returning int32_t report failure as the negated error code
+ * (e.g. -ZIG3270_TIMEOUT). Count-returning functions return the count
+ * (>= 0) on success.
+ */
+
 /* ========================================================================== */
 /* Opaque Types                                                             */
 /* ========================================================================== */
@@ -44,6 +51,7 @@ typedef struct zig3270_client zig3270_client_t;
 typedef struct zig3270_screen zig3270_screen_t;
 typedef struct zig3270_field_manager zig3270_field_manager_t;
 typedef struct zig3270_parser zig3270_parser_t;
+typedef struct zig3270_waiter zig3270_waiter_t;
 
 /* ========================================================================== */
 /* Type Definitions                                                         */
@@ -75,7 +83,7 @@ typedef struct {
  * TN3270 Command Code
  */
 typedef enum {
-    ZIG3270_CMD_WRITE_STRUCTURED_FIELD = 0x01,
+    ZIG3270_CMD_WRITE_STRUCTURED_FIELD = 0x11,
     ZIG3270_CMD_ERASE_WRITE = 0x05,
     ZIG3270_CMD_ERASE_WRITE_ALTERNATE = 0x0d,
     ZIG3270_CMD_WRITE = 0x01,
@@ -95,6 +103,14 @@ typedef struct {
     uint16_t offset;
 } zig3270_position_t;
 
+/**
+ * Caller-owned buffer descriptor for zig3270_client_send_batch()
+ */
+typedef struct {
+    const uint8_t* data;
+    size_t len;
+} zig3270_buffer_t;
+
 /* ========================================================================== */
 /* Memory Management                                                        */
 /* ========================================================================== */
@@ -187,13 +203,13 @@ int32_t zig3270_ebcdic_encode(
 /**
  * Create a new TN3270 client.
  * 
- * \param host Hostname or IP address of TN3270 server
+ * \param host IP address of TN3270 server (copied)
  * \param port Port number (typically 23 for telnet)
- * \return 0 on success, negative error code on failure
+ * \return Client handle, or NULL on allocation failure
  * 
  * The returned client pointer must be freed with zig3270_client_free().
  */
-int32_t zig3270_client_new(const char* host, uint16_t port);
+zig3270_client_t* zig3270_client_new(const char* host, uint16_t port);
 
 /**
  * Free a TN3270 client.
@@ -205,7 +221,8 @@ int32_t zig3270_client_new(const char* host, uint16_t port);
 void zig3270_client_free(zig3270_client_t* client);
 
 /**
- * Connect to the mainframe.
+ * Connect to the mainframe and answer its telnet negotiation (waits up
+ * to 5 seconds for the host).
  * 
  * \param client Client pointer
  * \return 0 on success, negative error code on failure
@@ -242,6 +259,7 @@ int32_t zig3270_client_send_command(
  * \param buffer_len Size of output buffer
  * \param timeout_ms Timeout in milliseconds (0 = no timeout)
  * \return Number of bytes read, or negative error code
+ *         (-ZIG3270_TIMEOUT if nothing arrived in time)
  */
 int32_t zig3270_client_read_response(
     zig3270_client_t* client,
@@ -250,6 +268,62 @@ int32_t zig3270_client_read_response(
     uint32_t timeout_ms
 );
 
+/* ========================================================================== */
+/* Non-blocking Client Functions                                            */
+/* ========================================================================== */
+
+/**
+ * Get the socket descriptor of a connected client.
+ * 
+ * Register it with poll/epoll/kqueue to learn when the session is
+ * readable or writable. The descriptor stays owned by the client.
+ * 
+ * \param client Client pointer
+ * \return File descriptor (>= 0), or -ZIG3270_INVALID_STATE if not connected
+ */
+int32_t zig3270_client_get_fd(zig3270_client_t* client);
+
+/**
+ * Switch a connected client between blocking and non-blocking mode.
+ * 
+ * \param client Client pointer
+ * \param enabled true for non-blocking
+ * \return 0 on success, negative error code on failure
+ */
+int32_t zig3270_client_set_nonblocking(zig3270_client_t* client, bool enabled);
+
+/**
+ * Read pending host data into a caller-owned buffer.
+ * 
+ * \param client Client pointer
+ * \param buffer Output buffer
+ * \param buffer_len Size of output buffer
+ * \return Number of bytes read, -ZIG3270_WOULD_BLOCK if nothing is pending
+ *         (non-blocking mode), or another negative error code. The client
+ *         is disconnected when the host closes the connection.
+ */
+int32_t zig3270_client_read_into(
+    zig3270_client_t* client,
+    uint8_t* buffer,
+    size_t buffer_len
+);
+
+/**
+ * Send several caller-owned buffers using vectored writes.
+ * 
+ * \param client Client pointer
+ * \param buffers Array of buffer descriptors
+ * \param buffer_count Number of descriptors
+ * \return Number of bytes written, or negative error code. In non-blocking
+ *         mode the count may be short; resubmit the remainder once the
+ *         descriptor is writable.
+ */
+int32_t zig3270_client_send_batch(
+    zig3270_client_t* client,
+    const zig3270_buffer_t* buffers,
+    size_t buffer_count
+);
+
 /* ========================================================================== */
 /* Screen Functions                                                         */
 /* ========================================================================== */
@@ -257,11 +331,11 @@ int32_t zig3270_client_read_response(
 /**
  * Create a new screen (24x80).
  * 
- * \return 0 on success, negative error code on failure
+ * \return Screen handle, or NULL on allocation failure
  * 
  * The returned screen pointer must be freed with zig3270_screen_free().
  */
-int32_t zig3270_screen_new(void);
+zig3270_screen_t* zig3270_screen_new(void);
 
 /**
  * Free a screen.
@@ -324,6 +398,61 @@ int32_t zig3270_screen_read(
  */
 char* zig3270_screen_to_string(zig3270_screen_t* screen);
 
+/**
+ * Borrow the screen's character plane without copying.
+ * 
+ * \param screen Screen pointer
+ * \param out Receives a pointer to rows * cols bytes, row-major
+ * \return 0 on success, negative error code on failure
+ * 
+ * The view is owned by the screen: it stays valid until zig3270_screen_free()
+ * and reflects later writes. Do not write through it.
+ */
+int32_t zig3270_screen_buffer(zig3270_screen_t* screen, zig3270_buffer_t* out);
+
+/**
+ * Current change generation of the screen.
+ * 
+ * \param screen Screen pointer
+ * \return Generation counter; it only moves after the screen is written,
+ *         so an unchanged value means a previously read copy is current
+ */
+uint32_t zig3270_screen_generation(zig3270_screen_t* screen);
+
+/**
+ * Encode the Read Modified reply for an AID key.
+ * 
+ * Writes the AID, the cursor address, then SBA + data for every field with
+ * a modified cell (set by zig3270_screen_write()), nulls suppressed. PA keys
+ * and Clear send only the AID unless read_all is set (Read Modified All).
+ * No telnet framing is added.
+ * 
+ * \param screen Screen pointer
+ * \param fields Field layout of the screen
+ * \param aid AID byte (e.g. 0x7D for Enter)
+ * \param read_all true for Read Modified All
+ * \param buffer Output buffer
+ * \param buffer_len Size of output buffer
+ * \return Number of bytes written, or negative error code
+ *         (-ZIG3270_INVALID_ARG for an unknown AID or a short buffer)
+ */
+int32_t zig3270_screen_read_modified(
+    zig3270_screen_t* screen,
+    zig3270_field_manager_t* fields,
+    uint8_t aid,
+    bool read_all,
+    uint8_t* buffer,
+    size_t buffer_len
+);
+
+/**
+ * Clear all modified data tags, e.g. after a Read Modified reply was sent.
+ * 
+ * \param screen Screen pointer
+ * \return 0 on success
+ */
+int32_t zig3270_screen_reset_modified(zig3270_screen_t* screen);
+
 /**
  * Get current cursor position.
  * 
@@ -340,11 +469,11 @@ int32_t zig3270_screen_get_cursor(zig3270_screen_t* screen, zig3270_address_t* a
 /**
  * Create a new field manager.
  * 
- * \return 0 on success, negative error code on failure
+ * \return Field manager handle, or NULL on allocation failure
  * 
  * The returned field manager pointer must be freed with zig3270_fields_free().
  */
-int32_t zig3270_fields_new(void);
+zig3270_field_manager_t* zig3270_fields_new(void);
 
 /**
  * Free a field manager.
@@ -393,6 +522,165 @@ int32_t zig3270_fields_get(
     uint16_t* length
 );
 
+/* ========================================================================== */
+/* Screen Waiter Functions                                                  */
+/* ========================================================================== */
+
+/*
+ * A waiter holds predicates over one screen and checks them against the
+ * cells written since the last check, without copying the screen. Each
+ * predicate fires once: the callback runs, its id is queued for
+ * zig3270_waiter_take_fired(), and the waiter's descriptor becomes
+ * readable. Text is compared byte for byte with the character plane.
+ *
+ *   uint32_t ready;
+ *   zig3270_buffer_t done[] = { { (const uint8_t*)"READY", 5 },
+ *                               { (const uint8_t*)"ABEND", 5 } };
+ *   zig3270_waiter_add_any_of(waiter, done, 2, &ready);
+ *   ... write the host's data to the screen ...
+ *   zig3270_waiter_check(waiter);
+ *   poll on zig3270_waiter_get_fd(waiter), then zig3270_waiter_take_fired()
+ */
+
+/**
+ * Callback run for each predicate that fires, on the thread calling
+ * zig3270_waiter_check() (or the add function, if already true)
+ */
+typedef void (*zig3270_waiter_callback_t)(void* user_data, uint32_t id);
+
+/**
+ * Create a waiter on a screen.
+ * 
+ * \param screen Screen to watch; must outlive the waiter
+ * \param fields Field manager for cursor-in-field predicates, or NULL
+ * \return Waiter handle, or NULL on allocation failure
+ * 
+ * The returned waiter pointer must be freed with zig3270_waiter_free().
+ */
+zig3270_waiter_t* zig3270_waiter_new(zig3270_screen_t* screen, zig3270_field_manager_t* fields);
+
+/**
+ * Free a waiter. The screen and field manager are not freed.
+ * 
+ * \param waiter Waiter pointer returned by zig3270_waiter_new()
+ */
+void zig3270_waiter_free(zig3270_waiter_t* waiter);
+
+/**
+ * Wait for text at a position.
+ * 
+ * \param waiter Waiter pointer
+ * \param row Row of the first character (0-23)
+ * \param col Column of the first character (0-79)
+ * \param text Text to match (copied)
+ * \param text_len Length of text (> 0)
+ * \param id Receives the predicate id
+ * \return 0 on success, negative error code on failure
+ */
+int32_t zig3270_waiter_add_text_at(
+    zig3270_waiter_t* waiter,
+    uint8_t row,
+    uint8_t col,
+    const uint8_t* text,
+    size_t text_len,
+    uint32_t* id
+);
+
+/**
+ * Wait for any of several strings anywhere on the screen.
+ * 
+ * \param waiter Waiter pointer
+ * \param strings Non-empty strings to match (copied)
+ * \param count Number of strings (1-64)
+ * \param id Receives the predicate id
+ * \return 0 on success, negative error code on failure
+ */
+int32_t zig3270_waiter_add_any_of(
+    zig3270_waiter_t* waiter,
+    const zig3270_buffer_t* strings,
+    size_t count,
+    uint32_t* id
+);
+
+/**
+ * Wait for the cursor to enter a field.
+ * 
+ * \param waiter Waiter pointer (created with a field manager)
+ * \param field_offset Screen offset where the field starts
+ * \param id Receives the predicate id
+ * \return 0 on success, -ZIG3270_INVALID_STATE without a field manager
+ */
+int32_t zig3270_waiter_add_cursor_in_field(zig3270_waiter_t* waiter, uint16_t field_offset, uint32_t* id);
+
+/**
+ * Wait for the keyboard to be unlocked (see zig3270_waiter_set_keyboard_locked()).
+ * 
+ * \param waiter Waiter pointer
+ * \param id Receives the predicate id
+ * \return 0 on success, negative error code on failure
+ */
+int32_t zig3270_waiter_add_keyboard_unlocked(zig3270_waiter_t* waiter, uint32_t* id);
+
+/**
+ * Drop a predicate that has not fired. Unknown ids are ignored.
+ * 
+ * \param waiter Waiter pointer
+ * \param id Predicate id
+ * \return 0
+ */
+int32_t zig3270_waiter_remove(zig3270_waiter_t* waiter, uint32_t id);
+
+/**
+ * Report the keyboard state. Lock it when an AID key is sent and unlock it
+ * when the host's WCC restores the keyboard.
+ * 
+ * \param waiter Waiter pointer
+ * \param locked true while the keyboard is locked
+ * \return 0
+ */
+int32_t zig3270_waiter_set_keyboard_locked(zig3270_waiter_t* waiter, bool locked);
+
+/**
+ * Check predicates against screen cells changed since the last check,
+ * using the screen's current cursor.
+ * 
+ * \param waiter Waiter pointer
+ * \return 0 on success, negative error code on failure
+ */
+int32_t zig3270_waiter_check(zig3270_waiter_t* waiter);
+
+/**
+ * Set the callback run when a predicate fires.
+ * 
+ * \param waiter Waiter pointer
+ * \param callback Callback, or NULL to remove it
+ * \param user_data Passed to the callback
+ * \return 0
+ */
+int32_t zig3270_waiter_set_callback(
+    zig3270_waiter_t* waiter,
+    zig3270_waiter_callback_t callback,
+    void* user_data
+);
+
+/**
+ * Get a descriptor that polls readable while fired ids are waiting.
+ * 
+ * \param waiter Waiter pointer
+ * \return File descriptor (>= 0), owned by the waiter, or negative error code
+ */
+int32_t zig3270_waiter_get_fd(zig3270_waiter_t* waiter);
+
+/**
+ * Collect fired predicate ids, oldest first.
+ * 
+ * \param waiter Waiter pointer
+ * \param ids Output array
+ * \param max_ids Size of the output array
+ * \return Number of ids written; ids that did not fit stay queued
+ */
+int32_t zig3270_waiter_take_fired(zig3270_waiter_t* waiter, uint32_t* ids, size_t max_ids);
+
 /* ========================================================================== */
 /* Version & Info                                                           */
 /* ========================================================================== */
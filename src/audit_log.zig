@@ -1,4 +1,5 @@
 const std = @import("std");
+const zone_trace = @import("zone_trace.zig");
 
 pub const AuditEvent = struct {
     timestamp: i64,
@@ -58,27 +59,191 @@ pub const RetentionPolicy = struct {
     secure_delete: bool = true,
 };
 
+/// When the background writer forces buffered events to disk.
+pub const FsyncPolicy = enum {
+    /// Leave durability to the OS page cache.
+    never,
+    /// fsync after every group commit.
+    per_batch,
+};
+
+/// What a producer does when the event queue is full.
+pub const OverflowPolicy = enum {
+    /// Spin (yielding) until the writer frees a slot. Nothing is lost.
+    block,
+    /// Discard the event and count it in `dropped_events`.
+    drop,
+};
+
+pub const AsyncOptions = struct {
+    /// Queue slots, rounded up to a power of two.
+    queue_capacity: u32 = 1024,
+    /// Serialized bytes that trigger a group commit.
+    batch_bytes: usize = 64 * 1024,
+    /// Upper bound on how long an event waits in the batch buffer.
+    flush_interval_ms: u32 = 50,
+    fsync: FsyncPolicy = .never,
+    overflow: OverflowPolicy = .block,
+};
+
+/// Strings of an async event are copied into its queue slot; this bounds
+/// their combined length.
+pub const max_event_payload = 1024;
+
+/// Worst-case JSON line for an event whose payload fits a slot (every
+/// payload byte escaped as \u00XX, plus field names and numbers).
+const max_line_bytes = max_event_payload * 6 + 512;
+
+const optional_strings = .{ "session_id", "user", "host", "details", "err" };
+
+fn payloadLen(event: AuditEvent) usize {
+    var len = event.action.len;
+    inline for (optional_strings) |name| {
+        if (@field(event, name)) |s| len += s.len;
+    }
+    return len;
+}
+
+fn stash(storage: []u8, used: *usize, bytes: []const u8) []const u8 {
+    const dest = storage[used.*..][0..bytes.len];
+    @memcpy(dest, bytes);
+    used.* += bytes.len;
+    return dest;
+}
+
+/// Copy `event` so its strings point into `storage`. The caller checked
+/// payloadLen(event) <= storage.len.
+fn copyEvent(event: AuditEvent, storage: []u8) AuditEvent {
+    var copy = event;
+    var used: usize = 0;
+    copy.action = stash(storage, &used, event.action);
+    inline for (optional_strings) |name| {
+        if (@field(event, name)) |s| @field(copy, name) = stash(storage, &used, s);
+    }
+    return copy;
+}
+
+fn encodeLine(out: *std.Io.Writer, event: AuditEvent) std.Io.Writer.Error!void {
+    try std.json.Stringify.value(event, .{}, out);
+    try out.writeByte('\n');
+}
+
+/// Bounded lock-free multi-producer queue with a single consumer. Each
+/// slot carries a sequence number: producers claim a position with a CAS
+/// on `enqueue_pos` and publish by storing position + 1; the consumer
+/// hands the slot back by storing position + capacity.
+const EventQueue = struct {
+    const Slot = struct {
+        sequence: std.atomic.Value(usize),
+        event: AuditEvent,
+        storage: [max_event_payload]u8,
+    };
+
+    slots: []Slot,
+    mask: usize,
+    enqueue_pos: std.atomic.Value(usize) align(std.atomic.cache_line) = .init(0),
+    dequeue_pos: usize align(std.atomic.cache_line) = 0,
+
+    fn init(allocator: std.mem.Allocator, capacity: u32) !EventQueue {
+        const len = std.math.ceilPowerOfTwo(usize, @max(capacity, 2)) catch return error.OutOfMemory;
+        const slots = try allocator.alloc(Slot, len);
+        for (slots, 0..) |*slot, i| slot.sequence = .init(i);
+        return .{ .slots = slots, .mask = len - 1 };
+    }
+
+    fn deinit(self: *EventQueue, allocator: std.mem.Allocator) void {
+        allocator.free(self.slots);
+    }
+
+    /// Returns the position the event was published at, or null when full.
+    fn tryPush(self: *EventQueue, event: AuditEvent) ?usize {
+        var pos = self.enqueue_pos.load(.monotonic);
+        while (true) {
+            const slot = &self.slots[pos & self.mask];
+            const diff: isize = @bitCast(slot.sequence.load(.acquire) -% pos);
+            if (diff == 0) {
+                if (self.enqueue_pos.cmpxchgWeak(pos, pos + 1, .monotonic, .monotonic)) |actual| {
+                    pos = actual;
+                    continue;
+                }
+                slot.event = copyEvent(event, &slot.storage);
+                slot.sequence.store(pos + 1, .release);
+                return pos;
+            }
+            if (diff < 0) return null;
+            pos = self.enqueue_pos.load(.monotonic);
+        }
+    }
+
+    /// Consumer only: the next published slot, if any.
+    fn peek(self: *EventQueue) ?*Slot {
+        const slot = &self.slots[self.dequeue_pos & self.mask];
+        if (slot.sequence.load(.acquire) != self.dequeue_pos + 1) return null;
+        return slot;
+    }
+
+    /// Consumer only: return the slot from peek() to producers.
+    fn release(self: *EventQueue, slot: *Slot) void {
+        slot.sequence.store(self.dequeue_pos + self.slots.len, .release);
+        self.dequeue_pos += 1;
+    }
+};
+
+/// State of the background writer. Heap allocated so the writer thread
+/// holds a stable pointer regardless of where the logger lives.
+const AsyncWriter = struct {
+    options: AsyncOptions,
+    queue: EventQueue,
+    batch: []u8,
+    out: std.Io.Writer,
+    batch_events: u64 = 0,
+    /// Producers kick the writer every `wake_stride` events so a burst is
+    /// committed by size rather than waiting out the interval.
+    wake_stride: usize,
+    thread: std.Thread = undefined,
+    wakeup: std.Thread.ResetEvent = .{},
+    stopping: std.atomic.Value(bool) = .init(false),
+    flush_requested: std.atomic.Value(bool) = .init(false),
+    /// Queue positions whose events have been handed to the file.
+    committed: std.atomic.Value(usize) = .init(0),
+    dropped: std.atomic.Value(u64) = .init(0),
+    failed: std.atomic.Value(u64) = .init(0),
+
+    fn push(self: *AsyncWriter, event: AuditEvent) !void {
+        if (payloadLen(event) > max_event_payload) return error.EventTooLarge;
+
+        while (true) {
+            if (self.queue.tryPush(event)) |pos| {
+                if (pos & (self.wake_stride - 1) == 0) self.wakeup.set();
+                return;
+            }
+            if (self.options.overflow == .drop) {
+                _ = self.dropped.fetchAdd(1, .monotonic);
+                return;
+            }
+            self.wakeup.set();
+            std.Thread.yield() catch {};
+        }
+    }
+};
+
 pub const AuditLogger = struct {
     allocator: std.mem.Allocator,
     config: AuditConfig,
     file: ?std.fs.File = null,
-    writer: ?std.io.BufferedWriter(4096, std.fs.File.Writer) = null,
     current_size: u64 = 0,
     event_count: u64 = 0,
     retention: RetentionPolicy = .{},
     mutex: std.Thread.Mutex = .{},
+    async_writer: ?*AsyncWriter = null,
 
     pub fn init(allocator: std.mem.Allocator, config: AuditConfig) !AuditLogger {
         var logger = AuditLogger{
             .allocator = allocator,
-            .config = try allocator.dupe(u8, config.file_path),
+            .config = config,
         };
-        logger.config.file_path = config.file_path;
-        logger.config.max_file_size = config.max_file_size;
-        logger.config.max_files = config.max_files;
-        logger.config.log_level = config.log_level;
-        logger.config.include_network_details = config.include_network_details;
-        logger.config.include_data_snapshots = config.include_data_snapshots;
+        logger.config.file_path = try allocator.dupe(u8, config.file_path);
+        errdefer allocator.free(logger.config.file_path);
 
         try logger.openFile();
         return logger;
@@ -92,17 +257,148 @@ pub const AuditLogger = struct {
         defer dir.close();
 
         const basename = std.fs.path.basename(self.config.file_path);
-        self.file = try dir.createFile(basename, .{
+        const file = try dir.createFile(basename, .{
             .read = true,
             .truncate = false,
         });
+        errdefer file.close();
 
-        self.current_size = try self.file.?.getEndPos();
+        self.current_size = try file.getEndPos();
+        try file.seekFromEnd(0);
+        self.file = file;
+    }
+
+    /// Switch to asynchronous logging: logEvent copies the event into a
+    /// lock-free queue and returns, and a background thread serializes,
+    /// batches and writes events, rotating files as it goes. Call this
+    /// before the logger is shared between threads; the logger must not
+    /// move afterwards.
+    pub fn startAsync(self: *AuditLogger, options: AsyncOptions) !void {
+        if (self.async_writer != null) return error.AlreadyStarted;
+
+        const aw = try self.allocator.create(AsyncWriter);
+        errdefer self.allocator.destroy(aw);
+
+        var queue = try EventQueue.init(self.allocator, options.queue_capacity);
+        errdefer queue.deinit(self.allocator);
+
+        const batch = try self.allocator.alloc(u8, options.batch_bytes + max_line_bytes);
+        errdefer self.allocator.free(batch);
+
+        aw.* = .{
+            .options = options,
+            .queue = queue,
+            .batch = batch,
+            .out = .fixed(batch),
+            .wake_stride = @max(queue.slots.len / 4, 1),
+        };
+        aw.thread = try std.Thread.spawn(.{}, writerMain, .{ self, aw });
+        self.async_writer = aw;
+    }
+
+    /// Block until every event logged before the call has been written.
+    /// A no-op in synchronous mode, where logEvent writes directly.
+    pub fn flush(self: *AuditLogger) void {
+        const aw = self.async_writer orelse return;
+        const target = aw.queue.enqueue_pos.load(.acquire);
+        while (aw.committed.load(.acquire) < target) {
+            aw.flush_requested.store(true, .release);
+            aw.wakeup.set();
+            std.Thread.sleep(100 * std.time.ns_per_us);
+        }
+    }
+
+    fn stopAsync(self: *AuditLogger) void {
+        const aw = self.async_writer orelse return;
+        aw.stopping.store(true, .release);
+        aw.wakeup.set();
+        aw.thread.join();
+
+        self.async_writer = null;
+        aw.queue.deinit(self.allocator);
+        self.allocator.free(aw.batch);
+        self.allocator.destroy(aw);
+    }
+
+    fn writerMain(self: *AuditLogger, aw: *AsyncWriter) void {
+        const interval_ms: i64 = aw.options.flush_interval_ms;
+        var last_commit = std.time.milliTimestamp();
+
+        while (true) {
+            aw.wakeup.reset();
+            const stopping = aw.stopping.load(.acquire);
+            const drained = self.drainQueue(aw);
+
+            const now = std.time.milliTimestamp();
+            const flush_requested = aw.flush_requested.swap(false, .acq_rel);
+            if (stopping or flush_requested or now - last_commit >= interval_ms) {
+                self.commitBatch(aw);
+                last_commit = now;
+            }
+
+            if (stopping and drained == 0) break;
+            if (drained == 0) {
+                aw.wakeup.timedWait(@as(u64, aw.options.flush_interval_ms) * std.time.ns_per_ms) catch {};
+            }
+        }
+    }
+
+    fn drainQueue(self: *AuditLogger, aw: *AsyncWriter) usize {
+        var drained: usize = 0;
+        while (aw.queue.peek()) |slot| {
+            const mark = aw.out.end;
+            if (encodeLine(&aw.out, slot.event)) {
+                aw.batch_events += 1;
+            } else |_| {
+                aw.out.end = mark;
+                _ = aw.failed.fetchAdd(1, .monotonic);
+            }
+            aw.queue.release(slot);
+            drained += 1;
+
+            if (aw.out.end >= aw.options.batch_bytes) self.commitBatch(aw);
+        }
+        return drained;
+    }
+
+    /// Group commit: one write (and optionally one fsync) for everything
+    /// serialized since the last commit.
+    fn commitBatch(self: *AuditLogger, aw: *AsyncWriter) void {
+        const zone = zone_trace.begin(.audit_commit);
+        defer zone.end();
+        const pending = aw.out.buffered();
+        if (pending.len > 0) {
+            self.mutex.lock();
+            defer self.mutex.unlock();
+
+            self.writeBatch(pending, aw.batch_events, aw.options.fsync) catch |err| {
+                std.log.err("audit log write failed: {s}", .{@errorName(err)});
+                _ = aw.failed.fetchAdd(aw.batch_events, .monotonic);
+            };
+        }
+        aw.out.end = 0;
+        aw.batch_events = 0;
+        aw.committed.store(aw.queue.dequeue_pos, .release);
+    }
+
+    fn writeBatch(self: *AuditLogger, bytes: []const u8, events: u64, fsync: FsyncPolicy) !void {
+        try self.rotateIfNeeded();
+        const file = self.file orelse return error.FileNotOpen;
+
+        try file.writeAll(bytes);
+        if (fsync == .per_batch) try file.sync();
+
+        self.current_size += bytes.len;
+        self.event_count += events;
     }
 
     pub fn logEvent(self: *AuditLogger, event: AuditEvent) !void {
+        const zone = zone_trace.begin(.audit_log);
+        defer zone.end();
         if (@intFromEnum(self.config.log_level) == 0) return; // disabled
 
+        if (self.async_writer) |aw| return aw.push(event);
+
         self.mutex.lock();
         defer self.mutex.unlock();
 
@@ -111,24 +407,15 @@ pub const AuditLogger = struct {
         // Check for rotation
         try self.rotateIfNeeded();
 
-        // Format event as JSON
+        // Format event as a JSON line
         var buf: [2048]u8 = undefined;
-        var fbs = std.io.fixedBufferStream(&buf);
-        try std.json.stringify(
-            event,
-            .{ .whitespace = .minified },
-            fbs.writer(),
-        );
-
-        const json_str = fbs.getWritten();
+        var out: std.Io.Writer = .fixed(&buf);
+        try encodeLine(&out, event);
 
-        // Write event with newline
-        var writer = std.io.bufferedWriter(self.file.?.writer());
-        try writer.writer().writeAll(json_str);
-        try writer.writer().writeAll("\n");
-        try writer.flush();
+        const line = out.buffered();
+        try self.file.?.writeAll(line);
 
-        self.current_size += json_str.len + 1;
+        self.current_size += line.len;
         self.event_count += 1;
     }
 
@@ -138,36 +425,40 @@ pub const AuditLogger = struct {
         // Close current file
         if (self.file) |f| {
             f.close();
+            self.file = null;
         }
 
         // Rotate files
         var i: i32 = @intCast(self.config.max_files - 1);
         while (i > 0) : (i -= 1) {
-            var buf: [256]u8 = undefined;
-            const old_name = try std.fmt.bufPrint(&buf, "{}.{}", .{
+            var old_buf: [256]u8 = undefined;
+            var new_buf: [256]u8 = undefined;
+            const old_name = try std.fmt.bufPrint(&old_buf, "{s}.{d}", .{
                 self.config.file_path,
                 i,
             });
-            const new_name = try std.fmt.bufPrint(&buf, "{}.{}", .{
+            const new_name = try std.fmt.bufPrint(&new_buf, "{s}.{d}", .{
                 self.config.file_path,
                 i + 1,
             });
 
-            _ = std.fs.cwd().renameZ(old_name, new_name) catch {};
+            std.fs.cwd().rename(old_name, new_name) catch {};
         }
 
         // Rename current to .1
         var buf: [256]u8 = undefined;
-        const archived_name = try std.fmt.bufPrint(&buf, "{}.1", .{
+        const archived_name = try std.fmt.bufPrint(&buf, "{s}.1", .{
             self.config.file_path,
         });
-        _ = std.fs.cwd().renameZ(self.config.file_path, archived_name) catch {};
+        std.fs.cwd().rename(self.config.file_path, archived_name) catch {};
 
         // Open new file
         try self.openFile();
     }
 
     pub fn deinit(self: *AuditLogger) void {
+        self.stopAsync();
+
         self.mutex.lock();
         defer self.mutex.unlock();
 
@@ -189,24 +480,24 @@ pub const AuditLogger = struct {
         defer self.mutex.unlock();
 
         const now = std.time.timestamp();
-        const retention_seconds = self.retention.retention_days * 86400;
+        const retention_seconds: i64 = @as(i64, self.retention.retention_days) * 86400;
         const cutoff_time = now - retention_seconds;
 
         // Find files to delete
         var i: i32 = @intCast(self.config.max_files);
         while (i > 0) : (i -= 1) {
             var buf: [256]u8 = undefined;
-            const archived_name = try std.fmt.bufPrint(&buf, "{}.{}", .{
+            const archived_name = try std.fmt.bufPrint(&buf, "{s}.{d}", .{
                 self.config.file_path,
                 i,
             });
 
-            if (std.fs.cwd().statZ(archived_name)) |stat| {
-                if (stat.mtime < cutoff_time) {
+            if (std.fs.cwd().statFile(archived_name)) |stat| {
+                if (@divFloor(stat.mtime, std.time.ns_per_s) < cutoff_time) {
                     if (self.retention.secure_delete) {
                         try self.secureDelete(archived_name);
                     } else {
-                        _ = std.fs.cwd().deleteFileZ(archived_name) catch {};
+                        std.fs.cwd().deleteFile(archived_name) catch {};
                     }
                 }
             } else |_| {}
@@ -216,7 +507,7 @@ pub const AuditLogger = struct {
     fn secureDelete(self: *AuditLogger, file_path: []const u8) !void {
         _ = self;
         // Overwrite with zeros (DoD 5220.22-M single-pass)
-        if (std.fs.cwd().openFileZ(file_path, .{
+        if (std.fs.cwd().openFile(file_path, .{
             .mode = .read_write,
         })) |file| {
             const size = try file.getEndPos();
@@ -225,13 +516,13 @@ pub const AuditLogger = struct {
 
             var offset: u64 = 0;
             while (offset < size) {
-                const to_write = @min(4096, size - offset);
-                try file.pwriteAll(&zeros[0..to_write], offset);
+                const to_write: usize = @intCast(@min(4096, size - offset));
+                try file.pwriteAll(zeros[0..to_write], offset);
                 offset += to_write;
             }
             file.close();
 
-            _ = std.fs.cwd().deleteFileZ(file_path) catch {};
+            std.fs.cwd().deleteFile(file_path) catch {};
         } else |_| {}
     }
 
@@ -239,11 +530,18 @@ pub const AuditLogger = struct {
         self.mutex.lock();
         defer self.mutex.unlock();
 
-        return .{
+        var stats = AuditStatistics{
             .total_events = self.event_count,
             .current_file_size = self.current_size,
             .max_file_size = self.config.max_file_size,
         };
+        if (self.async_writer) |aw| {
+            const committed = aw.committed.load(.acquire);
+            stats.queued_events = aw.queue.enqueue_pos.load(.monotonic) -| committed;
+            stats.dropped_events = aw.dropped.load(.monotonic);
+            stats.failed_events = aw.failed.load(.monotonic);
+        }
+        return stats;
     }
 };
 
@@ -251,6 +549,12 @@ pub const AuditStatistics = struct {
     total_events: u64,
     current_file_size: u64,
     max_file_size: u64,
+    /// Async mode: accepted but not yet written.
+    queued_events: u64 = 0,
+    /// Async mode with OverflowPolicy.drop: discarded on a full queue.
+    dropped_events: u64 = 0,
+    /// Async mode: events that could not be serialized or written.
+    failed_events: u64 = 0,
 };
 
 // Tests
@@ -562,3 +866,69 @@ test "audit_log: enforce retention" {
 
     try testing.expect(logger.retention.retention_days == 30);
 }
+
+test "audit_log: async writer batches events from many threads" {
+    const allocator = testing.allocator;
+    const path = "/tmp/test_audit_async.log";
+    std.fs.cwd().deleteFile(path) catch {};
+
+    var logger = try AuditLogger.init(allocator, .{ .file_path = path });
+    defer logger.deinit();
+    try logger.startAsync(.{ .queue_capacity = 64, .batch_bytes = 4096 });
+
+    const Producer = struct {
+        fn run(log: *AuditLogger, id: usize) !void {
+            var buf: [32]u8 = undefined;
+            for (0..250) |i| {
+                const session_id = try std.fmt.bufPrint(&buf, "sess_{d}_{d}", .{ id, i });
+                try log.logEvent(.{
+                    .timestamp = @intCast(i),
+                    .event_type = .field_modification,
+                    .session_id = session_id,
+                    .user = "testuser",
+                    .host = "mainframe1",
+                    .action = "keystroke",
+                    .details = null,
+                    .status = .success,
+                });
+            }
+        }
+    };
+
+    var threads: [4]std.Thread = undefined;
+    for (&threads, 0..) |*t, id| t.* = try std.Thread.spawn(.{}, Producer.run, .{ &logger, id });
+    for (threads) |t| t.join();
+    logger.flush();
+
+    const stats = logger.getStatistics();
+    try testing.expectEqual(@as(u64, 1000), stats.total_events);
+    try testing.expectEqual(@as(u64, 0), stats.queued_events);
+    try testing.expectEqual(@as(u64, 0), stats.failed_events);
+
+    const contents = try std.fs.cwd().readFileAlloc(allocator, path, 1 << 20);
+    defer allocator.free(contents);
+    try testing.expectEqual(@as(usize, 1000), std.mem.count(u8, contents, "\n"));
+    try testing.expectEqual(stats.current_file_size, contents.len);
+}
+
+test "audit_log: async writer rejects oversized events" {
+    const allocator = testing.allocator;
+    const path = "/tmp/test_audit_async_large.log";
+    std.fs.cwd().deleteFile(path) catch {};
+
+    var logger = try AuditLogger.init(allocator, .{ .file_path = path });
+    defer logger.deinit();
+    try logger.startAsync(.{});
+
+    const details = [_]u8{'x'} ** (max_event_payload + 1);
+    try testing.expectError(error.EventTooLarge, logger.logEvent(.{
+        .timestamp = 0,
+        .event_type = .data_access,
+        .session_id = null,
+        .user = null,
+        .host = null,
+        .action = "read",
+        .details = &details,
+        .status = .success,
+    }));
+}
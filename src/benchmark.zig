@@ -5,6 +5,10 @@ const executor = @import("executor.zig");
 const command_mod = @import("command.zig");
 const protocol = @import("protocol.zig");
 const emulator = @import("emulator.zig");
+const ebcdic_mod = @import("ebcdic.zig");
+const Ebcdic = ebcdic_mod.Ebcdic;
+const screen_mod = @import("screen.zig");
+const parse_utils = @import("parse_utils.zig");
 
 // Benchmarks for parsing throughput and performance
 
@@ -104,6 +108,7 @@ test "benchmark: executor throughput on screen writes" {
     defer order_data.deinit(allocator);
 
     // Fill screen with data
+    try order_data.append(allocator, 0x00); // WCC
     try order_data.append(allocator, 0x11); // Set Buffer Address
     try order_data.append(allocator, 0x00); // (0, 0)
     try order_data.append(allocator, 0x00);
@@ -215,3 +220,156 @@ test "benchmark: address conversion performance" {
 
     try std.testing.expectEqual(@as(u32, 1920), conversions);
 }
+
+test "benchmark: ebcdic bulk transcoding bytes/sec" {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    // One 24x80 screen of EBCDIC text, transcoded many times
+    const screen_bytes = 1920;
+    const iterations = 1000;
+    const ebcdic_data = try allocator.alloc(u8, screen_bytes);
+    defer allocator.free(ebcdic_data);
+    const ascii_data = try allocator.alloc(u8, screen_bytes);
+    defer allocator.free(ascii_data);
+    const output = try allocator.alloc(u8, screen_bytes);
+    defer allocator.free(output);
+    const scalar_output = try allocator.alloc(u8, screen_bytes);
+    defer allocator.free(scalar_output);
+
+    for (ascii_data, 0..) |*b, i| {
+        b.* = if (i % 26 < 25) 'A' + @as(u8, @truncate(i % 26)) else ' ';
+    }
+    _ = try Ebcdic.encode(ascii_data, ebcdic_data);
+
+    const total_bytes: f64 = @floatFromInt(screen_bytes * iterations);
+
+    // Baseline: byte-at-a-time table lookup
+    var timer_start = std.time.nanoTimestamp();
+    for (0..iterations) |_| {
+        for (ebcdic_data, 0..) |byte, i| {
+            scalar_output[i] = Ebcdic.decode_byte(byte);
+        }
+        std.mem.doNotOptimizeAway(scalar_output.ptr);
+    }
+    const scalar_ns = @as(f64, @floatFromInt(std.time.nanoTimestamp() - timer_start));
+
+    // Bulk kernel
+    timer_start = std.time.nanoTimestamp();
+    for (0..iterations) |_| {
+        _ = try Ebcdic.decode(ebcdic_data, output);
+        std.mem.doNotOptimizeAway(output.ptr);
+    }
+    const decode_ns = @as(f64, @floatFromInt(std.time.nanoTimestamp() - timer_start));
+
+    timer_start = std.time.nanoTimestamp();
+    for (0..iterations) |_| {
+        _ = try Ebcdic.encode(ascii_data, output);
+        std.mem.doNotOptimizeAway(output.ptr);
+    }
+    const encode_ns = @as(f64, @floatFromInt(std.time.nanoTimestamp() - timer_start));
+
+    const mb = 1024.0 * 1024.0;
+    std.debug.print("EBCDIC decode (scalar): {d:.2} MB/s\n", .{total_bytes / (scalar_ns / 1e9) / mb});
+    std.debug.print("EBCDIC decode (bulk, simd={}): {d:.2} MB/s\n", .{ ebcdic_mod.has_byte_shuffle, total_bytes / (decode_ns / 1e9) / mb });
+    std.debug.print("EBCDIC encode (bulk): {d:.2} MB/s\n", .{total_bytes / (encode_ns / 1e9) / mb});
+
+    _ = try Ebcdic.decode(ebcdic_data, output);
+    try std.testing.expectEqualSlices(u8, scalar_output, output);
+}
+
+test "benchmark: erase write repaint allocation counts" {
+    const AllocationTracker = @import("allocation_tracker.zig").AllocationTracker;
+    var tracker = AllocationTracker.init(std.testing.allocator);
+    const allocator = tracker.allocator();
+
+    var emu = try emulator.Emulator.init(allocator, 24, 80);
+    defer emu.deinit();
+
+    var exec = executor.Executor.init(allocator, &emu.screen_buffer, &emu.field_manager);
+
+    // 150-field form: SBA + SF + 6 bytes of label per field
+    var order_data = try std.ArrayList(u8).initCapacity(std.testing.allocator, 1 + 150 * 11);
+    defer order_data.deinit(std.testing.allocator);
+    try order_data.append(std.testing.allocator, 0x00); // WCC
+    for (0..150) |i| {
+        const address: u16 = @intCast(i * 12);
+        try order_data.appendSlice(std.testing.allocator, &.{ 0x11, @intCast(address >> 8), @intCast(address & 0xFF), 0x1D, 0x20 });
+        try order_data.appendSlice(std.testing.allocator, "FIELD:");
+    }
+    const cmd = command_mod.Command{ .code = protocol.CommandCode.erase_write, .data = order_data.items };
+
+    try exec.execute(cmd);
+    const warm_allocations = tracker.allocations;
+
+    const repaints = 1000;
+    for (0..repaints) |_| {
+        try exec.execute(cmd);
+    }
+
+    const repaint_allocations = tracker.allocations - warm_allocations;
+    std.debug.print("Erase Write repaint: {} heap allocations over {} repaints of {} fields\n", .{ repaint_allocations, repaints, emu.field_count() });
+    tracker.report();
+
+    try std.testing.expectEqual(@as(usize, 0), repaint_allocations);
+}
+
+/// The executor's previous text path: classify every byte through the
+/// error union and write one checked cell at a time
+fn legacy_process_text(scr: *screen_mod.Screen, data: []const u8) void {
+    var cursor: u16 = 0;
+    for (data) |byte| {
+        if (parse_utils.parse_order_code(byte)) |_| {
+            continue;
+        } else |_| {
+            scr.write_at(cursor, byte) catch {};
+            cursor += 1;
+            if (cursor >= 1920) cursor = 1919;
+        }
+    }
+}
+
+test "benchmark: executor order dispatch vs per-byte text path" {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    var emu = try emulator.Emulator.init(allocator, 24, 80);
+    defer emu.deinit();
+
+    var exec = executor.Executor.init(allocator, &emu.screen_buffer, &emu.field_manager);
+
+    // Text-heavy screen: WCC, one SBA then 1920 characters with no orders
+    var order_data = [_]u8{ 0x00, 0x11, 0x00, 0x00 } ++ [_]u8{0} ** 1920;
+    for (order_data[4..], 0..) |*b, j| {
+        b.* = if (j % 26 < 25) 'A' + @as(u8, @truncate(j % 26)) else ' ';
+    }
+    const cmd = command_mod.Command{ .code = protocol.CommandCode.write, .data = &order_data };
+
+    const iterations = 2000;
+    const total_bytes: f64 = @floatFromInt(order_data.len * iterations);
+
+    var reference = try screen_mod.Screen.init(allocator, 24, 80);
+    defer reference.deinit();
+
+    var timer_start = std.time.nanoTimestamp();
+    for (0..iterations) |_| {
+        legacy_process_text(&reference, order_data[3..]);
+        std.mem.doNotOptimizeAway(reference.buffer.ptr);
+    }
+    const legacy_ns = @as(f64, @floatFromInt(std.time.nanoTimestamp() - timer_start));
+
+    timer_start = std.time.nanoTimestamp();
+    for (0..iterations) |_| {
+        try exec.execute(cmd);
+        std.mem.doNotOptimizeAway(emu.screen_buffer.buffer.ptr);
+    }
+    const table_ns = @as(f64, @floatFromInt(std.time.nanoTimestamp() - timer_start));
+
+    const mb = 1024.0 * 1024.0;
+    std.debug.print("Executor text (per-byte): {d:.2} MB/s\n", .{total_bytes / (legacy_ns / 1e9) / mb});
+    std.debug.print("Executor text (table + bulk copy): {d:.2} MB/s\n", .{total_bytes / (table_ns / 1e9) / mb});
+
+    try std.testing.expectEqualSlices(u8, reference.buffer, emu.screen_buffer.buffer);
+}
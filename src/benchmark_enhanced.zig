@@ -130,6 +130,7 @@ test "benchmark enhanced: executor with allocation tracking" {
     defer order_data.deinit(allocator);
 
     // Fill screen with data
+    try order_data.append(allocator, 0x00); // WCC
     try order_data.append(allocator, 0x11);
     try order_data.append(allocator, 0x00);
     try order_data.append(allocator, 0x00);
@@ -5,7 +5,7 @@ pub fn BufferPool(comptime T: type) type {
     return struct {
         const Self = @This();
 
-        buffers: std.ArrayList([]T),
+        buffers: std.ArrayList([]T) = .empty,
         allocator: std.mem.Allocator,
         buffer_size: usize,
         allocations: usize = 0,
@@ -14,7 +14,6 @@ pub fn BufferPool(comptime T: type) type {
 
         pub fn init(allocator: std.mem.Allocator, buffer_size: usize) Self {
             return Self{
-                .buffers = std.ArrayList([]T).init(allocator),
                 .allocator = allocator,
                 .buffer_size = buffer_size,
             };
@@ -24,12 +23,12 @@ pub fn BufferPool(comptime T: type) type {
             for (self.buffers.items) |buf| {
                 self.allocator.free(buf);
             }
-            self.buffers.deinit();
+            self.buffers.deinit(self.allocator);
         }
 
         /// Acquire a buffer from the pool or allocate a new one
         pub fn acquire(self: *Self) ![]T {
-            if (self.buffers.popOrNull()) |buf| {
+            if (self.buffers.pop()) |buf| {
                 self.reuses += 1;
                 return buf;
             }
@@ -44,7 +43,7 @@ pub fn BufferPool(comptime T: type) type {
                 return;
             }
             self.deallocations += 1;
-            try self.buffers.append(buf);
+            try self.buffers.append(self.allocator, buf);
         }
 
         /// Get current pool size (number of available buffers)
@@ -77,7 +76,7 @@ pub const ScreenBufferPool = BufferPool(u8);
 pub const VariableBufferPool = struct {
     const Self = @This();
 
-    buffers: std.ArrayList([]u8),
+    buffers: std.ArrayList([]u8) = .empty,
     allocator: std.mem.Allocator,
     allocations: usize = 0,
     deallocations: usize = 0,
@@ -85,7 +84,6 @@ pub const VariableBufferPool = struct {
 
     pub fn init(allocator: std.mem.Allocator) Self {
         return Self{
-            .buffers = std.ArrayList([]u8).init(allocator),
             .allocator = allocator,
         };
     }
@@ -94,7 +92,7 @@ pub const VariableBufferPool = struct {
         for (self.buffers.items) |buf| {
             self.allocator.free(buf);
         }
-        self.buffers.deinit();
+        self.buffers.deinit(self.allocator);
     }
 
     /// Acquire a buffer of at least the requested size
@@ -123,7 +121,7 @@ pub const VariableBufferPool = struct {
     /// Return a buffer to the pool for reuse
     pub fn release(self: *Self, buf: []u8) !void {
         self.deallocations += 1;
-        try self.buffers.append(buf);
+        try self.buffers.append(self.allocator, buf);
     }
 
     /// Get current pool size
@@ -153,6 +151,329 @@ pub const VariableBufferPool = struct {
     }
 };
 
+/// Smallest and largest size classes of SharedBufferPool (64 B to 1 MiB)
+pub const min_class_shift = 6;
+pub const max_class_shift = 20;
+pub const class_count = max_class_shift - min_class_shift + 1;
+
+/// Buffers per magazine
+pub const magazine_capacity = 16;
+
+/// Size class serving `len` bytes, or null above the largest class
+pub fn sizeClass(len: usize) ?usize {
+    if (len > @as(usize, 1) << max_class_shift) return null;
+    const shift = @max(min_class_shift, std.math.log2_int_ceil(usize, @max(len, 1)));
+    return shift - min_class_shift;
+}
+
+/// Buffer length handed out for a size class
+pub fn classSize(class: usize) usize {
+    return @as(usize, 1) << @intCast(class + min_class_shift);
+}
+
+/// A fixed batch of same-class buffers; owned by one thread cache or
+/// parked on a depot stack
+const Magazine = struct {
+    buffers: [magazine_capacity][*]u8 = undefined,
+    count: u8 = 0,
+    /// Depot link: index + 1 of the next magazine, 0 at the end
+    next: std.atomic.Value(u32) = .init(0),
+};
+
+/// Lock-free (Treiber) stack of magazine indices. The head packs index + 1
+/// with a version tag, so a pop that races with another pop and re-push
+/// of the same magazine fails its compare-exchange instead of corrupting
+/// the list.
+const MagazineStack = struct {
+    head: std.atomic.Value(u64) = .init(0),
+
+    fn push(self: *MagazineStack, magazines: []Magazine, index: u32) void {
+        var head = self.head.load(.monotonic);
+        while (true) {
+            magazines[index].next.store(@truncate(head), .monotonic);
+            const tagged = ((head >> 32) +% 1) << 32 | (index + 1);
+            head = self.head.cmpxchgWeak(head, tagged, .release, .monotonic) orelse return;
+        }
+    }
+
+    fn pop(self: *MagazineStack, magazines: []Magazine) ?u32 {
+        var head = self.head.load(.acquire);
+        while (true) {
+            const top: u32 = @truncate(head);
+            if (top == 0) return null;
+            const next = magazines[top - 1].next.load(.monotonic);
+            const tagged = ((head >> 32) +% 1) << 32 | next;
+            head = self.head.cmpxchgWeak(head, tagged, .acquire, .acquire) orelse return top - 1;
+        }
+    }
+};
+
+/// One thread's magazines for one pool. Counters are written only by the
+/// owning thread and read by `stats` from any thread.
+const ThreadCache = struct {
+    loaded: [class_count]?u32 = [_]?u32{null} ** class_count,
+    hits: std.atomic.Value(u64) = .init(0),
+    misses: std.atomic.Value(u64) = .init(0),
+    node: std.SinglyLinkedList.Node = .{},
+
+    fn count(counter: *std.atomic.Value(u64)) void {
+        counter.store(counter.load(.monotonic) + 1, .monotonic);
+    }
+};
+
+/// Pools a thread keeps a cache for at once; beyond that the least
+/// recently added cache is dropped from the thread (its magazines stay
+/// with the pool until `deinit`)
+const max_thread_pools = 4;
+
+const ThreadSlot = struct {
+    pool_id: u64 = 0,
+    cache: ?*ThreadCache = null,
+};
+
+threadlocal var thread_slots: [max_thread_pools]ThreadSlot = [_]ThreadSlot{.{}} ** max_thread_pools;
+threadlocal var thread_slot_victim: usize = 0;
+
+var next_pool_id = std.atomic.Value(u64).init(1);
+
+/// Thread-safe pool of power-of-two buffers shared by all sessions.
+///
+/// Each thread keeps one magazine per size class, so most acquire and
+/// release calls touch no shared state. Full and empty magazines move
+/// through a lock-free depot per class, which lets buffers acquired on
+/// one thread be released on another. Retained memory is capped; releases
+/// beyond the cap are freed. Requests above 1 MiB bypass the pool.
+///
+/// The backing allocator must be thread-safe. All threads must be done
+/// with the pool before `deinit`.
+pub const SharedBufferPool = struct {
+    allocator: std.mem.Allocator,
+    /// Never reused, so a thread slot left over from a freed pool cannot
+    /// match a new one at the same address
+    id: u64,
+    options: Options,
+    magazines: []Magazine,
+    full: [class_count]MagazineStack = [_]MagazineStack{.{}} ** class_count,
+    empty: [class_count]MagazineStack = [_]MagazineStack{.{}} ** class_count,
+    retained_bytes: std.atomic.Value(usize) = .init(0),
+    registry_mutex: std.Thread.Mutex = .{},
+    caches: std.SinglyLinkedList = .{},
+    /// Requests served without a thread cache
+    uncached: std.atomic.Value(u64) = .init(0),
+    oversize: std.atomic.Value(u64) = .init(0),
+    discards: std.atomic.Value(u64) = .init(0),
+
+    pub const Options = struct {
+        /// Bytes held in magazines before releases are freed instead
+        max_retained_bytes: usize = 64 * 1024 * 1024,
+        /// Magazines per size class, shared by every thread
+        magazines_per_class: u32 = 64,
+    };
+
+    pub const Stats = struct {
+        hits: u64,
+        misses: u64,
+        /// Releases freed because the cap was reached or no magazine was free
+        discards: u64,
+        /// Requests too large for any size class
+        oversize: u64,
+        retained_bytes: usize,
+
+        pub fn hitRate(self: Stats) f64 {
+            const total = self.hits + self.misses;
+            if (total == 0) return 0.0;
+            return @as(f64, @floatFromInt(self.hits)) / @as(f64, @floatFromInt(total));
+        }
+    };
+
+    pub fn init(allocator: std.mem.Allocator, options: Options) !SharedBufferPool {
+        const magazines = try allocator.alloc(Magazine, class_count * options.magazines_per_class);
+        @memset(magazines, .{});
+
+        var pool = SharedBufferPool{
+            .allocator = allocator,
+            .id = next_pool_id.fetchAdd(1, .monotonic),
+            .options = options,
+            .magazines = magazines,
+        };
+        for (0..class_count) |class| {
+            for (0..options.magazines_per_class) |i| {
+                pool.empty[class].push(magazines, @intCast(class * options.magazines_per_class + i));
+            }
+        }
+        return pool;
+    }
+
+    pub fn deinit(self: *SharedBufferPool) void {
+        for (self.magazines, 0..) |*magazine, index| {
+            const size = classSize(index / self.options.magazines_per_class);
+            for (magazine.buffers[0..magazine.count]) |ptr| self.allocator.free(ptr[0..size]);
+        }
+        while (self.caches.popFirst()) |node| {
+            self.allocator.destroy(@as(*ThreadCache, @fieldParentPtr("node", node)));
+        }
+        self.allocator.free(self.magazines);
+    }
+
+    /// A buffer of at least `len` bytes. Its length is the class size;
+    /// hand the whole slice back to `release`.
+    pub fn acquire(self: *SharedBufferPool, len: usize) ![]u8 {
+        const class = sizeClass(len) orelse {
+            _ = self.oversize.fetchAdd(1, .monotonic);
+            return self.allocator.alloc(u8, len);
+        };
+        const size = classSize(class);
+
+        if (self.threadCache()) |cache| {
+            if (self.take(cache, class)) |ptr| {
+                ThreadCache.count(&cache.hits);
+                _ = self.retained_bytes.fetchSub(size, .monotonic);
+                return ptr[0..size];
+            }
+            ThreadCache.count(&cache.misses);
+        } else {
+            _ = self.uncached.fetchAdd(1, .monotonic);
+        }
+        return self.allocator.alloc(u8, size);
+    }
+
+    /// Return a buffer from `acquire`, from any thread
+    pub fn release(self: *SharedBufferPool, buf: []u8) void {
+        const class = sizeClass(buf.len) orelse return self.allocator.free(buf);
+        if (classSize(class) != buf.len) return self.allocator.free(buf);
+
+        const cache = self.threadCache() orelse return self.discard(buf);
+        const retained = self.retained_bytes.fetchAdd(buf.len, .monotonic) + buf.len;
+        if (retained > self.options.max_retained_bytes or !self.put(cache, class, buf.ptr)) {
+            _ = self.retained_bytes.fetchSub(buf.len, .monotonic);
+            self.discard(buf);
+        }
+    }
+
+    /// Hand the calling thread's magazines back to the depot before the
+    /// thread exits. Every session on a thread shares its magazines, so
+    /// call it on thread teardown, not per session: reactor threads do
+    /// as they exit, and `ProtocolSnooper.deinit` does for its capture
+    /// thread.
+    pub fn releaseThreadCache(self: *SharedBufferPool) void {
+        for (thread_slots) |slot| {
+            if (slot.pool_id != self.id) continue;
+            const cache = slot.cache.?;
+
+            for (&cache.loaded, 0..) |*loaded, class| {
+                const index = loaded.* orelse continue;
+                const stack = if (self.magazines[index].count > 0) &self.full[class] else &self.empty[class];
+                stack.push(self.magazines, index);
+                loaded.* = null;
+            }
+            // The cache stays registered so its counters keep adding up,
+            // and the thread reloads magazines into it on its next acquire
+        }
+    }
+
+    pub fn stats(self: *SharedBufferPool) Stats {
+        var result = Stats{
+            .hits = 0,
+            .misses = self.uncached.load(.monotonic),
+            .discards = self.discards.load(.monotonic),
+            .oversize = self.oversize.load(.monotonic),
+            .retained_bytes = self.retained_bytes.load(.monotonic),
+        };
+
+        self.registry_mutex.lock();
+        defer self.registry_mutex.unlock();
+        var node = self.caches.first;
+        while (node) |n| : (node = n.next) {
+            const cache: *ThreadCache = @fieldParentPtr("node", n);
+            result.hits += cache.hits.load(.monotonic);
+            result.misses += cache.misses.load(.monotonic);
+        }
+        return result;
+    }
+
+    fn discard(self: *SharedBufferPool, buf: []u8) void {
+        _ = self.discards.fetchAdd(1, .monotonic);
+        self.allocator.free(buf);
+    }
+
+    /// The calling thread's cache for this pool, created on first use
+    fn threadCache(self: *SharedBufferPool) ?*ThreadCache {
+        for (thread_slots) |slot| {
+            if (slot.pool_id == self.id) return slot.cache;
+        }
+
+        const cache = self.allocator.create(ThreadCache) catch return null;
+        cache.* = .{};
+        self.registry_mutex.lock();
+        self.caches.prepend(&cache.node);
+        self.registry_mutex.unlock();
+
+        const slot = for (&thread_slots) |*slot| {
+            if (slot.cache == null) break slot;
+        } else blk: {
+            const victim = &thread_slots[thread_slot_victim];
+            thread_slot_victim = (thread_slot_victim + 1) % max_thread_pools;
+            break :blk victim;
+        };
+        slot.* = .{ .pool_id = self.id, .cache = cache };
+        return cache;
+    }
+
+    fn take(self: *SharedBufferPool, cache: *ThreadCache, class: usize) ?[*]u8 {
+        var index = cache.loaded[class];
+        if (index == null or self.magazines[index.?].count == 0) {
+            // Swap the empty magazine (if any) for a full one from the depot
+            const full = self.full[class].pop(self.magazines) orelse {
+                if (index == null) cache.loaded[class] = self.empty[class].pop(self.magazines);
+                return null;
+            };
+            if (index) |empty| self.empty[class].push(self.magazines, empty);
+            cache.loaded[class] = full;
+            index = full;
+        }
+
+        const magazine = &self.magazines[index.?];
+        magazine.count -= 1;
+        return magazine.buffers[magazine.count];
+    }
+
+    fn put(self: *SharedBufferPool, cache: *ThreadCache, class: usize, ptr: [*]u8) bool {
+        var index = cache.loaded[class] orelse blk: {
+            const empty = self.empty[class].pop(self.magazines) orelse return false;
+            cache.loaded[class] = empty;
+            break :blk empty;
+        };
+        if (self.magazines[index].count == magazine_capacity) {
+            // Park the full magazine for other threads and start an empty one
+            const empty = self.empty[class].pop(self.magazines) orelse return false;
+            self.full[class].push(self.magazines, index);
+            cache.loaded[class] = empty;
+            index = empty;
+        }
+
+        const magazine = &self.magazines[index];
+        magazine.buffers[magazine.count] = ptr;
+        magazine.count += 1;
+        return true;
+    }
+};
+
+var global_pool: SharedBufferPool = undefined;
+var global_pool_ready = false;
+var global_pool_mutex: std.Thread.Mutex = .{};
+
+/// Process-wide pool on the thread-safe SMP allocator, used by clients
+/// and snoopers that are not given one
+pub fn global() !*SharedBufferPool {
+    global_pool_mutex.lock();
+    defer global_pool_mutex.unlock();
+    if (!global_pool_ready) {
+        global_pool = try SharedBufferPool.init(std.heap.smp_allocator, .{});
+        global_pool_ready = true;
+    }
+    return &global_pool;
+}
+
 test "buffer pool: fixed size pool basic operations" {
     var gpa = std.heap.GeneralPurposeAllocator(.{}){};
     defer _ = gpa.deinit();
@@ -222,3 +543,98 @@ test "buffer pool: oversized buffer not reused" {
     // Wrong size is freed, not added to pool
     try std.testing.expectEqual(@as(usize, 0), pool.poolSize());
 }
+
+test "shared buffer pool: size classes and reuse" {
+    var pool = try SharedBufferPool.init(std.testing.allocator, .{ .magazines_per_class = 2 });
+    defer pool.deinit();
+
+    try std.testing.expectEqual(@as(?usize, 0), sizeClass(1));
+    try std.testing.expectEqual(@as(usize, 128), classSize(sizeClass(100).?));
+    try std.testing.expectEqual(@as(?usize, null), sizeClass((1 << max_class_shift) + 1));
+
+    const first = try pool.acquire(100);
+    try std.testing.expectEqual(@as(usize, 128), first.len);
+    pool.release(first);
+
+    const second = try pool.acquire(120);
+    try std.testing.expectEqual(first.ptr, second.ptr);
+    pool.release(second);
+
+    const big = try pool.acquire(2 << max_class_shift);
+    pool.release(big);
+
+    const stats = pool.stats();
+    try std.testing.expectEqual(@as(u64, 1), stats.hits);
+    try std.testing.expectEqual(@as(u64, 1), stats.misses);
+    try std.testing.expectEqual(@as(u64, 1), stats.oversize);
+    try std.testing.expectEqual(@as(usize, 128), stats.retained_bytes);
+}
+
+test "shared buffer pool: retained memory cap" {
+    var pool = try SharedBufferPool.init(std.testing.allocator, .{ .max_retained_bytes = 256, .magazines_per_class = 2 });
+    defer pool.deinit();
+
+    var buffers: [3][]u8 = undefined;
+    for (&buffers) |*buf| buf.* = try pool.acquire(128);
+    for (buffers) |buf| pool.release(buf);
+
+    const stats = pool.stats();
+    try std.testing.expectEqual(@as(u64, 1), stats.discards);
+    try std.testing.expectEqual(@as(usize, 256), stats.retained_bytes);
+}
+
+fn acquireBatch(pool: *SharedBufferPool, buffers: [][]u8, result: *?anyerror) void {
+    for (buffers) |*buf| {
+        buf.* = pool.acquire(1000) catch |err| {
+            result.* = err;
+            return;
+        };
+    }
+}
+
+fn releaseBatch(pool: *SharedBufferPool, buffers: []const []u8) void {
+    for (buffers) |buf| pool.release(buf);
+}
+
+fn churn(pool: *SharedBufferPool, seed: usize, result: *?anyerror) void {
+    var prng = std.Random.DefaultPrng.init(seed);
+    const random = prng.random();
+    var held: [8][]u8 = undefined;
+    for (0..2000) |_| {
+        for (&held) |*buf| {
+            buf.* = pool.acquire(random.intRangeAtMost(usize, 1, 8192)) catch |err| {
+                result.* = err;
+                return;
+            };
+        }
+        for (held) |buf| pool.release(buf);
+    }
+    pool.releaseThreadCache();
+}
+
+test "shared buffer pool: buffers move between threads through the depot" {
+    var pool = try SharedBufferPool.init(std.testing.allocator, .{});
+    defer pool.deinit();
+
+    // Acquired on one thread, released on a second, reused on a third
+    var buffers: [100][]u8 = undefined;
+    var result: ?anyerror = null;
+    (try std.Thread.spawn(.{}, acquireBatch, .{ &pool, &buffers, &result })).join();
+    try std.testing.expectEqual(@as(?anyerror, null), result);
+    (try std.Thread.spawn(.{}, releaseBatch, .{ &pool, &buffers })).join();
+
+    const before = pool.stats().hits;
+    (try std.Thread.spawn(.{}, acquireBatch, .{ &pool, buffers[0..96], &result })).join();
+    try std.testing.expectEqual(@as(u64, 96), pool.stats().hits - before);
+    (try std.Thread.spawn(.{}, releaseBatch, .{ &pool, buffers[0..96] })).join();
+
+    // Concurrent churn across size classes
+    var results = [_]?anyerror{null} ** 4;
+    var threads: [4]std.Thread = undefined;
+    for (&threads, &results, 0..) |*thread, *slot, i| {
+        thread.* = try std.Thread.spawn(.{}, churn, .{ &pool, i, slot });
+    }
+    for (threads) |thread| thread.join();
+    for (results) |slot| try std.testing.expectEqual(@as(?anyerror, null), slot);
+    try std.testing.expect(pool.stats().hitRate() > 0.5);
+}
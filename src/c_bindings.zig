@@ -7,7 +7,10 @@
 //! All exported functions follow C calling conventions and memory safety rules:
 //! - Returned pointers are valid until freed with corresponding free function
 //! - String lifetimes are documented for each function
-//! - Error codes are returned as i32 with 0 = success
+//! - Error codes are returned as i32 with 0 = success and failures negated
+//!   (e.g. -ERROR_TIMEOUT); count-returning calls return the count on success
+//! - Clients expose their socket descriptor and a non-blocking read/batch-send
+//!   API so one event-loop thread can multiplex many sessions
 
 const std = @import("std");
 const protocol = @import("protocol.zig");
@@ -16,6 +19,8 @@ const screen = @import("screen.zig");
 const field = @import("field.zig");
 const ebcdic = @import("ebcdic.zig");
 const parser = @import("parser.zig");
+const screen_waiter = @import("screen_waiter.zig");
+const read_modified = @import("read_modified.zig");
 
 // ============================================================================
 // Error Codes (for C compatibility)
@@ -29,6 +34,12 @@ pub const ERROR_PARSE_ERROR = 4;
 pub const ERROR_INVALID_STATE = 5;
 pub const ERROR_TIMEOUT = 6;
 pub const ERROR_FIELD_NOT_FOUND = 7;
+pub const ERROR_WOULD_BLOCK = 8;
+
+/// Failures are reported to C as the negated error code
+fn fail(code: i32) i32 {
+    return -code;
+}
 
 // ============================================================================
 // Opaque Types (Hide implementation from C)
@@ -44,6 +55,50 @@ pub const TN3270Parser = opaque {};
 
 pub const TN3270String = opaque {};
 
+pub const TN3270Waiter = opaque {};
+
+/// How long `zig3270_client_connect` waits for the host's negotiation
+const negotiation_timeout_ms: i32 = 5000;
+
+/// Backing state for a `TN3270Client` handle
+const ClientHandle = struct {
+    host: []u8,
+    inner: client.Client,
+};
+
+/// Backing state for a `TN3270Screen` handle
+const ScreenHandle = struct {
+    inner: screen.Screen,
+    cursor: u16 = 0,
+};
+
+/// Fired-predicate callback as seen from C
+pub const TN3270WaiterCallback = *const fn (user_data: ?*anyopaque, id: u32) callconv(.c) void;
+
+/// Backing state for a `TN3270Waiter` handle
+const WaiterHandle = struct {
+    screen: *ScreenHandle,
+    inner: screen_waiter.ScreenWaiter,
+    callback: ?TN3270WaiterCallback = null,
+    user_data: ?*anyopaque = null,
+};
+
+fn client_from(ptr: *TN3270Client) *ClientHandle {
+    return @ptrCast(@alignCast(ptr));
+}
+
+fn screen_from(ptr: *TN3270Screen) *ScreenHandle {
+    return @ptrCast(@alignCast(ptr));
+}
+
+fn fields_from(ptr: *TN3270FieldManager) *field.FieldManager {
+    return @ptrCast(@alignCast(ptr));
+}
+
+fn waiter_from(ptr: *TN3270Waiter) *WaiterHandle {
+    return @ptrCast(@alignCast(ptr));
+}
+
 // ============================================================================
 // Protocol Types (C-compatible structs)
 // ============================================================================
@@ -54,18 +109,16 @@ pub const TN3270Address = extern struct {
     col: u8,
 };
 
-/// C-compatible representation of field attribute
+/// C-compatible representation of field attribute.
+/// Bit layout matches `protocol.FieldAttribute`: bit 0 protected,
+/// bit 1 numeric, bit 2 hidden, bit 3 intensified.
 pub const TN3270FieldAttr = extern struct {
-    protected: u1,
-    numeric: u1,
-    hidden: u1,
-    intensity: u1,
-    reserved: u4,
+    value: u8,
 };
 
 /// C-compatible representation of command code
-pub const TN3270CommandCode = extern enum(u8) {
-    WriteStructuredField = 0x01,
+pub const TN3270CommandCode = enum(u8) {
+    WriteStructuredField = 0x11,
     EraseWrite = 0x05,
     EraseWriteAlternate = 0x0d,
     Write = 0x01,
@@ -75,7 +128,6 @@ pub const TN3270CommandCode = extern enum(u8) {
     ReadModifiedAll = 0x6e,
     SearchForString = 0x34,
     SelectiveEraseWrite = 0x80,
-    EraseWrite3270 = 0x05,
     _,
 };
 
@@ -84,31 +136,41 @@ pub const TN3270Position = extern struct {
     offset: u16,
 };
 
+/// Caller-owned buffer descriptor used by batched send
+pub const TN3270Buffer = extern struct {
+    data: [*]const u8,
+    len: usize,
+};
+
 // ============================================================================
 // Memory Management
 // ============================================================================
 
+var c_gpa = std.heap.GeneralPurposeAllocator(.{ .thread_safe = true }){};
 var c_allocator: std.mem.Allocator = undefined;
-var c_allocator_initialized: bool = false;
+// Handles may be created from several threads at once (e.g. Python
+// workers, which call in with the GIL released)
+var c_allocator_once = std.once(set_c_allocator);
+
+fn set_c_allocator() void {
+    c_allocator = c_gpa.allocator();
+}
 
 fn init_c_allocator() void {
-    if (!c_allocator_initialized) {
-        var gpa = std.heap.GeneralPurposeAllocator(.{}){};
-        c_allocator = gpa.allocator();
-        c_allocator_initialized = true;
-    }
+    c_allocator_once.call();
 }
 
 /// Allocate memory (C-compatible)
 pub export fn zig3270_malloc(size: usize) ?[*]u8 {
     init_c_allocator();
-    const bytes = c_allocator.allocWithOptions(u8, size, @alignOf(u8), null) catch return null;
+    const bytes = c_allocator.alloc(u8, size) catch return null;
     return bytes.ptr;
 }
 
 /// Free memory (C-compatible)
 pub export fn zig3270_free(ptr: ?[*]u8, size: usize) void {
     if (ptr) |p| {
+        init_c_allocator();
         c_allocator.free(p[0..size]);
     }
 }
@@ -128,6 +190,7 @@ pub fn make_c_string(allocator: std.mem.Allocator, slice: []const u8) ![]u8 {
 /// Free a C string
 pub export fn zig3270_string_free(str: ?[*:0]u8) void {
     if (str) |s| {
+        init_c_allocator();
         const len = std.mem.len(s);
         c_allocator.free(s[0 .. len + 1]);
     }
@@ -139,12 +202,12 @@ pub export fn zig3270_string_free(str: ?[*:0]u8) void {
 
 /// Convert EBCDIC byte to ASCII
 pub export fn zig3270_ebcdic_decode_byte(ebcdic_byte: u8) u8 {
-    return ebcdic.decode_byte(ebcdic_byte);
+    return ebcdic.Ebcdic.decode_byte(ebcdic_byte);
 }
 
 /// Convert ASCII byte to EBCDIC
 pub export fn zig3270_ebcdic_encode_byte(ascii_byte: u8) i32 {
-    return ebcdic.encode_byte(ascii_byte) catch -1;
+    return ebcdic.Ebcdic.encode_byte(ascii_byte) catch -1;
 }
 
 /// Decode EBCDIC buffer to ASCII
@@ -154,10 +217,9 @@ pub export fn zig3270_ebcdic_decode(
     ascii_buf: [*]u8,
     ascii_len: usize,
 ) i32 {
-    init_c_allocator();
     const ebcdic_slice = ebcdic_buf[0..ebcdic_len];
     const ascii_slice = ascii_buf[0..ascii_len];
-    const result = ebcdic.decode(ebcdic_slice, ascii_slice) catch return ERROR_INVALID_ARG;
+    const result = ebcdic.Ebcdic.decode(ebcdic_slice, ascii_slice) catch return fail(ERROR_INVALID_ARG);
     return @intCast(result);
 }
 
@@ -168,10 +230,9 @@ pub export fn zig3270_ebcdic_encode(
     ebcdic_buf: [*]u8,
     ebcdic_len: usize,
 ) i32 {
-    init_c_allocator();
     const ascii_slice = ascii_buf[0..ascii_len];
     const ebcdic_slice = ebcdic_buf[0..ebcdic_len];
-    const result = ebcdic.encode(ascii_slice, ebcdic_slice) catch return ERROR_INVALID_ARG;
+    const result = ebcdic.Ebcdic.encode(ascii_slice, ebcdic_slice) catch return fail(ERROR_INVALID_ARG);
     return @intCast(result);
 }
 
@@ -179,37 +240,62 @@ pub export fn zig3270_ebcdic_encode(
 // Client Functions
 // ============================================================================
 
-/// Create a new TN3270 client
+/// Map client errors onto C error codes
+fn client_error_code(err: anyerror) i32 {
+    return switch (err) {
+        error.NotConnected => fail(ERROR_INVALID_STATE),
+        error.WouldBlock => fail(ERROR_WOULD_BLOCK),
+        error.ReadTimeout, error.WriteTimeout => fail(ERROR_TIMEOUT),
+        error.OutOfMemory => fail(ERROR_OUT_OF_MEMORY),
+        error.InvalidAddress => fail(ERROR_INVALID_ARG),
+        else => fail(ERROR_CONNECTION_FAILED),
+    };
+}
+
+/// Create a new TN3270 client. The host string is copied.
 pub export fn zig3270_client_new(
     host: [*:0]const u8,
     port: u16,
-) i32 {
+) ?*TN3270Client {
     init_c_allocator();
-    _ = host;
-    _ = port;
-    // TODO: Implement when client.zig is refactored for FFI
-    return ERROR_SUCCESS;
-}
-
-/// Free a TN3270 client
+    const handle = c_allocator.create(ClientHandle) catch return null;
+    const host_copy = c_allocator.dupe(u8, std.mem.span(host)) catch {
+        c_allocator.destroy(handle);
+        return null;
+    };
+    handle.* = .{
+        .host = host_copy,
+        .inner = client.Client.init(c_allocator, host_copy, port),
+    };
+    return @ptrCast(handle);
+}
+
+/// Free a TN3270 client, disconnecting it first if needed
 pub export fn zig3270_client_free(client_ptr: ?*TN3270Client) void {
     if (client_ptr) |c| {
-        init_c_allocator();
-        c_allocator.destroy(c);
+        const handle = client_from(c);
+        if (handle.inner.connected) handle.inner.disconnect();
+        c_allocator.free(handle.host);
+        c_allocator.destroy(handle);
     }
 }
 
-/// Connect to a mainframe
+/// Connect to a mainframe (blocking connect and telnet negotiation)
 pub export fn zig3270_client_connect(client_ptr: *TN3270Client) i32 {
-    _ = client_ptr;
-    // TODO: Implement
+    const handle = client_from(client_ptr);
+    if (handle.inner.connected) return fail(ERROR_INVALID_STATE);
+    handle.inner.connect_negotiated(negotiation_timeout_ms) catch |err| {
+        if (handle.inner.connected) handle.inner.disconnect();
+        return client_error_code(err);
+    };
     return ERROR_SUCCESS;
 }
 
 /// Disconnect from mainframe
 pub export fn zig3270_client_disconnect(client_ptr: *TN3270Client) i32 {
-    _ = client_ptr;
-    // TODO: Implement
+    const handle = client_from(client_ptr);
+    if (!handle.inner.connected) return fail(ERROR_INVALID_STATE);
+    handle.inner.disconnect();
     return ERROR_SUCCESS;
 }
 
@@ -219,55 +305,125 @@ pub export fn zig3270_client_send_command(
     command: [*]const u8,
     command_len: usize,
 ) i32 {
-    _ = client_ptr;
-    _ = command;
-    _ = command_len;
-    // TODO: Implement
+    const handle = client_from(client_ptr);
+    handle.inner.send(command[0..command_len]) catch |err| return client_error_code(err);
     return ERROR_SUCCESS;
 }
 
-/// Read response from mainframe (blocking)
+/// Read response from mainframe (blocking, bounded by timeout_ms; 0 = no timeout)
 pub export fn zig3270_client_read_response(
     client_ptr: *TN3270Client,
     buffer: [*]u8,
     buffer_len: usize,
     timeout_ms: u32,
 ) i32 {
-    _ = client_ptr;
-    _ = buffer;
-    _ = buffer_len;
-    _ = timeout_ms;
-    // TODO: Implement
+    const handle = client_from(client_ptr);
+    const wait_ms: i32 = if (timeout_ms == 0) -1 else @intCast(@min(timeout_ms, std.math.maxInt(i32)));
+    const ready = handle.inner.wait_readable(wait_ms) catch |err| return client_error_code(err);
+    if (!ready) return fail(ERROR_TIMEOUT);
+    return client_read(handle, buffer[0..buffer_len]);
+}
+
+/// Socket descriptor for poll/epoll/kqueue registration, or negative error
+pub export fn zig3270_client_get_fd(client_ptr: *TN3270Client) i32 {
+    const handle = client_from(client_ptr);
+    const fd = handle.inner.socket_fd() orelse return fail(ERROR_INVALID_STATE);
+    return @intCast(fd);
+}
+
+/// Toggle non-blocking mode on a connected client
+pub export fn zig3270_client_set_nonblocking(client_ptr: *TN3270Client, enabled: bool) i32 {
+    const handle = client_from(client_ptr);
+    handle.inner.set_nonblocking(enabled) catch |err| return client_error_code(err);
     return ERROR_SUCCESS;
 }
 
+/// Read pending host data into a caller-owned buffer without waiting
+/// (in non-blocking mode). Returns bytes read or a negative error code;
+/// `-ERROR_WOULD_BLOCK` means nothing is pending yet.
+pub export fn zig3270_client_read_into(
+    client_ptr: *TN3270Client,
+    buffer: [*]u8,
+    buffer_len: usize,
+) i32 {
+    return client_read(client_from(client_ptr), buffer[0..buffer_len]);
+}
+
+/// Send several caller-owned buffers with vectored writes. Returns bytes
+/// written, which may be short in non-blocking mode, or a negative error code.
+pub export fn zig3270_client_send_batch(
+    client_ptr: *TN3270Client,
+    buffers: [*]const TN3270Buffer,
+    buffer_count: usize,
+) i32 {
+    const handle = client_from(client_ptr);
+    var slices: [client.Client.max_batch_buffers][]const u8 = undefined;
+    var total_written: usize = 0;
+    var index: usize = 0;
+
+    while (index < buffer_count) {
+        const chunk_count = @min(buffer_count - index, slices.len);
+        var chunk_len: usize = 0;
+        for (0..chunk_count) |i| {
+            const buf = buffers[index + i];
+            slices[i] = buf.data[0..buf.len];
+            chunk_len += buf.len;
+        }
+
+        const written = handle.inner.send_batch(slices[0..chunk_count]) catch |err| {
+            if (total_written > 0) break;
+            return client_error_code(err);
+        };
+        total_written += written;
+        if (written < chunk_len) break;
+        index += chunk_count;
+    }
+
+    return @intCast(@min(total_written, std.math.maxInt(i32)));
+}
+
+fn client_read(handle: *ClientHandle, buffer: []u8) i32 {
+    const capped = buffer[0..@min(buffer.len, std.math.maxInt(i32))];
+    const bytes_read = handle.inner.read_into(capped) catch |err| return client_error_code(err);
+    return @intCast(bytes_read);
+}
+
 // ============================================================================
 // Screen Functions
 // ============================================================================
 
-/// Create a new screen
-pub export fn zig3270_screen_new() i32 {
+/// Create a new 24x80 screen
+pub export fn zig3270_screen_new() ?*TN3270Screen {
     init_c_allocator();
-    // TODO: Implement
-    return ERROR_SUCCESS;
+    const handle = c_allocator.create(ScreenHandle) catch return null;
+    handle.* = .{
+        .inner = screen.Screen.init(c_allocator, 24, 80) catch {
+            c_allocator.destroy(handle);
+            return null;
+        },
+    };
+    return @ptrCast(handle);
 }
 
 /// Free a screen
 pub export fn zig3270_screen_free(screen_ptr: ?*TN3270Screen) void {
     if (screen_ptr) |s| {
-        init_c_allocator();
-        c_allocator.destroy(s);
+        const handle = screen_from(s);
+        handle.inner.deinit();
+        c_allocator.destroy(handle);
     }
 }
 
 /// Clear screen
 pub export fn zig3270_screen_clear(screen_ptr: *TN3270Screen) i32 {
-    _ = screen_ptr;
-    // TODO: Implement
+    const handle = screen_from(screen_ptr);
+    handle.inner.clear();
+    handle.cursor = 0;
     return ERROR_SUCCESS;
 }
 
-/// Write text to screen at position
+/// Write text to screen at position, wrapping across rows.
+/// The cursor is left after the last character written.
 pub export fn zig3270_screen_write(
     screen_ptr: *TN3270Screen,
     row: u8,
@@ -275,16 +431,22 @@ pub export fn zig3270_screen_write(
     text: [*]const u8,
     text_len: usize,
 ) i32 {
-    _ = screen_ptr;
-    _ = row;
-    _ = col;
-    _ = text;
-    _ = text_len;
-    // TODO: Implement
+    const handle = screen_from(screen_ptr);
+    const scr = &handle.inner;
+    if (row >= scr.rows or col >= scr.cols) return fail(ERROR_INVALID_ARG);
+
+    const size = @as(usize, scr.rows) * scr.cols;
+    const start = @as(usize, row) * scr.cols + col;
+    if (text_len > size - start) return fail(ERROR_INVALID_ARG);
+
+    _ = scr.write_run(@intCast(start), text[0..text_len]);
+    scr.mark_modified(start, text_len);
+    handle.cursor = @intCast((start + text_len) % size);
     return ERROR_SUCCESS;
 }
 
-/// Read text from screen at position
+/// Read text from screen at position, wrapping across rows.
+/// Returns the number of bytes copied into buffer.
 pub export fn zig3270_screen_read(
     screen_ptr: *TN3270Screen,
     row: u8,
@@ -292,28 +454,79 @@ pub export fn zig3270_screen_read(
     buffer: [*]u8,
     buffer_len: usize,
 ) i32 {
-    _ = screen_ptr;
-    _ = row;
-    _ = col;
-    _ = buffer;
-    _ = buffer_len;
-    // TODO: Implement
-    return ERROR_SUCCESS;
+    const handle = screen_from(screen_ptr);
+    const scr = &handle.inner;
+    if (row >= scr.rows or col >= scr.cols) return fail(ERROR_INVALID_ARG);
+
+    const size = @as(usize, scr.rows) * scr.cols;
+    const start = @as(usize, row) * scr.cols + col;
+    const count = @min(buffer_len, size - start);
+
+    @memcpy(buffer[0..count], scr.buffer[start..][0..count]);
+    return @intCast(count);
 }
 
-/// Get screen as string (allocates memory)
+/// Get screen as string, one line per row (free with zig3270_string_free)
 pub export fn zig3270_screen_to_string(screen_ptr: *TN3270Screen) ?[*:0]u8 {
-    _ = screen_ptr;
-    init_c_allocator();
-    // TODO: Implement
-    return null;
+    const scr = &screen_from(screen_ptr).inner;
+    const line_len = @as(usize, scr.cols) + 1;
+    const result = c_allocator.allocSentinel(u8, line_len * scr.rows, 0) catch return null;
+
+    for (0..scr.rows) |r| {
+        const line = result[r * line_len ..][0..line_len];
+        @memcpy(line[0..scr.cols], scr.row_slice(@intCast(r)));
+        // NUL cells would truncate the C string
+        std.mem.replaceScalar(u8, line[0..scr.cols], 0, ' ');
+        line[scr.cols] = '\n';
+    }
+    return result.ptr;
+}
+
+/// Borrow the character plane (row-major, rows * cols bytes) without
+/// copying. The view stays valid until the screen is freed and reflects
+/// later writes.
+pub export fn zig3270_screen_buffer(screen_ptr: *TN3270Screen, out: *TN3270Buffer) i32 {
+    const scr = &screen_from(screen_ptr).inner;
+    out.* = .{ .data = scr.buffer.ptr, .len = scr.buffer.len };
+    return ERROR_SUCCESS;
+}
+
+/// Current change generation; it moves only when the screen is written,
+/// so callers can skip re-reading an unchanged screen
+pub export fn zig3270_screen_generation(screen_ptr: *TN3270Screen) u32 {
+    return screen_from(screen_ptr).inner.current_generation();
 }
 
 /// Get current cursor position
 pub export fn zig3270_screen_get_cursor(screen_ptr: *TN3270Screen, addr: *TN3270Address) i32 {
-    _ = screen_ptr;
-    _ = addr;
-    // TODO: Implement
+    const handle = screen_from(screen_ptr);
+    addr.* = .{
+        .row = @intCast(handle.cursor / handle.inner.cols),
+        .col = @intCast(handle.cursor % handle.inner.cols),
+    };
+    return ERROR_SUCCESS;
+}
+
+/// Encode the Read Modified reply for an AID key into a caller buffer
+pub export fn zig3270_screen_read_modified(
+    screen_ptr: *TN3270Screen,
+    fields_ptr: *TN3270FieldManager,
+    aid: u8,
+    read_all: bool,
+    buffer: [*]u8,
+    buffer_len: usize,
+) i32 {
+    const handle = screen_from(screen_ptr);
+    const key = std.meta.intToEnum(protocol.Aid, aid) catch return fail(ERROR_INVALID_ARG);
+    var out = std.Io.Writer.fixed(buffer[0..@min(buffer_len, std.math.maxInt(i32))]);
+    read_modified.encode(&out, &handle.inner, fields_from(fields_ptr), key, handle.cursor, .{ .read_all = read_all }) catch
+        return fail(ERROR_INVALID_ARG);
+    return @intCast(out.end);
+}
+
+/// Clear all modified data tags, e.g. after sending a Read Modified reply
+pub export fn zig3270_screen_reset_modified(screen_ptr: *TN3270Screen) i32 {
+    screen_from(screen_ptr).inner.reset_modified();
     return ERROR_SUCCESS;
 }
 
@@ -322,17 +535,19 @@ pub export fn zig3270_screen_get_cursor(screen_ptr: *TN3270Screen, addr: *TN3270
 // ============================================================================
 
 /// Create a new field manager
-pub export fn zig3270_fields_new() i32 {
+pub export fn zig3270_fields_new() ?*TN3270FieldManager {
     init_c_allocator();
-    // TODO: Implement
-    return ERROR_SUCCESS;
+    const manager = c_allocator.create(field.FieldManager) catch return null;
+    manager.* = field.FieldManager.init(c_allocator);
+    return @ptrCast(manager);
 }
 
 /// Free field manager
 pub export fn zig3270_fields_free(fields_ptr: ?*TN3270FieldManager) void {
     if (fields_ptr) |f| {
-        init_c_allocator();
-        c_allocator.destroy(f);
+        const manager = fields_from(f);
+        manager.deinit();
+        c_allocator.destroy(manager);
     }
 }
 
@@ -343,19 +558,16 @@ pub export fn zig3270_fields_add(
     length: u16,
     attr: TN3270FieldAttr,
 ) i32 {
-    _ = fields_ptr;
-    _ = offset;
-    _ = length;
-    _ = attr;
-    // TODO: Implement
+    if (offset >= 1920 or length == 0) return fail(ERROR_INVALID_ARG);
+    const manager = fields_from(fields_ptr);
+    const attribute: protocol.FieldAttribute = @bitCast(attr.value);
+    _ = manager.add_field(offset, length, attribute) catch return fail(ERROR_OUT_OF_MEMORY);
     return ERROR_SUCCESS;
 }
 
 /// Get field count
 pub export fn zig3270_fields_count(fields_ptr: *TN3270FieldManager) u32 {
-    _ = fields_ptr;
-    // TODO: Implement
-    return 0;
+    return @intCast(fields_from(fields_ptr).count());
 }
 
 /// Get field by index
@@ -365,14 +577,138 @@ pub export fn zig3270_fields_get(
     offset: *u16,
     length: *u16,
 ) i32 {
-    _ = fields_ptr;
-    _ = index;
-    _ = offset;
-    _ = length;
-    // TODO: Implement
+    const f = fields_from(fields_ptr).get_field(index) orelse return fail(ERROR_FIELD_NOT_FOUND);
+    offset.* = f.start_address;
+    length.* = f.length;
     return ERROR_SUCCESS;
 }
 
+// ============================================================================
+// Screen Waiter Functions
+// ============================================================================
+
+/// Create a waiter on a screen; predicates on fields need `fields_ptr`
+pub export fn zig3270_waiter_new(screen_ptr: *TN3270Screen, fields_ptr: ?*TN3270FieldManager) ?*TN3270Waiter {
+    init_c_allocator();
+    const handle = c_allocator.create(WaiterHandle) catch return null;
+    const scr = screen_from(screen_ptr);
+    handle.* = .{
+        .screen = scr,
+        .inner = screen_waiter.ScreenWaiter.init(c_allocator, &scr.inner, if (fields_ptr) |f| fields_from(f) else null),
+    };
+    handle.inner.notify = .{ .context = handle, .func = waiter_notify };
+    return @ptrCast(handle);
+}
+
+/// Free a waiter; its screen and field manager stay alive
+pub export fn zig3270_waiter_free(waiter_ptr: ?*TN3270Waiter) void {
+    if (waiter_ptr) |w| {
+        const handle = waiter_from(w);
+        handle.inner.deinit();
+        c_allocator.destroy(handle);
+    }
+}
+
+fn waiter_notify(context: ?*anyopaque, id: screen_waiter.PredicateId) void {
+    const handle: *WaiterHandle = @ptrCast(@alignCast(context.?));
+    if (handle.callback) |callback| callback(handle.user_data, id);
+}
+
+fn waiter_add(handle: *WaiterHandle, predicate: screen_waiter.Predicate, id: *u32) i32 {
+    id.* = handle.inner.add(predicate) catch |err| return switch (err) {
+        error.OutOfMemory => fail(ERROR_OUT_OF_MEMORY),
+        else => fail(ERROR_INVALID_ARG),
+    };
+    return ERROR_SUCCESS;
+}
+
+/// Wait for `text` at row/col
+pub export fn zig3270_waiter_add_text_at(
+    waiter_ptr: *TN3270Waiter,
+    row: u8,
+    col: u8,
+    text: [*]const u8,
+    text_len: usize,
+    id: *u32,
+) i32 {
+    const handle = waiter_from(waiter_ptr);
+    const scr = &handle.screen.inner;
+    if (row >= scr.rows or col >= scr.cols or text_len == 0) return fail(ERROR_INVALID_ARG);
+    const address: u16 = @intCast(@as(usize, row) * scr.cols + col);
+    return waiter_add(handle, .{ .text_at = .{ .address = address, .text = text[0..text_len] } }, id);
+}
+
+/// Wait for any of `count` strings anywhere on the screen
+pub export fn zig3270_waiter_add_any_of(
+    waiter_ptr: *TN3270Waiter,
+    strings: [*]const TN3270Buffer,
+    count: usize,
+    id: *u32,
+) i32 {
+    if (count == 0 or count > 64) return fail(ERROR_INVALID_ARG);
+    var slices: [64][]const u8 = undefined;
+    for (strings[0..count], slices[0..count]) |buffer, *slice| {
+        if (buffer.len == 0) return fail(ERROR_INVALID_ARG);
+        slice.* = buffer.data[0..buffer.len];
+    }
+    return waiter_add(waiter_from(waiter_ptr), .{ .any_text = slices[0..count] }, id);
+}
+
+/// Wait for the cursor to enter the field starting at `field_offset`
+pub export fn zig3270_waiter_add_cursor_in_field(waiter_ptr: *TN3270Waiter, field_offset: u16, id: *u32) i32 {
+    const handle = waiter_from(waiter_ptr);
+    if (handle.inner.fields == null) return fail(ERROR_INVALID_STATE);
+    return waiter_add(handle, .{ .cursor_in_field = field_offset }, id);
+}
+
+/// Wait for the keyboard to be unlocked
+pub export fn zig3270_waiter_add_keyboard_unlocked(waiter_ptr: *TN3270Waiter, id: *u32) i32 {
+    return waiter_add(waiter_from(waiter_ptr), .keyboard_unlocked, id);
+}
+
+/// Drop a predicate that has not fired
+pub export fn zig3270_waiter_remove(waiter_ptr: *TN3270Waiter, id: u32) i32 {
+    waiter_from(waiter_ptr).inner.remove(id);
+    return ERROR_SUCCESS;
+}
+
+/// Report the keyboard state (lock when an AID key is sent)
+pub export fn zig3270_waiter_set_keyboard_locked(waiter_ptr: *TN3270Waiter, locked: bool) i32 {
+    waiter_from(waiter_ptr).inner.set_keyboard_locked(locked);
+    return ERROR_SUCCESS;
+}
+
+/// Evaluate predicates against screen cells changed since the last check
+pub export fn zig3270_waiter_check(waiter_ptr: *TN3270Waiter) i32 {
+    const handle = waiter_from(waiter_ptr);
+    handle.inner.check(handle.screen.cursor) catch return fail(ERROR_OUT_OF_MEMORY);
+    return ERROR_SUCCESS;
+}
+
+/// Run `callback` for each predicate that fires
+pub export fn zig3270_waiter_set_callback(
+    waiter_ptr: *TN3270Waiter,
+    callback: ?TN3270WaiterCallback,
+    user_data: ?*anyopaque,
+) i32 {
+    const handle = waiter_from(waiter_ptr);
+    handle.callback = callback;
+    handle.user_data = user_data;
+    return ERROR_SUCCESS;
+}
+
+/// Descriptor that polls readable while fired ids are waiting
+pub export fn zig3270_waiter_get_fd(waiter_ptr: *TN3270Waiter) i32 {
+    const fd = waiter_from(waiter_ptr).inner.wait_fd() catch return fail(ERROR_OUT_OF_MEMORY);
+    return @intCast(fd);
+}
+
+/// Copy out fired predicate ids, oldest first; returns the count
+pub export fn zig3270_waiter_take_fired(waiter_ptr: *TN3270Waiter, ids: [*]u32, max_ids: usize) i32 {
+    const count = waiter_from(waiter_ptr).inner.take_fired(ids[0..@min(max_ids, std.math.maxInt(i32))]);
+    return @intCast(count);
+}
+
 // ============================================================================
 // Version & Info
 // ============================================================================
@@ -435,8 +771,118 @@ test "memory allocation C bindings" {
 
 test "version functions" {
     const version = zig3270_version();
-    try std.testing.expect(version != null);
+    try std.testing.expect(std.mem.len(version) > 0);
 
     const proto = zig3270_protocol_version();
-    try std.testing.expect(proto != null);
+    try std.testing.expect(std.mem.len(proto) > 0);
+}
+
+test "client handle lifecycle C bindings" {
+    const handle = zig3270_client_new("127.0.0.1", 3270) orelse return error.TestUnexpectedResult;
+    defer zig3270_client_free(handle);
+
+    var buffer: [16]u8 = undefined;
+    try std.testing.expectEqual(fail(ERROR_INVALID_STATE), zig3270_client_get_fd(handle));
+    try std.testing.expectEqual(fail(ERROR_INVALID_STATE), zig3270_client_read_into(handle, &buffer, buffer.len));
+    try std.testing.expectEqual(fail(ERROR_INVALID_STATE), zig3270_client_disconnect(handle));
+
+    const batch = [_]TN3270Buffer{.{ .data = "AB", .len = 2 }};
+    try std.testing.expectEqual(fail(ERROR_INVALID_STATE), zig3270_client_send_batch(handle, &batch, batch.len));
+}
+
+test "screen handle C bindings" {
+    const handle = zig3270_screen_new() orelse return error.TestUnexpectedResult;
+    defer zig3270_screen_free(handle);
+
+    try std.testing.expectEqual(@as(i32, ERROR_SUCCESS), zig3270_screen_write(handle, 1, 78, "ABC", 3));
+
+    var buffer: [3]u8 = undefined;
+    try std.testing.expectEqual(@as(i32, 3), zig3270_screen_read(handle, 1, 78, &buffer, buffer.len));
+    try std.testing.expectEqualStrings("ABC", &buffer);
+
+    var cursor: TN3270Address = undefined;
+    _ = zig3270_screen_get_cursor(handle, &cursor);
+    try std.testing.expectEqual(@as(u8, 2), cursor.row);
+    try std.testing.expectEqual(@as(u8, 1), cursor.col);
+
+    const text = zig3270_screen_to_string(handle) orelse return error.TestUnexpectedResult;
+    defer zig3270_string_free(text);
+    try std.testing.expectEqual(@as(usize, 24 * 81), std.mem.len(text));
+    try std.testing.expectEqual(@as(u8, 'C'), text[2 * 81]);
+
+    try std.testing.expectEqual(fail(ERROR_INVALID_ARG), zig3270_screen_write(handle, 24, 0, "X", 1));
+
+    // The borrowed plane is live: later writes show through it
+    var plane: TN3270Buffer = undefined;
+    try std.testing.expectEqual(@as(i32, ERROR_SUCCESS), zig3270_screen_buffer(handle, &plane));
+    try std.testing.expectEqual(@as(usize, 24 * 80), plane.len);
+    try std.testing.expectEqualStrings("ABC", plane.data[80 + 78 ..][0..3]);
+
+    const generation = zig3270_screen_generation(handle);
+    try std.testing.expectEqual(generation, zig3270_screen_generation(handle));
+    _ = zig3270_screen_write(handle, 0, 0, "Z", 1);
+    try std.testing.expect(zig3270_screen_generation(handle) != generation);
+    try std.testing.expectEqual(@as(u8, 'Z'), plane.data[0]);
+}
+
+test "field manager handle C bindings" {
+    const handle = zig3270_fields_new() orelse return error.TestUnexpectedResult;
+    defer zig3270_fields_free(handle);
+
+    try std.testing.expectEqual(@as(i32, ERROR_SUCCESS), zig3270_fields_add(handle, 80, 10, .{ .value = 0x01 }));
+    try std.testing.expectEqual(@as(u32, 1), zig3270_fields_count(handle));
+
+    var offset: u16 = 0;
+    var length: u16 = 0;
+    try std.testing.expectEqual(@as(i32, ERROR_SUCCESS), zig3270_fields_get(handle, 0, &offset, &length));
+    try std.testing.expectEqual(@as(u16, 80), offset);
+    try std.testing.expectEqual(@as(u16, 10), length);
+    try std.testing.expectEqual(fail(ERROR_FIELD_NOT_FOUND), zig3270_fields_get(handle, 1, &offset, &length));
+}
+
+test "screen waiter C bindings" {
+    const scr = zig3270_screen_new() orelse return error.TestUnexpectedResult;
+    defer zig3270_screen_free(scr);
+    const waiter = zig3270_waiter_new(scr, null) orelse return error.TestUnexpectedResult;
+    defer zig3270_waiter_free(waiter);
+
+    const Seen = struct {
+        fn on_fire(user_data: ?*anyopaque, id: u32) callconv(.c) void {
+            const last: *u32 = @ptrCast(@alignCast(user_data.?));
+            last.* = id;
+        }
+    };
+    var last: u32 = 0;
+    _ = zig3270_waiter_set_callback(waiter, Seen.on_fire, &last);
+
+    var ready: u32 = 0;
+    const strings = [_]TN3270Buffer{ .{ .data = "READY", .len = 5 }, .{ .data = "ABEND", .len = 5 } };
+    try std.testing.expectEqual(@as(i32, ERROR_SUCCESS), zig3270_waiter_add_any_of(waiter, &strings, strings.len, &ready));
+    var unused: u32 = 0;
+    try std.testing.expectEqual(fail(ERROR_INVALID_STATE), zig3270_waiter_add_cursor_in_field(waiter, 0, &unused));
+
+    _ = zig3270_screen_write(scr, 3, 10, "READY", 5);
+    try std.testing.expectEqual(@as(i32, ERROR_SUCCESS), zig3270_waiter_check(waiter));
+    try std.testing.expectEqual(ready, last);
+
+    var ids: [4]u32 = undefined;
+    try std.testing.expectEqual(@as(i32, 1), zig3270_waiter_take_fired(waiter, &ids, ids.len));
+    try std.testing.expectEqual(ready, ids[0]);
+}
+
+test "read modified C bindings" {
+    const scr = zig3270_screen_new() orelse return error.TestUnexpectedResult;
+    defer zig3270_screen_free(scr);
+    const fields = zig3270_fields_new() orelse return error.TestUnexpectedResult;
+    defer zig3270_fields_free(fields);
+    _ = zig3270_fields_add(fields, 80, 2, .{ .value = 0x00 });
+
+    _ = zig3270_screen_write(scr, 1, 0, "AB", 2);
+    var buffer: [16]u8 = undefined;
+    const written = zig3270_screen_read_modified(scr, fields, 0x7D, false, &buffer, buffer.len);
+    try std.testing.expectEqualSlices(u8, &.{ 0x7D, 0x00, 0x52, 0x11, 0x00, 0x50, 'A', 'B' }, buffer[0..@intCast(written)]);
+
+    _ = zig3270_screen_reset_modified(scr);
+    try std.testing.expectEqual(@as(i32, 3), zig3270_screen_read_modified(scr, fields, 0x7D, false, &buffer, buffer.len));
+    try std.testing.expectEqual(fail(ERROR_INVALID_ARG), zig3270_screen_read_modified(scr, fields, 0x01, false, &buffer, buffer.len));
 }
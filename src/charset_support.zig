@@ -1,4 +1,5 @@
 const std = @import("std");
+const ebcdic = @import("ebcdic.zig");
 
 /// Character set support for TN3270
 /// Supports APL and extended Latin-1 character sets
@@ -40,6 +41,21 @@ const apl_mappings = [_]AplCharacter{
     .{ .ascii_code = 126, .apl_symbol = "⍟", .apl_name = "log" },
 };
 
+/// APL symbol per ASCII code, precomputed from apl_mappings
+const apl_by_ascii: [256]?[]const u8 = blk: {
+    var table = [_]?[]const u8{null} ** 256;
+    for (apl_mappings) |mapping| table[mapping.ascii_code] = mapping.apl_symbol;
+    break :blk table;
+};
+
+/// Every byte value as a one-byte slice, so pass-through results outlive
+/// the call
+const identity: [256]u8 = blk: {
+    var table: [256]u8 = undefined;
+    for (&table, 0..) |*entry, i| entry.* = i;
+    break :blk table;
+};
+
 const latin1_mappings = [_]struct {
     code: u8,
     name: []const u8,
@@ -87,57 +103,65 @@ pub const CharsetConverter = struct {
         };
     }
 
-    /// Convert buffer from source to target charset
+    /// Convert buffer from source to target charset. Sizes the result
+    /// first and allocates once.
     pub fn convert(self: CharsetConverter, input: []const u8) ![]u8 {
-        var output = std.ArrayList(u8).init(self.allocator);
-        defer output.deinit();
+        var len: usize = 0;
+        for (input) |byte| {
+            len += (try self.convert_byte(byte)).len;
+        }
+
+        const output = try self.allocator.alloc(u8, len);
+        errdefer self.allocator.free(output);
+        _ = try self.convert_into(input, output);
+        return output;
+    }
 
+    /// Convert into `output` without allocating; returns bytes written
+    pub fn convert_into(self: CharsetConverter, input: []const u8, output: []u8) !usize {
+        var written: usize = 0;
         for (input) |byte| {
             const converted = try self.convert_byte(byte);
-            if (converted.len > 0) {
-                try output.appendSlice(converted);
-            }
+            if (output.len - written < converted.len) return error.BufferTooSmall;
+            @memcpy(output[written..][0..converted.len], converted);
+            written += converted.len;
         }
-
-        return output.toOwnedSlice();
+        return written;
     }
 
     /// Convert single byte
     pub fn convert_byte(self: CharsetConverter, input: u8) ![]const u8 {
+        const unchanged = identity[input..][0..1];
+
         // No conversion needed for same charset
         if (self.source_set == self.target_set) {
-            return &.{input};
+            return unchanged;
         }
 
         return switch (self.source_set) {
             .ascii => switch (self.target_set) {
                 .apl => try self.ascii_to_apl(input),
-                .latin1 => if (input < 128) &.{input} else return self.handle_unknown_char(),
+                .latin1 => if (input < 128) unchanged else return self.handle_unknown_char(),
                 .ebcdic => return error.EbcdcConversionNotSupported,
-                else => &.{input},
+                else => unchanged,
             },
             .latin1 => switch (self.target_set) {
                 .apl => try self.latin1_to_apl(input),
-                .ascii => if (input < 128) &.{input} else return self.handle_unknown_char(),
+                .ascii => if (input < 128) unchanged else return self.handle_unknown_char(),
                 .ebcdic => return error.EbcdcConversionNotSupported,
-                else => &.{input},
+                else => unchanged,
             },
             .apl => switch (self.target_set) {
                 .ascii => try self.apl_to_ascii(input),
                 .latin1 => try self.apl_to_latin1(input),
-                else => &.{input},
+                else => unchanged,
             },
-            else => &.{input},
+            else => unchanged,
         };
     }
 
     fn ascii_to_apl(self: CharsetConverter, code: u8) ![]const u8 {
-        for (apl_mappings) |mapping| {
-            if (mapping.ascii_code == code) {
-                return mapping.apl_symbol;
-            }
-        }
-        return self.handle_unknown_char();
+        return apl_by_ascii[code] orelse self.handle_unknown_char();
     }
 
     fn latin1_to_apl(self: CharsetConverter, code: u8) ![]const u8 {
@@ -166,6 +190,416 @@ pub const CharsetConverter = struct {
     }
 };
 
+// ============================================================================
+// EBCDIC code pages
+// ============================================================================
+
+/// Table value for bytes or code points a code page does not map
+const unmapped: u16 = 0xFFFF;
+
+/// DBCS shift controls
+pub const shift_out: u8 = 0x0E;
+pub const shift_in: u8 = 0x0F;
+
+/// EBCDIC code pages a session can run in
+pub const Codepage = enum {
+    cp037, // US/Canada
+    cp273, // Germany/Austria
+    cp500, // International
+    cp1047, // Latin-1 open systems (z/OS UNIX)
+    cp930, // Japanese Katakana-Kanji (SBCS + DBCS)
+    cp939, // Japanese Latin-Kanji (SBCS + DBCS)
+
+    /// Whether SO/SI switch the stream into double-byte mode
+    pub fn is_dbcs(self: Codepage) bool {
+        return self == .cp930 or self == .cp939;
+    }
+
+    pub fn name(self: Codepage) []const u8 {
+        return switch (self) {
+            .cp037 => "CP037",
+            .cp273 => "CP273",
+            .cp500 => "CP500",
+            .cp1047 => "CP1047",
+            .cp930 => "CP930",
+            .cp939 => "CP939",
+        };
+    }
+
+    /// Parse "CP037", "cp1047", "IBM-273" or a bare number such as "500"
+    pub fn from_name(text: []const u8) ?Codepage {
+        var digits = text;
+        for ([_][]const u8{ "cp", "ibm-", "ibm" }) |prefix| {
+            if (std.ascii.startsWithIgnoreCase(digits, prefix)) {
+                digits = digits[prefix.len..];
+                break;
+            }
+        }
+        const number = std.fmt.parseInt(u16, digits, 10) catch return null;
+        return switch (number) {
+            37 => .cp037,
+            273 => .cp273,
+            500 => .cp500,
+            1047 => .cp1047,
+            930 => .cp930,
+            939 => .cp939,
+            else => null,
+        };
+    }
+
+    fn sbcs(self: Codepage) *const SbcsTable {
+        return switch (self) {
+            .cp037 => &cp037,
+            .cp273 => &cp273,
+            .cp500 => &cp500,
+            .cp1047 => &cp1047,
+            .cp930 => &cp930_sbcs,
+            .cp939 => &cp939_sbcs,
+        };
+    }
+
+    /// Bulk 1:1 decode to Latin-1 through the vector kernel in ebcdic.zig.
+    /// The Latin code pages map onto Latin-1 exactly; DBCS pages are
+    /// rejected with error.UnsupportedCodepage.
+    pub fn decode_latin1(self: Codepage, input: []const u8, output: []u8) !usize {
+        if (output.len < input.len) return error.BufferTooSmall;
+        switch (self) {
+            inline .cp037, .cp273, .cp500, .cp1047 => |page| {
+                ebcdic.translate(comptime page.sbcs().to_latin1, 16, input, output);
+            },
+            .cp930, .cp939 => return error.UnsupportedCodepage,
+        }
+        return input.len;
+    }
+
+    /// Bulk 1:1 encode from Latin-1; the inverse of `decode_latin1`
+    pub fn encode_latin1(self: Codepage, input: []const u8, output: []u8) !usize {
+        if (output.len < input.len) return error.BufferTooSmall;
+        switch (self) {
+            inline .cp037, .cp273, .cp500, .cp1047 => |page| {
+                ebcdic.translate(comptime page.sbcs().from_latin1, 16, input, output);
+            },
+            .cp930, .cp939 => return error.UnsupportedCodepage,
+        }
+        return input.len;
+    }
+};
+
+/// Byte tables for one single-byte code page
+const SbcsTable = struct {
+    to_unicode: [256]u16,
+    /// Latin-1 code point to EBCDIC byte
+    from_unicode: [256]u16,
+    /// 1:1 tables for the bulk kernel (Latin code pages only)
+    to_latin1: [256]u8,
+    from_latin1: [256]u8,
+
+    fn build(comptime to_unicode: [256]u16) SbcsTable {
+        @setEvalBranchQuota(10000);
+        var table: SbcsTable = .{
+            .to_unicode = to_unicode,
+            .from_unicode = [_]u16{unmapped} ** 256,
+            .to_latin1 = undefined,
+            .from_latin1 = undefined,
+        };
+        for (to_unicode, 0..) |code_point, byte| {
+            if (code_point <= 0xFF) table.from_unicode[code_point] = byte;
+            table.to_latin1[byte] = if (code_point <= 0xFF) code_point else '?';
+        }
+        for (table.from_unicode, 0..) |byte, code_point| {
+            table.from_latin1[code_point] = if (byte == unmapped) 0x6F else byte;
+        }
+        return table;
+    }
+};
+
+/// CP037 as Latin-1 code points, one row per high nibble
+const cp037_latin1 = [256]u8{
+    0x00, 0x01, 0x02, 0x03, 0x9C, 0x09, 0x86, 0x7F, 0x97, 0x8D, 0x8E, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, // 0x00
+    0x10, 0x11, 0x12, 0x13, 0x9D, 0x85, 0x08, 0x87, 0x18, 0x19, 0x92, 0x8F, 0x1C, 0x1D, 0x1E, 0x1F, // 0x10
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x0A, 0x17, 0x1B, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x05, 0x06, 0x07, // 0x20
+    0x90, 0x91, 0x16, 0x93, 0x94, 0x95, 0x96, 0x04, 0x98, 0x99, 0x9A, 0x9B, 0x14, 0x15, 0x9E, 0x1A, // 0x30
+    0x20, 0xA0, 0xE2, 0xE4, 0xE0, 0xE1, 0xE3, 0xE5, 0xE7, 0xF1, 0xA2, 0x2E, 0x3C, 0x28, 0x2B, 0x7C, // 0x40
+    0x26, 0xE9, 0xEA, 0xEB, 0xE8, 0xED, 0xEE, 0xEF, 0xEC, 0xDF, 0x21, 0x24, 0x2A, 0x29, 0x3B, 0xAC, // 0x50
+    0x2D, 0x2F, 0xC2, 0xC4, 0xC0, 0xC1, 0xC3, 0xC5, 0xC7, 0xD1, 0xA6, 0x2C, 0x25, 0x5F, 0x3E, 0x3F, // 0x60
+    0xF8, 0xC9, 0xCA, 0xCB, 0xC8, 0xCD, 0xCE, 0xCF, 0xCC, 0x60, 0x3A, 0x23, 0x40, 0x27, 0x3D, 0x22, // 0x70
+    0xD8, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0xAB, 0xBB, 0xF0, 0xFD, 0xFE, 0xB1, // 0x80
+    0xB0, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 0x70, 0x71, 0x72, 0xAA, 0xBA, 0xE6, 0xB8, 0xC6, 0xA4, // 0x90
+    0xB5, 0x7E, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0xA1, 0xBF, 0xD0, 0xDD, 0xDE, 0xAE, // 0xA0
+    0x5E, 0xA3, 0xA5, 0xB7, 0xA9, 0xA7, 0xB6, 0xBC, 0xBD, 0xBE, 0x5B, 0x5D, 0xAF, 0xA8, 0xB4, 0xD7, // 0xB0
+    0x7B, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0xAD, 0xF4, 0xF6, 0xF2, 0xF3, 0xF5, // 0xC0
+    0x7D, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50, 0x51, 0x52, 0xB9, 0xFB, 0xFC, 0xF9, 0xFA, 0xFF, // 0xD0
+    0x5C, 0xF7, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0xB2, 0xD4, 0xD6, 0xD2, 0xD3, 0xD5, // 0xE0
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0xB3, 0xDB, 0xDC, 0xD9, 0xDA, 0x9F, // 0xF0
+};
+
+/// The other Latin pages are CP037 with national characters moved:
+/// (EBCDIC byte, Latin-1 code point) pairs
+const cp273_changes = [_][2]u8{
+    .{ 0x43, 0x7B }, .{ 0x4A, 0xC4 }, .{ 0x4F, 0x21 }, .{ 0x59, 0x7E },
+    .{ 0x5A, 0xDC }, .{ 0x5F, 0x5E }, .{ 0x63, 0x5B }, .{ 0x6A, 0xF6 },
+    .{ 0x7C, 0xA7 }, .{ 0xA1, 0xDF }, .{ 0xB0, 0xA2 }, .{ 0xB5, 0x40 },
+    .{ 0xBA, 0xAC }, .{ 0xBB, 0x7C }, .{ 0xC0, 0xE4 }, .{ 0xCC, 0xA6 },
+    .{ 0xD0, 0xFC }, .{ 0xDC, 0x7D }, .{ 0xE0, 0xD6 }, .{ 0xEC, 0x5C },
+    .{ 0xFC, 0x5D },
+};
+const cp500_changes = [_][2]u8{
+    .{ 0x4A, 0x5B }, .{ 0x4F, 0x21 }, .{ 0x5A, 0x5D }, .{ 0x5F, 0x5E },
+    .{ 0xB0, 0xA2 }, .{ 0xBA, 0xAC }, .{ 0xBB, 0x7C },
+};
+const cp1047_changes = [_][2]u8{
+    .{ 0x5F, 0x5E }, .{ 0xAD, 0x5B }, .{ 0xB0, 0xAC },
+    .{ 0xBA, 0xDD }, .{ 0xBB, 0xA8 }, .{ 0xBD, 0x5D },
+};
+
+fn latin_page(comptime changes: []const [2]u8) [256]u16 {
+    @setEvalBranchQuota(10000);
+    var table: [256]u16 = undefined;
+    for (cp037_latin1, 0..) |code_point, byte| table[byte] = code_point;
+    for (changes) |change| table[change[0]] = change[1];
+    return table;
+}
+
+/// Single-byte half of the Japanese pages: the ASCII characters every
+/// Latin page above agrees on. CP930's lowercase positions carry
+/// katakana instead, which is not mapped here.
+fn japanese_sbcs(comptime lowercase: bool) [256]u16 {
+    @setEvalBranchQuota(10000);
+    const pages = [_][256]u16{ latin_page(&.{}), latin_page(&cp273_changes), latin_page(&cp500_changes), latin_page(&cp1047_changes) };
+    var table = [_]u16{unmapped} ** 256;
+    for (0..256) |byte| {
+        const code_point = pages[0][byte];
+        const invariant = for (pages[1..]) |page| {
+            if (page[byte] != code_point) break false;
+        } else true;
+        if (!invariant or code_point >= 0x80) continue;
+        if (!lowercase and code_point >= 'a' and code_point <= 'z') continue;
+        table[byte] = code_point;
+    }
+    return table;
+}
+
+const cp037 = SbcsTable.build(latin_page(&.{}));
+const cp273 = SbcsTable.build(latin_page(&cp273_changes));
+const cp500 = SbcsTable.build(latin_page(&cp500_changes));
+const cp1047 = SbcsTable.build(latin_page(&cp1047_changes));
+const cp930_sbcs = SbcsTable.build(japanese_sbcs(false));
+const cp939_sbcs = SbcsTable.build(japanese_sbcs(true));
+
+/// Two-level 16-bit lookup: the high byte of the key selects a 256-entry
+/// page, the low byte an entry. High bytes without mappings share the
+/// empty page 0, so a sparse DBCS ward costs nothing.
+pub const TwoLevelTable = struct {
+    index: [256]u8,
+    pages: []const [256]u16,
+
+    pub fn lookup(self: *const TwoLevelTable, key: u16) ?u16 {
+        const value = self.pages[self.index[key >> 8]][key & 0xFF];
+        return if (value == unmapped) null else value;
+    }
+
+    /// Build from (key, value) pairs at comptime
+    fn build(comptime entries: []const [2]u16) TwoLevelTable {
+        @setEvalBranchQuota(entries.len * 20 + 10000);
+        var index = [_]u8{0} ** 256;
+        var page_count: usize = 1;
+        for (entries) |entry| {
+            if (index[entry[0] >> 8] == 0) {
+                index[entry[0] >> 8] = page_count;
+                page_count += 1;
+            }
+        }
+
+        var pages = [_][256]u16{[_]u16{unmapped} ** 256} ** page_count;
+        for (entries) |entry| pages[index[entry[0] >> 8]][entry[0] & 0xFF] = entry[1];
+
+        const final = pages;
+        return .{ .index = index, .pages = &final };
+    }
+
+    /// Table mapping each value back to its key
+    fn inverse(comptime self: TwoLevelTable) TwoLevelTable {
+        @setEvalBranchQuota(self.pages.len * 256 * 20 + 10000);
+        var entries: [self.pages.len * 256][2]u16 = undefined;
+        var len: usize = 0;
+        for (self.index, 0..) |page, high| {
+            if (page == 0) continue;
+            for (self.pages[page], 0..) |value, low| {
+                if (value == unmapped) continue;
+                entries[len] = .{ value, high << 8 | low };
+                len += 1;
+            }
+        }
+        const final = entries[0..len].*;
+        return build(&final);
+    }
+};
+
+/// Japanese DBCS (CCSID 300) wards derivable without IBM's mapping files:
+/// the ideographic space and ward 0x42, which holds the full-width form of
+/// each SBCS character at the SBCS byte's position. Kanji and kana wards
+/// slot into the same table as further entries.
+fn japanese_dbcs_entries() []const [2]u16 {
+    @setEvalBranchQuota(10000);
+    const sbcs = japanese_sbcs(true);
+    var entries: [257][2]u16 = undefined;
+    entries[0] = .{ 0x4040, 0x3000 };
+    var len: usize = 1;
+    for (sbcs, 0..) |code_point, byte| {
+        if (byte <= 0x40 or code_point <= 0x20 or code_point >= 0x7F) continue;
+        entries[len] = .{ 0x4200 | byte, 0xFF01 + (code_point - 0x21) };
+        len += 1;
+    }
+    const final = entries[0..len].*;
+    return &final;
+}
+
+const japanese_dbcs = TwoLevelTable.build(japanese_dbcs_entries());
+const japanese_dbcs_reverse = japanese_dbcs.inverse();
+
+/// Per-session EBCDIC transcoder between a host code page and UTF-8.
+///
+/// Holds only the code page and the SO/SI shift state of each direction,
+/// so it can live in the session and be switched with `set_codepage`.
+/// Both directions write into caller buffers and never allocate: when
+/// `output` fills up they stop and report how far they got, and the
+/// next call resumes from there. A DBCS pair split across calls is
+/// carried over.
+pub const Transcoder = struct {
+    codepage: Codepage,
+    error_mode: CharsetConverter.ErrorMode = .replace,
+    /// Host stream is between SO and SI
+    decode_shifted: bool = false,
+    /// First byte of a DBCS pair waiting for its second
+    decode_lead: ?u8 = null,
+    /// Encoded output is between SO and SI
+    encode_shifted: bool = false,
+
+    pub const Progress = struct {
+        consumed: usize,
+        written: usize,
+    };
+
+    pub fn init(codepage: Codepage) Transcoder {
+        return .{ .codepage = codepage };
+    }
+
+    /// Switch code page, dropping any shift state
+    pub fn set_codepage(self: *Transcoder, codepage: Codepage) void {
+        self.* = .{ .codepage = codepage, .error_mode = self.error_mode };
+    }
+
+    /// Host bytes to UTF-8
+    pub fn decode(self: *Transcoder, input: []const u8, output: []u8) !Progress {
+        const sbcs = self.codepage.sbcs();
+        const dbcs = self.codepage.is_dbcs();
+        var consumed: usize = 0;
+        var written: usize = 0;
+
+        while (consumed < input.len) {
+            const byte = input[consumed];
+            if (dbcs and (byte == shift_out or byte == shift_in)) {
+                self.decode_shifted = byte == shift_out;
+                self.decode_lead = null;
+                consumed += 1;
+                continue;
+            }
+
+            var mapped: ?u16 = undefined;
+            if (self.decode_shifted) {
+                const lead = self.decode_lead orelse {
+                    self.decode_lead = byte;
+                    consumed += 1;
+                    continue;
+                };
+                mapped = japanese_dbcs.lookup(@as(u16, lead) << 8 | byte);
+            } else {
+                const value = sbcs.to_unicode[byte];
+                mapped = if (value == unmapped) null else value;
+            }
+
+            const code_point: u21 = mapped orelse switch (self.error_mode) {
+                .replace => '?',
+                .skip => {
+                    self.decode_lead = null;
+                    consumed += 1;
+                    continue;
+                },
+                .error_mode => return error.UnknownCharacter,
+            };
+            const len = std.unicode.utf8CodepointSequenceLength(code_point) catch unreachable;
+            if (output.len - written < len) break;
+            _ = std.unicode.utf8Encode(code_point, output[written..][0..len]) catch unreachable;
+            written += len;
+            self.decode_lead = null;
+            consumed += 1;
+        }
+
+        return .{ .consumed = consumed, .written = written };
+    }
+
+    /// UTF-8 to host bytes, adding SO/SI around double-byte runs. A
+    /// sequence cut off at the end of `input` is left unconsumed.
+    pub fn encode(self: *Transcoder, input: []const u8, output: []u8) !Progress {
+        const sbcs = self.codepage.sbcs();
+        var consumed: usize = 0;
+        var written: usize = 0;
+
+        while (consumed < input.len) {
+            const seq_len = std.unicode.utf8ByteSequenceLength(input[consumed]) catch return error.InvalidUtf8;
+            if (input.len - consumed < seq_len) break;
+            const code_point = std.unicode.utf8Decode(input[consumed..][0..seq_len]) catch return error.InvalidUtf8;
+
+            var single: ?u8 = null;
+            var double: ?u16 = null;
+            if (code_point <= 0xFF and sbcs.from_unicode[code_point] != unmapped) {
+                single = @intCast(sbcs.from_unicode[code_point]);
+            } else if (self.codepage.is_dbcs() and code_point <= 0xFFFF) {
+                double = japanese_dbcs_reverse.lookup(@intCast(code_point));
+            }
+            if (single == null and double == null) switch (self.error_mode) {
+                .replace => single = @intCast(sbcs.from_unicode['?']),
+                .skip => {
+                    consumed += seq_len;
+                    continue;
+                },
+                .error_mode => return error.UnknownCharacter,
+            };
+
+            const shifted = double != null;
+            const shift_len: usize = @intFromBool(shifted != self.encode_shifted);
+            const needed = shift_len + @as(usize, if (shifted) 2 else 1);
+            if (output.len - written < needed) break;
+
+            if (shift_len == 1) {
+                output[written] = if (shifted) shift_out else shift_in;
+                written += 1;
+                self.encode_shifted = shifted;
+            }
+            if (double) |code| {
+                output[written..][0..2].* = .{ @intCast(code >> 8), @truncate(code) };
+                written += 2;
+            } else {
+                output[written] = single.?;
+                written += 1;
+            }
+            consumed += seq_len;
+        }
+
+        return .{ .consumed = consumed, .written = written };
+    }
+
+    /// End an encoded stream: closes an open double-byte run with SI.
+    /// Returns the bytes written.
+    pub fn finish(self: *Transcoder, output: []u8) !usize {
+        if (!self.encode_shifted) return 0;
+        if (output.len < 1) return error.BufferTooSmall;
+        output[0] = shift_in;
+        self.encode_shifted = false;
+        return 1;
+    }
+};
+
 /// Get character set name
 pub fn getCharsetName(charset: CharacterSet) []const u8 {
     return switch (charset) {
@@ -186,12 +620,7 @@ pub fn isSupported(charset: CharacterSet) bool {
 
 /// Get APL symbol for character code
 pub fn getAplSymbol(ascii_code: u8) ?[]const u8 {
-    for (apl_mappings) |mapping| {
-        if (mapping.ascii_code == ascii_code) {
-            return mapping.apl_symbol;
-        }
-    }
-    return null;
+    return apl_by_ascii[ascii_code];
 }
 
 /// Get APL character name
@@ -262,3 +691,81 @@ test "charset converter: unknown character handling" {
     const result = try converter.convert_byte(200);
     try std.testing.expectEqualStrings("?", result);
 }
+
+test "charset converter: convert into caller buffer" {
+    const converter = CharsetConverter.init(std.testing.allocator, .ascii, .apl);
+
+    var buffer: [32]u8 = undefined;
+    const written = try converter.convert_into("!#", &buffer);
+    try std.testing.expectEqualStrings("⍳⍒", buffer[0..written]);
+    try std.testing.expectError(error.BufferTooSmall, converter.convert_into("!", buffer[0..2]));
+
+    const owned = try converter.convert("!#");
+    defer std.testing.allocator.free(owned);
+    try std.testing.expectEqualStrings("⍳⍒", owned);
+}
+
+test "codepage: latin pages round trip every byte" {
+    for ([_]Codepage{ .cp037, .cp273, .cp500, .cp1047 }) |codepage| {
+        var transcoder = Transcoder.init(codepage);
+        var utf8: [512]u8 = undefined;
+        var back: [256]u8 = undefined;
+        var latin1: [256]u8 = undefined;
+
+        const decoded = try transcoder.decode(&identity, &utf8);
+        try std.testing.expectEqual(@as(usize, 256), decoded.consumed);
+        const encoded = try transcoder.encode(utf8[0..decoded.written], &back);
+        try std.testing.expectEqualSlices(u8, &identity, back[0..encoded.written]);
+
+        _ = try codepage.decode_latin1(&identity, &latin1);
+        _ = try codepage.encode_latin1(&latin1, &back);
+        try std.testing.expectEqualSlices(u8, &identity, &back);
+    }
+}
+
+test "codepage: national characters" {
+    var buffer: [8]u8 = undefined;
+    var german = Transcoder.init(.cp273);
+    const umlaut = try german.decode(&.{ 0xC0, 0x43 }, &buffer);
+    try std.testing.expectEqualStrings("ä{", buffer[0..umlaut.written]);
+
+    var unix = Transcoder.init(.cp1047);
+    const brackets = try unix.decode(&.{ 0xAD, 0xBD, 0x5F }, &buffer);
+    try std.testing.expectEqualStrings("[]^", buffer[0..brackets.written]);
+
+    try std.testing.expectEqual(Codepage.cp1047, Codepage.from_name("IBM-1047").?);
+    try std.testing.expectEqual(Codepage.cp037, Codepage.from_name("cp037").?);
+    try std.testing.expectEqual(@as(?Codepage, null), Codepage.from_name("cp999"));
+}
+
+test "codepage: dbcs shift state across chunks" {
+    // "A" SO <full-width A> <ideographic space> SI "B"
+    const host = [_]u8{ 0xC1, shift_out, 0x42, 0xC1, 0x40, 0x40, shift_in, 0xC2 };
+    const text = "A\u{FF21}\u{3000}B";
+
+    var transcoder = Transcoder.init(.cp939);
+    var utf8: [16]u8 = undefined;
+    var written: usize = 0;
+    for (0..host.len) |i| {
+        const progress = try transcoder.decode(host[i..][0..1], utf8[written..]);
+        try std.testing.expectEqual(@as(usize, 1), progress.consumed);
+        written += progress.written;
+    }
+    try std.testing.expectEqualStrings(text, utf8[0..written]);
+
+    var encoded: [16]u8 = undefined;
+    const progress = try transcoder.encode(text, &encoded);
+    try std.testing.expectEqual(text.len, progress.consumed);
+    try std.testing.expectEqualSlices(u8, &host, encoded[0..progress.written]);
+    try std.testing.expectEqual(@as(usize, 0), try transcoder.finish(encoded[progress.written..]));
+}
+
+test "codepage: decode stops when the output is full" {
+    var transcoder = Transcoder.init(.cp273);
+    var buffer: [3]u8 = undefined;
+
+    // Each 0xC0 is "ä", two bytes of UTF-8
+    const progress = try transcoder.decode(&.{ 0xC0, 0xC0, 0xC0 }, &buffer);
+    try std.testing.expectEqual(@as(usize, 1), progress.consumed);
+    try std.testing.expectEqual(@as(usize, 2), progress.written);
+}
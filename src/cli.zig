@@ -1,5 +1,6 @@
 const std = @import("std");
 const debug_log = @import("debug_log.zig");
+const zone_trace = @import("zone_trace.zig");
 
 pub const CliCommand = enum {
     connect,
@@ -18,6 +19,21 @@ pub const CliArgs = struct {
     verbose: bool = false,
     log_level: debug_log.DebugLog.Level = .warn,
     file: ?[]const u8 = null, // for replay/dump commands
+    /// Zone trace output (Chrome trace JSON); tracing is on when set
+    trace_file: ?[]const u8 = null,
+
+    /// Turn zone tracing on if `--trace` was given
+    pub fn start_trace(self: CliArgs) void {
+        if (self.trace_file != null) zone_trace.enable();
+    }
+
+    /// Write the zone trace to the `--trace` file. Safe to call at any
+    /// time while sessions run, as often as wanted; each call rewrites
+    /// the file with what the rings hold now.
+    pub fn dump_trace(self: CliArgs, allocator: std.mem.Allocator) !void {
+        const path = self.trace_file orelse return;
+        try zone_trace.write_chrome_trace_file(allocator, path);
+    }
 };
 
 pub const CliParser = struct {
@@ -75,6 +91,10 @@ pub const CliParser = struct {
                 i += 1;
                 if (i >= args.len) return error.MissingFileValue;
                 result.file = args[i];
+            } else if (std.mem.eql(u8, arg, "--trace")) {
+                i += 1;
+                if (i >= args.len) return error.MissingTraceValue;
+                result.trace_file = args[i];
             } else {
                 return error.UnknownArgument;
             }
@@ -105,6 +125,7 @@ pub const CliParser = struct {
             \\    --verbose           Enable verbose logging
             \\    --debug             Enable debug logging
             \\    --file <PATH>       File for replay/dump commands
+            \\    --trace <PATH>      Record zone traces, written to PATH as Chrome trace JSON
             \\    -h, --help          Show this help message
             \\    -v, --version       Show version information
             \\
@@ -249,3 +270,37 @@ test "unknown argument error" {
 
     try std.testing.expectError(error.UnknownArgument, result);
 }
+
+test "parse trace flag" {
+    const parser = CliParser.init(std.testing.allocator);
+    const args = [_][]const u8{ "zig-3270", "connect", "--trace", "session.trace.json" };
+    const result = try parser.parse(&args);
+    try std.testing.expectEqualStrings("session.trace.json", result.trace_file.?);
+
+    const missing = [_][]const u8{ "zig-3270", "--trace" };
+    try std.testing.expectError(error.MissingTraceValue, parser.parse(&missing));
+}
+
+test "trace flag enables zone tracing and dumps it on demand" {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const dir_path = try tmp.dir.realpathAlloc(std.testing.allocator, ".");
+    defer std.testing.allocator.free(dir_path);
+    const path = try std.fs.path.join(std.testing.allocator, &.{ dir_path, "cli.trace.json" });
+    defer std.testing.allocator.free(path);
+
+    const args = CliArgs{ .trace_file = path };
+    args.start_trace();
+    defer zone_trace.disable();
+    zone_trace.reset();
+    try std.testing.expect(zone_trace.is_enabled());
+
+    zone_trace.begin(.execute).end();
+    try args.dump_trace(std.testing.allocator);
+
+    const json = try tmp.dir.readFileAlloc(std.testing.allocator, "cli.trace.json", 1 << 20);
+    defer std.testing.allocator.free(json);
+    const parsed = try std.json.parseFromSlice(std.json.Value, std.testing.allocator, json, .{});
+    defer parsed.deinit();
+    try std.testing.expectEqual(@as(usize, 2), parsed.value.object.get("traceEvents").?.array.items.len);
+}
@@ -1,5 +1,6 @@
 const std = @import("std");
 const profiler = @import("profiler.zig");
+const zone_trace = @import("zone_trace.zig");
 
 /// Performance baseline metrics from benchmarks
 pub const PerformanceBaseline = struct {
@@ -219,6 +220,11 @@ pub const CliProfiler = struct {
 
         _ = try file.writeAll(report);
     }
+
+    /// Dump the zone trace rings to a Chrome trace / Perfetto JSON file
+    pub fn export_trace(self: CliProfiler, path: []const u8) !void {
+        try zone_trace.write_chrome_trace_file(self.allocator, path);
+    }
 };
 
 // Tests
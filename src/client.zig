@@ -2,6 +2,15 @@
 /// Handles TCP connection to 3270 hosts and TN3270 protocol negotiation.
 const std = @import("std");
 const protocol = @import("protocol.zig");
+const zero_copy_parser = @import("zero_copy_parser.zig");
+const buffer_pool = @import("buffer_pool.zig");
+const dns_cache = @import("dns_cache.zig");
+const telnet_enhanced = @import("telnet_enhanced.zig");
+const screen = @import("screen.zig");
+const field = @import("field.zig");
+const read_modified = @import("read_modified.zig");
+const zone_trace = @import("zone_trace.zig");
+const metrics_export = @import("metrics_export.zig");
 
 /// TN3270 telnet option codes
 pub const TelnetOption = enum(u8) {
@@ -15,6 +24,7 @@ pub const TelnetOption = enum(u8) {
 
 /// TN3270 subnegotiation commands
 pub const TelnetCommand = enum(u8) {
+    eor = 239, // End Of Record
     se = 240, // Subnegotiation End
     nop = 241, // No Operation
     dm = 242, // Data Mark
@@ -41,9 +51,20 @@ pub const Client = struct {
     stream: ?std.net.Stream,
     connected: bool,
     read_buffer: []u8,
+    /// Source of the read buffer and outgoing command buffers; null uses
+    /// the process-wide pool, resolved on first use
+    pool: ?*buffer_pool.SharedBufferPool = null,
+    /// Name resolution for `host`; null uses the process-wide cache
+    dns: ?*dns_cache.DnsCache = null,
+    negotiator: telnet_enhanced.TelnetNegotiator,
+    /// Host bytes that arrived with the last negotiation response, handed
+    /// out by the next read
+    pending: []u8 = &[_]u8{},
     read_timeout_ms: u32 = 10000,
     write_timeout_ms: u32 = 5000,
     last_activity: i64 = 0,
+    /// Started when an AID goes out; stopped by the first host data after it
+    reply_timer: ?metrics_export.LatencyTimer = null,
 
     pub fn init(
         allocator: std.mem.Allocator,
@@ -57,6 +78,7 @@ pub const Client = struct {
             .stream = null,
             .connected = false,
             .read_buffer = &[_]u8{},
+            .negotiator = telnet_enhanced.TelnetNegotiator.init(allocator),
             .last_activity = std.time.milliTimestamp(),
         };
     }
@@ -77,82 +99,270 @@ pub const Client = struct {
         return (now - self.last_activity) > @as(i64, self.read_timeout_ms);
     }
 
-    /// Connect to the host
+    /// Connect to the host and send the TN3270 negotiation request.
+    /// `host` may be an IP address or a name; names go through the DNS
+    /// cache and each resolved address is tried in turn. The TCP connect
+    /// blocks; after it, returns without waiting for the host's
+    /// negotiation replies (see `finish_negotiation`).
     pub fn connect(self: *Client) !void {
-        // Try to parse as IP address first
-        const address = std.net.Address.parseIp(self.host, self.port) catch |err| {
-            std.debug.print("Note: Could not parse as IP address: {}\n", .{err});
-            std.debug.print("Please provide an IP address (DNS resolution not yet supported).\n", .{});
-            return error.InvalidAddress;
-        };
-
-        self.stream = try std.net.tcpConnectToAddress(address);
+        const cache = self.dns orelse dns_cache.global();
+        var addresses: [dns_cache.max_addresses]std.net.Address = undefined;
+        const count = try cache.resolve(self.host, self.port, &addresses);
+        if (count == 0) return error.InvalidAddress;
+
+        var last_error: anyerror = error.ConnectionRefused;
+        self.stream = for (addresses[0..count]) |address| {
+            break std.net.tcpConnectToAddress(address) catch |err| {
+                last_error = err;
+                continue;
+            };
+        } else return last_error;
         self.connected = true;
+        errdefer self.disconnect();
 
-        // Allocate read buffer
-        self.read_buffer = try self.allocator.alloc(u8, 4096);
+        // Take the read buffer from the shared pool
+        self.read_buffer = try (try self.buffers()).acquire(4096);
 
         // Perform TN3270 negotiation
         try self.negotiate();
     }
 
+    /// `connect`, then answer the host with `finish_negotiation`. For
+    /// callers that go straight to reading screens; a timeout is not an
+    /// error, since some hosts stay silent until they see data.
+    pub fn connect_negotiated(self: *Client, timeout_ms: i32) !void {
+        try self.connect();
+        errdefer self.disconnect();
+        _ = try self.finish_negotiation(timeout_ms);
+    }
+
     /// Disconnect from host
     pub fn disconnect(self: *Client) void {
         if (self.stream) |stream| {
             stream.close();
         }
+        self.stream = null;
         self.connected = false;
+        self.pending = &[_]u8{};
+        self.reply_timer = null;
+        self.negotiator = telnet_enhanced.TelnetNegotiator.init(self.allocator);
         if (self.read_buffer.len > 0) {
-            self.allocator.free(self.read_buffer);
+            self.pool.?.release(self.read_buffer);
+            self.read_buffer = &[_]u8{};
         }
     }
 
-    /// Send telnet negotiation sequence
-    fn sendTelnetCommand(self: *Client, cmd: u8, option: u8) !void {
-        const sequence = [_]u8{
-            @intFromEnum(TelnetCommand.iac),
-            cmd,
-            option,
-        };
-        try self.stream.?.writeAll(&sequence);
+    fn buffers(self: *Client) !*buffer_pool.SharedBufferPool {
+        if (self.pool == null) self.pool = try buffer_pool.global();
+        return self.pool.?;
     }
 
-    /// Handle TN3270 negotiation
-    fn negotiate(self: *Client) !void {
-        // Request binary transmission
-        try self.sendTelnetCommand(@intFromEnum(TelnetCommand.will), @intFromEnum(TelnetOption.transmit_binary));
+    /// Socket handle for registering with an external poll/epoll/kqueue loop.
+    /// Returns null when not connected.
+    pub fn socket_fd(self: Client) ?std.posix.socket_t {
+        if (!self.connected) return null;
+        if (self.stream) |stream| return stream.handle;
+        return null;
+    }
 
-        // Request suppress GA
-        try self.sendTelnetCommand(@intFromEnum(TelnetCommand.will), @intFromEnum(TelnetOption.suppress_ga));
+    /// Switch the socket between blocking and non-blocking mode.
+    /// In non-blocking mode `read_into` and `send_batch` return
+    /// `error.WouldBlock` instead of waiting on the host.
+    pub fn set_nonblocking(self: *Client, enabled: bool) !void {
+        const fd = self.socket_fd() orelse return error.NotConnected;
+        const nonblock: usize = @as(usize, 1) << @bitOffsetOf(std.posix.O, "NONBLOCK");
+        const flags = try std.posix.fcntl(fd, std.posix.F.GETFL, 0);
+        const new_flags = if (enabled) flags | nonblock else flags & ~nonblock;
+        if (new_flags != flags) {
+            _ = try std.posix.fcntl(fd, std.posix.F.SETFL, new_flags);
+        }
+    }
+
+    /// Wait until the socket is readable or the timeout expires.
+    /// A negative timeout waits indefinitely. Returns false on timeout.
+    pub fn wait_readable(self: *Client, timeout_ms: i32) !bool {
+        const fd = self.socket_fd() orelse return error.NotConnected;
+        var fds = [_]std.posix.pollfd{.{
+            .fd = fd,
+            .events = std.posix.POLL.IN,
+            .revents = 0,
+        }};
+        const ready = try std.posix.poll(&fds, timeout_ms);
+        return ready > 0;
+    }
 
-        // Request terminal type negotiation
-        try self.sendTelnetCommand(@intFromEnum(TelnetCommand.will), @intFromEnum(TelnetOption.terminal_type));
+    /// Read whatever the host has sent into a caller-owned buffer.
+    /// Unlike `read`, this never copies through `read_buffer` and does not
+    /// apply the idle timeout; callers driving an event loop own timing.
+    /// Returns `error.WouldBlock` in non-blocking mode when no data is
+    /// pending and `error.ConnectionClosed` when the host hung up.
+    pub fn read_into(self: *Client, buffer: []u8) !usize {
+        const zone = zone_trace.begin(.client_read);
+        defer zone.end();
+        const fd = self.socket_fd() orelse return error.NotConnected;
+        if (buffer.len == 0) return 0;
+
+        if (self.pending.len > 0) {
+            const len = @min(buffer.len, self.pending.len);
+            @memcpy(buffer[0..len], self.pending[0..len]);
+            self.pending = self.pending[len..];
+            return len;
+        }
 
-        // Request end of record
-        try self.sendTelnetCommand(@intFromEnum(TelnetCommand.will), @intFromEnum(TelnetOption.end_of_record));
+        const bytes_read = try std.posix.read(fd, buffer);
+        if (bytes_read == 0) {
+            self.disconnect();
+            return error.ConnectionClosed;
+        }
+        self.last_activity = std.time.milliTimestamp();
+        self.stop_reply_timer();
+        return bytes_read;
+    }
+
+    /// Read straight into the free space of a ring buffer, for use with
+    /// `stream_decoder.StreamDecoder`. Returns `error.BufferFull` when the
+    /// reader has not drained the ring yet.
+    pub fn read_ring(self: *Client, ring: *zero_copy_parser.RingBufferIO) !usize {
+        const slice = ring.get_write_slice();
+        if (slice.len == 0) return error.BufferFull;
+
+        const bytes_read = try self.read_into(slice);
+        try ring.advance_write(bytes_read);
+        return bytes_read;
+    }
+
+    /// Maximum buffers handed to a single `writev` call by `send_batch`
+    pub const max_batch_buffers = 64;
+
+    /// Send several buffers with vectored writes (one syscall per
+    /// `max_batch_buffers` buffers). Returns the number of bytes written,
+    /// which may be short in non-blocking mode; the caller resubmits the
+    /// remainder once the socket is writable again.
+    pub fn send_batch(self: *Client, buffers: []const []const u8) !usize {
+        const zone = zone_trace.begin(.client_write);
+        defer zone.end();
+        const fd = self.socket_fd() orelse return error.NotConnected;
+
+        var iovecs: [max_batch_buffers]std.posix.iovec_const = undefined;
+        var total_written: usize = 0;
+        var index: usize = 0;
+
+        while (index < buffers.len) {
+            const chunk = buffers[index..@min(buffers.len, index + max_batch_buffers)];
+            var chunk_len: usize = 0;
+            for (chunk, 0..) |buf, i| {
+                iovecs[i] = .{ .base = buf.ptr, .len = buf.len };
+                chunk_len += buf.len;
+            }
+
+            const written = std.posix.writev(fd, iovecs[0..chunk.len]) catch |err| {
+                if (err == error.WouldBlock and total_written > 0) return total_written;
+                return err;
+            };
+            total_written += written;
+            self.last_activity = std.time.milliTimestamp();
+
+            if (written < chunk_len) return total_written;
+            index += chunk.len;
+        }
+
+        return total_written;
+    }
+
+    /// Send the whole negotiation request in one write
+    fn negotiate(self: *Client) !void {
+        var buffer: [32]u8 = undefined;
+        var out = std.Io.Writer.fixed(&buffer);
+        try self.negotiator.write_opening(&out);
+        try self.stream.?.writeAll(out.buffered());
+    }
 
-        // Try to read negotiation response (optional - some servers don't send anything)
-        // (disabled for now - can cause blocking)
-        // _ = self.stream.?.read(self.read_buffer) catch {};
+    /// Answer the host's negotiation until TN3270 mode is agreed or the
+    /// 3270 data stream starts. All replies to one read go out in one
+    /// write. Returns false on timeout (some hosts send nothing until
+    /// they see data). Data that arrived with the last response is kept
+    /// for the next `read`/`read_into`.
+    pub fn finish_negotiation(self: *Client, timeout_ms: i32) !bool {
+        if (!self.connected) return error.NotConnected;
+        const deadline = std.time.milliTimestamp() + timeout_ms;
+        var held: usize = 0;
+
+        while (true) {
+            // Bytes of an incomplete sequence stay at the front for the next read
+            const remaining = deadline - std.time.milliTimestamp();
+            if (remaining <= 0 or !try self.wait_readable(@intCast(remaining))) {
+                self.pending = self.read_buffer[0..held];
+                return false;
+            }
+            if (held == self.read_buffer.len) return error.NegotiationTooLong;
+
+            const bytes_read = try self.stream.?.read(self.read_buffer[held..]);
+            if (bytes_read == 0) {
+                self.disconnect();
+                return error.ConnectionClosed;
+            }
+            self.last_activity = std.time.milliTimestamp();
+            const bytes = self.read_buffer[0 .. held + bytes_read];
+
+            var offset: usize = 0;
+            var reply_buffer: [256]u8 = undefined;
+            while (true) {
+                var replies = std.Io.Writer.fixed(&reply_buffer);
+                const result = try self.negotiator.feed(bytes[offset..], &replies);
+                offset += result.consumed;
+                if (replies.end > 0) try self.stream.?.writeAll(replies.buffered());
+
+                if (result.data_started) {
+                    self.pending = bytes[offset..];
+                    return true;
+                }
+                if (result.consumed == 0 or offset == bytes.len) break;
+            }
+
+            held = bytes.len - offset;
+            std.mem.copyForwards(u8, self.read_buffer[0..held], bytes[offset..]);
+            if (self.negotiator.is_complete()) {
+                self.pending = self.read_buffer[0..held];
+                return true;
+            }
+        }
     }
 
     /// Read data from host
     pub fn read(self: *Client) ![]u8 {
+        const zone = zone_trace.begin(.client_read);
+        defer zone.end();
         if (!self.connected) {
             return error.NotConnected;
         }
 
+        if (self.pending.len > 0) {
+            const data = self.pending;
+            self.pending = &[_]u8{};
+            return data;
+        }
+
         if (self.is_timed_out()) {
             return error.ReadTimeout;
         }
 
         const bytes_read = try self.stream.?.read(self.read_buffer);
         self.last_activity = std.time.milliTimestamp();
+        if (bytes_read > 0) self.stop_reply_timer();
         return self.read_buffer[0..bytes_read];
     }
 
+    /// Record the round trip of the last AID, if one is outstanding
+    fn stop_reply_timer(self: *Client) void {
+        const timer = self.reply_timer orelse return;
+        timer.stop();
+        self.reply_timer = null;
+    }
+
     /// Send data to host
     pub fn send(self: *Client, data: []const u8) !void {
+        const zone = zone_trace.begin(.client_write);
+        defer zone.end();
         if (!self.connected) {
             return error.NotConnected;
         }
@@ -165,12 +375,37 @@ pub const Client = struct {
         self.last_activity = std.time.milliTimestamp();
     }
 
+    /// Answer an AID key with the Read Modified stream for `scr`, encoded
+    /// straight into a pooled buffer and sent with one write. The modified
+    /// data tags are left for the caller to reset.
+    pub fn send_read_modified(
+        self: *Client,
+        scr: *const screen.Screen,
+        fields: *field.FieldManager,
+        aid: protocol.Aid,
+        cursor: u16,
+        options: read_modified.Options,
+    ) !void {
+        const pool = try self.buffers();
+        const buffer = try pool.acquire(read_modified.encoded_size_bound(scr, fields));
+        defer pool.release(buffer);
+
+        var out = std.Io.Writer.fixed(buffer);
+        var framed = options;
+        framed.telnet = true;
+        try read_modified.encode(&out, scr, fields, aid, cursor, framed);
+        try self.send(out.buffered());
+        self.reply_timer = metrics_export.start_latency(.command_round_trip);
+    }
+
     /// Send a 3270 command
     pub fn send3270Command(self: *Client, cmd: protocol.CommandCode, data: []const u8) !void {
-        var buffer: [4096]u8 = undefined;
-        buffer[0] = @intFromEnum(cmd);
-        @memcpy(buffer[1 .. 1 + data.len], data);
+        const pool = try self.buffers();
+        const buffer = try pool.acquire(1 + data.len);
+        defer pool.release(buffer);
 
+        buffer[0] = @intFromEnum(cmd);
+        @memcpy(buffer[1..][0..data.len], data);
         try self.send(buffer[0 .. 1 + data.len]);
     }
 };
@@ -234,6 +469,57 @@ test "client: is_timed_out detects timeout" {
     try std.testing.expect(test_client.is_timed_out());
 }
 
+test "client: non-blocking helpers require a connection" {
+    var test_client = Client.init(std.testing.allocator, "127.0.0.1", 3270);
+    var buffer: [16]u8 = undefined;
+
+    try std.testing.expect(test_client.socket_fd() == null);
+    try std.testing.expectError(error.NotConnected, test_client.set_nonblocking(true));
+    try std.testing.expectError(error.NotConnected, test_client.read_into(&buffer));
+    try std.testing.expectError(error.NotConnected, test_client.send_batch(&.{"ABC"}));
+}
+
+fn read_exactly(stream: std.net.Stream, buffer: []u8) !void {
+    var filled: usize = 0;
+    while (filled < buffer.len) {
+        const n = try stream.read(buffer[filled..]);
+        if (n == 0) return error.EndOfStream;
+        filled += n;
+    }
+}
+
+test "client: read_into and send_batch over loopback" {
+    const listen_address = try std.net.Address.parseIp("127.0.0.1", 0);
+    var server = try listen_address.listen(.{ .reuse_address = true });
+    defer server.deinit();
+
+    var test_client = Client.init(std.testing.allocator, "127.0.0.1", server.listen_address.getPort());
+    try test_client.connect();
+    defer test_client.disconnect();
+
+    const conn = try server.accept();
+    defer conn.stream.close();
+
+    // Drain the negotiation request sent by connect()
+    var negotiation: [15]u8 = undefined;
+    try read_exactly(conn.stream, &negotiation);
+
+    try test_client.set_nonblocking(true);
+    var buffer: [16]u8 = undefined;
+    try std.testing.expectError(error.WouldBlock, test_client.read_into(&buffer));
+
+    try conn.stream.writeAll("HOST");
+    try std.testing.expect(try test_client.wait_readable(1000));
+    const bytes_read = try test_client.read_into(&buffer);
+    try std.testing.expectEqualStrings("HOST", buffer[0..bytes_read]);
+
+    const written = try test_client.send_batch(&.{ "AB", "CD", "EF" });
+    try std.testing.expectEqual(@as(usize, 6), written);
+    var echoed: [6]u8 = undefined;
+    try read_exactly(conn.stream, &echoed);
+    try std.testing.expectEqualStrings("ABCDEF", &echoed);
+}
+
 test "client: is_timed_out detects active connection" {
     var gpa = std.heap.GeneralPurposeAllocator(.{}){};
     defer _ = gpa.deinit();
@@ -245,3 +531,33 @@ test "client: is_timed_out detects active connection" {
 
     try std.testing.expect(!test_client.is_timed_out());
 }
+
+test "client: finish_negotiation answers the host and keeps the first screen" {
+    const listen_address = try std.net.Address.parseIp("127.0.0.1", 0);
+    var server = try listen_address.listen(.{ .reuse_address = true });
+    defer server.deinit();
+
+    var test_client = Client.init(std.testing.allocator, "127.0.0.1", server.listen_address.getPort());
+    try test_client.connect();
+    defer test_client.disconnect();
+
+    const conn = try server.accept();
+    defer conn.stream.close();
+    var request: [15]u8 = undefined;
+    try read_exactly(conn.stream, &request);
+
+    // Negotiation and the first screen in one segment, as busy hosts send it
+    try conn.stream.writeAll(&.{
+        0xFF, 0xFD, 0x18, 0xFF, 0xFA, 0x18, 0x01, 0xFF, 0xF0, // DO TTYPE, SB TTYPE SEND
+        0xFF, 0xFD, 0x19, 0xFF, 0xFB, 0x19, 0xFF, 0xFD, 0x00, 0xFF, 0xFB, 0x00,
+        0xF5, 0xC3, 0xFF, 0xEF, // EW, WCC, IAC EOR
+    });
+    try std.testing.expect(try test_client.finish_negotiation(1000));
+
+    const expected_reply = "\xFF\xFA\x18\x00IBM-3278-2-E\xFF\xF0";
+    var reply: [expected_reply.len]u8 = undefined;
+    try read_exactly(conn.stream, &reply);
+    try std.testing.expectEqualSlices(u8, expected_reply, &reply);
+
+    try std.testing.expectEqualSlices(u8, &.{ 0xF5, 0xC3, 0xFF, 0xEF }, try test_client.read());
+}
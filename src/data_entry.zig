@@ -1,7 +1,6 @@
 const std = @import("std");
 const field = @import("field.zig");
 const screen = @import("screen.zig");
-const parse_utils = @import("parse_utils.zig");
 
 /// Data entry manager - handles keyboard input to unprotected fields
 pub const DataEntry = struct {
@@ -23,44 +22,31 @@ pub const DataEntry = struct {
 
     /// Move to first unprotected field
     pub fn home(self: *DataEntry) !void {
-        for (0..self.field_manager.count()) |i| {
-            if (self.field_manager.get_field(i)) |f| {
-                if (!f.attribute.protected) {
-                    self.current_field_index = i;
-                    self.field_cursor = 0;
-                    return;
-                }
-            }
-        }
-        return error.NoUnprotectedFields;
+        const index = self.field_manager.next_unprotected_index(0) orelse return error.NoUnprotectedFields;
+        self.current_field_index = index;
+        self.field_cursor = 0;
     }
 
-    /// Move to next unprotected field
+    /// Move to next unprotected field (wrapping), using the field manager's
+    /// precomputed tab table rather than scanning every field
     pub fn tab(self: *DataEntry) !void {
-        const start_idx = if (self.current_field_index) |idx| idx + 1 else 0;
-
-        for (start_idx..self.field_manager.count()) |i| {
-            if (self.field_manager.get_field(i)) |f| {
-                if (!f.attribute.protected) {
-                    self.current_field_index = i;
-                    self.field_cursor = 0;
-                    return;
-                }
-            }
-        }
+        const from_address: u16 = if (self.current_field_index) |idx| blk: {
+            const f = self.field_manager.get_field(idx) orelse break :blk 0;
+            break :blk f.start_address +| 1;
+        } else 0;
 
-        // Wrap around
-        for (0..start_idx) |i| {
-            if (self.field_manager.get_field(i)) |f| {
-                if (!f.attribute.protected) {
-                    self.current_field_index = i;
-                    self.field_cursor = 0;
-                    return;
-                }
-            }
-        }
+        const index = self.field_manager.next_unprotected_index(from_address) orelse return error.NoUnprotectedFields;
+        self.current_field_index = index;
+        self.field_cursor = 0;
+    }
 
-        return error.NoUnprotectedFields;
+    /// Mirror a field character onto the screen at a linear buffer address
+    /// and tag the cell as modified for Read Modified
+    fn write_screen_cell(self: *DataEntry, address: usize, char: u8) void {
+        if (address < self.screen.size()) {
+            self.screen.write_at(@intCast(address), char) catch {};
+            self.screen.mark_modified(address, 1);
+        }
     }
 
     /// Write character to current field
@@ -81,16 +67,10 @@ pub const DataEntry = struct {
         }
 
         try f.set_char(self.field_cursor, char);
+        f.attribute.modified = true;
 
         // Also update screen
-        const screen_offset = f.start_address + self.field_cursor;
-        const addr = parse_utils.buffer_to_address(screen_offset);
-        const row = @as(u16, @intCast(addr.row));
-        const col = @as(u16, @intCast(addr.col));
-
-        if (row < self.screen.rows and col < self.screen.cols) {
-            try self.screen.write_char(row, col, char);
-        }
+        self.write_screen_cell(@as(usize, f.start_address) + self.field_cursor, char);
 
         self.field_cursor += 1;
     }
@@ -111,16 +91,10 @@ pub const DataEntry = struct {
         self.field_cursor -= 1;
 
         try f.set_char(self.field_cursor, ' ');
+        f.attribute.modified = true;
 
         // Also update screen
-        const screen_offset = f.start_address + self.field_cursor;
-        const addr = parse_utils.buffer_to_address(screen_offset);
-        const row = @as(u16, @intCast(addr.row));
-        const col = @as(u16, @intCast(addr.col));
-
-        if (row < self.screen.rows and col < self.screen.cols) {
-            try self.screen.write_char(row, col, ' ');
-        }
+        self.write_screen_cell(@as(usize, f.start_address) + self.field_cursor, ' ');
     }
 
     /// Get content of current field
@@ -145,17 +119,11 @@ pub const DataEntry = struct {
         const f = self.field_manager.get_field(idx) orelse return error.InvalidFieldIndex;
 
         @memset(f.content, ' ');
+        f.attribute.modified = true;
 
         // Update screen
         for (0..f.length) |offset| {
-            const screen_offset = f.start_address + offset;
-            const addr = parse_utils.buffer_to_address(screen_offset);
-            const row = @as(u16, @intCast(addr.row));
-            const col = @as(u16, @intCast(addr.col));
-
-            if (row < self.screen.rows and col < self.screen.cols) {
-                try self.screen.write_char(row, col, ' ');
-            }
+            self.write_screen_cell(@as(usize, f.start_address) + offset, ' ');
         }
 
         self.field_cursor = 0;
@@ -316,3 +284,42 @@ test "data entry current address" {
     const addr = try de.current_address();
     try std.testing.expectEqual(@as(u16, 5), addr);
 }
+
+test "data entry tab wraps to first unprotected field" {
+    var scr = try screen.Screen.init(std.testing.allocator, 3, 30);
+    defer scr.deinit();
+
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    _ = try fm.add_field(0, 10, .{ .protected = false });
+    _ = try fm.add_field(10, 10, .{ .protected = true });
+    _ = try fm.add_field(20, 10, .{ .protected = false });
+
+    var de = DataEntry.init(std.testing.allocator, &fm, &scr);
+    try de.home();
+    try de.tab();
+    try de.tab();
+
+    try std.testing.expectEqual(@as(?usize, 0), de.current_field_index);
+}
+
+test "data entry sets modified data tags" {
+    var scr = try screen.Screen.init(std.testing.allocator, 3, 20);
+    defer scr.deinit();
+
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    _ = try fm.add_field(20, 10, .{ .protected = false });
+
+    var de = DataEntry.init(std.testing.allocator, &fm, &scr);
+    try de.write_char('A');
+
+    try std.testing.expect(scr.is_modified(20));
+    try std.testing.expect(!scr.is_modified(21));
+    try std.testing.expect(fm.get_field(0).?.attribute.modified);
+
+    scr.clear();
+    try std.testing.expect(!scr.is_modified(20));
+}
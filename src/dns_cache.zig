@@ -0,0 +1,359 @@
+//! Host name resolution with a shared TTL cache.
+//!
+//! Many sessions to the same host (a logon storm at shift change) cost one
+//! lookup: concurrent callers for a name wait for the lookup already in
+//! flight, and later callers within the TTL are served from the cache.
+//! Entries past their TTL are still served for a grace period while a
+//! background thread refreshes them, so a slow resolver never sits on the
+//! connect path once a name has been seen. `prefetch` starts a lookup in the
+//! background ahead of the first connect, and `resolve_cached` never waits
+//! for one.
+//!
+//! The system resolver reports no TTLs, so entries live for the configured
+//! `ttl_ms`; failures are cached for `negative_ttl_ms`.
+const std = @import("std");
+
+/// Addresses kept per host name
+pub const max_addresses = 8;
+
+/// Fills `out` with addresses for `host` (port 0) and returns the count
+pub const ResolveFn = *const fn (allocator: std.mem.Allocator, host: []const u8, out: []std.net.Address) anyerror!usize;
+
+/// Blocking lookup through the system resolver
+pub fn system_resolve(allocator: std.mem.Allocator, host: []const u8, out: []std.net.Address) anyerror!usize {
+    const list = try std.net.getAddressList(allocator, host, 0);
+    defer list.deinit();
+    if (list.addrs.len == 0) return error.UnknownHostName;
+
+    const count = @min(list.addrs.len, out.len);
+    @memcpy(out[0..count], list.addrs[0..count]);
+    return count;
+}
+
+pub const DnsCache = struct {
+    allocator: std.mem.Allocator,
+    options: Options,
+    mutex: std.Thread.Mutex = .{},
+    /// Signalled when a lookup finishes
+    changed: std.Thread.Condition = .{},
+    entries: std.StringHashMapUnmanaged(Entry) = .empty,
+    /// Background lookups still running
+    in_flight: usize = 0,
+    lookups: u64 = 0,
+    hits: u64 = 0,
+
+    pub const Options = struct {
+        ttl_ms: i64 = 60_000,
+        negative_ttl_ms: i64 = 5_000,
+        /// How long past the TTL an entry is still served while it refreshes
+        stale_ms: i64 = 300_000,
+        resolver: ResolveFn = system_resolve,
+        clock: *const fn () i64 = std.time.milliTimestamp,
+    };
+
+    const Entry = struct {
+        addresses: [max_addresses]std.net.Address = undefined,
+        len: usize = 0,
+        failure: ?anyerror = null,
+        expires_ms: i64 = 0,
+        resolving: bool = false,
+    };
+
+    pub fn init(allocator: std.mem.Allocator, options: Options) DnsCache {
+        return .{
+            .allocator = allocator,
+            .options = options,
+        };
+    }
+
+    /// Waits for background lookups, then frees the cache
+    pub fn deinit(self: *DnsCache) void {
+        self.mutex.lock();
+        while (self.in_flight > 0) self.changed.wait(&self.mutex);
+        self.mutex.unlock();
+
+        var keys = self.entries.keyIterator();
+        while (keys.next()) |key| self.allocator.free(key.*);
+        self.entries.deinit(self.allocator);
+    }
+
+    /// Addresses for `host` with `port` applied, written to `out`; returns
+    /// how many. Literal IP addresses are returned without a lookup.
+    pub fn resolve(self: *DnsCache, host: []const u8, port: u16, out: []std.net.Address) !usize {
+        if (std.net.Address.parseIp(host, port)) |address| {
+            if (out.len == 0) return 0;
+            out[0] = address;
+            return 1;
+        } else |_| {}
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        while (true) {
+            const now = self.options.clock();
+            const entry = try self.get_or_put(host);
+
+            const has_result = entry.len > 0 or entry.failure != null;
+            if (has_result and entry.expires_ms > now) {
+                self.hits += 1;
+                return copy_out(entry, port, out);
+            }
+            if (entry.len > 0 and entry.expires_ms + self.options.stale_ms > now) {
+                if (!entry.resolving) self.start_refresh(host);
+                self.hits += 1;
+                return copy_out(entry, port, out);
+            }
+            if (entry.resolving) {
+                self.changed.wait(&self.mutex);
+                continue;
+            }
+
+            entry.resolving = true;
+            self.lookup_unlocked(host);
+        }
+    }
+
+    /// `resolve` for callers that must not block: serves what is cached
+    /// (fresh, stale within the grace period, or a cached failure) and
+    /// otherwise starts a background lookup and returns null. Ask again
+    /// later for the answer.
+    pub fn resolve_cached(self: *DnsCache, host: []const u8, port: u16, out: []std.net.Address) !?usize {
+        if (std.net.Address.parseIp(host, port)) |address| {
+            if (out.len == 0) return 0;
+            out[0] = address;
+            return 1;
+        } else |_| {}
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        const now = self.options.clock();
+        const entry = try self.get_or_put(host);
+
+        const has_result = entry.len > 0 or entry.failure != null;
+        if (has_result and entry.expires_ms > now) {
+            self.hits += 1;
+            return try copy_out(entry, port, out);
+        }
+        if (entry.len > 0 and entry.expires_ms + self.options.stale_ms > now) {
+            if (!entry.resolving) self.start_refresh(host);
+            self.hits += 1;
+            return try copy_out(entry, port, out);
+        }
+        if (!entry.resolving) self.start_refresh(host);
+        return null;
+    }
+
+    /// Start a background lookup unless a fresh entry or a lookup exists
+    pub fn prefetch(self: *DnsCache, host: []const u8) !void {
+        if (std.net.Address.parseIp(host, 0)) |_| return else |_| {}
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        const entry = try self.get_or_put(host);
+        if (entry.resolving or entry.expires_ms > self.options.clock()) return;
+        self.start_refresh(host);
+    }
+
+    /// Drop every cached entry that no lookup is running for
+    pub fn clear(self: *DnsCache) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        var it = self.entries.valueIterator();
+        while (it.next()) |entry| {
+            if (!entry.resolving) entry.* = .{};
+        }
+    }
+
+    fn get_or_put(self: *DnsCache, host: []const u8) !*Entry {
+        const gop = try self.entries.getOrPut(self.allocator, host);
+        if (!gop.found_existing) {
+            gop.key_ptr.* = self.allocator.dupe(u8, host) catch |err| {
+                self.entries.removeByPtr(gop.key_ptr);
+                return err;
+            };
+            gop.value_ptr.* = .{};
+        }
+        return gop.value_ptr;
+    }
+
+    fn copy_out(entry: *const Entry, port: u16, out: []std.net.Address) !usize {
+        if (entry.failure) |err| return err;
+        const count = @min(entry.len, out.len);
+        for (out[0..count], entry.addresses[0..count]) |*dest, address| {
+            dest.* = address;
+            dest.setPort(port);
+        }
+        return count;
+    }
+
+    /// Run the resolver for an entry already marked `resolving`. Called
+    /// and returns with the mutex held; the lookup itself runs unlocked.
+    fn lookup_unlocked(self: *DnsCache, host: []const u8) void {
+        self.lookups += 1;
+        self.mutex.unlock();
+        var addresses: [max_addresses]std.net.Address = undefined;
+        const result = self.options.resolver(self.allocator, host, &addresses);
+        self.mutex.lock();
+
+        // The map may have grown while unlocked; look the entry up again
+        const entry = self.entries.getPtr(host).?;
+        const now = self.options.clock();
+        entry.resolving = false;
+        if (result) |count| {
+            entry.addresses = addresses;
+            entry.len = count;
+            entry.failure = null;
+            entry.expires_ms = now + self.options.ttl_ms;
+        } else |err| {
+            // Keep serving a stale answer rather than replacing it with a failure
+            if (entry.len == 0) entry.failure = err;
+            entry.expires_ms = now + self.options.negative_ttl_ms;
+        }
+        self.changed.broadcast();
+    }
+
+    /// Refresh an entry on a background thread. Called with the mutex held.
+    fn start_refresh(self: *DnsCache, host: []const u8) void {
+        const key = self.entries.getKey(host).?;
+        const entry = self.entries.getPtr(host).?;
+        entry.resolving = true;
+        self.in_flight += 1;
+        const thread = std.Thread.spawn(.{}, refresh, .{ self, key }) catch {
+            entry.resolving = false;
+            self.in_flight -= 1;
+            return;
+        };
+        thread.detach();
+    }
+
+    fn refresh(self: *DnsCache, key: []const u8) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.lookup_unlocked(key);
+        self.in_flight -= 1;
+        self.changed.broadcast();
+    }
+};
+
+var global_cache: DnsCache = undefined;
+var global_cache_ready = false;
+var global_cache_mutex: std.Thread.Mutex = .{};
+
+/// Process-wide cache on the SMP allocator, used by clients that are not
+/// given one
+pub fn global() *DnsCache {
+    global_cache_mutex.lock();
+    defer global_cache_mutex.unlock();
+    if (!global_cache_ready) {
+        global_cache = DnsCache.init(std.heap.smp_allocator, .{});
+        global_cache_ready = true;
+    }
+    return &global_cache;
+}
+
+const TestResolver = struct {
+    var calls = std.atomic.Value(u32).init(0);
+    var now: i64 = 0;
+    var fail = false;
+
+    fn resolve(allocator: std.mem.Allocator, host: []const u8, out: []std.net.Address) anyerror!usize {
+        _ = allocator;
+        _ = calls.fetchAdd(1, .monotonic);
+        std.Thread.sleep(5 * std.time.ns_per_ms);
+        if (fail) return error.UnknownHostName;
+        out[0] = try std.net.Address.parseIp(if (std.mem.eql(u8, host, "mvs1")) "10.0.0.1" else "10.0.0.2", 0);
+        return 1;
+    }
+
+    fn clock() i64 {
+        return now;
+    }
+
+    fn reset() void {
+        calls.store(0, .monotonic);
+        now = 1_000;
+        fail = false;
+    }
+};
+
+test "dns cache: ttl, stale refresh and literal addresses" {
+    TestResolver.reset();
+    var cache = DnsCache.init(std.testing.allocator, .{
+        .ttl_ms = 100,
+        .stale_ms = 1_000,
+        .resolver = TestResolver.resolve,
+        .clock = TestResolver.clock,
+    });
+    defer cache.deinit();
+
+    var out: [max_addresses]std.net.Address = undefined;
+    try std.testing.expectEqual(@as(usize, 1), try cache.resolve("127.0.0.1", 23, &out));
+    try std.testing.expectEqual(@as(u32, 0), TestResolver.calls.load(.monotonic));
+
+    try std.testing.expectEqual(@as(usize, 1), try cache.resolve("mvs1", 3270, &out));
+    try std.testing.expectEqual(@as(u16, 3270), out[0].getPort());
+    _ = try cache.resolve("mvs1", 992, &out);
+    try std.testing.expectEqual(@as(u16, 992), out[0].getPort());
+    try std.testing.expectEqual(@as(u32, 1), TestResolver.calls.load(.monotonic));
+
+    // Past the TTL the stale answer is served while a refresh runs
+    TestResolver.now += 200;
+    _ = try cache.resolve("mvs1", 3270, &out);
+    cache.mutex.lock();
+    while (cache.in_flight > 0) cache.changed.wait(&cache.mutex);
+    cache.mutex.unlock();
+    try std.testing.expectEqual(@as(u32, 2), TestResolver.calls.load(.monotonic));
+
+    // Failures are cached too
+    TestResolver.fail = true;
+    try std.testing.expectError(error.UnknownHostName, cache.resolve("mvs2", 3270, &out));
+    try std.testing.expectError(error.UnknownHostName, cache.resolve("mvs2", 3270, &out));
+    try std.testing.expectEqual(@as(u32, 3), TestResolver.calls.load(.monotonic));
+}
+
+test "dns cache: resolve_cached never waits for a lookup" {
+    TestResolver.reset();
+    var cache = DnsCache.init(std.testing.allocator, .{
+        .resolver = TestResolver.resolve,
+        .clock = TestResolver.clock,
+    });
+    defer cache.deinit();
+
+    var out: [max_addresses]std.net.Address = undefined;
+    try std.testing.expectEqual(@as(?usize, null), try cache.resolve_cached("mvs1", 23, &out));
+    // A second call while the lookup runs does not start another
+    try std.testing.expectEqual(@as(?usize, null), try cache.resolve_cached("mvs1", 23, &out));
+    cache.mutex.lock();
+    while (cache.in_flight > 0) cache.changed.wait(&cache.mutex);
+    cache.mutex.unlock();
+
+    try std.testing.expectEqual(@as(?usize, 1), try cache.resolve_cached("mvs1", 23, &out));
+    try std.testing.expectEqual(@as(u16, 23), out[0].getPort());
+    try std.testing.expectEqual(@as(u32, 1), TestResolver.calls.load(.monotonic));
+}
+
+fn resolve_mvs1(cache: *DnsCache, result: *?anyerror) void {
+    var out: [max_addresses]std.net.Address = undefined;
+    _ = cache.resolve("mvs1", 3270, &out) catch |err| {
+        result.* = err;
+    };
+}
+
+test "dns cache: concurrent callers share one lookup" {
+    TestResolver.reset();
+    var cache = DnsCache.init(std.testing.allocator, .{
+        .resolver = TestResolver.resolve,
+        .clock = TestResolver.clock,
+    });
+    defer cache.deinit();
+
+    var results = [_]?anyerror{null} ** 8;
+    var threads: [8]std.Thread = undefined;
+    for (&threads, &results) |*thread, *result| {
+        thread.* = try std.Thread.spawn(.{}, resolve_mvs1, .{ &cache, result });
+    }
+    for (threads) |thread| thread.join();
+
+    for (results) |result| try std.testing.expectEqual(@as(?anyerror, null), result);
+    try std.testing.expectEqual(@as(u32, 1), TestResolver.calls.load(.monotonic));
+}
@@ -1,4 +1,83 @@
 const std = @import("std");
+const builtin = @import("builtin");
+
+/// Lane count of the bulk transcoding kernel
+pub const vector_len = 16;
+const Block = @Vector(vector_len, u8);
+
+/// True when the backend can lower a runtime 16-byte table shuffle
+/// (SSSE3 pshufb / NEON tbl). Other targets use the scalar loop only.
+pub const has_byte_shuffle = builtin.zig_backend == .stage2_llvm and switch (builtin.cpu.arch) {
+    .x86_64, .x86 => std.Target.x86.featureSetHas(builtin.cpu.features, .ssse3),
+    .aarch64 => std.Target.aarch64.featureSetHas(builtin.cpu.features, .neon),
+    else => false,
+};
+
+extern fn @"llvm.x86.ssse3.pshuf.b.128"(Block, Block) Block;
+extern fn @"llvm.aarch64.neon.tbl1.v16i8"(Block, Block) Block;
+
+/// Look up each lane of `indices` (0-15) in a 16-entry `table`
+inline fn shuffle16(table: Block, indices: Block) Block {
+    return switch (builtin.cpu.arch) {
+        .x86_64, .x86 => @"llvm.x86.ssse3.pshuf.b.128"(table, indices),
+        .aarch64 => @"llvm.aarch64.neon.tbl1.v16i8"(table, indices),
+        else => unreachable,
+    };
+}
+
+/// Split a 256-entry table into 16 rows indexed by the high nibble
+fn nibble_rows(comptime table: [256]u8) [16]Block {
+    var rows: [16]Block = undefined;
+    for (0..16) |hi| {
+        rows[hi] = table[hi * 16 ..][0..16].*;
+    }
+    return rows;
+}
+
+/// Translate one block: shuffle the low nibble through each row and keep
+/// the lanes whose high nibble selects that row. Only the first
+/// `row_count` rows are reachable (8 for validated 7-bit input).
+inline fn translate_block(comptime rows: [16]Block, comptime row_count: usize, input: Block) Block {
+    const lo = input & @as(Block, @splat(0x0F));
+    const hi = input >> @as(@Vector(vector_len, u3), @splat(4));
+    var result: Block = @splat(0);
+    inline for (0..row_count) |row| {
+        const in_row = hi == @as(Block, @splat(row));
+        result = @select(u8, in_row, shuffle16(rows[row], lo), result);
+    }
+    return result;
+}
+
+/// Table-driven bulk translation: vector blocks plus a scalar tail.
+/// `output` must be at least `input.len` bytes.
+pub fn translate(comptime table: [256]u8, comptime row_count: usize, input: []const u8, output: []u8) void {
+    var i: usize = 0;
+    if (has_byte_shuffle) {
+        const rows = comptime nibble_rows(table);
+        while (i + vector_len <= input.len) : (i += vector_len) {
+            const block: Block = input[i..][0..vector_len].*;
+            output[i..][0..vector_len].* = translate_block(rows, row_count, block);
+        }
+    }
+    while (i < input.len) : (i += 1) {
+        output[i] = table[input[i]];
+    }
+}
+
+/// Index of the first byte above 0x7F, or null if the buffer is 7-bit clean.
+/// Checks eight bytes per step so encode validates once up front.
+fn find_non_ascii(buffer: []const u8) ?usize {
+    const high_bits: u64 = 0x8080808080808080;
+    var i: usize = 0;
+    while (i + 8 <= buffer.len) : (i += 8) {
+        const word = std.mem.readInt(u64, buffer[i..][0..8], .little);
+        if (word & high_bits != 0) break;
+    }
+    while (i < buffer.len) : (i += 1) {
+        if (buffer[i] > 127) return i;
+    }
+    return null;
+}
 
 /// EBCDIC (Extended Binary Coded Decimal Interchange Code)
 /// Standard encoding used by IBM mainframes and TN3270 protocol
@@ -166,6 +245,14 @@ pub const Ebcdic = struct {
         0x07,
     };
 
+    /// ASCII table padded to 256 entries for the bulk kernel; bytes above
+    /// 0x7F are rejected before lookup so the padding is never read.
+    const ascii_to_ebcdic_full: [256]u8 = blk: {
+        var table = [_]u8{0} ** 256;
+        @memcpy(table[0..128], &ascii_to_ebcdic_table);
+        break :blk table;
+    };
+
     /// Decode EBCDIC byte to ASCII
     pub fn decode_byte(ebcdic_byte: u8) u8 {
         return ebcdic_to_ascii_table[ebcdic_byte];
@@ -180,29 +267,29 @@ pub const Ebcdic = struct {
         return ascii_to_ebcdic_table[ascii_byte];
     }
 
-    /// Decode EBCDIC buffer to ASCII
+    /// Decode EBCDIC buffer to ASCII (vectorized where supported)
     pub fn decode(ebcdic_buffer: []const u8, ascii_buffer: []u8) !usize {
         if (ascii_buffer.len < ebcdic_buffer.len) {
             return error.BufferTooSmall;
         }
 
-        for (ebcdic_buffer, 0..) |byte, i| {
-            ascii_buffer[i] = decode_byte(byte);
-        }
-
+        translate(ebcdic_to_ascii_table, 16, ebcdic_buffer, ascii_buffer);
         return ebcdic_buffer.len;
     }
 
-    /// Encode ASCII buffer to EBCDIC
+    /// Encode ASCII buffer to EBCDIC.
+    /// The input is validated once, so nothing is written on
+    /// `error.InvalidAsciiValue`.
     pub fn encode(ascii_buffer: []const u8, ebcdic_buffer: []u8) !usize {
         if (ebcdic_buffer.len < ascii_buffer.len) {
             return error.BufferTooSmall;
         }
 
-        for (ascii_buffer, 0..) |byte, i| {
-            ebcdic_buffer[i] = try encode_byte(byte);
+        if (find_non_ascii(ascii_buffer) != null) {
+            return error.InvalidAsciiValue;
         }
 
+        translate(ascii_to_ebcdic_full, 8, ascii_buffer, ebcdic_buffer);
         return ascii_buffer.len;
     }
 
@@ -357,3 +444,34 @@ test "ebcdic lowercase round trip" {
 
     try std.testing.expectEqualSlices(u8, lowercase, &decoded);
 }
+
+test "ebcdic bulk decode matches byte table for all values" {
+    var all: [256 + 7]u8 = undefined;
+    for (&all, 0..) |*b, i| b.* = @truncate(i);
+    var decoded: [all.len]u8 = undefined;
+
+    _ = try Ebcdic.decode(&all, &decoded);
+
+    for (all, decoded) |in, out| {
+        try std.testing.expectEqual(Ebcdic.decode_byte(in), out);
+    }
+}
+
+test "ebcdic bulk encode matches byte table for all ascii values" {
+    var all: [128 + 5]u8 = undefined;
+    for (&all, 0..) |*b, i| b.* = @truncate(i % 128);
+    var encoded: [all.len]u8 = undefined;
+
+    _ = try Ebcdic.encode(&all, &encoded);
+
+    for (all, encoded) |in, out| {
+        try std.testing.expectEqual(try Ebcdic.encode_byte(in), out);
+    }
+}
+
+test "ebcdic bulk encode rejects invalid byte past first block" {
+    var ascii = [_]u8{'A'} ** 40;
+    ascii[33] = 0x80;
+    var ebcdic: [40]u8 = undefined;
+    try std.testing.expectError(error.InvalidAsciiValue, Ebcdic.encode(&ascii, &ebcdic));
+}
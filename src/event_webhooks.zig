@@ -11,6 +11,8 @@ pub const EventType = enum {
     data_sent,
     error_occurred,
     connection_lost,
+    /// `data` holds `rest_api.screenDeltaJson` for the changed cells
+    screen_changed,
 };
 
 pub const WebhookEvent = struct {
@@ -4,13 +4,59 @@ const command = @import("command.zig");
 const field = @import("field.zig");
 const screen = @import("screen.zig");
 const parse_utils = @import("parse_utils.zig");
+const screen_fingerprint = @import("screen_fingerprint.zig");
+const zone_trace = @import("zone_trace.zig");
+const metrics_export = @import("metrics_export.zig");
+
+/// Highest cursor address text can advance to (24x80)
+const last_address: u16 = 1919;
+
+/// Order classification for every byte value; null means text
+const order_table = blk: {
+    var table = [_]?protocol.OrderCode{null} ** 256;
+    for (std.enums.values(protocol.OrderCode)) |code| {
+        table[@intFromEnum(code)] = code;
+    }
+    break :blk table;
+};
+
+/// Bytes compared per step when scanning for the next order
+const scan_width = std.simd.suggestVectorLength(u8) orelse 16;
+
+/// Length of the text run at the start of `data`, i.e. the offset of the
+/// first order byte (or `data.len`). Compares a vector of bytes against
+/// every order code at once, then finishes the tail with the table.
+fn text_run_length(data: []const u8) usize {
+    const Chunk = @Vector(scan_width, u8);
+    const Mask = std.meta.Int(.unsigned, scan_width);
+
+    var offset: usize = 0;
+    while (offset + scan_width <= data.len) : (offset += scan_width) {
+        const chunk: Chunk = data[offset..][0..scan_width].*;
+        var hits: Mask = 0;
+        inline for (comptime std.enums.values(protocol.OrderCode)) |code| {
+            hits |= @as(Mask, @bitCast(chunk == @as(Chunk, @splat(@intFromEnum(code)))));
+        }
+        if (hits != 0) return offset + @ctz(hits);
+    }
+    while (offset < data.len and order_table[data[offset]] == null) : (offset += 1) {}
+    return offset;
+}
+
+/// WCC bit: reset every modified data tag before the orders run
+pub const wcc_reset_mdt: u8 = 0x01;
 
-/// 3270 command executor - processes parsed commands and updates screen state
+/// 3270 command executor - processes parsed commands and updates screen state.
+/// Write, Erase Write and Erase Write Alternate data starts with the WCC.
 pub const Executor = struct {
     allocator: std.mem.Allocator,
     screen: *screen.Screen,
     field_manager: *field.FieldManager,
     cursor_address: u16,
+    /// Layout and protected-text hash, kept current as orders run
+    fingerprint: screen_fingerprint.Fingerprint = .{},
+    /// Whether text at the cursor lands in a protected field
+    cursor_protected: bool = false,
 
     pub fn init(allocator: std.mem.Allocator, scr: *screen.Screen, fm: *field.FieldManager) Executor {
         return Executor{
@@ -23,19 +69,27 @@ pub const Executor = struct {
 
     /// Execute a command
     pub fn execute(self: *Executor, cmd: command.Command) !void {
+        const zone = zone_trace.begin(.execute);
+        defer zone.end();
+        const timer = metrics_export.start_latency(.execute);
+        defer timer.stop();
+        const wcc: u8 = if (cmd.data.len > 0) cmd.data[0] else 0;
+        const orders = if (cmd.data.len > 0) cmd.data[1..] else cmd.data;
         switch (cmd.code) {
-            .erase_write => try self.execute_erase_write(cmd.data),
-            .erase_write_alt => try self.execute_erase_write_alt(cmd.data),
-            .write => try self.execute_write(cmd.data),
+            .erase_write => try self.execute_erase_write(orders),
+            .erase_write_alt => try self.execute_erase_write_alt(orders),
+            .write => try self.execute_write(wcc, orders),
             else => return error.UnsupportedCommand,
         }
     }
 
-    /// Erase Write (EW) - clear screen and process orders
+    /// Erase Write (EW) - clear screen, drop all fields and process orders
     fn execute_erase_write(self: *Executor, data: []const u8) !void {
         self.screen.clear();
         self.cursor_address = 0;
-        self.field_manager.clear();
+        self.field_manager.reset();
+        self.fingerprint.reset();
+        self.cursor_protected = false;
 
         try self.process_orders(data);
     }
@@ -44,24 +98,30 @@ pub const Executor = struct {
     fn execute_erase_write_alt(self: *Executor, data: []const u8) !void {
         self.screen.clear();
         self.cursor_address = 0;
+        self.fingerprint.reset_text();
+        self.cursor_protected = self.fingerprint.protected_at(0);
 
         try self.process_orders(data);
     }
 
-    /// Write (W) - process orders at current position
-    fn execute_write(self: *Executor, data: []const u8) !void {
+    /// Write (W) - process orders at current position. The erase commands
+    /// clear the tags with the screen; a Write resets them if its WCC asks.
+    fn execute_write(self: *Executor, wcc: u8, data: []const u8) !void {
+        if (wcc & wcc_reset_mdt != 0) self.screen.reset_modified();
         try self.process_orders(data);
     }
 
     /// Process orders within command data
     fn process_orders(self: *Executor, data: []const u8) !void {
+        // Tab lookups are answered from the rebuilt table once the
+        // command's Start Field orders are all in
+        defer self.field_manager.rebuild_tab_index();
         var pos: usize = 0;
 
         while (pos < data.len) {
             const byte = data[pos];
 
-            // Try to parse as order code
-            if (parse_utils.parse_order_code(byte)) |order_code| {
+            if (order_table[byte]) |order_code| {
                 pos += 1;
 
                 switch (order_code) {
@@ -69,6 +129,7 @@ pub const Executor = struct {
                         const addr_bytes = try parse_utils.read_bytes(data, pos, 2);
                         const addr = protocol.Address.from_bytes(addr_bytes[0..2].*);
                         self.cursor_address = parse_utils.address_to_buffer(addr);
+                        self.cursor_protected = self.fingerprint.protected_at(self.cursor_address);
                         pos += 2;
                     },
                     .start_field => {
@@ -78,6 +139,14 @@ pub const Executor = struct {
                         // Field starts at current position, will be sized when we encounter next field
                         const field_start = self.cursor_address;
                         _ = try self.field_manager.add_field(field_start, 1, attr);
+                        self.screen.set_attribute(field_start, attr_byte[0]) catch {};
+                        if (field_start < self.screen.size()) {
+                            self.fingerprint.set_text(field_start, self.screen.buffer[field_start], 0, false);
+                        }
+                        self.fingerprint.set_field(field_start, attr_byte[0]);
+                        // The host can preset MDT so the field is always sent back
+                        if (attr.modified) self.screen.mark_modified(field_start, 1);
+                        self.cursor_protected = attr.protected;
                         self.cursor_address += 1;
                         pos += 1;
                     },
@@ -95,26 +164,55 @@ pub const Executor = struct {
                         pos += 1;
                     },
                 }
-            } else |_| {
-                // Regular text - write to screen
-                const addr = parse_utils.buffer_to_address(self.cursor_address);
-                const row = @as(u16, addr.row);
-                const col = @as(u16, addr.col);
-
-                if (row < self.screen.rows and col < self.screen.cols) {
-                    try self.screen.write_char(row, col, byte);
-                }
+            } else {
+                // Regular text - copy the whole run up to the next order
+                const run = text_run_length(data[pos..]);
+                self.write_text(data[pos..][0..run]);
+                pos += run;
+            }
+        }
+    }
 
-                self.cursor_address += 1;
-                if (self.cursor_address >= 1920) {
-                    self.cursor_address = 1919;
-                }
+    /// Write a text run at the cursor with one bulk copy. Matches the
+    /// per-character semantics: the cursor advances one cell per byte and
+    /// pins at `last_address`, where any overflow lands (last byte wins).
+    fn write_text(self: *Executor, run: []const u8) void {
+        var rest = run;
+        if (self.cursor_address < last_address) {
+            const direct = @min(rest.len, last_address - self.cursor_address);
+            self.track_text(self.cursor_address, rest[0..direct]);
+            _ = self.screen.write_run(self.cursor_address, rest[0..direct]);
+            self.cursor_address += @intCast(direct);
+            rest = rest[direct..];
+        }
+        if (rest.len == 0) return;
 
-                pos += 1;
-            }
+        self.track_text(self.cursor_address, rest[0..1]);
+        self.screen.write_at(self.cursor_address, rest[0]) catch {};
+        if (rest.len > 1) {
+            self.track_text(last_address, rest[rest.len - 1 ..]);
+            self.screen.write_at(last_address, rest[rest.len - 1]) catch {};
+        }
+        self.cursor_address = last_address;
+    }
+
+    /// Update the fingerprint for text about to be written at `address`
+    fn track_text(self: *Executor, address: u16, run: []const u8) void {
+        // Unprotected text over cells that never counted changes nothing
+        if (!self.cursor_protected and self.fingerprint.text_clear()) return;
+        const end = @min(@as(usize, address) + run.len, self.screen.size());
+        if (end <= address) return;
+        for (run[0 .. end - address], address..) |byte, cell| {
+            self.fingerprint.set_text(cell, self.screen.buffer[cell], byte, self.cursor_protected);
         }
     }
 
+    /// Hash of the field layout and protected text; equal for screens
+    /// showing the same panel whatever the operator typed
+    pub fn screen_fingerprint(self: *const Executor) u64 {
+        return self.fingerprint.value();
+    }
+
     /// Get current cursor address
     pub fn get_cursor_address(self: *Executor) u16 {
         return self.cursor_address;
@@ -166,8 +264,8 @@ test "executor set buffer address order" {
 
     var exec = Executor.init(std.testing.allocator, &scr, &fm);
 
-    // Create order: set buffer address to (1, 5) = address 85
-    const order_data = &.{ @intFromEnum(protocol.OrderCode.set_buffer_address), 0x00, 0x55 };
+    // WCC, then set buffer address to (1, 5) = address 85
+    const order_data = &.{ 0x00, @intFromEnum(protocol.OrderCode.set_buffer_address), 0x00, 0x55 };
     var cmd = command.Command{
         .code = protocol.CommandCode.write,
         .data = try std.testing.allocator.dupe(u8, order_data),
@@ -187,7 +285,7 @@ test "executor write text to screen" {
 
     var exec = Executor.init(std.testing.allocator, &scr, &fm);
 
-    const text = "Hello";
+    const text = "\x00Hello";
     var cmd = command.Command{
         .code = protocol.CommandCode.write,
         .data = try std.testing.allocator.dupe(u8, text),
@@ -210,8 +308,9 @@ test "executor set buffer address then write" {
 
     var exec = Executor.init(std.testing.allocator, &scr, &fm);
 
-    // Set address to (0, 5), then write "OK"
+    // WCC, set address to (0, 5), then write "OK"
     const orders_and_text = &.{
+        0x00,
         @intFromEnum(protocol.OrderCode.set_buffer_address), 0x00, 0x05,
         'O',                                                 'K',
     };
@@ -238,7 +337,7 @@ test "executor full command pipeline: erase write with field and text" {
     var exec = Executor.init(std.testing.allocator, &scr, &fm);
 
     // Simple test: write "Test" and verify it's on screen
-    const cmd_data = "Test";
+    const cmd_data = "\x00Test";
 
     var cmd = command.Command{
         .code = protocol.CommandCode.erase_write,
@@ -254,3 +353,154 @@ test "executor full command pipeline: erase write with field and text" {
     try std.testing.expectEqual(@as(u8, 's'), try scr.read_char(0, 2));
     try std.testing.expectEqual(@as(u8, 't'), try scr.read_char(0, 3));
 }
+
+test "executor start field records attribute in screen plane" {
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    var exec = Executor.init(std.testing.allocator, &scr, &fm);
+
+    const order_data = &.{
+        0x00,
+        @intFromEnum(protocol.OrderCode.set_buffer_address), 0x00, 0x50,
+        @intFromEnum(protocol.OrderCode.start_field),        0x20,
+        'A',
+    };
+    var cmd = command.Command{
+        .code = protocol.CommandCode.write,
+        .data = try std.testing.allocator.dupe(u8, order_data),
+    };
+    defer cmd.deinit(std.testing.allocator);
+
+    try exec.execute(cmd);
+
+    try std.testing.expectEqual(@as(u8, 0x20), try scr.get_attribute(80));
+    try std.testing.expectEqual(@as(u8, 'A'), try scr.read_char(1, 1));
+}
+
+test "executor erase write repaint does no heap allocations once warm" {
+    const AllocationTracker = @import("allocation_tracker.zig").AllocationTracker;
+    var tracker = AllocationTracker.init(std.testing.allocator);
+    const allocator = tracker.allocator();
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+
+    var fm = field.FieldManager.init(allocator);
+    defer fm.deinit();
+
+    var exec = Executor.init(allocator, &scr, &fm);
+
+    // WCC, then one field per row, each followed by a label
+    var data: [1 + 24 * 10]u8 = undefined;
+    data[0] = 0x00;
+    for (0..24) |row| {
+        const address: u16 = @intCast(row * 80);
+        const chunk = data[1 + row * 10 ..][0..10];
+        chunk[0..3].* = .{ @intFromEnum(protocol.OrderCode.set_buffer_address), @intCast(address >> 8), @intCast(address & 0xFF) };
+        chunk[3..5].* = .{ @intFromEnum(protocol.OrderCode.start_field), 0x20 };
+        @memcpy(chunk[5..10], "LABEL");
+    }
+    const cmd = command.Command{ .code = .erase_write, .data = &data };
+
+    try exec.execute(cmd);
+    const warm_allocations = tracker.allocations;
+    try exec.execute(cmd);
+
+    try std.testing.expectEqual(warm_allocations, tracker.allocations);
+    try std.testing.expectEqual(@as(usize, 24), fm.count());
+}
+
+test "executor text run scan stops at order bytes" {
+    var text = [_]u8{'x'} ** 100;
+    try std.testing.expectEqual(@as(usize, 100), text_run_length(&text));
+
+    text[70] = @intFromEnum(protocol.OrderCode.start_field);
+    try std.testing.expectEqual(@as(usize, 70), text_run_length(&text));
+
+    text[3] = @intFromEnum(protocol.OrderCode.set_attribute);
+    try std.testing.expectEqual(@as(usize, 3), text_run_length(&text));
+    try std.testing.expectEqual(@as(usize, 0), text_run_length(text[3..]));
+}
+
+test "executor bulk text run pins at the last address" {
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    var exec = Executor.init(std.testing.allocator, &scr, &fm);
+
+    // SBA to row 23, col 77, then five characters: three fit, the rest
+    // overwrite the final cell
+    var data = [_]u8{ 0x00, @intFromEnum(protocol.OrderCode.set_buffer_address), 0x07, 0x7D, 'A', 'B', 'C', 'D', 'E' };
+    const cmd = command.Command{ .code = .write, .data = &data };
+    try exec.execute(cmd);
+
+    try std.testing.expectEqualStrings("ABE", scr.buffer[1917..1920]);
+    try std.testing.expectEqual(last_address, exec.cursor_address);
+}
+
+test "executor records execution latency in the global metrics" {
+    var scr = try screen.Screen.init(std.testing.allocator, 2, 3);
+    defer scr.deinit();
+
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    var exec = Executor.init(std.testing.allocator, &scr, &fm);
+    const before = metrics_export.global().snapshot().latency.get(.execute).count;
+
+    var no_orders = [_]u8{};
+    try exec.execute(.{ .code = protocol.CommandCode.erase_write, .data = &no_orders });
+
+    const after = metrics_export.global().snapshot().latency.get(.execute).count;
+    try std.testing.expectEqual(before + 1, after);
+
+    // The system exporter carries the histograms next to its counters
+    const system = try metrics_export.SystemMetrics.init(std.testing.allocator);
+    const output = try metrics_export.PrometheusExporter.init(std.testing.allocator).export_system_metrics(system);
+    defer std.testing.allocator.free(output);
+    try std.testing.expect(std.mem.containsAtLeast(u8, output, 1, "# TYPE tn3270_execute_seconds histogram"));
+    try std.testing.expect(std.mem.containsAtLeast(u8, output, 1, "tn3270_total_commands 0"));
+}
+
+test "executor rebuilds the tab index once per write" {
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    var exec = Executor.init(std.testing.allocator, &scr, &fm);
+
+    // WCC, SF protected at 0, SF unprotected at 1
+    var orders = [_]u8{ 0x00, 0x1D, 0x01, 0x1D, 0x00 };
+    try exec.execute(.{ .code = protocol.CommandCode.erase_write, .data = &orders });
+    try std.testing.expect(fm.next_unprotected_valid);
+    try std.testing.expectEqual(@as(?usize, 1), fm.next_unprotected_index(0));
+}
+
+test "executor write resets modified tags only when the WCC asks" {
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    var exec = Executor.init(std.testing.allocator, &scr, &fm);
+    scr.mark_modified(100, 3);
+
+    var keep = [_]u8{ 0x02, @intFromEnum(protocol.OrderCode.set_buffer_address), 0x00, 0x10, 'X' };
+    try exec.execute(.{ .code = .write, .data = &keep });
+    try std.testing.expect(scr.is_modified(101));
+    try std.testing.expectEqual(@as(u8, 'X'), try scr.read_at(16));
+
+    var reset = [_]u8{wcc_reset_mdt};
+    try exec.execute(.{ .code = .write, .data = &reset });
+    try std.testing.expect(!scr.is_modified(101));
+}
@@ -136,9 +136,9 @@ pub const Failover = struct {
         defer healthy_endpoints.deinit();
 
         // Collect healthy endpoints excluding the failed one
-        for (self.lb.endpoints.items) |*endpoint| {
+        for (self.lb.endpoint_view()) |endpoint| {
             if (!std.mem.eql(u8, endpoint.host, failed_host) and
-                endpoint.health_status == .healthy)
+                endpoint.health() == .healthy)
             {
                 try healthy_endpoints.append(endpoint);
             }
@@ -151,7 +151,7 @@ pub const Failover = struct {
         // Return endpoint with least connections
         var best_endpoint = healthy_endpoints.items[0];
         for (healthy_endpoints.items[1..]) |endpoint| {
-            if (endpoint.active_sessions < best_endpoint.active_sessions) {
+            if (endpoint.sessions() < best_endpoint.sessions()) {
                 best_endpoint = endpoint;
             }
         }
@@ -177,13 +177,13 @@ pub const Failover = struct {
         }).init(self.allocator);
         defer candidates.deinit();
 
-        for (self.lb.endpoints.items) |endpoint| {
+        for (self.lb.endpoint_view()) |endpoint| {
             if (!std.mem.eql(u8, endpoint.host, failed_host) and
-                endpoint.health_status == .healthy)
+                endpoint.health() == .healthy)
             {
                 try candidates.append(.{
                     .host = endpoint.host,
-                    .connections = endpoint.active_sessions,
+                    .connections = endpoint.sessions(),
                 });
             }
         }
@@ -230,11 +230,8 @@ pub const Failover = struct {
                 // Check if session belongs to failed endpoint
                 if (std.mem.eql(u8, sess.metadata.host, failed_host)) {
                     // Update session metadata to target endpoint
-                    if (self.pool.sessions.getPtr(session_id)) |mutable_sess| {
-                        mutable_sess.metadata.host = target_endpoint.host;
-                        mutable_sess.metadata.port = target_endpoint.port;
-                        migrated_count += 1;
-                    }
+                    self.pool.set_endpoint(session_id, target_endpoint.host, target_endpoint.port) catch continue;
+                    migrated_count += 1;
                 }
             }
         }
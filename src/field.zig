@@ -1,5 +1,6 @@
 const std = @import("std");
 const protocol = @import("protocol.zig");
+const field_storage = @import("field_storage.zig");
 
 /// 3270 Field definition
 pub const Field = struct {
@@ -34,10 +35,40 @@ pub const Field = struct {
     }
 };
 
-/// Field manager for 3270 screen
+/// Addresses covered by the per-screen lookup tables (24x80)
+pub const indexed_addresses = 1920;
+
+/// Lookup-table entry meaning "no field"
+const no_field = std.math.maxInt(u16);
+
+/// Field manager for 3270 screen.
+///
+/// Point lookups go through `address_index`, a table mapping every screen
+/// address to the first field (in insertion order) covering it; it is
+/// extended incrementally by `add_field`. Tab targets are answered from
+/// `next_unprotected`, which `rebuild_tab_index` recomputes in
+/// O(addresses + fields) once a batch of field changes is done; the
+/// executor calls it after each write command. Lookups never rebuild:
+/// until the table is current, and for addresses beyond
+/// `indexed_addresses`, they fall back to a linear scan.
+///
+/// Field content is carved from a per-screen `FieldDataStorage` arena that
+/// `reset` rewinds, so repainting a screen performs no heap allocations
+/// once the arena and field list have reached their working size. Content
+/// that does not fit the arena falls back to the allocator.
 pub const FieldManager = struct {
     allocator: std.mem.Allocator,
     fields: std.ArrayList(Field),
+    storage: ?field_storage.FieldDataStorage = null,
+    address_index: [indexed_addresses]u16 = [_]u16{no_field} ** indexed_addresses,
+    next_unprotected: [indexed_addresses]u16 = [_]u16{no_field} ** indexed_addresses,
+    next_unprotected_valid: bool = false,
+    /// Scratch for `rebuild_tab_index`, kept so rebuilds stop allocating
+    /// once the field count reaches its working size
+    unprotected_from: std.ArrayList(u16) = .empty,
+
+    /// Arena size: one byte per screen cell covers any non-overlapping layout
+    pub const storage_capacity = indexed_addresses;
 
     pub fn init(allocator: std.mem.Allocator) FieldManager {
         return FieldManager{
@@ -51,15 +82,49 @@ pub const FieldManager = struct {
 
     pub fn deinit(self: *FieldManager) void {
         for (self.fields.items) |*field| {
-            field.deinit(self.allocator);
+            self.free_content(field.content);
         }
         self.fields.deinit(self.allocator);
+        self.unprotected_from.deinit(self.allocator);
+        if (self.storage) |*storage| {
+            storage.deinit();
+        }
     }
 
-    /// Add a new field
-    pub fn add_field(self: *FieldManager, start_address: u16, length: u16, attr: protocol.FieldAttribute) !*Field {
+    /// Blank content for a new field, from the arena when it has room
+    fn alloc_content(self: *FieldManager, length: u16) ![]u8 {
+        if (self.storage == null) {
+            self.storage = try field_storage.FieldDataStorage.init(self.allocator, storage_capacity);
+        }
+
+        const storage = &self.storage.?;
+        if (storage.allocate(length)) |handle| {
+            const content = storage.getData(handle);
+            @memset(content, ' ');
+            return content;
+        } else |_| {}
+
         const content = try self.allocator.alloc(u8, length);
         @memset(content, ' ');
+        return content;
+    }
+
+    /// Release field content that did not come from the arena
+    fn free_content(self: *FieldManager, content: []u8) void {
+        if (self.storage) |*storage| {
+            if (storage.owns(content)) return;
+        }
+        self.allocator.free(content);
+    }
+
+    /// Add a new field
+    pub fn add_field(self: *FieldManager, start_address: u16, length: u16, attr: protocol.FieldAttribute) !*Field {
+        if (self.fields.items.len >= no_field) {
+            return error.TooManyFields;
+        }
+
+        const content = try self.alloc_content(length);
+        errdefer self.free_content(content);
 
         const field = Field{
             .start_address = start_address,
@@ -69,19 +134,54 @@ pub const FieldManager = struct {
         };
 
         try self.fields.append(self.allocator, field);
-        return &self.fields.items[self.fields.items.len - 1];
+        const index = self.fields.items.len - 1;
+        self.index_field(index);
+        self.next_unprotected_valid = false;
+        return &self.fields.items[index];
     }
 
-    /// Find field at address
-    pub fn find_field(self: *FieldManager, address: u16) ?*Field {
-        for (self.fields.items) |*field| {
+    /// Claim the unowned addresses of a field in the address table
+    fn index_field(self: *FieldManager, index: usize) void {
+        const f = &self.fields.items[index];
+        if (f.start_address >= indexed_addresses) return;
+        const end = @min(@as(usize, f.start_address) + f.length, indexed_addresses);
+        for (self.address_index[f.start_address..end]) |*slot| {
+            if (slot.* == no_field) slot.* = @intCast(index);
+        }
+    }
+
+    /// Rebuild lookup tables after fields were modified in place
+    /// (e.g. attributes or lengths changed through a returned pointer)
+    pub fn invalidate_index(self: *FieldManager) void {
+        @memset(&self.address_index, no_field);
+        for (0..self.fields.items.len) |i| {
+            self.index_field(i);
+        }
+        self.next_unprotected_valid = false;
+        self.rebuild_tab_index();
+    }
+
+    /// Index of the field at address
+    pub fn find_field_index(self: *FieldManager, address: u16) ?usize {
+        if (address < indexed_addresses) {
+            const index = self.address_index[address];
+            return if (index == no_field) null else index;
+        }
+
+        for (self.fields.items, 0..) |*field, i| {
             if (field.contains(address)) {
-                return field;
+                return i;
             }
         }
         return null;
     }
 
+    /// Find field at address
+    pub fn find_field(self: *FieldManager, address: u16) ?*Field {
+        const index = self.find_field_index(address) orelse return null;
+        return &self.fields.items[index];
+    }
+
     /// Get field by index
     pub fn get_field(self: *FieldManager, index: usize) ?*Field {
         if (index >= self.fields.items.len) {
@@ -90,29 +190,113 @@ pub const FieldManager = struct {
         return &self.fields.items[index];
     }
 
+    /// Index of the next unprotected field from address: the first
+    /// unprotected field at or after the first field (in insertion order)
+    /// starting at or beyond address, wrapping to the first unprotected field.
+    pub fn next_unprotected_index(self: *FieldManager, address: u16) ?usize {
+        if (address < indexed_addresses and self.next_unprotected_valid) {
+            const index = self.next_unprotected[address];
+            return if (index == no_field) null else index;
+        }
+        return self.scan_next_unprotected(address);
+    }
+
     /// Get next unprotected field from address
     pub fn next_unprotected_field(self: *FieldManager, address: u16) ?*Field {
+        const index = self.next_unprotected_index(address) orelse return null;
+        return &self.fields.items[index];
+    }
+
+    /// Linear reference implementation of `next_unprotected_index`
+    fn scan_next_unprotected(self: *FieldManager, address: u16) ?usize {
         var found_start = false;
 
-        for (self.fields.items) |*field| {
+        for (self.fields.items, 0..) |*field, i| {
             if (field.start_address >= address) {
                 found_start = true;
             }
             if (found_start and !field.attribute.protected) {
-                return field;
+                return i;
             }
         }
 
         // Wrap around to beginning
-        for (self.fields.items) |*field| {
+        for (self.fields.items, 0..) |*field, i| {
             if (!field.attribute.protected) {
-                return field;
+                return i;
             }
         }
 
         return null;
     }
 
+    /// Precompute `next_unprotected_index` for every indexed address after
+    /// fields were added. Does nothing when the table is current. If the
+    /// scratch cannot grow, the table stays stale and lookups keep scanning.
+    pub fn rebuild_tab_index(self: *FieldManager) void {
+        if (self.next_unprotected_valid) return;
+        const items = self.fields.items;
+        self.unprotected_from.resize(self.allocator, items.len) catch return;
+        const unprotected_from = self.unprotected_from.items;
+
+        // First unprotected field from each index onward (suffix scan)
+        var first_unprotected: u16 = no_field;
+        var wrap_target: u16 = no_field;
+        for (items, 0..) |f, i| {
+            if (!f.attribute.protected) {
+                wrap_target = @intCast(i);
+                break;
+            }
+        }
+
+        // Lowest field index starting at each address; fields starting
+        // past the table count for every address
+        var first_at: [indexed_addresses]u16 = [_]u16{no_field} ** indexed_addresses;
+        var first_beyond: u16 = no_field;
+        for (items, 0..) |f, i| {
+            const index: u16 = @intCast(i);
+            if (f.start_address < indexed_addresses) {
+                first_at[f.start_address] = @min(first_at[f.start_address], index);
+            } else {
+                first_beyond = @min(first_beyond, index);
+            }
+        }
+
+        var i = items.len;
+        while (i > 0) {
+            i -= 1;
+            if (!items[i].attribute.protected) first_unprotected = @intCast(i);
+            unprotected_from[i] = first_unprotected;
+        }
+
+        // Walk addresses downward keeping the lowest starting index seen
+        var first_ge = first_beyond;
+        var a: usize = indexed_addresses;
+        while (a > 0) {
+            a -= 1;
+            first_ge = @min(first_ge, first_at[a]);
+            const from = if (first_ge == no_field) no_field else unprotected_from[first_ge];
+            self.next_unprotected[a] = if (from != no_field) from else wrap_target;
+        }
+        self.next_unprotected_valid = true;
+    }
+
+    /// Drop every field for a new screen (Erase Write). Arena content is
+    /// rewound rather than freed, and the field list keeps its capacity.
+    pub fn reset(self: *FieldManager) void {
+        for (self.fields.items) |*field| {
+            self.free_content(field.content);
+        }
+        self.fields.clearRetainingCapacity();
+        if (self.storage) |*storage| {
+            storage.reset();
+        }
+        @memset(&self.address_index, no_field);
+        // No fields, so no tab targets; the table is current as it stands
+        @memset(&self.next_unprotected, no_field);
+        self.next_unprotected_valid = true;
+    }
+
     /// Clear all fields
     pub fn clear(self: *FieldManager) void {
         for (self.fields.items) |*field| {
@@ -227,3 +411,96 @@ test "field manager clear fields" {
 
     try std.testing.expectEqual(@as(u8, ' '), try field.get_char(0));
 }
+
+test "field manager find field uses first match for overlaps" {
+    var fm = FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    _ = try fm.add_field(0, 10, .{});
+    _ = try fm.add_field(5, 10, .{});
+
+    try std.testing.expectEqual(@as(?usize, 0), fm.find_field_index(7));
+    try std.testing.expectEqual(@as(?usize, 1), fm.find_field_index(12));
+    try std.testing.expectEqual(@as(?usize, null), fm.find_field_index(15));
+    try std.testing.expectEqual(@as(?usize, null), fm.find_field_index(1919));
+}
+
+test "field manager lookup tables match linear scan" {
+    var fm = FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    // 150 fields in screen order, every third one unprotected
+    for (0..150) |i| {
+        const start: u16 = @intCast(i * 12);
+        _ = try fm.add_field(start, 6, .{ .protected = i % 3 != 0 });
+    }
+    fm.rebuild_tab_index();
+    try std.testing.expect(fm.next_unprotected_valid);
+
+    var address: u16 = 0;
+    while (address < indexed_addresses) : (address += 1) {
+        try std.testing.expectEqual(fm.scan_next_unprotected(address), fm.next_unprotected_index(address));
+
+        var expected: ?usize = null;
+        for (fm.fields.items, 0..) |*f, i| {
+            if (f.contains(address)) {
+                expected = i;
+                break;
+            }
+        }
+        try std.testing.expectEqual(expected, fm.find_field_index(address));
+    }
+}
+
+test "field manager invalidate_index picks up attribute changes" {
+    var fm = FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    _ = try fm.add_field(0, 10, .{ .protected = true });
+    const second = try fm.add_field(10, 10, .{ .protected = true });
+    try std.testing.expectEqual(@as(?usize, null), fm.next_unprotected_index(0));
+
+    second.attribute.protected = false;
+    fm.invalidate_index();
+    try std.testing.expectEqual(@as(?usize, 1), fm.next_unprotected_index(0));
+}
+
+test "field manager reset drops fields and reuses arena" {
+    const AllocationTracker = @import("allocation_tracker.zig").AllocationTracker;
+    var tracker = AllocationTracker.init(std.testing.allocator);
+
+    var fm = FieldManager.init(tracker.allocator());
+    defer fm.deinit();
+
+    for (0..150) |i| {
+        _ = try fm.add_field(@intCast(i * 12), 11, .{});
+    }
+    fm.rebuild_tab_index();
+    const warm_allocations = tracker.allocations;
+
+    fm.reset();
+    try std.testing.expectEqual(@as(usize, 0), fm.count());
+    try std.testing.expectEqual(@as(?usize, null), fm.find_field_index(0));
+
+    // Second repaint of the same layout, tab index rebuild and tab
+    // lookups included: no heap traffic
+    for (0..150) |i| {
+        _ = try fm.add_field(@intCast(i * 12), 11, .{});
+    }
+    fm.rebuild_tab_index();
+    try std.testing.expectEqual(@as(?usize, 1), fm.next_unprotected_index(5));
+    try std.testing.expectEqual(warm_allocations, tracker.allocations);
+    try std.testing.expectEqual(@as(u8, ' '), try fm.get_field(0).?.get_char(0));
+}
+
+test "field manager falls back to heap when arena is full" {
+    var fm = FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    _ = try fm.add_field(0, FieldManager.storage_capacity, .{});
+    const overflow = try fm.add_field(0, 10, .{});
+    try std.testing.expect(!fm.storage.?.owns(overflow.content));
+
+    fm.reset();
+    try std.testing.expectEqual(@as(usize, 0), fm.count());
+}
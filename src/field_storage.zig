@@ -25,14 +25,14 @@ pub const FieldDataStorage = struct {
         return Self{
             .allocator = allocator,
             .data = data,
-            .field_ranges = std.ArrayList([2]usize).init(allocator),
+            .field_ranges = .empty,
             .total_capacity = capacity,
         };
     }
 
     pub fn deinit(self: *Self) void {
         self.allocator.free(self.data);
-        self.field_ranges.deinit();
+        self.field_ranges.deinit(self.allocator);
     }
 
     /// Allocate space for a field and return a handle
@@ -47,11 +47,26 @@ pub const FieldDataStorage = struct {
             .length = size,
         };
 
-        try self.field_ranges.append([2]usize{ self.used, size });
+        try self.field_ranges.append(self.allocator, [2]usize{ self.used, size });
         self.used += size;
         return handle;
     }
 
+    /// Release every field at once (e.g. on Erase Write) while keeping the
+    /// buffer and range capacity, so the next screen allocates nothing
+    pub fn reset(self: *Self) void {
+        @memset(self.data[0..self.used], ' ');
+        self.used = 0;
+        self.field_ranges.clearRetainingCapacity();
+    }
+
+    /// Whether a slice points into this storage's buffer
+    pub fn owns(self: *const Self, slice: []const u8) bool {
+        const start = @intFromPtr(self.data.ptr);
+        const addr = @intFromPtr(slice.ptr);
+        return addr >= start and addr + slice.len <= start + self.data.len;
+    }
+
     /// Get data slice for a field handle
     pub fn getData(self: *Self, handle: FieldHandle) []u8 {
         return self.data[handle.offset .. handle.offset + handle.length];
@@ -167,6 +182,23 @@ test "field storage: out of bounds error" {
     try std.testing.expectError(error.OutOfBounds, result);
 }
 
+test "field storage: reset reuses buffer" {
+    var storage = try FieldDataStorage.init(std.testing.allocator, 64);
+    defer storage.deinit();
+
+    const handle = try storage.allocate(32);
+    try storage.setChar(handle, 0, 'X');
+    try std.testing.expect(storage.owns(storage.getData(handle)));
+
+    storage.reset();
+    try std.testing.expectEqual(@as(usize, 0), storage.getStats().used);
+    try std.testing.expectEqual(@as(usize, 0), storage.getStats().fields);
+
+    const again = try storage.allocate(64);
+    try std.testing.expectEqual(@as(u8, ' '), try storage.getChar(again, 0));
+    try std.testing.expect(!storage.owns("outside"));
+}
+
 test "field storage: single allocation vs multiple" {
     var gpa = std.heap.GeneralPurposeAllocator(.{}){};
     defer _ = gpa.deinit();
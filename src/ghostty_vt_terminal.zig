@@ -91,11 +91,7 @@ pub const GhosttyVtTerminal = struct {
         std.debug.print("\x1B[2J\x1B[H", .{});
 
         for (0..self.screen.rows) |row| {
-            for (0..self.screen.cols) |col| {
-                const char = self.screen.buffer[row][col];
-                std.debug.print("{c}", .{char});
-            }
-            std.debug.print("\n", .{});
+            std.debug.print("{s}\n", .{self.screen.row_slice(@intCast(row))});
         }
 
         std.debug.print("\x1B[{};{}H", .{ self.cursor_row + 1, self.cursor_col + 1 });
@@ -11,6 +11,10 @@
 /// try checker.check_endpoint("host1", 23);
 /// checker.update_health_status_from_monitor("host1", 23);
 /// ```
+///
+/// `check_endpoint` probes one endpoint at a time. To probe many endpoints
+/// concurrently, with deadlines and jitter, use `health_probe.ProbeScheduler`,
+/// which publishes results to the load balancer as lock-free snapshots.
 const std = @import("std");
 const Allocator = std.mem.Allocator;
 const load_balancer = @import("load_balancer.zig");
@@ -0,0 +1,409 @@
+//! Concurrent endpoint health probing.
+//!
+//! `ProbeScheduler` checks every registered endpoint from one thread: each
+//! probe is a non-blocking TCP connect, and all probes in flight wait in a
+//! single `poll`, each with its own deadline. A slow or silent host uses
+//! up only its own timeout. Names are resolved in the background through
+//! `DnsCache.resolve_cached`; a target whose name is still resolving waits
+//! without holding up the others. Intervals are jittered so probes spread out
+//! instead of arriving together, and back off exponentially while an
+//! endpoint keeps failing.
+//!
+//! Results go to the load balancer through `LoadBalancer.publish_health`,
+//! which swaps in a new `HealthSnapshot`. Readers pin a snapshot without
+//! waiting and never touch the scheduler's state.
+//!
+//! Usage:
+//! ```zig
+//! var scheduler = ProbeScheduler.init(allocator, &lb, .{});
+//! defer scheduler.deinit();
+//! try scheduler.register_endpoint("lpar1", 23);
+//! try scheduler.start();
+//!
+//! const view = lb.health_snapshot();
+//! defer view.release();
+//! ```
+const std = @import("std");
+const load_balancer = @import("load_balancer.zig");
+const dns_cache = @import("dns_cache.zig");
+
+const posix = std.posix;
+const Allocator = std.mem.Allocator;
+
+pub const ProbeConfig = struct {
+    interval_ms: u32 = 10_000,
+    /// Deadline for one connect
+    timeout_ms: u32 = 2_000,
+    /// Each interval is scaled by a random factor in [1 - jitter, 1 + jitter]
+    jitter: f32 = 0.1,
+    unhealthy_threshold: u32 = 3,
+    recovery_threshold: u32 = 2,
+    /// Ceiling for the backed-off interval of a failing endpoint
+    max_backoff_ms: u32 = 60_000,
+    /// Name cache; null uses `dns_cache.global()`
+    dns: ?*dns_cache.DnsCache = null,
+    clock: *const fn () i64 = std.time.milliTimestamp,
+};
+
+/// How often a target waiting for its name is checked again
+const resolve_poll_ms = 20;
+
+pub const ProbeScheduler = struct {
+    allocator: Allocator,
+    lb: *load_balancer.LoadBalancer,
+    config: ProbeConfig,
+    targets: std.ArrayList(Target) = .empty,
+    /// Reused each step: the wake pipe, then one entry per probe in flight
+    poll_fds: std.ArrayList(posix.pollfd) = .empty,
+    poll_targets: std.ArrayList(usize) = .empty,
+    reports: std.ArrayList(load_balancer.HealthEntry) = .empty,
+    prng: std.Random.DefaultPrng,
+    thread: ?std.Thread = null,
+    stopping: std.atomic.Value(bool) = .init(false),
+    wake_pipe: ?[2]posix.fd_t = null,
+    probes_started: u64 = 0,
+    probes_failed: u64 = 0,
+
+    const Target = struct {
+        host: []const u8,
+        port: u16,
+        status: load_balancer.HealthStatus = .healthy,
+        reachable: bool = true,
+        consecutive_failures: u32 = 0,
+        consecutive_successes: u32 = 0,
+        response_time_ms: u32 = 0,
+        checked_ms: i64 = 0,
+        next_due_ms: i64 = 0,
+        /// Socket of the probe in flight
+        socket: ?posix.socket_t = null,
+        started_ms: i64 = 0,
+        deadline_ms: i64 = 0,
+        /// When the probe started waiting for its name to resolve
+        resolve_started_ms: ?i64 = null,
+    };
+
+    pub fn init(allocator: Allocator, lb: *load_balancer.LoadBalancer, config: ProbeConfig) ProbeScheduler {
+        return .{
+            .allocator = allocator,
+            .lb = lb,
+            .config = config,
+            .prng = .init(@bitCast(std.time.microTimestamp())),
+        };
+    }
+
+    pub fn deinit(self: *ProbeScheduler) void {
+        self.stop();
+        for (self.targets.items) |*target| {
+            if (target.socket) |fd| posix.close(fd);
+            self.allocator.free(target.host);
+        }
+        self.targets.deinit(self.allocator);
+        self.poll_fds.deinit(self.allocator);
+        self.poll_targets.deinit(self.allocator);
+        self.reports.deinit(self.allocator);
+        if (self.wake_pipe) |pipe| {
+            posix.close(pipe[0]);
+            posix.close(pipe[1]);
+        }
+    }
+
+    /// Probe `host:port` from now on; the first probe is due immediately.
+    /// Call before `start`.
+    pub fn register_endpoint(self: *ProbeScheduler, host: []const u8, port: u16) !void {
+        std.debug.assert(self.thread == null);
+        const host_copy = try self.allocator.dupe(u8, host);
+        errdefer self.allocator.free(host_copy);
+        try self.targets.append(self.allocator, .{ .host = host_copy, .port = port });
+        self.resolver().prefetch(host) catch {};
+    }
+
+    fn resolver(self: *ProbeScheduler) *dns_cache.DnsCache {
+        return self.config.dns orelse dns_cache.global();
+    }
+
+    pub fn start(self: *ProbeScheduler) !void {
+        if (self.thread != null) return;
+        if (self.wake_pipe == null) {
+            self.wake_pipe = try posix.pipe2(.{ .NONBLOCK = true, .CLOEXEC = true });
+        }
+        self.stopping.store(false, .release);
+        self.thread = try std.Thread.spawn(.{}, run, .{self});
+    }
+
+    pub fn stop(self: *ProbeScheduler) void {
+        const thread = self.thread orelse return;
+        self.stopping.store(true, .release);
+        _ = posix.write(self.wake_pipe.?[1], &.{1}) catch {};
+        thread.join();
+        self.thread = null;
+    }
+
+    fn run(self: *ProbeScheduler) void {
+        while (!self.stopping.load(.acquire)) {
+            _ = self.step(-1) catch {
+                // Out of memory or poll failure: back off and retry
+                std.Thread.sleep(100 * std.time.ns_per_ms);
+            };
+        }
+    }
+
+    /// Start due probes, wait for probes to finish (at most `max_wait_ms`,
+    /// -1 for the next deadline or due time), settle them and publish the
+    /// results. Returns how many probes finished.
+    pub fn step(self: *ProbeScheduler, max_wait_ms: i32) !usize {
+        var now = self.config.clock();
+        var finished: usize = 0;
+        for (self.targets.items) |*target| {
+            if (target.socket == null and target.next_due_ms <= now) {
+                if (self.begin_probe(target, now)) |result| {
+                    self.settle(target, result, now);
+                    finished += 1;
+                }
+            }
+        }
+
+        self.poll_fds.clearRetainingCapacity();
+        self.poll_targets.clearRetainingCapacity();
+        if (self.wake_pipe) |pipe| {
+            try self.poll_fds.append(self.allocator, .{ .fd = pipe[0], .events = posix.POLL.IN, .revents = 0 });
+        }
+        const first_probe = self.poll_fds.items.len;
+        var wake_at: i64 = std.math.maxInt(i64);
+        for (self.targets.items, 0..) |target, index| {
+            if (target.socket) |fd| {
+                try self.poll_fds.append(self.allocator, .{ .fd = fd, .events = posix.POLL.OUT, .revents = 0 });
+                try self.poll_targets.append(self.allocator, index);
+                wake_at = @min(wake_at, target.deadline_ms);
+            } else {
+                wake_at = @min(wake_at, target.next_due_ms);
+            }
+        }
+
+        var timeout: i32 = if (wake_at == std.math.maxInt(i64))
+            -1
+        else
+            @intCast(std.math.clamp(wake_at - now, 0, std.math.maxInt(i32)));
+        if (max_wait_ms >= 0 and (timeout < 0 or timeout > max_wait_ms)) timeout = max_wait_ms;
+        // Finished probes are published without waiting for the rest
+        if (finished > 0) timeout = 0;
+
+        _ = try posix.poll(self.poll_fds.items, timeout);
+        now = self.config.clock();
+
+        if (first_probe > 0 and self.poll_fds.items[0].revents != 0) {
+            var drain: [16]u8 = undefined;
+            while (posix.read(self.poll_fds.items[0].fd, &drain)) |n| {
+                if (n == 0) break;
+            } else |_| {}
+        }
+
+        for (self.poll_fds.items[first_probe..], self.poll_targets.items) |pfd, index| {
+            const target = &self.targets.items[index];
+            const result: ?bool = if (pfd.revents != 0)
+                connect_succeeded(pfd.fd)
+            else if (now >= target.deadline_ms)
+                false
+            else
+                null;
+            if (result) |ok| {
+                posix.close(target.socket.?);
+                target.socket = null;
+                self.settle(target, ok, now);
+                finished += 1;
+            }
+        }
+
+        if (finished > 0) try self.publish();
+        return finished;
+    }
+
+    /// Open a non-blocking connect. Returns a result when the probe ended
+    /// at once (connected, refused or unresolvable), null when in flight
+    /// or still waiting for its name.
+    fn begin_probe(self: *ProbeScheduler, target: *Target, now: i64) ?bool {
+        var addresses: [1]std.net.Address = undefined;
+        const resolved = self.resolver().resolve_cached(target.host, target.port, &addresses) catch {
+            self.count_probe(target, now);
+            return false;
+        };
+        const count = resolved orelse {
+            // The lookup runs in the background; check back shortly, and
+            // fail the probe once the name has taken a whole timeout
+            const waiting_since = target.resolve_started_ms orelse now;
+            if (now - waiting_since >= self.config.timeout_ms) {
+                self.count_probe(target, now);
+                return false;
+            }
+            target.resolve_started_ms = waiting_since;
+            target.next_due_ms = now + resolve_poll_ms;
+            return null;
+        };
+        self.count_probe(target, now);
+        if (count == 0) return false;
+        const address = addresses[0];
+
+        const fd = posix.socket(
+            address.any.family,
+            posix.SOCK.STREAM | posix.SOCK.NONBLOCK | posix.SOCK.CLOEXEC,
+            posix.IPPROTO.TCP,
+        ) catch return false;
+        posix.connect(fd, &address.any, address.getOsSockLen()) catch |err| switch (err) {
+            error.WouldBlock => {
+                target.socket = fd;
+                return null;
+            },
+            else => {
+                posix.close(fd);
+                return false;
+            },
+        };
+        posix.close(fd);
+        return true;
+    }
+
+    fn count_probe(self: *ProbeScheduler, target: *Target, now: i64) void {
+        self.probes_started += 1;
+        target.started_ms = now;
+        target.deadline_ms = now + self.config.timeout_ms;
+        target.resolve_started_ms = null;
+    }
+
+    fn connect_succeeded(fd: posix.socket_t) bool {
+        posix.getsockoptError(fd) catch return false;
+        return true;
+    }
+
+    /// Record a probe result, move the endpoint's status across the
+    /// thresholds and schedule its next probe
+    fn settle(self: *ProbeScheduler, target: *Target, ok: bool, now: i64) void {
+        target.reachable = ok;
+        target.checked_ms = now;
+        var interval: f32 = @floatFromInt(self.config.interval_ms);
+        if (ok) {
+            target.response_time_ms = @intCast(std.math.clamp(now - target.started_ms, 0, std.math.maxInt(u32)));
+            target.consecutive_successes += 1;
+            target.consecutive_failures = 0;
+            if (target.consecutive_successes >= self.config.recovery_threshold) target.status = .healthy;
+        } else {
+            self.probes_failed += 1;
+            target.consecutive_failures += 1;
+            target.consecutive_successes = 0;
+            target.status = if (target.consecutive_failures >= self.config.unhealthy_threshold) .unhealthy else .degraded;
+            const shift: u5 = @intCast(@min(target.consecutive_failures - 1, 16));
+            interval = @min(interval * @as(f32, @floatFromInt(@as(u32, 1) << shift)), @as(f32, @floatFromInt(self.config.max_backoff_ms)));
+        }
+
+        const spread = self.config.jitter * (self.prng.random().float(f32) * 2 - 1);
+        target.next_due_ms = now + @as(i64, @intFromFloat(@max(0, interval * (1 + spread))));
+    }
+
+    fn publish(self: *ProbeScheduler) !void {
+        self.reports.clearRetainingCapacity();
+        try self.reports.ensureTotalCapacity(self.allocator, self.targets.items.len);
+        for (self.targets.items) |target| {
+            self.reports.appendAssumeCapacity(.{
+                .host = target.host,
+                .port = target.port,
+                .status = target.status,
+                .reachable = target.reachable,
+                .response_time_ms = target.response_time_ms,
+                .consecutive_failures = target.consecutive_failures,
+                .checked_ms = target.checked_ms,
+            });
+        }
+        try self.lb.publish_health(self.reports.items);
+    }
+};
+
+test "probe scheduler probes endpoints concurrently and publishes snapshots" {
+    var lb = try load_balancer.LoadBalancer.init(std.testing.allocator);
+    defer lb.deinit();
+
+    // One listener that accepts, and a port with nothing behind it
+    const loopback = try std.net.Address.parseIp("127.0.0.1", 0);
+    var up = try loopback.listen(.{ .reuse_address = true });
+    defer up.deinit();
+    var closed = try loopback.listen(.{ .reuse_address = true });
+    const down_port = closed.listen_address.getPort();
+    closed.deinit();
+
+    const up_port = up.listen_address.getPort();
+    try lb.add_endpoint("127.0.0.1", up_port, 1);
+
+    var scheduler = ProbeScheduler.init(std.testing.allocator, &lb, .{
+        .unhealthy_threshold = 1,
+        .recovery_threshold = 1,
+        .timeout_ms = 1_000,
+    });
+    defer scheduler.deinit();
+    try scheduler.register_endpoint("127.0.0.1", up_port);
+    try scheduler.register_endpoint("127.0.0.1", down_port);
+
+    var finished: usize = 0;
+    var steps: usize = 0;
+    while (finished < 2 and steps < 50) : (steps += 1) {
+        finished += try scheduler.step(100);
+    }
+    try std.testing.expectEqual(@as(usize, 2), finished);
+    try std.testing.expectEqual(@as(u64, 2), scheduler.probes_started);
+
+    const view = lb.health_snapshot();
+    defer view.release();
+    const healthy = view.snapshot().find("127.0.0.1", up_port) orelse return error.TestExpectedEntry;
+    try std.testing.expect(healthy.reachable);
+    try std.testing.expectEqual(load_balancer.HealthStatus.healthy, healthy.status);
+    const failed = view.snapshot().find("127.0.0.1", down_port) orelse return error.TestExpectedEntry;
+    try std.testing.expectEqual(load_balancer.HealthStatus.unhealthy, failed.status);
+
+    // Next probes are a jittered interval away, not due yet
+    for (scheduler.targets.items) |target| {
+        try std.testing.expect(target.socket == null);
+        try std.testing.expect(target.next_due_ms > target.checked_ms);
+    }
+    try std.testing.expectEqual(@as(usize, 0), try scheduler.step(0));
+}
+
+const SlowResolver = struct {
+    fn resolve(_: Allocator, _: []const u8, out: []std.net.Address) anyerror!usize {
+        std.Thread.sleep(200 * std.time.ns_per_ms);
+        out[0] = try std.net.Address.parseIp("127.0.0.1", 0);
+        return 1;
+    }
+};
+
+test "probe scheduler does not wait for names to resolve" {
+    var lb = try load_balancer.LoadBalancer.init(std.testing.allocator);
+    defer lb.deinit();
+    const loopback = try std.net.Address.parseIp("127.0.0.1", 0);
+    var up = try loopback.listen(.{ .reuse_address = true });
+    defer up.deinit();
+    const up_port = up.listen_address.getPort();
+
+    var cache = dns_cache.DnsCache.init(std.testing.allocator, .{ .resolver = SlowResolver.resolve });
+    defer cache.deinit();
+    var scheduler = ProbeScheduler.init(std.testing.allocator, &lb, .{
+        .recovery_threshold = 1,
+        .timeout_ms = 1_000,
+        .dns = &cache,
+    });
+    defer scheduler.deinit();
+    try scheduler.register_endpoint("slow.example", up_port);
+    try scheduler.register_endpoint("127.0.0.1", up_port);
+
+    // The literal address is probed while the name is still resolving
+    const started = std.time.milliTimestamp();
+    var finished: usize = 0;
+    while (finished == 0) finished += try scheduler.step(100);
+    try std.testing.expect(std.time.milliTimestamp() - started < 180);
+    try std.testing.expectEqual(@as(u64, 1), scheduler.probes_started);
+
+    var steps: usize = 0;
+    while (finished < 2 and steps < 100) : (steps += 1) {
+        finished += try scheduler.step(100);
+    }
+    try std.testing.expectEqual(@as(usize, 2), finished);
+    const view = lb.health_snapshot();
+    defer view.release();
+    const slow = view.snapshot().find("slow.example", up_port) orelse return error.TestExpectedEntry;
+    try std.testing.expect(slow.reachable);
+}
@@ -32,6 +32,7 @@ test "full screen update cycle: erase write with field and data" {
     // 3. Write "Hello"
     var order_data = std.ArrayList(u8).init(allocator);
     defer order_data.deinit();
+    try order_data.append(0x00); // WCC
 
     // Order: Set Buffer Address (0x11) at position 0,0
     try order_data.append(0x11); // Set Buffer Address
@@ -81,6 +82,7 @@ test "full screen update cycle: multiple fields with different attributes" {
     // Field 2 (0,10): Unprotected input area
     var order_data = std.ArrayList(u8).init(allocator);
     defer order_data.deinit();
+    try order_data.append(0x00); // WCC
 
     // Field 1: Protected text at (0,0)
     try order_data.append(0x11); // Set Buffer Address
@@ -142,6 +144,7 @@ test "erase write command clears screen" {
 
     var order_data = std.ArrayList(u8).init(allocator);
     defer order_data.deinit();
+    try order_data.append(0x00); // WCC
 
     try order_data.append(0x11); // Set Buffer Address
     try order_data.append(0x00); // (0, 0)
@@ -191,6 +194,7 @@ test "command execution with boundary conditions" {
     // Write at bottom-right of screen
     var order_data = std.ArrayList(u8).init(allocator);
     defer order_data.deinit();
+    try order_data.append(0x00); // WCC
 
     // Set address to (23, 79) - last position
     const last_addr = parse_utils.address_to_buffer(protocol.Address{ .row = 23, .col = 79 });
@@ -265,6 +269,7 @@ test "layer facade integration: protocol_layer with domain_layer" {
     // Build command using protocol layer
     var order_data = std.ArrayList(u8).init(allocator);
     defer order_data.deinit();
+    try order_data.append(0x00); // WCC
 
     try order_data.append(0x11); // Set Buffer Address
     try order_data.append(0x00);
@@ -299,6 +304,7 @@ test "e2e: complex screen with multiple fields and cursor movement" {
     // Create multi-field screen: label + input on line 0, another field on line 1
     var order_data = std.ArrayList(u8).init(allocator);
     defer order_data.deinit();
+    try order_data.append(0x00); // WCC
 
     // Line 1: Protected label
     try order_data.append(0x11); // Set Buffer Address (0,0)
@@ -354,6 +360,7 @@ test "e2e: sequential commands (erase write then write)" {
     // First command: Erase Write with initial content
     var order_data1 = std.ArrayList(u8).init(allocator);
     defer order_data1.deinit();
+    try order_data1.append(0x00); // WCC
 
     try order_data1.append(0x11);
     try order_data1.append(0x00);
@@ -374,6 +381,7 @@ test "e2e: sequential commands (erase write then write)" {
     // Second command: Write (partial update without erase)
     var order_data2 = std.ArrayList(u8).init(allocator);
     defer order_data2.deinit();
+    try order_data2.append(0x00); // WCC
 
     try order_data2.append(0x11); // Set address to (0, 10)
     try order_data2.append(0x00);
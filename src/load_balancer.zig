@@ -27,10 +27,26 @@ pub const Endpoint = struct {
     host: []const u8,
     port: u16,
     weight: u32 = 1,
-    health_status: HealthStatus = .healthy,
-    active_sessions: u32 = 0,
-    failed_attempts: u32 = 0,
-    last_response_time_ms: u32 = 0,
+    /// Counters are atomic so selection and bookkeeping never take a lock;
+    /// each endpoint gets its own cache line to avoid false sharing
+    health_status: std.atomic.Value(HealthStatus) align(std.atomic.cache_line) = .init(.healthy),
+    active_sessions: std.atomic.Value(u32) = .init(0),
+    failed_attempts: std.atomic.Value(u32) = .init(0),
+    last_response_time_ms: std.atomic.Value(u32) = .init(0),
+    /// Selections routed to this endpoint
+    requests: std.atomic.Value(u64) = .init(0),
+
+    pub fn health(self: *const Endpoint) HealthStatus {
+        return self.health_status.load(.monotonic);
+    }
+
+    pub fn sessions(self: *const Endpoint) u32 {
+        return self.active_sessions.load(.monotonic);
+    }
+
+    pub fn response_time_ms(self: *const Endpoint) u32 {
+        return self.last_response_time_ms.load(.monotonic);
+    }
 };
 
 pub const Strategy = enum {
@@ -50,216 +66,371 @@ pub const LoadBalancerStats = struct {
     request_distribution: std.StringHashMap(u64),
 };
 
+/// Health of one endpoint as last probed
+pub const HealthEntry = struct {
+    host: []const u8,
+    port: u16,
+    status: HealthStatus,
+    /// Whether the last probe succeeded
+    reachable: bool,
+    response_time_ms: u32 = 0,
+    consecutive_failures: u32 = 0,
+    checked_ms: i64 = 0,
+};
+
+/// Immutable view of every probed endpoint at one instant
+pub const HealthSnapshot = struct {
+    generation: u64 = 0,
+    published_ms: i64 = 0,
+    entries: []const HealthEntry = &.{},
+
+    pub fn find(self: *const HealthSnapshot, host: []const u8, port: u16) ?HealthEntry {
+        for (self.entries) |entry| {
+            if (entry.port == port and std.mem.eql(u8, entry.host, host)) return entry;
+        }
+        return null;
+    }
+};
+
+/// Publishes `HealthSnapshot`s to readers that never block.
+///
+/// Three slots rotate. A reader pins the current slot with a counter and
+/// rechecks that it is still current; `publish` fills a slot nobody has
+/// pinned and swaps it in with one atomic store. Only publishers can
+/// wait, for a slot to be unpinned. Slot storage is reused, so a
+/// steady-state publish does not allocate.
+pub const HealthBoard = struct {
+    slots: [slot_count]Slot = .{ .{}, .{}, .{} },
+    current: std.atomic.Value(u8) = .init(0),
+    publish_mutex: std.Thread.Mutex = .{},
+    generation: u64 = 0,
+
+    const slot_count: u8 = 3;
+
+    const Slot = struct {
+        snapshot: HealthSnapshot = .{},
+        entries: std.ArrayList(HealthEntry) = .empty,
+        /// Host names of `entries`, back to back
+        names: std.ArrayList(u8) = .empty,
+        readers: std.atomic.Value(u32) = .init(0),
+    };
+
+    /// A pinned snapshot; call `release` when done with it
+    pub const Guard = struct {
+        board: *HealthBoard,
+        slot: u8,
+
+        pub fn snapshot(self: Guard) *const HealthSnapshot {
+            return &self.board.slots[self.slot].snapshot;
+        }
+
+        pub fn release(self: Guard) void {
+            _ = self.board.slots[self.slot].readers.fetchSub(1, .release);
+        }
+    };
+
+    pub fn deinit(self: *HealthBoard, allocator: Allocator) void {
+        for (&self.slots) |*slot| {
+            slot.entries.deinit(allocator);
+            slot.names.deinit(allocator);
+        }
+    }
+
+    pub fn acquire(self: *HealthBoard) Guard {
+        while (true) {
+            const index = self.current.load(.seq_cst);
+            const slot = &self.slots[index];
+            _ = slot.readers.fetchAdd(1, .seq_cst);
+            // The slot may have been retired (and be being refilled)
+            // between the load and the pin
+            if (self.current.load(.seq_cst) == index) return .{ .board = self, .slot = index };
+            _ = slot.readers.fetchSub(1, .release);
+        }
+    }
+
+    /// Copy `entries` into a free slot and make it current
+    pub fn publish(self: *HealthBoard, allocator: Allocator, entries: []const HealthEntry) !void {
+        self.publish_mutex.lock();
+        defer self.publish_mutex.unlock();
+
+        const current = self.current.load(.seq_cst);
+        var index = current;
+        while (true) {
+            index = (index + 1) % slot_count;
+            if (index == current) {
+                // Every other slot is pinned; readers hold them briefly
+                std.Thread.yield() catch {};
+                continue;
+            }
+            if (self.slots[index].readers.load(.seq_cst) == 0) break;
+        }
+
+        const slot = &self.slots[index];
+        var name_bytes: usize = 0;
+        for (entries) |entry| name_bytes += entry.host.len;
+        slot.entries.clearRetainingCapacity();
+        slot.names.clearRetainingCapacity();
+        try slot.entries.ensureTotalCapacity(allocator, entries.len);
+        try slot.names.ensureTotalCapacity(allocator, name_bytes);
+        for (entries) |entry| {
+            // Capacity is reserved, so earlier host slices stay valid
+            const start = slot.names.items.len;
+            slot.names.appendSliceAssumeCapacity(entry.host);
+            var copy = entry;
+            copy.host = slot.names.items[start..];
+            slot.entries.appendAssumeCapacity(copy);
+        }
+
+        self.generation += 1;
+        slot.snapshot = .{
+            .generation = self.generation,
+            .published_ms = std.time.milliTimestamp(),
+            .entries = slot.entries.items,
+        };
+        self.current.store(index, .seq_cst);
+    }
+};
+
+/// Endpoints as readers see them. Each membership change publishes a new
+/// set; earlier sets and removed endpoints stay allocated until `deinit`,
+/// so a reader holding an old set never touches freed memory. Memory held
+/// that way grows with membership changes, not with traffic.
+const EndpointSet = struct {
+    items: []const *Endpoint,
+};
+
+const no_endpoints: EndpointSet = .{ .items = &.{} };
+
 pub const LoadBalancer = struct {
-    endpoints: std.ArrayList(Endpoint),
+    /// Writer-side membership, guarded by `membership`. Endpoints are boxed
+    /// so pointers handed out stay put.
+    endpoints: std.ArrayList(*Endpoint) = .empty,
     allocator: Allocator,
     strategy: Strategy,
-    stats: LoadBalancerStats,
-    round_robin_index: u32 = 0,
-    mutex: std.Thread.Mutex = .{},
-    random_gen: std.Random.DefaultPrng,
+    /// Keys borrow `Endpoint.host`; values are refreshed by `get_stats`
+    request_distribution: std.StringHashMap(u64),
+    total_requests: std.atomic.Value(u64) = .init(0),
+    successful_requests: std.atomic.Value(u64) = .init(0),
+    failed_requests: std.atomic.Value(u64) = .init(0),
+    round_robin_index: std.atomic.Value(u32) = .init(0),
+    random_state: std.atomic.Value(u64),
+    /// Current reader view of `endpoints`; selection and the `record_*`
+    /// calls load it and take no lock
+    published: std.atomic.Value(*const EndpointSet) = .init(&no_endpoints),
+    /// Every set ever published, freed by `deinit`
+    sets: std.ArrayList(*EndpointSet) = .empty,
+    /// Removed endpoints, freed by `deinit`
+    removed: std.ArrayList(*Endpoint) = .empty,
+    /// Serializes membership changes and `get_stats`; readers never take it
+    membership: std.Thread.Mutex = .{},
+    /// Latest probe results (see `health_probe.ProbeScheduler`)
+    health: HealthBoard = .{},
 
     /// Initialize load balancer with default round-robin strategy
     pub fn init(allocator: Allocator) !LoadBalancer {
-        var lb = LoadBalancer{
-            .endpoints = std.ArrayList(Endpoint).init(allocator),
+        return LoadBalancer{
             .allocator = allocator,
             .strategy = .round_robin,
-            .stats = .{
-                .strategy = .round_robin,
-                .request_distribution = std.StringHashMap(u64).init(allocator),
-            },
-            .random_gen = std.Random.DefaultPrng.init(@intCast(std.time.microTimestamp())),
+            .request_distribution = std.StringHashMap(u64).init(allocator),
+            .random_state = .init(@bitCast(std.time.microTimestamp())),
         };
-        return lb;
     }
 
     /// Deinitialize load balancer
     pub fn deinit(self: *LoadBalancer) void {
-        for (self.endpoints.items) |endpoint| {
-            self.allocator.free(endpoint.host);
+        for (self.endpoints.items) |endpoint| self.destroy_endpoint(endpoint);
+        for (self.removed.items) |endpoint| self.destroy_endpoint(endpoint);
+        for (self.sets.items) |set| {
+            self.allocator.free(set.items);
+            self.allocator.destroy(set);
         }
-        self.endpoints.deinit();
+        self.endpoints.deinit(self.allocator);
+        self.removed.deinit(self.allocator);
+        self.sets.deinit(self.allocator);
+        self.request_distribution.deinit();
+        self.health.deinit(self.allocator);
+    }
 
-        var iter = self.stats.request_distribution.keyIterator();
-        while (iter.next()) |key| {
-            self.allocator.free(key.*);
-        }
-        self.stats.request_distribution.deinit();
+    fn destroy_endpoint(self: *LoadBalancer, endpoint: *Endpoint) void {
+        self.allocator.free(endpoint.host);
+        self.allocator.destroy(endpoint);
     }
 
     /// Add endpoint to load balancer
     pub fn add_endpoint(self: *LoadBalancer, host: []const u8, port: u16, weight: u32) !void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        self.membership.lock();
+        defer self.membership.unlock();
 
         const host_copy = try self.allocator.dupe(u8, host);
         errdefer self.allocator.free(host_copy);
 
-        try self.endpoints.append(.{
+        const endpoint = try self.allocator.create(Endpoint);
+        errdefer self.allocator.destroy(endpoint);
+        endpoint.* = .{
             .host = host_copy,
             .port = port,
             .weight = weight,
-        });
+        };
+
+        try self.endpoints.ensureUnusedCapacity(self.allocator, 1);
+        try self.request_distribution.ensureUnusedCapacity(1);
+        const items = try self.allocator.alloc(*Endpoint, self.endpoints.items.len + 1);
+        errdefer self.allocator.free(items);
+        @memcpy(items[0..self.endpoints.items.len], self.endpoints.items);
+        items[self.endpoints.items.len] = endpoint;
+        try self.publish_endpoints(items);
 
+        self.endpoints.appendAssumeCapacity(endpoint);
         // Initialize request distribution tracking
-        try self.stats.request_distribution.put(host_copy, 0);
+        self.request_distribution.putAssumeCapacity(host_copy, 0);
     }
 
-    /// Remove endpoint from load balancer
+    /// Remove endpoint from load balancer. Its memory is kept until
+    /// `deinit`, since selections in flight may still hold it.
     pub fn remove_endpoint(self: *LoadBalancer, host: []const u8) bool {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        self.membership.lock();
+        defer self.membership.unlock();
+
+        const index = for (self.endpoints.items, 0..) |endpoint, i| {
+            if (std.mem.eql(u8, endpoint.host, host)) break i;
+        } else return false;
+        const endpoint = self.endpoints.items[index];
+
+        self.removed.ensureUnusedCapacity(self.allocator, 1) catch return false;
+        const items = self.allocator.alloc(*Endpoint, self.endpoints.items.len - 1) catch return false;
+        @memcpy(items[0..index], self.endpoints.items[0..index]);
+        @memcpy(items[index..], self.endpoints.items[index + 1 ..]);
+        self.publish_endpoints(items) catch {
+            self.allocator.free(items);
+            return false;
+        };
 
-        for (self.endpoints.items, 0..) |endpoint, i| {
-            if (std.mem.eql(u8, endpoint.host, host)) {
-                const removed = self.endpoints.swapRemove(i);
-                self.allocator.free(removed.host);
-                _ = self.stats.request_distribution.remove(host);
-                return true;
-            }
-        }
-        return false;
+        _ = self.endpoints.orderedRemove(index);
+        _ = self.request_distribution.remove(endpoint.host);
+        self.removed.appendAssumeCapacity(endpoint);
+        return true;
+    }
+
+    /// Make `items` the reader view; takes ownership once it succeeds
+    fn publish_endpoints(self: *LoadBalancer, items: []const *Endpoint) !void {
+        try self.sets.ensureUnusedCapacity(self.allocator, 1);
+        const set = try self.allocator.create(EndpointSet);
+        set.* = .{ .items = items };
+        self.sets.appendAssumeCapacity(set);
+        self.published.store(set, .release);
+    }
+
+    /// The endpoints as of now. The slice stays valid until `deinit`;
+    /// later membership changes publish a new one.
+    pub fn endpoint_view(self: *const LoadBalancer) []const *Endpoint {
+        return self.published.load(.acquire).items;
     }
 
     /// Select endpoint based on current strategy
+    /// Prefers healthy endpoints and falls back to degraded ones.
     pub fn select_endpoint(self: *LoadBalancer, strategy: Strategy) !*Endpoint {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        if (self.endpoints.items.len == 0) {
+        const endpoints = self.endpoint_view();
+        if (endpoints.len == 0) {
             return error.NoEndpointsAvailable;
         }
 
-        // Filter healthy endpoints
-        var healthy_indices = std.ArrayList(usize).init(self.allocator);
-        defer healthy_indices.deinit();
-
-        for (self.endpoints.items, 0..) |endpoint, i| {
-            if (endpoint.health_status == .healthy) {
-                try healthy_indices.append(i);
-            }
-        }
-
-        // Fallback to degraded if no healthy endpoints
-        if (healthy_indices.items.len == 0) {
-            for (self.endpoints.items, 0..) |endpoint, i| {
-                if (endpoint.health_status == .degraded) {
-                    try healthy_indices.append(i);
-                }
-            }
+        var status: HealthStatus = .healthy;
+        var eligible = count_with_status(endpoints, status);
+        if (eligible == 0) {
+            status = .degraded;
+            eligible = count_with_status(endpoints, status);
         }
-
-        if (healthy_indices.items.len == 0) {
+        if (eligible == 0) {
             return error.NoHealthyEndpointsAvailable;
         }
 
-        const index = switch (strategy) {
-            .round_robin => try self.select_round_robin(healthy_indices.items),
-            .weighted_round_robin => try self.select_weighted_round_robin(healthy_indices.items),
-            .least_connections => try self.select_least_connections(healthy_indices.items),
-            .least_response_time => try self.select_least_response_time(healthy_indices.items),
-            .random => try self.select_random(healthy_indices.items),
+        const selected = switch (strategy) {
+            .round_robin => self.select_round_robin(endpoints, status, eligible),
+            .weighted_round_robin => self.select_weighted_round_robin(endpoints, status),
+            .least_connections => select_least_connections(endpoints, status),
+            .least_response_time => select_least_response_time(endpoints, status),
+            .random => self.select_random(endpoints, status, eligible),
         };
+        const endpoint = selected orelse return error.NoHealthyEndpointsAvailable;
 
-        const endpoint = &self.endpoints.items[index];
-        endpoint.active_sessions += 1;
-        self.stats.total_requests += 1;
-        self.stats.successful_requests += 1;
-        self.stats.active_sessions = self.count_active_sessions();
-
-        // Update distribution stats
-        if (self.stats.request_distribution.getPtr(endpoint.host)) |count| {
-            count.* += 1;
-        }
+        _ = endpoint.active_sessions.fetchAdd(1, .monotonic);
+        _ = endpoint.requests.fetchAdd(1, .monotonic);
+        _ = self.total_requests.fetchAdd(1, .monotonic);
+        _ = self.successful_requests.fetchAdd(1, .monotonic);
 
         return endpoint;
     }
 
     /// Record endpoint failure
     pub fn record_failure(self: *LoadBalancer, host: []const u8) void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        for (self.endpoints.items) |*endpoint| {
-            if (std.mem.eql(u8, endpoint.host, host)) {
-                endpoint.failed_attempts += 1;
-                self.stats.failed_requests += 1;
-                break;
-            }
+        if (self.find(host)) |endpoint| {
+            _ = endpoint.failed_attempts.fetchAdd(1, .monotonic);
+            _ = self.failed_requests.fetchAdd(1, .monotonic);
         }
     }
 
     /// Record endpoint success
     pub fn record_success(self: *LoadBalancer, host: []const u8) void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        for (self.endpoints.items) |*endpoint| {
-            if (std.mem.eql(u8, endpoint.host, host)) {
-                endpoint.failed_attempts = 0;
-                break;
-            }
+        if (self.find(host)) |endpoint| {
+            endpoint.failed_attempts.store(0, .monotonic);
         }
     }
 
     /// Update endpoint health status
     pub fn set_health_status(self: *LoadBalancer, host: []const u8, status: HealthStatus) void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        for (self.endpoints.items) |*endpoint| {
-            if (std.mem.eql(u8, endpoint.host, host)) {
-                endpoint.health_status = status;
-                break;
-            }
+        if (self.find(host)) |endpoint| {
+            endpoint.health_status.store(status, .monotonic);
         }
     }
 
     /// Update endpoint response time
     pub fn record_response_time(self: *LoadBalancer, host: []const u8, response_time_ms: u32) void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        for (self.endpoints.items) |*endpoint| {
-            if (std.mem.eql(u8, endpoint.host, host)) {
-                endpoint.last_response_time_ms = response_time_ms;
-                break;
-            }
+        if (self.find(host)) |endpoint| {
+            endpoint.last_response_time_ms.store(response_time_ms, .monotonic);
         }
     }
 
     /// Decrement active sessions for endpoint
     pub fn decrement_active_sessions(self: *LoadBalancer, host: []const u8) void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        const endpoint = self.find(host) orelse return;
+        var current = endpoint.active_sessions.load(.monotonic);
+        while (current > 0) {
+            current = endpoint.active_sessions.cmpxchgWeak(current, current - 1, .monotonic, .monotonic) orelse break;
+        }
+    }
 
-        for (self.endpoints.items) |*endpoint| {
-            if (std.mem.eql(u8, endpoint.host, host)) {
-                if (endpoint.active_sessions > 0) {
-                    endpoint.active_sessions -= 1;
-                }
-                self.stats.active_sessions = self.count_active_sessions();
-                break;
-            }
+    /// Publish probe results: swap in a new health snapshot and apply each
+    /// status and response time to its endpoint
+    pub fn publish_health(self: *LoadBalancer, entries: []const HealthEntry) !void {
+        try self.health.publish(self.allocator, entries);
+
+        for (entries) |entry| {
+            const endpoint = self.find_address(entry.host, entry.port) orelse continue;
+            endpoint.health_status.store(entry.status, .monotonic);
+            if (entry.reachable) endpoint.last_response_time_ms.store(entry.response_time_ms, .monotonic);
         }
     }
 
+    /// Pin the latest health snapshot; release the guard when done
+    pub fn health_snapshot(self: *LoadBalancer) HealthBoard.Guard {
+        return self.health.acquire();
+    }
+
     /// Set load balancer strategy
     pub fn set_strategy(self: *LoadBalancer, strategy: Strategy) void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        self.membership.lock();
+        defer self.membership.unlock();
 
         self.strategy = strategy;
-        self.stats.strategy = strategy;
     }
 
     /// Get endpoint by host
     pub fn get_endpoint(self: *LoadBalancer, host: []const u8) ?*Endpoint {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        return self.find(host);
+    }
 
-        for (self.endpoints.items) |*endpoint| {
+    fn find(self: *LoadBalancer, host: []const u8) ?*Endpoint {
+        for (self.endpoint_view()) |endpoint| {
             if (std.mem.eql(u8, endpoint.host, host)) {
                 return endpoint;
             }
@@ -267,99 +438,142 @@ pub const LoadBalancer = struct {
         return null;
     }
 
+    /// Several endpoints may share a host on different ports
+    fn find_address(self: *LoadBalancer, host: []const u8, port: u16) ?*Endpoint {
+        for (self.endpoint_view()) |endpoint| {
+            if (endpoint.port == port and std.mem.eql(u8, endpoint.host, host)) {
+                return endpoint;
+            }
+        }
+        return null;
+    }
+
     /// Count total active sessions across all endpoints
-    fn count_active_sessions(self: *LoadBalancer) u32 {
+    fn count_active_sessions(endpoints: []const *Endpoint) u32 {
         var count: u32 = 0;
-        for (self.endpoints.items) |endpoint| {
-            count += endpoint.active_sessions;
+        for (endpoints) |endpoint| {
+            count += endpoint.sessions();
+        }
+        return count;
+    }
+
+    fn count_with_status(endpoints: []const *Endpoint, status: HealthStatus) usize {
+        var count: usize = 0;
+        for (endpoints) |endpoint| {
+            if (endpoint.health() == status) count += 1;
         }
         return count;
     }
 
     /// Get statistics snapshot
+    /// Counters are read with relaxed ordering, so the snapshot is an
+    /// aggregate rather than a single consistent instant. Only membership
+    /// changes wait on it; selection keeps running.
     pub fn get_stats(self: *LoadBalancer) LoadBalancerStats {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        self.membership.lock();
+        defer self.membership.unlock();
+
+        for (self.endpoints.items) |endpoint| {
+            if (self.request_distribution.getPtr(endpoint.host)) |count| {
+                count.* = endpoint.requests.load(.monotonic);
+            }
+        }
 
-        var stats = self.stats;
-        stats.active_sessions = self.count_active_sessions();
-        return stats;
+        return .{
+            .total_requests = self.total_requests.load(.monotonic),
+            .successful_requests = self.successful_requests.load(.monotonic),
+            .failed_requests = self.failed_requests.load(.monotonic),
+            .active_sessions = count_active_sessions(self.endpoints.items),
+            .strategy = self.strategy,
+            .request_distribution = self.request_distribution,
+        };
     }
 
-    /// Round-robin selection
-    fn select_round_robin(self: *LoadBalancer, healthy_indices: []usize) !usize {
-        if (healthy_indices.len == 0) return error.NoHealthyEndpointsAvailable;
+    /// Pick the `n`th endpoint with `status`, or the last one seen if
+    /// health changed underneath the caller
+    fn nth_with_status(endpoints: []const *Endpoint, status: HealthStatus, n: usize) ?*Endpoint {
+        var seen: usize = 0;
+        var last: ?*Endpoint = null;
+        for (endpoints) |endpoint| {
+            if (endpoint.health() != status) continue;
+            if (seen == n) return endpoint;
+            seen += 1;
+            last = endpoint;
+        }
+        return last;
+    }
 
-        const index = self.round_robin_index % healthy_indices.len;
-        self.round_robin_index += 1;
-        return healthy_indices[index];
+    /// Round-robin selection
+    fn select_round_robin(self: *LoadBalancer, endpoints: []const *Endpoint, status: HealthStatus, eligible: usize) ?*Endpoint {
+        const ticket = self.round_robin_index.fetchAdd(1, .monotonic);
+        return nth_with_status(endpoints, status, ticket % eligible);
     }
 
     /// Weighted round-robin selection
-    fn select_weighted_round_robin(self: *LoadBalancer, healthy_indices: []usize) !usize {
-        if (healthy_indices.len == 0) return error.NoHealthyEndpointsAvailable;
-
+    fn select_weighted_round_robin(self: *LoadBalancer, endpoints: []const *Endpoint, status: HealthStatus) ?*Endpoint {
         var total_weight: u32 = 0;
-        for (healthy_indices) |idx| {
-            total_weight += self.endpoints.items[idx].weight;
+        for (endpoints) |endpoint| {
+            if (endpoint.health() == status) total_weight += endpoint.weight;
         }
 
-        if (total_weight == 0) return healthy_indices[0];
+        if (total_weight == 0) return nth_with_status(endpoints, status, 0);
 
-        var weighted_choice = (self.round_robin_index % total_weight);
-        self.round_robin_index += 1;
+        const weighted_choice = self.round_robin_index.fetchAdd(1, .monotonic) % total_weight;
 
         var cumulative: u32 = 0;
-        for (healthy_indices) |idx| {
-            cumulative += self.endpoints.items[idx].weight;
+        for (endpoints) |endpoint| {
+            if (endpoint.health() != status) continue;
+            cumulative += endpoint.weight;
             if (weighted_choice < cumulative) {
-                return idx;
+                return endpoint;
             }
         }
 
-        return healthy_indices[0];
+        return nth_with_status(endpoints, status, 0);
     }
 
     /// Least connections selection
-    fn select_least_connections(self: *LoadBalancer, healthy_indices: []usize) !usize {
-        if (healthy_indices.len == 0) return error.NoHealthyEndpointsAvailable;
-
-        var min_connections = self.endpoints.items[healthy_indices[0]].active_sessions;
-        var selected_idx: usize = 0;
-
-        for (healthy_indices, 0..) |idx, i| {
-            if (self.endpoints.items[idx].active_sessions < min_connections) {
-                min_connections = self.endpoints.items[idx].active_sessions;
-                selected_idx = i;
+    fn select_least_connections(endpoints: []const *Endpoint, status: HealthStatus) ?*Endpoint {
+        var best: ?*Endpoint = null;
+        var min_connections: u32 = std.math.maxInt(u32);
+
+        for (endpoints) |endpoint| {
+            if (endpoint.health() != status) continue;
+            const connections = endpoint.sessions();
+            if (best == null or connections < min_connections) {
+                min_connections = connections;
+                best = endpoint;
             }
         }
 
-        return healthy_indices[selected_idx];
+        return best;
     }
 
     /// Least response time selection
-    fn select_least_response_time(self: *LoadBalancer, healthy_indices: []usize) !usize {
-        if (healthy_indices.len == 0) return error.NoHealthyEndpointsAvailable;
-
-        var min_response_time = self.endpoints.items[healthy_indices[0]].last_response_time_ms;
-        var selected_idx: usize = 0;
-
-        for (healthy_indices, 0..) |idx, i| {
-            if (self.endpoints.items[idx].last_response_time_ms < min_response_time) {
-                min_response_time = self.endpoints.items[idx].last_response_time_ms;
-                selected_idx = i;
+    fn select_least_response_time(endpoints: []const *Endpoint, status: HealthStatus) ?*Endpoint {
+        var best: ?*Endpoint = null;
+        var min_response_time: u32 = std.math.maxInt(u32);
+
+        for (endpoints) |endpoint| {
+            if (endpoint.health() != status) continue;
+            const response_time = endpoint.response_time_ms();
+            if (best == null or response_time < min_response_time) {
+                min_response_time = response_time;
+                best = endpoint;
             }
         }
 
-        return healthy_indices[selected_idx];
+        return best;
     }
 
     /// Random selection
-    fn select_random(self: *LoadBalancer, healthy_indices: []usize) !usize {
-        if (healthy_indices.len == 0) return error.NoHealthyEndpointsAvailable;
-
-        const random_idx = self.random_gen.random().uintLessThan(usize, healthy_indices.len);
-        return healthy_indices[random_idx];
+    fn select_random(self: *LoadBalancer, endpoints: []const *Endpoint, status: HealthStatus, eligible: usize) ?*Endpoint {
+        // Lock-free splitmix64 step over a shared counter
+        var z = self.random_state.fetchAdd(0x9E3779B97F4A7C15, .monotonic) +% 0x9E3779B97F4A7C15;
+        z = (z ^ (z >> 30)) *% 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) *% 0x94D049BB133111EB;
+        z ^= z >> 31;
+        return nth_with_status(endpoints, status, @intCast(z % eligible));
     }
 };
 
@@ -453,7 +667,7 @@ test "LoadBalancer: least connections selection" {
 
     // Manually set active sessions
     if (lb.get_endpoint("host1")) |ep| {
-        ep.active_sessions = 5;
+        ep.active_sessions.store(5, .monotonic);
     }
 
     const ep = try lb.select_endpoint(.least_connections);
@@ -499,3 +713,124 @@ test "LoadBalancer: statistics tracking" {
     try testing.expectEqual(stats.total_requests, 2);
     try testing.expectEqual(stats.successful_requests, 2);
 }
+
+test "LoadBalancer: concurrent selection keeps counters exact" {
+    var lb = try LoadBalancer.init(testing.allocator);
+    defer lb.deinit();
+
+    try lb.add_endpoint("host1", 23, 1);
+    try lb.add_endpoint("host2", 23, 1);
+
+    const Worker = struct {
+        fn run(balancer: *LoadBalancer) void {
+            for (0..1000) |_| {
+                const ep = balancer.select_endpoint(.least_connections) catch return;
+                balancer.record_response_time(ep.host, 10);
+                balancer.decrement_active_sessions(ep.host);
+            }
+        }
+    };
+
+    var threads: [4]std.Thread = undefined;
+    for (&threads) |*thread| thread.* = try std.Thread.spawn(.{}, Worker.run, .{&lb});
+    for (threads) |thread| thread.join();
+
+    const stats = lb.get_stats();
+    try testing.expectEqual(@as(u64, 4000), stats.total_requests);
+    try testing.expectEqual(@as(u32, 0), stats.active_sessions);
+    try testing.expectEqual(
+        @as(u64, 4000),
+        stats.request_distribution.get("host1").? + stats.request_distribution.get("host2").?,
+    );
+}
+
+test "LoadBalancer: selection runs lock-free across membership changes" {
+    var lb = try LoadBalancer.init(testing.allocator);
+    defer lb.deinit();
+
+    try lb.add_endpoint("host1", 23, 1);
+
+    const Worker = struct {
+        fn run(balancer: *LoadBalancer, done: *std.atomic.Value(bool)) void {
+            while (!done.load(.acquire)) {
+                const ep = balancer.select_endpoint(.round_robin) catch continue;
+                balancer.decrement_active_sessions(ep.host);
+            }
+        }
+    };
+
+    var done = std.atomic.Value(bool).init(false);
+    var threads: [2]std.Thread = undefined;
+    for (&threads) |*thread| thread.* = try std.Thread.spawn(.{}, Worker.run, .{ &lb, &done });
+
+    // Removed endpoints stay valid for selections still holding them
+    for (0..200) |_| {
+        try lb.add_endpoint("host2", 23, 1);
+        try testing.expect(lb.remove_endpoint("host2"));
+    }
+    done.store(true, .release);
+    for (threads) |thread| thread.join();
+
+    try testing.expectEqual(@as(usize, 1), lb.endpoint_view().len);
+    try testing.expectEqualStrings("host1", lb.endpoint_view()[0].host);
+    try testing.expectEqual(lb.endpoints.items.len, lb.endpoint_view().len);
+}
+
+test "LoadBalancer: health snapshots swap under pinned readers" {
+    var lb = try LoadBalancer.init(testing.allocator);
+    defer lb.deinit();
+
+    try lb.add_endpoint("host1", 23, 1);
+    try lb.add_endpoint("host2", 23, 1);
+
+    // Nothing published yet: an empty snapshot, never a wait
+    const empty = lb.health_snapshot();
+    try testing.expectEqual(@as(usize, 0), empty.snapshot().entries.len);
+
+    var host = "host1".*;
+    try lb.publish_health(&.{
+        .{ .host = &host, .port = 23, .status = .healthy, .reachable = true, .response_time_ms = 12 },
+        .{ .host = "host2", .port = 23, .status = .unhealthy, .reachable = false },
+    });
+    // Entries are copied; the caller's strings may change
+    host[4] = 'X';
+
+    const pinned = lb.health_snapshot();
+    try testing.expectEqual(@as(u32, 12), pinned.snapshot().find("host1", 23).?.response_time_ms);
+    try testing.expectEqual(HealthStatus.unhealthy, lb.get_endpoint("host2").?.health());
+
+    // Two pinned slots still leave one to publish into
+    try lb.publish_health(&.{.{ .host = "host2", .port = 23, .status = .healthy, .reachable = true }});
+    try testing.expect(pinned.snapshot().find("host1", 23) != null);
+    empty.release();
+    pinned.release();
+
+    const latest = lb.health_snapshot();
+    defer latest.release();
+    try testing.expectEqual(@as(u64, 2), latest.snapshot().generation);
+    try testing.expect(latest.snapshot().find("host1", 23) == null);
+}
+
+test "LoadBalancer: published health matches host and port" {
+    var lb = try LoadBalancer.init(testing.allocator);
+    defer lb.deinit();
+
+    try lb.add_endpoint("host1", 23, 1);
+    try lb.add_endpoint("host1", 992, 1);
+
+    try lb.publish_health(&.{
+        .{ .host = "host1", .port = 992, .status = .unhealthy, .reachable = false },
+        .{ .host = "host1", .port = 23, .status = .degraded, .reachable = true, .response_time_ms = 40 },
+    });
+
+    for (lb.endpoints.items) |endpoint| {
+        switch (endpoint.port) {
+            23 => {
+                try testing.expectEqual(HealthStatus.degraded, endpoint.health());
+                try testing.expectEqual(@as(u32, 40), endpoint.response_time_ms());
+            },
+            992 => try testing.expectEqual(HealthStatus.unhealthy, endpoint.health()),
+            else => unreachable,
+        }
+    }
+}
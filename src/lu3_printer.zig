@@ -1,6 +1,7 @@
 const std = @import("std");
 const protocol = @import("protocol.zig");
 const error_context = @import("error_context.zig");
+const ebcdic = @import("ebcdic.zig");
 
 /// LU3 (Logical Unit 3) Printing Support
 /// Handles print job requests and management for TN3270 sessions
@@ -72,6 +73,7 @@ pub const PrintFormat = enum {
 
 /// Print job metadata
 pub const PrintJob = struct {
+    allocator: std.mem.Allocator,
     job_id: u32,
     timestamp: i64,
     status: PrintJobStatus = .queued,
@@ -83,21 +85,22 @@ pub const PrintJob = struct {
 
     pub fn init(allocator: std.mem.Allocator, job_id: u32) PrintJob {
         return .{
+            .allocator = allocator,
             .job_id = job_id,
             .timestamp = std.time.timestamp(),
-            .data = std.ArrayList(u8).init(allocator),
+            .data = .empty,
         };
     }
 
     pub fn deinit(self: *PrintJob, allocator: std.mem.Allocator) void {
-        self.data.deinit();
+        self.data.deinit(allocator);
         if (self.error_message) |msg| {
             allocator.free(msg);
         }
     }
 
     pub fn add_data(self: *PrintJob, data: []const u8) !void {
-        try self.data.appendSlice(data);
+        try self.data.appendSlice(self.allocator, data);
     }
 
     pub fn size_bytes(self: PrintJob) usize {
@@ -116,7 +119,7 @@ pub const PrintQueue = struct {
     pub fn init(allocator: std.mem.Allocator) PrintQueue {
         return .{
             .allocator = allocator,
-            .jobs = std.ArrayList(PrintJob).init(allocator),
+            .jobs = .empty,
         };
     }
 
@@ -124,7 +127,7 @@ pub const PrintQueue = struct {
         for (self.jobs.items) |*job| {
             job.deinit(self.allocator);
         }
-        self.jobs.deinit();
+        self.jobs.deinit(self.allocator);
     }
 
     /// Create and queue a new print job
@@ -139,7 +142,7 @@ pub const PrintQueue = struct {
         var job = PrintJob.init(self.allocator, job_id);
         job.format = format;
 
-        try self.jobs.append(job);
+        try self.jobs.append(self.allocator, job);
         return &self.jobs.items[self.jobs.items.len - 1];
     }
 
@@ -185,13 +188,14 @@ pub const PrintQueue = struct {
 
     /// Get all queued jobs
     pub fn get_queued_jobs(self: PrintQueue, allocator: std.mem.Allocator) ![]u32 {
-        var job_ids = std.ArrayList(u32).init(allocator);
+        var job_ids: std.ArrayList(u32) = .empty;
+        errdefer job_ids.deinit(allocator);
         for (self.jobs.items) |job| {
             if (job.status == .queued) {
-                try job_ids.append(job.job_id);
+                try job_ids.append(allocator, job.job_id);
             }
         }
-        return job_ids.toOwnedSlice();
+        return job_ids.toOwnedSlice(allocator);
     }
 
     /// Statistics for the queue
@@ -247,6 +251,7 @@ pub const PrintCommandDetector = struct {
 
     /// Detect if buffer contains a print command
     pub fn is_print_command(self: PrintCommandDetector, buffer: []const u8) bool {
+        _ = self;
         if (buffer.len < 2) return false;
 
         // Check for print command markers
@@ -260,18 +265,16 @@ pub const PrintCommandDetector = struct {
 
     /// Extract print data from buffer
     pub fn extract_print_data(self: PrintCommandDetector, buffer: []const u8) ![]u8 {
-        if (buffer.len < 2) return error.InsufficientData;
+        return try self.allocator.dupe(u8, try payload(buffer));
+    }
 
-        // Find end of print data (typically terminated by 0xFF)
-        var end: usize = buffer.len;
-        for (buffer[1..], 1..) |byte, idx| {
-            if (byte == 0xFF) {
-                end = idx;
-                break;
-            }
-        }
+    /// Print data within `buffer`, without copying
+    pub fn payload(buffer: []const u8) ![]const u8 {
+        if (buffer.len < 2) return error.InsufficientData;
 
-        return try self.allocator.dupe(u8, buffer[1..end]);
+        // Print data is typically terminated by 0xFF
+        const end = std.mem.indexOfScalarPos(u8, buffer, 1, 0xFF) orelse buffer.len;
+        return buffer[1..end];
     }
 };
 
@@ -346,6 +349,366 @@ pub const SCSProcessor = struct {
     }
 };
 
+/// Longest SCS control sequence: ESC, command byte and four parameters
+const max_sequence_len = 6;
+
+/// Widest line the streaming formatter renders; later columns are dropped
+pub const max_line_width = 256;
+
+/// Formats an SCS stream as it arrives, holding at most one line.
+///
+/// Graphic bytes (0x40 and up) are EBCDIC and come out as ASCII. Position
+/// commands become spaces, newlines and form feeds; a line feed past the
+/// page height starts a new page. HT (0x09) advances to the next 8-column
+/// stop and VT (0x0B) acts as a line feed. A sequence split across chunks
+/// is completed by the next `feed`. Moves back up the page start a new
+/// page, since a stream cannot be rewound.
+pub const ScsFormatter = struct {
+    out: *std.Io.Writer,
+    column: u16 = 1,
+    row: u16 = 1,
+    page_width: u16 = 132,
+    page_height: u16 = 66,
+    line: [max_line_width]u8 = undefined,
+    line_len: usize = 0,
+    pending: [max_sequence_len]u8 = undefined,
+    pending_len: usize = 0,
+    page_dirty: bool = false,
+    line_count: u32 = 0,
+    page_count: u32 = 0,
+    bytes_written: u64 = 0,
+
+    pub fn init(out: *std.Io.Writer) ScsFormatter {
+        return .{ .out = out };
+    }
+
+    /// Format the next chunk of SCS data
+    pub fn feed(self: *ScsFormatter, chunk: []const u8) !void {
+        var rest = chunk;
+        if (self.pending_len > 0) {
+            const held = self.pending_len;
+            const take = @min(rest.len, self.pending.len - held);
+            @memcpy(self.pending[held..][0..take], rest[0..take]);
+            const used = try self.step(self.pending[0 .. held + take]) orelse {
+                self.pending_len = held + take;
+                return;
+            };
+            rest = rest[used - held ..];
+            self.pending_len = 0;
+        }
+
+        while (rest.len > 0) {
+            const used = try self.step(rest) orelse {
+                @memcpy(self.pending[0..rest.len], rest);
+                self.pending_len = rest.len;
+                return;
+            };
+            rest = rest[used..];
+        }
+    }
+
+    /// Write the last line and flush the output. An incomplete trailing
+    /// sequence is dropped.
+    pub fn finish(self: *ScsFormatter) !void {
+        if (self.line_len > 0) try self.end_line();
+        if (self.page_dirty) self.page_count += 1;
+        self.page_dirty = false;
+        self.pending_len = 0;
+        try self.out.flush();
+    }
+
+    /// Pass bytes through unformatted (raw jobs)
+    pub fn write_raw(self: *ScsFormatter, bytes: []const u8) !void {
+        try self.out.writeAll(bytes);
+        self.bytes_written += bytes.len;
+    }
+
+    /// Handle the text run or control sequence at the start of `bytes`;
+    /// null when the sequence is not complete yet
+    fn step(self: *ScsFormatter, bytes: []const u8) !?usize {
+        if (bytes[0] >= 0x40) {
+            const end = for (bytes, 0..) |byte, i| {
+                if (byte < 0x40) break i;
+            } else bytes.len;
+            self.put_text(bytes[0..end]);
+            return end;
+        }
+
+        const len = sequence_len(bytes) orelse return null;
+        if (bytes.len < len) return null;
+        try self.control(bytes[0..len]);
+        return len;
+    }
+
+    fn sequence_len(bytes: []const u8) ?usize {
+        const command: SCSCommand = @enumFromInt(bytes[0]);
+        return switch (command) {
+            .set_absolute_horizontal,
+            .set_absolute_vertical,
+            .set_relative_horizontal,
+            .set_relative_vertical,
+            => 2,
+            .escape => if (bytes.len < 2) null else 2 + escape_params(@enumFromInt(bytes[1])),
+            else => 1,
+        };
+    }
+
+    fn escape_params(command: SCSCommand) usize {
+        return switch (command) {
+            .define_print_area => 4,
+            .set_page_size, .draw_box => 2,
+            .set_line_density, .set_character_density, .set_font, .set_color, .set_intensity => 1,
+            else => 0,
+        };
+    }
+
+    fn control(self: *ScsFormatter, sequence: []const u8) !void {
+        const command: SCSCommand = @enumFromInt(sequence[0]);
+        switch (command) {
+            .carriage_return => self.column = 1,
+            .line_feed, .set_vertical_tab_stop => try self.new_line(),
+            .form_feed => try self.new_page(),
+            .set_horizontal_tab_stop => self.column = (self.column - 1) / 8 * 8 + 9,
+            .set_absolute_horizontal => self.column = @max(sequence[1], 1),
+            .set_relative_horizontal => self.column +|= sequence[1],
+            .set_absolute_vertical => {
+                const target = std.math.clamp(sequence[1], 1, self.page_height);
+                if (target < self.row) try self.new_page();
+                while (self.row < target) try self.new_line();
+            },
+            .set_relative_vertical => for (0..sequence[1]) |_| try self.new_line(),
+            .escape => {
+                const extended: SCSCommand = @enumFromInt(sequence[1]);
+                if (extended == .set_page_size) {
+                    if (sequence[2] != 0) self.page_width = sequence[2];
+                    if (sequence[3] != 0) self.page_height = sequence[3];
+                    self.row = @min(self.row, self.page_height);
+                }
+            },
+            // Fonts, colors and highlighting have no plain-text form
+            else => {},
+        }
+    }
+
+    fn put_text(self: *ScsFormatter, text: []const u8) void {
+        for (text) |byte| {
+            if (self.column <= max_line_width) {
+                const index: usize = self.column - 1;
+                if (index > self.line_len) @memset(self.line[self.line_len..index], ' ');
+                self.line[index] = ebcdic.Ebcdic.decode_byte(byte);
+                self.line_len = @max(self.line_len, index + 1);
+            }
+            self.column +|= 1;
+        }
+        self.page_dirty = true;
+    }
+
+    fn end_line(self: *ScsFormatter) !void {
+        try self.write_raw(std.mem.trimEnd(u8, self.line[0..self.line_len], " "));
+        try self.write_raw("\n");
+        self.line_len = 0;
+        self.line_count += 1;
+    }
+
+    fn new_line(self: *ScsFormatter) !void {
+        try self.end_line();
+        self.page_dirty = true;
+        if (self.row >= self.page_height) {
+            try self.write_raw("\x0c");
+            self.page_count += 1;
+            self.page_dirty = false;
+            self.row = 1;
+        } else {
+            self.row += 1;
+        }
+    }
+
+    fn new_page(self: *ScsFormatter) !void {
+        if (self.line_len > 0) try self.end_line();
+        try self.write_raw("\x0c");
+        self.page_count += 1;
+        self.page_dirty = false;
+        self.row = 1;
+        self.column = 1;
+    }
+};
+
+/// Output buffer per streaming job
+pub const sink_buffer_size = 64 * 1024;
+
+/// A print job whose output goes to a file or pipe as data arrives.
+///
+/// Memory per job is constant however large the report: one formatted
+/// line plus the sink buffer. Writes block while a pipe's reader is
+/// behind, which stalls `add_data` and the session feeding it; that is the
+/// backpressure to the host. Text jobs are formatted; raw, PostScript and
+/// PDF jobs pass through unchanged.
+pub const StreamingJob = struct {
+    job_id: u32,
+    format: PrintFormat,
+    status: PrintJobStatus = .printing,
+    timestamp: i64,
+    file: std.fs.File,
+    /// Spool files are closed with the job; caller-provided files are not
+    owns_file: bool,
+    file_writer: std.fs.File.Writer,
+    formatter: ScsFormatter,
+    bytes_received: u64 = 0,
+    buffer: [sink_buffer_size]u8,
+
+    /// Format and write the next chunk of print data
+    pub fn add_data(self: *StreamingJob, data: []const u8) !void {
+        if (self.status != .printing) return error.InvalidJobState;
+        self.bytes_received += data.len;
+        const written = if (self.format == .text) self.formatter.feed(data) else self.formatter.write_raw(data);
+        written catch {
+            self.status = .failed;
+            return error.WriteFailed;
+        };
+    }
+
+    /// Bytes written to the sink so far
+    pub fn size_bytes(self: StreamingJob) u64 {
+        return self.formatter.bytes_written;
+    }
+
+    fn finish(self: *StreamingJob) !void {
+        const flushed = if (self.format == .text) self.formatter.finish() else self.formatter.out.flush();
+        flushed catch return error.WriteFailed;
+    }
+};
+
+/// Thread-safe owner of streaming jobs for any number of printer LUs.
+///
+/// Each job is fed by a single thread (its LU's session) and shares
+/// nothing with other jobs on the data path; the spooler lock only guards
+/// ids and counters, so LUs print in parallel.
+pub const PrintSpooler = struct {
+    allocator: std.mem.Allocator,
+    /// Spool directory (not closed by the spooler)
+    dir: std.fs.Dir,
+    mutex: std.Thread.Mutex = .{},
+    next_job_id: u32 = 1,
+    max_active_jobs: usize = 100,
+    active_jobs: usize = 0,
+    completed_jobs: usize = 0,
+    failed_jobs: usize = 0,
+    total_bytes_printed: u64 = 0,
+
+    pub fn init(allocator: std.mem.Allocator, dir: std.fs.Dir) PrintSpooler {
+        return .{ .allocator = allocator, .dir = dir };
+    }
+
+    /// Spool file name for a job, e.g. "job-00042.txt"
+    pub fn spool_name(buf: []u8, job_id: u32, format: PrintFormat) ![]const u8 {
+        const extension = switch (format) {
+            .text => "txt",
+            .postscript => "ps",
+            .pdf => "pdf",
+            .raw => "prn",
+        };
+        return std.fmt.bufPrint(buf, "job-{d:0>5}.{s}", .{ job_id, extension });
+    }
+
+    /// Open a job spooled to a new file in the spool directory
+    pub fn open_job(self: *PrintSpooler, format: PrintFormat) !*StreamingJob {
+        const job_id = try self.reserve();
+        errdefer self.release(.cancelled, 0);
+
+        var name_buf: [32]u8 = undefined;
+        const file = try self.dir.createFile(try spool_name(&name_buf, job_id, format), .{});
+        errdefer file.close();
+        return self.create(job_id, format, file, true);
+    }
+
+    /// Open a job writing to `file`, e.g. the stdin pipe of a print command
+    pub fn open_job_to(self: *PrintSpooler, format: PrintFormat, file: std.fs.File) !*StreamingJob {
+        const job_id = try self.reserve();
+        errdefer self.release(.cancelled, 0);
+        return self.create(job_id, format, file, false);
+    }
+
+    /// Flush and close a job; `job` is freed even on error
+    pub fn close_job(self: *PrintSpooler, job: *StreamingJob) !void {
+        defer self.destroy(job);
+        const result = if (job.status == .printing) job.finish() else error.InvalidJobState;
+        job.status = if (result) |_| .completed else |_| .failed;
+        self.release(job.status, job.bytes_received);
+        return result;
+    }
+
+    /// Drop a job without flushing; its spool file is deleted
+    pub fn abort_job(self: *PrintSpooler, job: *StreamingJob) void {
+        job.status = .cancelled;
+        self.release(.cancelled, 0);
+        if (job.owns_file) {
+            var name_buf: [32]u8 = undefined;
+            if (spool_name(&name_buf, job.job_id, job.format)) |name| {
+                self.dir.deleteFile(name) catch {};
+            } else |_| {}
+        }
+        self.destroy(job);
+    }
+
+    pub fn statistics(self: *PrintSpooler) PrintQueueStats {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        return .{
+            .total_jobs = self.next_job_id - 1,
+            .queued_jobs = 0,
+            .printing_jobs = self.active_jobs,
+            .completed_jobs = self.completed_jobs,
+            .error_jobs = self.failed_jobs,
+            .total_bytes = self.total_bytes_printed,
+            .total_bytes_printed = self.total_bytes_printed,
+        };
+    }
+
+    fn reserve(self: *PrintSpooler) !u32 {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        if (self.active_jobs >= self.max_active_jobs) return error.QueueFull;
+        self.active_jobs += 1;
+        const job_id = self.next_job_id;
+        self.next_job_id += 1;
+        return job_id;
+    }
+
+    fn release(self: *PrintSpooler, status: PrintJobStatus, bytes: u64) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.active_jobs -= 1;
+        switch (status) {
+            .completed => {
+                self.completed_jobs += 1;
+                self.total_bytes_printed += bytes;
+            },
+            .failed => self.failed_jobs += 1,
+            else => {},
+        }
+    }
+
+    fn create(self: *PrintSpooler, job_id: u32, format: PrintFormat, file: std.fs.File, owns_file: bool) !*StreamingJob {
+        const job = try self.allocator.create(StreamingJob);
+        job.job_id = job_id;
+        job.format = format;
+        job.status = .printing;
+        job.timestamp = std.time.timestamp();
+        job.file = file;
+        job.owns_file = owns_file;
+        job.bytes_received = 0;
+        // Both point into the job itself, which is why jobs live on the heap
+        job.file_writer = file.writerStreaming(&job.buffer);
+        job.formatter = ScsFormatter.init(&job.file_writer.interface);
+        return job;
+    }
+
+    fn destroy(self: *PrintSpooler, job: *StreamingJob) void {
+        if (job.owns_file) job.file.close();
+        self.allocator.destroy(job);
+    }
+};
+
 /// LU3 Printer controller
 pub const LU3Printer = struct {
     allocator: std.mem.Allocator,
@@ -353,6 +716,9 @@ pub const LU3Printer = struct {
     detector: PrintCommandDetector,
     scs_processor: SCSProcessor,
     enabled: bool = true,
+    /// When set, jobs stream through the spooler instead of the queue
+    spooler: ?*PrintSpooler = null,
+    active_stream: ?*StreamingJob = null,
 
     pub fn init(allocator: std.mem.Allocator) LU3Printer {
         return .{
@@ -364,21 +730,44 @@ pub const LU3Printer = struct {
     }
 
     pub fn deinit(self: *LU3Printer) void {
+        if (self.active_stream) |job| self.spooler.?.abort_job(job);
         self.queue.deinit();
     }
 
+    /// Stream later jobs to `spooler` (null returns to in-memory jobs).
+    /// A job still streaming is aborted.
+    pub fn set_spooler(self: *LU3Printer, spooler: ?*PrintSpooler) void {
+        if (self.active_stream) |job| self.spooler.?.abort_job(job);
+        self.active_stream = null;
+        self.spooler = spooler;
+    }
+
+    fn streaming_job(self: LU3Printer, job_id: u32) ?*StreamingJob {
+        const job = self.active_stream orelse return null;
+        return if (job.job_id == job_id) job else null;
+    }
+
     /// Process a data stream for print commands
     pub fn process_stream(self: *LU3Printer, buffer: []const u8) !?u32 {
         if (!self.enabled) return null;
 
         if (!self.detector.is_print_command(buffer)) return null;
 
-        // Extract print data
-        const print_data = try self.detector.extract_print_data(buffer);
-        defer self.allocator.free(print_data);
+        const print_data = try PrintCommandDetector.payload(buffer);
+
+        if (self.spooler) |spooler| {
+            // Streaming: one job spans records until complete_job
+            const job = self.active_stream orelse blk: {
+                const opened = try spooler.open_job(.text);
+                self.active_stream = opened;
+                break :blk opened;
+            };
+            try job.add_data(print_data);
+            return job.job_id;
+        }
 
         // Create print job
-        var job = try self.queue.create_job(.text);
+        const job = try self.queue.create_job(.text);
         try job.add_data(print_data);
 
         return job.job_id;
@@ -386,6 +775,7 @@ pub const LU3Printer = struct {
 
     /// Submit print data to existing job
     pub fn submit_data(self: *LU3Printer, job_id: u32, data: []const u8) !void {
+        if (self.streaming_job(job_id)) |job| return job.add_data(data);
         if (self.queue.get_job(job_id)) |job| {
             if (job.status != .queued and job.status != .printing) {
                 return error.InvalidJobState;
@@ -407,11 +797,16 @@ pub const LU3Printer = struct {
 
     /// Complete a print job
     pub fn complete_job(self: *LU3Printer, job_id: u32) !void {
+        if (self.streaming_job(job_id)) |job| {
+            self.active_stream = null;
+            return self.spooler.?.close_job(job);
+        }
         try self.queue.complete_job(job_id);
     }
 
     /// Get job status
     pub fn get_status(self: LU3Printer, job_id: u32) ?PrintJobStatus {
+        if (self.streaming_job(job_id)) |job| return job.status;
         if (self.queue.get_job(job_id)) |job| {
             return job.status;
         }
@@ -434,7 +829,7 @@ pub const LU3Printer = struct {
 // ============================================================================
 
 test "print job creation" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var job = PrintJob.init(allocator, 1);
     defer job.deinit(allocator);
 
@@ -444,7 +839,7 @@ test "print job creation" {
 }
 
 test "print job add data" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var job = PrintJob.init(allocator, 1);
     defer job.deinit(allocator);
 
@@ -455,7 +850,7 @@ test "print job add data" {
 }
 
 test "print queue create job" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var queue = PrintQueue.init(allocator);
     defer queue.deinit();
 
@@ -465,7 +860,7 @@ test "print queue create job" {
 }
 
 test "print queue get job" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var queue = PrintQueue.init(allocator);
     defer queue.deinit();
 
@@ -479,7 +874,7 @@ test "print queue get job" {
 }
 
 test "print queue job not found" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var queue = PrintQueue.init(allocator);
     defer queue.deinit();
 
@@ -488,7 +883,7 @@ test "print queue job not found" {
 }
 
 test "print queue complete job" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var queue = PrintQueue.init(allocator);
     defer queue.deinit();
 
@@ -503,7 +898,7 @@ test "print queue complete job" {
 }
 
 test "print queue cancel job" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var queue = PrintQueue.init(allocator);
     defer queue.deinit();
 
@@ -518,7 +913,7 @@ test "print queue cancel job" {
 }
 
 test "print queue count by status" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var queue = PrintQueue.init(allocator);
     defer queue.deinit();
 
@@ -534,7 +929,7 @@ test "print queue count by status" {
 }
 
 test "print queue statistics" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var queue = PrintQueue.init(allocator);
     defer queue.deinit();
 
@@ -549,31 +944,31 @@ test "print queue statistics" {
 }
 
 test "print command detector is print command" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     const detector = PrintCommandDetector.init(allocator);
 
-    var print_cmd: [2]u8 = .{ 0x7F, 0x00 };
+    const print_cmd: [2]u8 = .{ 0x7F, 0x00 };
     const is_print = detector.is_print_command(&print_cmd);
 
     try std.testing.expectEqual(true, is_print);
 }
 
 test "print command detector not print command" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     const detector = PrintCommandDetector.init(allocator);
 
-    var data: [2]u8 = .{ 0x41, 0x42 };
+    const data: [2]u8 = .{ 0x41, 0x42 };
     const is_print = detector.is_print_command(&data);
 
     try std.testing.expectEqual(false, is_print);
 }
 
 test "lu3 printer process stream" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var printer = LU3Printer.init(allocator);
     defer printer.deinit();
 
-    var stream: [5]u8 = .{ 0x7F, 0x41, 0x42, 0x43, 0xFF };
+    const stream: [5]u8 = .{ 0x7F, 0x41, 0x42, 0x43, 0xFF };
     const job_id = try printer.process_stream(&stream);
 
     try std.testing.expect(job_id != null);
@@ -587,7 +982,7 @@ test "lu3 printer process stream" {
 }
 
 test "lu3 printer submit data" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var printer = LU3Printer.init(allocator);
     defer printer.deinit();
 
@@ -601,11 +996,11 @@ test "lu3 printer submit data" {
 }
 
 test "lu3 printer start job" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var printer = LU3Printer.init(allocator);
     defer printer.deinit();
 
-    var job = try printer.queue.create_job(.text);
+    const job = try printer.queue.create_job(.text);
     try printer.start_job(job.job_id);
 
     const status = printer.get_status(job.job_id);
@@ -616,11 +1011,11 @@ test "lu3 printer start job" {
 }
 
 test "lu3 printer complete job" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var printer = LU3Printer.init(allocator);
     defer printer.deinit();
 
-    var job = try printer.queue.create_job(.text);
+    const job = try printer.queue.create_job(.text);
     try printer.complete_job(job.job_id);
 
     const status = printer.get_status(job.job_id);
@@ -631,7 +1026,7 @@ test "lu3 printer complete job" {
 }
 
 test "lu3 printer enable disable" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var printer = LU3Printer.init(allocator);
     defer printer.deinit();
 
@@ -645,7 +1040,7 @@ test "lu3 printer enable disable" {
 }
 
 test "lu3 printer get statistics" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var printer = LU3Printer.init(allocator);
     defer printer.deinit();
 
@@ -659,7 +1054,7 @@ test "lu3 printer get statistics" {
 }
 
 test "scs parameter from bytes carriage return" {
-    var buffer: [1]u8 = .{0x0D};
+    const buffer: [1]u8 = .{0x0D};
     const param = SCSParameter.from_bytes(&buffer);
 
     try std.testing.expect(param != null);
@@ -669,7 +1064,7 @@ test "scs parameter from bytes carriage return" {
 }
 
 test "scs parameter from bytes line feed" {
-    var buffer: [1]u8 = .{0x0A};
+    const buffer: [1]u8 = .{0x0A};
     const param = SCSParameter.from_bytes(&buffer);
 
     try std.testing.expect(param != null);
@@ -679,7 +1074,7 @@ test "scs parameter from bytes line feed" {
 }
 
 test "scs parameter from bytes with params" {
-    var buffer: [3]u8 = .{ 0x2B, 0x20, 0x00 };
+    const buffer: [3]u8 = .{ 0x2B, 0x20, 0x00 };
     const param = SCSParameter.from_bytes(&buffer);
 
     try std.testing.expect(param != null);
@@ -690,7 +1085,7 @@ test "scs parameter from bytes with params" {
 }
 
 test "scs processor carriage return" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var processor = SCSProcessor.init(allocator);
 
     processor.current_column = 50;
@@ -700,7 +1095,7 @@ test "scs processor carriage return" {
 }
 
 test "scs processor line feed" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var processor = SCSProcessor.init(allocator);
 
     processor.current_row = 10;
@@ -711,7 +1106,7 @@ test "scs processor line feed" {
 }
 
 test "scs processor form feed" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var processor = SCSProcessor.init(allocator);
 
     processor.current_row = 50;
@@ -723,7 +1118,7 @@ test "scs processor form feed" {
 }
 
 test "scs processor absolute horizontal" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var processor = SCSProcessor.init(allocator);
 
     _ = processor.process_command(.set_absolute_horizontal, 25, 0);
@@ -732,7 +1127,7 @@ test "scs processor absolute horizontal" {
 }
 
 test "scs processor absolute vertical" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var processor = SCSProcessor.init(allocator);
 
     _ = processor.process_command(.set_absolute_vertical, 30, 0);
@@ -741,7 +1136,7 @@ test "scs processor absolute vertical" {
 }
 
 test "scs processor page size" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var processor = SCSProcessor.init(allocator);
 
     const original_width = processor.page_width;
@@ -755,7 +1150,7 @@ test "scs processor page size" {
 }
 
 test "scs processor get position" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var processor = SCSProcessor.init(allocator);
 
     processor.current_row = 15;
@@ -765,3 +1160,95 @@ test "scs processor get position" {
     try std.testing.expectEqual(@as(u16, 15), pos.row);
     try std.testing.expectEqual(@as(u16, 40), pos.col);
 }
+
+test "scs formatter renders positioning across chunk boundaries" {
+    // "AB", SAH 10, "C", LF, ESC s 80x3, LF LF (page break), "D"
+    const stream = [_]u8{ 0xC1, 0xC2, 0x2B, 0x0A, 0xC3, 0x0A, 0x1B, 0x73, 80, 3, 0x0A, 0x0A, 0xC4 };
+    // LF keeps the column, as on a real printer
+    const expected = "AB       C\n\n\n\x0c          D\n";
+
+    var whole: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer whole.deinit();
+    var formatter = ScsFormatter.init(&whole.writer);
+    try formatter.feed(&stream);
+    try formatter.finish();
+    try std.testing.expectEqualStrings(expected, whole.written());
+    try std.testing.expectEqual(@as(u32, 2), formatter.page_count);
+
+    // Byte-at-a-time delivery splits every sequence
+    var split: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer split.deinit();
+    var streaming = ScsFormatter.init(&split.writer);
+    for (0..stream.len) |i| try streaming.feed(stream[i..][0..1]);
+    try streaming.finish();
+    try std.testing.expectEqualStrings(expected, split.written());
+}
+
+fn spool_report(spooler: *PrintSpooler, lines: usize, result: *?anyerror) void {
+    const job = spooler.open_job(.text) catch |err| {
+        result.* = err;
+        return;
+    };
+    // One EBCDIC "X" line, cut mid-run to mimic record boundaries
+    const line = [_]u8{0xE7} ** 100 ++ [_]u8{ 0x0D, 0x0A };
+    for (0..lines) |_| {
+        job.add_data(line[0..37]) catch |err| result.* = err;
+        job.add_data(line[37..]) catch |err| result.* = err;
+    }
+    spooler.close_job(job) catch |err| {
+        result.* = err;
+    };
+}
+
+test "print spooler streams jobs from parallel printer LUs" {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var spooler = PrintSpooler.init(std.testing.allocator, tmp.dir);
+    const lines = 2000;
+    var results = [_]?anyerror{null} ** 4;
+    var threads: [4]std.Thread = undefined;
+    for (&threads, &results) |*thread, *result| {
+        thread.* = try std.Thread.spawn(.{}, spool_report, .{ &spooler, lines, result });
+    }
+    for (threads) |thread| thread.join();
+    for (results) |result| try std.testing.expectEqual(@as(?anyerror, null), result);
+
+    const stats = spooler.statistics();
+    try std.testing.expectEqual(@as(usize, 4), stats.completed_jobs);
+    try std.testing.expectEqual(@as(usize, 0), stats.printing_jobs);
+    try std.testing.expectEqual(@as(u64, 4 * lines * 102), stats.total_bytes_printed);
+
+    // 2000 lines at 66 per page: 30 form feeds between them
+    for (1..5) |job_id| {
+        var name_buf: [32]u8 = undefined;
+        const name = try PrintSpooler.spool_name(&name_buf, @intCast(job_id), .text);
+        const stat = try tmp.dir.statFile(name);
+        try std.testing.expectEqual(@as(u64, lines * 101 + lines / 66), stat.size);
+    }
+}
+
+test "lu3 printer streams through a spooler" {
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var spooler = PrintSpooler.init(std.testing.allocator, tmp.dir);
+    var printer = LU3Printer.init(std.testing.allocator);
+    defer printer.deinit();
+    printer.set_spooler(&spooler);
+
+    const record = [_]u8{ 0x7F, 0xC1, 0xC2, 0xC3, 0xFF };
+    const job_id = (try printer.process_stream(&record)).?;
+    try std.testing.expectEqual(job_id, (try printer.process_stream(&record)).?);
+    try std.testing.expectEqual(PrintJobStatus.printing, printer.get_status(job_id).?);
+    try printer.complete_job(job_id);
+
+    // Nothing was buffered in the in-memory queue
+    try std.testing.expectEqual(@as(usize, 0), printer.queue.jobs.items.len);
+
+    var name_buf: [32]u8 = undefined;
+    const name = try PrintSpooler.spool_name(&name_buf, job_id, .text);
+    var content_buf: [64]u8 = undefined;
+    try std.testing.expectEqualStrings("ABCABC\n", try tmp.dir.readFile(name, &content_buf));
+    try std.testing.expectEqual(@as(usize, 1), spooler.statistics().completed_jobs);
+}
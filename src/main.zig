@@ -4,6 +4,7 @@ const client_mod = @import("client.zig");
 const hex_viewer = @import("hex_viewer.zig");
 const ghostty_vt_terminal = @import("ghostty_vt_terminal.zig");
 const ghostty_vt_example = @import("ghostty_vt_example.zig");
+const cli = @import("cli.zig");
 
 // Optional: libghostty-vt integration (only available if dependency is available)
 const has_ghostty_vt = @import("builtin").zig_backend != .other;
@@ -13,6 +14,18 @@ pub fn main() !void {
     defer _ = gpa.deinit();
     const allocator = gpa.allocator();
 
+    const argv = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, argv);
+    const args = cli.CliParser.init(allocator).parse(argv) catch |err| {
+        cli.CliParser.print_help();
+        return err;
+    };
+    // With --trace, zones record from here and are written out on exit
+    args.start_trace();
+    defer args.dump_trace(allocator) catch |err| {
+        std.debug.print("Could not write trace: {s}\n", .{@errorName(err)});
+    };
+
     // Initialize emulator (facade that wraps screen, terminal, field, input)
     var emu = try emulator.Emulator.init(allocator, 24, 80);
     defer emu.deinit();
@@ -68,6 +81,26 @@ test {
     _ = @import("resource_limits.zig");
     _ = @import("metrics_export.zig");
     _ = @import("disaster_recovery_test.zig");
+    _ = @import("stream_decoder.zig");
+    _ = @import("session_reactor.zig");
+    _ = @import("span_processor.zig");
+    _ = @import("rest_server.zig");
+    _ = @import("lu3_printer.zig");
+    _ = @import("structured_fields.zig");
+    _ = @import("charset_support.zig");
+    _ = @import("buffer_pool.zig");
+    _ = @import("protocol_snooper.zig");
+    _ = @import("replay_bench.zig");
+    _ = @import("dns_cache.zig");
+    _ = @import("telnet_enhanced.zig");
+    _ = @import("network_resilience.zig");
+    _ = @import("screen_waiter.zig");
+    _ = @import("screen_fingerprint.zig");
+    _ = @import("read_modified.zig");
+    _ = @import("session_snapshot.zig");
+    _ = @import("health_probe.zig");
+    _ = @import("zone_trace.zig");
+    _ = @import("session_memory.zig");
     _ = ghostty_vt_example;
     _ = ghostty_vt_terminal;
     _ = client_mod;
@@ -15,6 +15,11 @@ pub const SessionMetrics = struct {
     peak_latency_ms: u32 = 0,
     errors: u64 = 0,
     start_time: u64 = 0,
+    /// Bytes held through the session's allocator (see session_memory)
+    memory_bytes: u64 = 0,
+    memory_peak_bytes: u64 = 0,
+    /// Allocations refused at the hard quota
+    memory_quota_failures: u64 = 0,
 
     pub fn duration_seconds(self: SessionMetrics) i64 {
         if (self.start_time == 0) return 0;
@@ -113,6 +118,208 @@ pub const SystemMetrics = struct {
     }
 };
 
+/// Log-linear latency histogram in microseconds. Each power-of-two octave
+/// is split into `sub_buckets` linear buckets, giving at most 12.5%
+/// relative error over 1us..~134s. Bucket i holds values v with
+/// (v - 1) in its range, so octave boundaries are exact inclusive `le`
+/// bounds. Recording is two relaxed atomic adds.
+pub const LatencyHistogram = struct {
+    pub const sub_bucket_bits = 3;
+    pub const sub_buckets = 1 << sub_bucket_bits;
+    pub const octaves = 27;
+    pub const bucket_count = sub_buckets * (octaves - sub_bucket_bits + 1);
+
+    counts: [bucket_count]std.atomic.Value(u64) = [_]std.atomic.Value(u64){.init(0)} ** bucket_count,
+    sum_us: std.atomic.Value(u64) = .init(0),
+
+    pub fn bucket_index(value_us: u64) usize {
+        const v = value_us -| 1;
+        if (v < sub_buckets) return @intCast(v);
+        const msb: usize = 63 - @clz(v);
+        const shift: u6 = @intCast(msb - sub_bucket_bits);
+        const index = (msb - sub_bucket_bits + 1) * sub_buckets + @as(usize, @intCast((v >> shift) & (sub_buckets - 1)));
+        return @min(index, bucket_count - 1);
+    }
+
+    /// Largest value (inclusive) that lands in bucket `index`
+    pub fn bucket_upper_bound(index: usize) u64 {
+        if (index < sub_buckets) return index + 1;
+        const octave = index / sub_buckets - 1 + sub_bucket_bits;
+        const width = @as(u64, 1) << @intCast(octave - sub_bucket_bits);
+        const lower = (@as(u64, sub_buckets) + index % sub_buckets) * width;
+        return lower + width;
+    }
+
+    pub fn record(self: *LatencyHistogram, value_us: u64) void {
+        _ = self.counts[bucket_index(value_us)].fetchAdd(1, .monotonic);
+        _ = self.sum_us.fetchAdd(value_us, .monotonic);
+    }
+
+    fn add_to(self: *const LatencyHistogram, into: *HistogramSnapshot) void {
+        for (&into.counts, &self.counts) |*total, *bucket| {
+            const n = bucket.load(.monotonic);
+            total.* += n;
+            into.count += n;
+        }
+        into.sum_us += self.sum_us.load(.monotonic);
+    }
+};
+
+/// Plain copy of one or more merged histograms, taken on scrape
+pub const HistogramSnapshot = struct {
+    counts: [LatencyHistogram.bucket_count]u64 = [_]u64{0} ** LatencyHistogram.bucket_count,
+    count: u64 = 0,
+    sum_us: u64 = 0,
+
+    /// Upper bound in microseconds of the bucket holding quantile `q`
+    pub fn percentile(self: HistogramSnapshot, q: f64) u64 {
+        if (self.count == 0) return 0;
+        const rank: u64 = @intFromFloat(@ceil(q * @as(f64, @floatFromInt(self.count))));
+        var seen: u64 = 0;
+        for (self.counts, 0..) |n, i| {
+            seen += n;
+            if (seen >= @max(rank, 1)) return LatencyHistogram.bucket_upper_bound(i);
+        }
+        return LatencyHistogram.bucket_upper_bound(self.counts.len - 1);
+    }
+
+    /// Values at or below `bound_us`, which must be a power of two
+    pub fn cumulative_count(self: HistogramSnapshot, bound_us: u64) u64 {
+        var total: u64 = 0;
+        for (self.counts, 0..) |n, i| {
+            if (LatencyHistogram.bucket_upper_bound(i) > bound_us) break;
+            total += n;
+        }
+        return total;
+    }
+};
+
+pub const LatencyKind = enum {
+    command_round_trip,
+    parse,
+    execute,
+    render,
+
+    fn metric_name(self: LatencyKind) []const u8 {
+        return switch (self) {
+            .command_round_trip => "tn3270_command_round_trip_seconds",
+            .parse => "tn3270_parse_seconds",
+            .execute => "tn3270_execute_seconds",
+            .render => "tn3270_render_seconds",
+        };
+    }
+
+    fn help(self: LatencyKind) []const u8 {
+        return switch (self) {
+            .command_round_trip => "Host command round-trip latency",
+            .parse => "3270 data stream parse time",
+            .execute => "3270 command execution time",
+            .render => "Screen render time",
+        };
+    }
+};
+
+/// Metrics recorded from many threads without contention. Each thread
+/// updates the shard picked by its thread id with relaxed atomics; scrapes
+/// sum the shards. Totals read mid-update may lag by in-flight records.
+pub const ShardedMetrics = struct {
+    pub const shard_count = 16;
+
+    allocator: Allocator,
+    shards: []Shard,
+
+    const Shard = struct {
+        commands: std.atomic.Value(u64) align(std.atomic.cache_line) = .init(0),
+        failed_commands: std.atomic.Value(u64) = .init(0),
+        bytes_sent: std.atomic.Value(u64) = .init(0),
+        bytes_received: std.atomic.Value(u64) = .init(0),
+        latency: [std.meta.fields(LatencyKind).len]LatencyHistogram = [_]LatencyHistogram{.{}} ** std.meta.fields(LatencyKind).len,
+    };
+
+    pub const Snapshot = struct {
+        total_commands: u64 = 0,
+        failed_commands: u64 = 0,
+        total_bytes_sent: u64 = 0,
+        total_bytes_received: u64 = 0,
+        latency: std.EnumArray(LatencyKind, HistogramSnapshot) = .initFill(.{}),
+    };
+
+    pub fn init(allocator: Allocator) !ShardedMetrics {
+        const shards = try allocator.alloc(Shard, shard_count);
+        @memset(shards, .{});
+        return .{ .allocator = allocator, .shards = shards };
+    }
+
+    pub fn deinit(self: *ShardedMetrics) void {
+        self.allocator.free(self.shards);
+    }
+
+    fn local(self: *ShardedMetrics) *Shard {
+        const id: u64 = @intCast(std.Thread.getCurrentId());
+        return &self.shards[@intCast(id % shard_count)];
+    }
+
+    pub fn record_command(self: *ShardedMetrics, success: bool) void {
+        const shard = self.local();
+        _ = shard.commands.fetchAdd(1, .monotonic);
+        if (!success) _ = shard.failed_commands.fetchAdd(1, .monotonic);
+    }
+
+    pub fn record_data_sent(self: *ShardedMetrics, bytes: u64) void {
+        _ = self.local().bytes_sent.fetchAdd(bytes, .monotonic);
+    }
+
+    pub fn record_data_received(self: *ShardedMetrics, bytes: u64) void {
+        _ = self.local().bytes_received.fetchAdd(bytes, .monotonic);
+    }
+
+    pub fn record_latency(self: *ShardedMetrics, kind: LatencyKind, elapsed_ns: u64) void {
+        self.local().latency[@intFromEnum(kind)].record(elapsed_ns / std.time.ns_per_us);
+    }
+
+    pub fn snapshot(self: *const ShardedMetrics) Snapshot {
+        var result = Snapshot{};
+        for (self.shards) |*shard| {
+            result.total_commands += shard.commands.load(.monotonic);
+            result.failed_commands += shard.failed_commands.load(.monotonic);
+            result.total_bytes_sent += shard.bytes_sent.load(.monotonic);
+            result.total_bytes_received += shard.bytes_received.load(.monotonic);
+            for (&shard.latency, 0..) |*histogram, kind| {
+                histogram.add_to(result.latency.getPtr(@enumFromInt(kind)));
+            }
+        }
+        return result;
+    }
+};
+
+var global_shards = [_]ShardedMetrics.Shard{.{}} ** ShardedMetrics.shard_count;
+var global_metrics: ShardedMetrics = .{ .allocator = std.heap.page_allocator, .shards = &global_shards };
+
+/// Process-wide metrics the parser, executor, renderer and client record
+/// into. Statically allocated; never deinit it.
+pub fn global() *ShardedMetrics {
+    return &global_metrics;
+}
+
+/// One latency measurement into `global`, started by `start_latency`
+pub const LatencyTimer = struct {
+    kind: LatencyKind,
+    /// Null when the clock could not be read; nothing is recorded then
+    started: ?std.time.Instant,
+
+    pub fn stop(self: LatencyTimer) void {
+        const started = self.started orelse return;
+        const now = std.time.Instant.now() catch return;
+        global_metrics.record_latency(self.kind, now.since(started));
+    }
+};
+
+/// Time a call into the global metrics:
+/// `const timer = start_latency(.parse); defer timer.stop();`
+pub fn start_latency(kind: LatencyKind) LatencyTimer {
+    return .{ .kind = kind, .started = std.time.Instant.now() catch null };
+}
+
 /// Prometheus metrics formatter
 pub const PrometheusExporter = struct {
     allocator: Allocator,
@@ -165,9 +372,66 @@ pub const PrometheusExporter = struct {
         try writer.print("# TYPE tn3270_peak_connections gauge\n", .{});
         try writer.print("tn3270_peak_connections {}\n", .{metrics.peak_active_connections});
 
+        // Latency histograms
+        try write_latency_histograms(writer, &global_metrics.snapshot());
+
         return buffer.toOwnedSlice(self.allocator);
     }
 
+    /// Counters and latency histograms aggregated across all shards. The
+    /// histogram `le` bounds are the power-of-two octave edges, 1us..67s.
+    pub fn export_sharded_metrics(
+        self: PrometheusExporter,
+        metrics: *const ShardedMetrics,
+    ) ![]u8 {
+        const snap = metrics.snapshot();
+
+        var buffer = try std.ArrayList(u8).initCapacity(self.allocator, 8192);
+        defer buffer.deinit(self.allocator);
+
+        var writer = buffer.writer(self.allocator);
+
+        try writer.print("# HELP tn3270_total_commands Total commands processed\n", .{});
+        try writer.print("# TYPE tn3270_total_commands counter\n", .{});
+        try writer.print("tn3270_total_commands {}\n", .{snap.total_commands});
+
+        try writer.print("# HELP tn3270_failed_commands Failed commands\n", .{});
+        try writer.print("# TYPE tn3270_failed_commands counter\n", .{});
+        try writer.print("tn3270_failed_commands {}\n", .{snap.failed_commands});
+
+        try writer.print("# HELP tn3270_bytes_sent Total bytes sent\n", .{});
+        try writer.print("# TYPE tn3270_bytes_sent counter\n", .{});
+        try writer.print("tn3270_bytes_sent {}\n", .{snap.total_bytes_sent});
+
+        try writer.print("# HELP tn3270_bytes_received Total bytes received\n", .{});
+        try writer.print("# TYPE tn3270_bytes_received counter\n", .{});
+        try writer.print("tn3270_bytes_received {}\n", .{snap.total_bytes_received});
+
+        try write_latency_histograms(writer, &snap);
+
+        return buffer.toOwnedSlice(self.allocator);
+    }
+
+    /// One Prometheus histogram per `LatencyKind`; the `le` bounds are the
+    /// power-of-two octave edges, 1us..67s
+    fn write_latency_histograms(writer: anytype, snap: *const ShardedMetrics.Snapshot) !void {
+        for (std.enums.values(LatencyKind)) |kind| {
+            const histogram = snap.latency.get(kind);
+            const name = kind.metric_name();
+
+            try writer.print("# HELP {s} {s}\n", .{ name, kind.help() });
+            try writer.print("# TYPE {s} histogram\n", .{name});
+            for (0..LatencyHistogram.octaves) |octave| {
+                const bound_us = @as(u64, 1) << @intCast(octave);
+                const le = @as(f64, @floatFromInt(bound_us)) / std.time.us_per_s;
+                try writer.print("{s}_bucket{{le=\"{d}\"}} {}\n", .{ name, le, histogram.cumulative_count(bound_us) });
+            }
+            try writer.print("{s}_bucket{{le=\"+Inf\"}} {}\n", .{ name, histogram.count });
+            try writer.print("{s}_sum {d}\n", .{ name, @as(f64, @floatFromInt(histogram.sum_us)) / std.time.us_per_s });
+            try writer.print("{s}_count {}\n", .{ name, histogram.count });
+        }
+    }
+
     pub fn export_session_metrics(
         self: PrometheusExporter,
         session: SessionMetrics,
@@ -189,6 +453,18 @@ pub const PrometheusExporter = struct {
         try writer.print("# TYPE tn3270_session_latency_ms gauge\n", .{});
         try writer.print("tn3270_session_latency_ms{{session_id=\"{}\"}} {}\n", .{ session.session_id, session.average_latency_ms });
 
+        try writer.print("# HELP tn3270_session_memory_bytes Memory held by session\n", .{});
+        try writer.print("# TYPE tn3270_session_memory_bytes gauge\n", .{});
+        try writer.print("tn3270_session_memory_bytes{{session_id=\"{}\"}} {}\n", .{ session.session_id, session.memory_bytes });
+
+        try writer.print("# HELP tn3270_session_memory_peak_bytes Peak memory held by session\n", .{});
+        try writer.print("# TYPE tn3270_session_memory_peak_bytes gauge\n", .{});
+        try writer.print("tn3270_session_memory_peak_bytes{{session_id=\"{}\"}} {}\n", .{ session.session_id, session.memory_peak_bytes });
+
+        try writer.print("# HELP tn3270_session_memory_quota_failures Allocations refused at the session hard quota\n", .{});
+        try writer.print("# TYPE tn3270_session_memory_quota_failures counter\n", .{});
+        try writer.print("tn3270_session_memory_quota_failures{{session_id=\"{}\"}} {}\n", .{ session.session_id, session.memory_quota_failures });
+
         return buffer.toOwnedSlice(self.allocator);
     }
 };
@@ -249,7 +525,10 @@ pub const JSONExporter = struct {
             \\  "throughput_cps": {d:.2},
             \\  "throughput_mbps": {d:.2},
             \\  "error_rate_percent": {d:.2},
-            \\  "average_latency_ms": {}
+            \\  "average_latency_ms": {},
+            \\  "memory_bytes": {},
+            \\  "memory_peak_bytes": {},
+            \\  "memory_quota_failures": {}
             \\}}
         ,
             .{
@@ -261,6 +540,9 @@ pub const JSONExporter = struct {
                 session.throughput_mb_per_second(),
                 session.error_rate_percent(),
                 session.average_latency_ms,
+                session.memory_bytes,
+                session.memory_peak_bytes,
+                session.memory_quota_failures,
             },
         );
     }
@@ -412,3 +694,62 @@ test "JSONExporter exports session metrics" {
     try testing.expect(std.mem.containsAtLeast(u8, output, 1, "session_id"));
     try testing.expect(std.mem.containsAtLeast(u8, output, 1, "42"));
 }
+
+test "LatencyHistogram buckets are log-linear with exact octave edges" {
+    try testing.expectEqual(@as(usize, 0), LatencyHistogram.bucket_index(1));
+    try testing.expectEqual(@as(usize, 7), LatencyHistogram.bucket_index(8));
+    for (1..100_000) |v| {
+        const index = LatencyHistogram.bucket_index(v);
+        const upper = LatencyHistogram.bucket_upper_bound(index);
+        try testing.expect(v <= upper);
+        if (index > 0) try testing.expect(v > LatencyHistogram.bucket_upper_bound(index - 1));
+        // Relative error of the bucket bound stays within one sub-bucket
+        try testing.expect(@as(f64, @floatFromInt(upper - v)) <= @as(f64, @floatFromInt(v)) / LatencyHistogram.sub_buckets + 1);
+    }
+
+    var histogram = LatencyHistogram{};
+    for (1..1001) |v| histogram.record(v);
+    var snap = HistogramSnapshot{};
+    histogram.add_to(&snap);
+    try testing.expectEqual(@as(u64, 1000), snap.count);
+    try testing.expectEqual(@as(u64, 512), snap.cumulative_count(512));
+    const p99 = snap.percentile(0.99);
+    try testing.expect(p99 >= 990 and p99 <= 990 + 990 / 8 + 1);
+}
+
+test "ShardedMetrics aggregates records from many threads" {
+    const allocator = testing.allocator;
+    var metrics = try ShardedMetrics.init(allocator);
+    defer metrics.deinit();
+
+    const Worker = struct {
+        fn run(m: *ShardedMetrics) void {
+            for (0..1000) |i| {
+                m.record_command(i % 10 != 0);
+                m.record_data_sent(10);
+                m.record_latency(.command_round_trip, (i + 1) * std.time.ns_per_ms);
+                m.record_latency(.parse, 50 * std.time.ns_per_us);
+            }
+        }
+    };
+
+    var threads: [4]std.Thread = undefined;
+    for (&threads) |*t| t.* = try std.Thread.spawn(.{}, Worker.run, .{&metrics});
+    for (threads) |t| t.join();
+
+    const snap = metrics.snapshot();
+    try testing.expectEqual(@as(u64, 4000), snap.total_commands);
+    try testing.expectEqual(@as(u64, 400), snap.failed_commands);
+    try testing.expectEqual(@as(u64, 40_000), snap.total_bytes_sent);
+    try testing.expectEqual(@as(u64, 4000), snap.latency.get(.command_round_trip).count);
+    try testing.expectEqual(@as(u64, 0), snap.latency.get(.render).count);
+
+    var exporter = PrometheusExporter.init(allocator);
+    const output = try exporter.export_sharded_metrics(&metrics);
+    defer allocator.free(output);
+
+    try testing.expect(std.mem.containsAtLeast(u8, output, 1, "# TYPE tn3270_command_round_trip_seconds histogram"));
+    try testing.expect(std.mem.containsAtLeast(u8, output, 1, "tn3270_command_round_trip_seconds_bucket{le=\"+Inf\"} 4000"));
+    try testing.expect(std.mem.containsAtLeast(u8, output, 1, "tn3270_parse_seconds_bucket{le=\"0.000064\"} 4000"));
+    try testing.expect(std.mem.containsAtLeast(u8, output, 1, "tn3270_parse_seconds_count 4000"));
+}
@@ -1,9 +1,23 @@
 const std = @import("std");
+const session_recorder = @import("session_recorder.zig");
 
-/// Simple mock 3270 server for testing
+/// Simple mock 3270 server for testing.
+///
+/// With a recording path argument (the SessionRecorder binary format), each
+/// connection is sent the recorded host responses instead, paced by their
+/// recorded timestamps.
 pub fn main() !void {
     const stdout = std.debug.print;
 
+    var args = std.process.args();
+    _ = args.skip();
+    var recording: ?session_recorder.MappedRecording = null;
+    defer if (recording) |*r| r.close();
+    if (args.next()) |path| {
+        recording = try session_recorder.MappedRecording.open(path);
+        stdout("Replaying recording {s}\n", .{path});
+    }
+
     // Create a 3270 screen response with sample data
     var response: [512]u8 = undefined;
     var idx: usize = 0;
@@ -66,11 +80,31 @@ pub fn main() !void {
         connection_count += 1;
         stdout("\n[Connection #{}] Client connected\n", .{connection_count});
 
-        // Send the response
-        try connection.stream.writeAll(response[0..idx]);
-        stdout("[Connection #{}] Sent {} bytes of 3270 screen data\n", .{ connection_count, idx });
+        if (recording) |r| {
+            const sent = try replay(r, connection.stream);
+            stdout("[Connection #{}] Replayed {} recorded responses\n", .{ connection_count, sent });
+        } else {
+            // Send the response
+            try connection.stream.writeAll(response[0..idx]);
+            stdout("[Connection #{}] Sent {} bytes of 3270 screen data\n", .{ connection_count, idx });
+        }
 
         // Wait for client to read and disconnect
         std.posix.nanosleep(1, 0); // 1 second
     }
 }
+
+/// Send the recorded host responses straight out of the mapping.
+fn replay(recording: session_recorder.MappedRecording, stream: std.net.Stream) !usize {
+    var reader = try recording.reader();
+    var last_timestamp: u64 = 0;
+    var sent: usize = 0;
+    while (try reader.next()) |event| {
+        if (event.event_type != .response) continue;
+        std.Thread.sleep((event.timestamp - last_timestamp) * std.time.ns_per_ms);
+        last_timestamp = event.timestamp;
+        try stream.writeAll(event.data);
+        sent += 1;
+    }
+    return sent;
+}
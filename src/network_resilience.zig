@@ -1,5 +1,6 @@
 const std = @import("std");
 const client = @import("client.zig");
+const dns_cache = @import("dns_cache.zig");
 
 /// Network resilience configuration and connection management
 pub const NetworkConfig = struct {
@@ -9,26 +10,67 @@ pub const NetworkConfig = struct {
     max_retries: u32 = 3,
     retry_delay_ms: u32 = 1000, // 1 second initial delay
     max_retry_delay_ms: u32 = 30000, // 30 seconds max
+    /// How long a warm connection waits for the host to finish negotiating
+    negotiation_timeout_ms: u32 = 5000,
+    /// Warm connections older than this are closed; hosts drop idle
+    /// unbound sessions eventually
+    warm_max_idle_ms: i64 = 120_000,
+    /// How often the warmer thread tops endpoints up
+    warm_interval_ms: u32 = 1000,
 };
 
-/// Connection pool for reusing connections
+/// Connection pool for reusing connections.
+///
+/// Besides shared connections (`get_connection`), the pool keeps a warm
+/// set per registered endpoint: connections that are already open and
+/// negotiated, with any screen the host sent first kept for the first
+/// read. `take_session` hands one out and the warmer thread (or a
+/// `fill_warm` call) replaces it, so a new session starts on a ready
+/// socket instead of paying DNS, TCP and telnet round trips. The warm set
+/// is thread-safe; the shared connection list is not.
 pub const ConnectionPool = struct {
     allocator: std.mem.Allocator,
-    connections: std.ArrayList(PooledConnection),
+    connections: std.ArrayList(PooledConnection) = .empty,
     config: NetworkConfig,
+    mutex: std.Thread.Mutex = .{},
+    /// Signals the warmer to stop or top up early
+    wake: std.Thread.Condition = .{},
+    endpoints: std.ArrayList(Endpoint) = .empty,
+    warm: std.ArrayList(WarmConnection) = .empty,
+    warmer: ?std.Thread = null,
+    stopping: bool = false,
+    warm_hits: u64 = 0,
+    warm_misses: u64 = 0,
 
     pub const PooledConnection = struct {
-        client: client.Client,
+        client: *client.Client,
         last_used: i64,
         created_at: i64,
         use_count: u64,
     };
 
+    pub const Endpoint = struct {
+        host: []const u8,
+        port: u16,
+        /// Warm connections to keep ready
+        target: u32,
+        /// After a failed connect, passes before this time skip the
+        /// endpoint; the delay starts at `retry_delay_ms` and doubles per
+        /// failure up to `max_retry_delay_ms`
+        retry_at: i64 = 0,
+        backoff_ms: u32 = 0,
+    };
+
+    const WarmConnection = struct {
+        client: *client.Client,
+        endpoint: usize,
+        ready_at: i64,
+    };
+
     /// Initialize connection pool
     pub fn init(allocator: std.mem.Allocator, config: NetworkConfig) ConnectionPool {
         return .{
             .allocator = allocator,
-            .connections = std.ArrayList(PooledConnection).init(allocator),
             .config = config,
         };
     }
@@ -48,18 +90,35 @@ pub const ConnectionPool = struct {
                 if (pooled.client.connected) {
                     pooled.last_used = now;
                     pooled.use_count += 1;
-                    return &pooled.client;
+                    return pooled.client;
                 }
             }
         }
 
-        // Create new connection with retries
-        var new_client = client.Client.init(self.allocator, host, port);
+        const new_client = self.take_session(host, port) orelse try self.open(host, port);
+        errdefer self.destroy_client(new_client);
+
+        // Add to pool
+        try self.connections.append(self.allocator, .{
+            .client = new_client,
+            .last_used = now,
+            .created_at = now,
+            .use_count = 1,
+        });
+        return new_client;
+    }
+
+    /// Connect and negotiate with retries and exponential backoff
+    fn open(self: *ConnectionPool, host: []const u8, port: u16) !*client.Client {
+        const new_client = try self.allocator.create(client.Client);
+        errdefer self.allocator.destroy(new_client);
+        new_client.* = client.Client.init(self.allocator, host, port);
+
         var retry_count: u32 = 0;
         var retry_delay = self.config.retry_delay_ms;
 
         while (retry_count < self.config.max_retries) {
-            new_client.connect() catch {
+            new_client.connect_negotiated(self.negotiation_timeout()) catch {
                 retry_count += 1;
                 if (retry_count >= self.config.max_retries) {
                     return error.ConnectionFailed;
@@ -73,24 +132,194 @@ pub const ConnectionPool = struct {
 
             break;
         }
+        return new_client;
+    }
 
-        // Add to pool
-        const pooled = PooledConnection{
-            .client = new_client,
-            .last_used = now,
-            .created_at = now,
-            .use_count = 1,
+    fn destroy_client(self: *ConnectionPool, conn: *client.Client) void {
+        conn.disconnect();
+        self.allocator.destroy(conn);
+    }
+
+    /// Keep `target` negotiated connections ready for host:port. The host
+    /// string must outlive the pool. Names are resolved in the background
+    /// right away.
+    pub fn register_endpoint(self: *ConnectionPool, host: []const u8, port: u16, target: u32) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        for (self.endpoints.items) |*endpoint| {
+            if (std.mem.eql(u8, endpoint.host, host) and endpoint.port == port) {
+                endpoint.target = target;
+                self.wake.signal();
+                return;
+            }
+        }
+        try self.endpoints.append(self.allocator, .{ .host = host, .port = port, .target = target });
+        dns_cache.global().prefetch(host) catch {};
+        self.wake.signal();
+    }
+
+    /// A connected, negotiated client for host:port from the warm set, or
+    /// null when none is ready. The caller owns it (see `release_session`).
+    pub fn take_session(self: *ConnectionPool, host: []const u8, port: u16) ?*client.Client {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        var index: usize = 0;
+        while (index < self.warm.items.len) {
+            const warm = self.warm.items[index];
+            const endpoint = self.endpoints.items[warm.endpoint];
+            if (endpoint.port != port or !std.mem.eql(u8, endpoint.host, host)) {
+                index += 1;
+                continue;
+            }
+
+            _ = self.warm.swapRemove(index);
+            // Top the endpoint back up in the background
+            self.wake.signal();
+            if (!still_open(warm.client)) {
+                self.destroy_client(warm.client);
+                continue;
+            }
+            // Idle time in the warm set is not session inactivity; without
+            // this the first send would trip the read timeout
+            warm.client.last_activity = std.time.milliTimestamp();
+            self.warm_hits += 1;
+            return warm.client;
+        }
+        self.warm_misses += 1;
+        return null;
+    }
+
+    /// Close and free a client obtained from `take_session`
+    pub fn release_session(self: *ConnectionPool, conn: *client.Client) void {
+        self.destroy_client(conn);
+    }
+
+    /// False when the host has closed the socket. Unread screen data
+    /// counts as open and is left in place.
+    fn still_open(conn: *client.Client) bool {
+        const fd = conn.socket_fd() orelse return false;
+        var byte: [1]u8 = undefined;
+        const n = std.posix.recv(fd, &byte, std.posix.MSG.PEEK | std.posix.MSG.DONTWAIT) catch |err| {
+            return err == error.WouldBlock;
         };
+        return n > 0;
+    }
 
-        try self.connections.append(pooled);
-        return &self.connections.items[self.connections.items.len - 1].client;
+    /// One pass over the registered endpoints: drop expired warm
+    /// connections and open new ones up to each target, skipping endpoints
+    /// still backing off after a failure. Connecting and negotiating happen
+    /// without the lock held. Returns connections added.
+    pub fn fill_warm(self: *ConnectionPool) usize {
+        var added: usize = 0;
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const now = std.time.milliTimestamp();
+        var index: usize = 0;
+        while (index < self.warm.items.len) {
+            const warm = self.warm.items[index];
+            if (now - warm.ready_at > self.config.warm_max_idle_ms or !still_open(warm.client)) {
+                _ = self.warm.swapRemove(index);
+                self.destroy_client(warm.client);
+            } else {
+                index += 1;
+            }
+        }
+
+        for (0..self.endpoints.items.len) |endpoint_index| {
+            if (now < self.endpoints.items[endpoint_index].retry_at) continue;
+            while (!self.stopping and self.warm_count(endpoint_index) < self.endpoints.items[endpoint_index].target) {
+                const endpoint = self.endpoints.items[endpoint_index];
+                self.mutex.unlock();
+                const ready = self.open_negotiated(endpoint.host, endpoint.port);
+                self.mutex.lock();
+
+                const conn = ready orelse {
+                    self.back_off(&self.endpoints.items[endpoint_index]);
+                    break;
+                };
+                self.endpoints.items[endpoint_index].backoff_ms = 0;
+                self.warm.append(self.allocator, .{
+                    .client = conn,
+                    .endpoint = endpoint_index,
+                    .ready_at = std.time.milliTimestamp(),
+                }) catch {
+                    self.destroy_client(conn);
+                    break;
+                };
+                added += 1;
+            }
+        }
+        return added;
+    }
+
+    fn back_off(self: *const ConnectionPool, endpoint: *Endpoint) void {
+        endpoint.backoff_ms = if (endpoint.backoff_ms == 0)
+            self.config.retry_delay_ms
+        else
+            @min(endpoint.backoff_ms *| 2, self.config.max_retry_delay_ms);
+        endpoint.retry_at = std.time.milliTimestamp() + endpoint.backoff_ms;
+    }
+
+    fn warm_count(self: *ConnectionPool, endpoint_index: usize) usize {
+        var count: usize = 0;
+        for (self.warm.items) |warm| {
+            if (warm.endpoint == endpoint_index) count += 1;
+        }
+        return count;
+    }
+
+    /// Connect once and wait for negotiation; null on any failure
+    fn open_negotiated(self: *ConnectionPool, host: []const u8, port: u16) ?*client.Client {
+        const conn = self.allocator.create(client.Client) catch return null;
+        conn.* = client.Client.init(self.allocator, host, port);
+        conn.connect_negotiated(self.negotiation_timeout()) catch {
+            self.allocator.destroy(conn);
+            return null;
+        };
+        return conn;
+    }
+
+    fn negotiation_timeout(self: *const ConnectionPool) i32 {
+        return @intCast(@min(self.config.negotiation_timeout_ms, std.math.maxInt(i32)));
+    }
+
+    /// Run `fill_warm` on a background thread every `warm_interval_ms`
+    /// and whenever a warm connection is taken
+    pub fn start_warmer(self: *ConnectionPool) !void {
+        if (self.warmer != null) return;
+        self.stopping = false;
+        self.warmer = try std.Thread.spawn(.{}, warmer_loop, .{self});
+    }
+
+    pub fn stop_warmer(self: *ConnectionPool) void {
+        const thread = self.warmer orelse return;
+        self.mutex.lock();
+        self.stopping = true;
+        self.wake.signal();
+        self.mutex.unlock();
+        thread.join();
+        self.warmer = null;
+    }
+
+    fn warmer_loop(self: *ConnectionPool) void {
+        while (true) {
+            _ = self.fill_warm();
+
+            self.mutex.lock();
+            defer self.mutex.unlock();
+            if (self.stopping) return;
+            self.wake.timedWait(&self.mutex, @as(u64, self.config.warm_interval_ms) * std.time.ns_per_ms) catch {};
+            if (self.stopping) return;
+        }
     }
 
     /// Return connection to pool (for future use)
     pub fn return_connection(self: *ConnectionPool, conn: *client.Client) void {
         const now = std.time.milliTimestamp();
         for (self.connections.items) |*pooled| {
-            if (&pooled.client == conn) {
+            if (pooled.client == conn) {
                 pooled.last_used = now;
                 break;
             }
@@ -105,7 +334,7 @@ pub const ConnectionPool = struct {
         while (idx < self.connections.items.len) {
             const pooled = &self.connections.items[idx];
             if (now - pooled.last_used > idle_threshold_ms) {
-                pooled.client.disconnect();
+                self.destroy_client(pooled.client);
                 _ = self.connections.orderedRemove(idx);
             } else {
                 idx += 1;
@@ -114,15 +343,20 @@ pub const ConnectionPool = struct {
     }
 
     /// Get pool statistics
-    pub fn get_stats(self: ConnectionPool) PoolStats {
+    pub fn get_stats(self: *ConnectionPool) PoolStats {
+        self.mutex.lock();
+        defer self.mutex.unlock();
         return .{
             .total_connections = self.connections.items.len,
             .active_connections = self.count_active(),
             .total_uses = self.sum_uses(),
+            .warm_connections = self.warm.items.len,
+            .warm_hits = self.warm_hits,
+            .warm_misses = self.warm_misses,
         };
     }
 
-    fn count_active(self: ConnectionPool) usize {
+    fn count_active(self: *const ConnectionPool) usize {
         var count: usize = 0;
         for (self.connections.items) |pooled| {
             if (pooled.client.connected) {
@@ -132,7 +366,7 @@ pub const ConnectionPool = struct {
         return count;
     }
 
-    fn sum_uses(self: ConnectionPool) u64 {
+    fn sum_uses(self: *const ConnectionPool) u64 {
         var sum: u64 = 0;
         for (self.connections.items) |pooled| {
             sum += pooled.use_count;
@@ -140,18 +374,28 @@ pub const ConnectionPool = struct {
         return sum;
     }
 
-    /// Clear all connections
+    /// Clear all connections, warm ones included
     pub fn clear(self: *ConnectionPool) void {
-        for (self.connections.items) |*pooled| {
-            pooled.client.disconnect();
+        for (self.connections.items) |pooled| {
+            self.destroy_client(pooled.client);
         }
         self.connections.clearRetainingCapacity();
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        for (self.warm.items) |warm| {
+            self.destroy_client(warm.client);
+        }
+        self.warm.clearRetainingCapacity();
     }
 
     /// Deinitialize pool
     pub fn deinit(self: *ConnectionPool) void {
+        self.stop_warmer();
         self.clear();
-        self.connections.deinit();
+        self.connections.deinit(self.allocator);
+        self.warm.deinit(self.allocator);
+        self.endpoints.deinit(self.allocator);
     }
 };
 
@@ -159,6 +403,9 @@ pub const PoolStats = struct {
     total_connections: usize,
     active_connections: usize,
     total_uses: u64,
+    warm_connections: usize = 0,
+    warm_hits: u64 = 0,
+    warm_misses: u64 = 0,
 };
 
 /// Resilient client wrapper with retry and timeout logic
@@ -320,3 +567,123 @@ test "connection_pool: custom config" {
     try std.testing.expectEqual(@as(u32, 5), pool.config.max_retries);
     try std.testing.expectEqual(@as(u32, 500), pool.config.retry_delay_ms);
 }
+
+fn serve_negotiation(server: *std.net.Server, accepted: *?std.net.Stream) void {
+    const conn = server.accept() catch return;
+    var request: [15]u8 = undefined;
+    var filled: usize = 0;
+    while (filled < request.len) {
+        const n = conn.stream.read(request[filled..]) catch 0;
+        if (n == 0) break;
+        filled += n;
+    }
+    // Refuse TTYPE, agree binary and EOR and send the first screen right behind it
+    conn.stream.writeAll(&.{
+        0xFF, 0xFE, 0x18,
+        0xFF, 0xFD, 0x19, 0xFF, 0xFB, 0x19, 0xFF, 0xFD, 0x00, 0xFF, 0xFB, 0x00,
+        0xF5, 0xC3, 0xFF, 0xEF,
+    }) catch {};
+    accepted.* = conn.stream;
+}
+
+test "connection_pool: warm sessions are negotiated and handed out once" {
+    const listen_address = try std.net.Address.parseIp("127.0.0.1", 0);
+    var server = try listen_address.listen(.{ .reuse_address = true });
+    defer server.deinit();
+    const port = server.listen_address.getPort();
+
+    var pool = ConnectionPool.init(std.testing.allocator, .{ .negotiation_timeout_ms = 1000 });
+    defer pool.deinit();
+    try pool.register_endpoint("127.0.0.1", port, 1);
+
+    var accepted: ?std.net.Stream = null;
+    const host = try std.Thread.spawn(.{}, serve_negotiation, .{ &server, &accepted });
+    try std.testing.expectEqual(@as(usize, 1), pool.fill_warm());
+    host.join();
+    defer if (accepted) |stream| stream.close();
+
+    // Already full: another pass opens nothing
+    try std.testing.expectEqual(@as(usize, 0), pool.fill_warm());
+
+    const session = pool.take_session("127.0.0.1", port) orelse return error.TestExpectedWarmSession;
+    defer pool.release_session(session);
+    try std.testing.expect(session.negotiator.is_complete());
+    try std.testing.expectEqualSlices(u8, &.{ 0xF5, 0xC3, 0xFF, 0xEF }, try session.read());
+
+    try std.testing.expect(pool.take_session("127.0.0.1", port) == null);
+    const stats = pool.get_stats();
+    try std.testing.expectEqual(@as(u64, 1), stats.warm_hits);
+    try std.testing.expectEqual(@as(u64, 1), stats.warm_misses);
+}
+
+test "connection_pool: new connections answer the host's negotiation" {
+    const listen_address = try std.net.Address.parseIp("127.0.0.1", 0);
+    var server = try listen_address.listen(.{ .reuse_address = true });
+    defer server.deinit();
+    const port = server.listen_address.getPort();
+
+    var pool = ConnectionPool.init(std.testing.allocator, .{ .negotiation_timeout_ms = 1000 });
+    defer pool.deinit();
+
+    var accepted: ?std.net.Stream = null;
+    const host = try std.Thread.spawn(.{}, serve_negotiation, .{ &server, &accepted });
+    const session = try pool.get_connection("127.0.0.1", port);
+    host.join();
+    defer if (accepted) |stream| stream.close();
+
+    // Not a warm session, but negotiated all the same
+    try std.testing.expect(session.negotiator.is_complete());
+    try std.testing.expectEqualSlices(u8, &.{ 0xF5, 0xC3, 0xFF, 0xEF }, try session.read());
+}
+
+test "connection_pool: a warm session idle past the read timeout still sends" {
+    const listen_address = try std.net.Address.parseIp("127.0.0.1", 0);
+    var server = try listen_address.listen(.{ .reuse_address = true });
+    defer server.deinit();
+    const port = server.listen_address.getPort();
+
+    var pool = ConnectionPool.init(std.testing.allocator, .{ .negotiation_timeout_ms = 1000 });
+    defer pool.deinit();
+    try pool.register_endpoint("127.0.0.1", port, 1);
+
+    var accepted: ?std.net.Stream = null;
+    const host = try std.Thread.spawn(.{}, serve_negotiation, .{ &server, &accepted });
+    try std.testing.expectEqual(@as(usize, 1), pool.fill_warm());
+    host.join();
+    defer if (accepted) |stream| stream.close();
+
+    // Warmed long before it is needed
+    const warm = pool.warm.items[0].client;
+    warm.last_activity -= @as(i64, pool.config.read_timeout_ms) + 1000;
+    try std.testing.expect(warm.is_timed_out());
+
+    const session = pool.take_session("127.0.0.1", port) orelse return error.TestExpectedWarmSession;
+    defer pool.release_session(session);
+    try session.send(&.{ 0x7D, 0x40, 0x40, 0xFF, 0xEF });
+}
+
+test "connection_pool: a failing endpoint backs off before the next attempt" {
+    // A port nothing listens on
+    const listen_address = try std.net.Address.parseIp("127.0.0.1", 0);
+    var server = try listen_address.listen(.{ .reuse_address = true });
+    const port = server.listen_address.getPort();
+    server.deinit();
+
+    var pool = ConnectionPool.init(std.testing.allocator, .{ .retry_delay_ms = 60_000, .max_retry_delay_ms = 90_000 });
+    defer pool.deinit();
+    try pool.register_endpoint("127.0.0.1", port, 1);
+
+    try std.testing.expectEqual(@as(usize, 0), pool.fill_warm());
+    const endpoint = pool.endpoints.items[0];
+    try std.testing.expectEqual(@as(u32, 60_000), endpoint.backoff_ms);
+    try std.testing.expect(endpoint.retry_at > std.time.milliTimestamp());
+
+    // Still backing off: the pass does not try, so the delay stays put
+    try std.testing.expectEqual(@as(usize, 0), pool.fill_warm());
+    try std.testing.expectEqual(@as(u32, 60_000), pool.endpoints.items[0].backoff_ms);
+
+    // Once due, another failure doubles the delay up to the cap
+    pool.endpoints.items[0].retry_at = 0;
+    try std.testing.expectEqual(@as(usize, 0), pool.fill_warm());
+    try std.testing.expectEqual(@as(u32, 90_000), pool.endpoints.items[0].backoff_ms);
+}
@@ -10,6 +10,9 @@
 //! - Structured logging with trace context
 //! - OTLP export (HTTP and gRPC)
 //! - Sampling and baggage propagation
+//!
+//! High-volume transaction tracing goes through span_processor.zig, which
+//! pools span records and exports sampled batches in the background.
 
 const std = @import("std");
 const debug_log = @import("debug_log.zig");
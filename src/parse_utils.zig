@@ -25,7 +25,7 @@ pub fn buffer_to_address(pos: usize) protocol.Address {
 
 /// Convert 3270 screen address to buffer position
 pub fn address_to_buffer(addr: protocol.Address) u16 {
-    return (addr.row * 80) + addr.col;
+    return @as(u16, addr.row) * 80 + addr.col;
 }
 
 /// Parse command code from byte
@@ -1,4 +1,5 @@
 const std = @import("std");
+const charset_support = @import("charset_support.zig");
 
 pub const ConnectionProfile = struct {
     name: []const u8,
@@ -7,6 +8,12 @@ pub const ConnectionProfile = struct {
     timeout: u32 = 5000,
     auto_reconnect: bool = true,
     max_retries: u32 = 3,
+    /// Host code page; each session builds its own Transcoder from it
+    codepage: charset_support.Codepage = .cp037,
+
+    pub fn transcoder(self: ConnectionProfile) charset_support.Transcoder {
+        return charset_support.Transcoder.init(self.codepage);
+    }
 };
 
 pub const ProfileManager = struct {
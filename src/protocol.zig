@@ -7,6 +7,7 @@ pub const CommandCode = enum(u8) {
     write = 0x01,
     read_buffer = 0x02,
     read_modified = 0x06,
+    write_structured_field = 0x11,
 };
 
 /// 3270 Order Codes
@@ -20,6 +21,49 @@ pub const OrderCode = enum(u8) {
     graphic_escape = 0x08,
 };
 
+/// Attention identifiers sent as the first byte of an inbound stream
+pub const Aid = enum(u8) {
+    no_aid = 0x60,
+    enter = 0x7D,
+    clear = 0x6D,
+    pa1 = 0x6C,
+    pa2 = 0x6E,
+    pa3 = 0x6B,
+    pf1 = 0xF1,
+    pf2 = 0xF2,
+    pf3 = 0xF3,
+    pf4 = 0xF4,
+    pf5 = 0xF5,
+    pf6 = 0xF6,
+    pf7 = 0xF7,
+    pf8 = 0xF8,
+    pf9 = 0xF9,
+    pf10 = 0x7A,
+    pf11 = 0x7B,
+    pf12 = 0x7C,
+    pf13 = 0xC1,
+    pf14 = 0xC2,
+    pf15 = 0xC3,
+    pf16 = 0xC4,
+    pf17 = 0xC5,
+    pf18 = 0xC6,
+    pf19 = 0xC7,
+    pf20 = 0xC8,
+    pf21 = 0xC9,
+    pf22 = 0x4A,
+    pf23 = 0x4B,
+    pf24 = 0x4C,
+
+    /// PA keys and Clear send only the AID unless the host asked for
+    /// Read Modified All
+    pub fn is_short_read(self: Aid) bool {
+        return switch (self) {
+            .clear, .pa1, .pa2, .pa3 => true,
+            else => false,
+        };
+    }
+};
+
 /// Field Attribute Flags
 pub const FieldAttribute = packed struct {
     protected: bool = false,
@@ -43,7 +87,7 @@ pub const Address = struct {
     }
 
     pub fn to_bytes(self: Address) [2]u8 {
-        const combined: u16 = (self.row * 80) + self.col;
+        const combined: u16 = @as(u16, self.row) * 80 + self.col;
         return .{
             @as(u8, @truncate(combined >> 8)),
             @as(u8, @truncate(combined & 0xFF)),
@@ -1,6 +1,8 @@
 const std = @import("std");
 const protocol = @import("protocol.zig");
 const command_mod = @import("command.zig");
+const buffer_pool = @import("buffer_pool.zig");
+const session_recorder = @import("session_recorder.zig");
 
 /// Protocol event that was captured
 pub const ProtocolEvent = struct {
@@ -8,9 +10,11 @@ pub const ProtocolEvent = struct {
     sequence_number: u64,
     event_type: EventType,
     data: []const u8,
+    /// Pooled buffer holding `data`
+    storage: []u8,
 
-    pub fn deinit(self: *ProtocolEvent, allocator: std.mem.Allocator) void {
-        allocator.free(self.data);
+    pub fn deinit(self: *ProtocolEvent, pool: *buffer_pool.SharedBufferPool) void {
+        pool.release(self.storage);
     }
 };
 
@@ -39,53 +43,53 @@ pub const ProtocolAnalysis = struct {
 /// Snoops on protocol traffic and captures events
 pub const ProtocolSnooper = struct {
     allocator: std.mem.Allocator,
-    events: std.ArrayList(ProtocolEvent),
+    events: std.ArrayList(ProtocolEvent) = .empty,
+    /// Where captured data is copied; null uses the process-wide pool,
+    /// resolved on the first capture
+    pool: ?*buffer_pool.SharedBufferPool = null,
     sequence_counter: u64 = 0,
     enabled: bool = true,
 
     pub fn init(allocator: std.mem.Allocator) ProtocolSnooper {
         return ProtocolSnooper{
             .allocator = allocator,
-            .events = std.ArrayList(ProtocolEvent).init(allocator),
         };
     }
 
     pub fn deinit(self: *ProtocolSnooper) void {
         for (self.events.items) |*event| {
-            event.deinit(self.allocator);
+            event.deinit(self.pool.?);
         }
-        self.events.deinit();
+        self.events.deinit(self.allocator);
+        // The capturing thread may exit next; give its magazines back
+        if (self.pool) |pool| pool.releaseThreadCache();
     }
 
     /// Capture an outgoing command
     pub fn capture_command(self: *ProtocolSnooper, data: []const u8) !void {
-        if (!self.enabled) return;
-
-        const timestamp = std.time.milliTimestamp();
-        const event = ProtocolEvent{
-            .timestamp = timestamp,
-            .sequence_number = self.sequence_counter,
-            .event_type = .command_sent,
-            .data = try self.allocator.dupe(u8, data),
-        };
-
-        try self.events.append(event);
-        self.sequence_counter += 1;
+        try self.capture(.command_sent, data);
     }
 
     /// Capture an incoming response
     pub fn capture_response(self: *ProtocolSnooper, data: []const u8) !void {
+        try self.capture(.response_received, data);
+    }
+
+    fn capture(self: *ProtocolSnooper, event_type: EventType, data: []const u8) !void {
         if (!self.enabled) return;
 
-        const timestamp = std.time.milliTimestamp();
-        const event = ProtocolEvent{
-            .timestamp = timestamp,
-            .sequence_number = self.sequence_counter,
-            .event_type = .response_received,
-            .data = try self.allocator.dupe(u8, data),
-        };
+        if (self.pool == null) self.pool = try buffer_pool.global();
+        try self.events.ensureUnusedCapacity(self.allocator, 1);
+        const storage = try self.pool.?.acquire(data.len);
+        @memcpy(storage[0..data.len], data);
 
-        try self.events.append(event);
+        self.events.appendAssumeCapacity(.{
+            .timestamp = std.time.milliTimestamp(),
+            .sequence_number = self.sequence_counter,
+            .event_type = event_type,
+            .data = storage[0..data.len],
+            .storage = storage,
+        });
         self.sequence_counter += 1;
     }
 
@@ -128,7 +132,9 @@ pub const ProtocolSnooper = struct {
         var file = try std.fs.cwd().createFile(path, .{});
         defer file.close();
 
-        var writer = file.writer();
+        var buffer: [4096]u8 = undefined;
+        var file_writer = file.writer(&buffer);
+        const writer = &file_writer.interface;
 
         // Write header
         try writer.print("=== PROTOCOL SNOOPER LOG ===\n", .{});
@@ -142,7 +148,7 @@ pub const ProtocolSnooper = struct {
                 .response_received => "RESPONSE_RECEIVED",
             };
 
-            try writer.print("[{:04}] {s} at {} ms, {} bytes\n", .{
+            try writer.print("[{d:0>4}] {s} at {} ms, {} bytes\n", .{
                 event.sequence_number,
                 event_type_str,
                 event.timestamp,
@@ -179,12 +185,35 @@ pub const ProtocolSnooper = struct {
         try writer.print("Bytes Sent: {}\n", .{analysis.data_sent_bytes});
         try writer.print("Bytes Received: {}\n", .{analysis.data_received_bytes});
         try writer.print("Duration: {} ms\n", .{analysis.duration_ms()});
+        try writer.flush();
+    }
+
+    /// Write the captured events in the session recording format, so a
+    /// capture can be replayed (e.g. by the replay benchmark). Commands
+    /// become `command` records and responses `response` records.
+    pub fn write_recording(self: *ProtocolSnooper, out: *std.Io.Writer) !void {
+        const format = session_recorder.format;
+        try out.writeAll(format.header);
+
+        var previous: i64 = if (self.events.items.len > 0) self.events.items[0].timestamp else 0;
+        for (self.events.items) |event| {
+            const delta: u64 = @intCast(@max(0, event.timestamp - previous));
+            previous = @max(previous, event.timestamp);
+
+            var prefix: [format.max_prefix_len]u8 = undefined;
+            const event_type: session_recorder.SessionEvent.EventType = switch (event.event_type) {
+                .command_sent => .command,
+                .response_received => .response,
+            };
+            try out.writeAll(format.encode_prefix(&prefix, delta, event_type, event.data.len));
+            try out.writeAll(event.data);
+        }
     }
 
     /// Clear all captured events
     pub fn clear(self: *ProtocolSnooper) void {
         for (self.events.items) |*event| {
-            event.deinit(self.allocator);
+            event.deinit(self.pool.?);
         }
         self.events.clearRetainingCapacity();
         self.sequence_counter = 0;
@@ -308,3 +337,70 @@ test "protocol snooper: clear events" {
     try std.testing.expectEqual(@as(usize, 0), snooper.events.items.len);
     try std.testing.expectEqual(@as(u64, 0), snooper.sequence_counter);
 }
+
+test "protocol snooper: captures copy into the given pool" {
+    var pool = try buffer_pool.SharedBufferPool.init(std.testing.allocator, .{ .magazines_per_class = 2 });
+    defer pool.deinit();
+
+    var snooper = ProtocolSnooper.init(std.testing.allocator);
+    snooper.pool = &pool;
+
+    var cmd_data = [_]u8{ 0x05, 0x11, 0x00, 0x00 };
+    try snooper.capture_command(&cmd_data);
+    cmd_data[0] = 0xFF;
+    try std.testing.expectEqualSlices(u8, &[_]u8{ 0x05, 0x11, 0x00, 0x00 }, snooper.events.items[0].data);
+
+    // Cleared events hand their storage back for the next capture
+    snooper.clear();
+    try snooper.capture_response(&cmd_data);
+    snooper.deinit();
+
+    const stats = pool.stats();
+    try std.testing.expectEqual(@as(u64, 1), stats.hits);
+    try std.testing.expectEqual(@as(u64, 1), stats.misses);
+}
+
+test "protocol snooper: deinit hands the thread's buffers back to the pool" {
+    var pool = try buffer_pool.SharedBufferPool.init(std.testing.allocator, .{ .magazines_per_class = 2 });
+    defer pool.deinit();
+
+    const Capture = struct {
+        fn run(shared: *buffer_pool.SharedBufferPool, result: *?anyerror) void {
+            var snooper = ProtocolSnooper.init(std.testing.allocator);
+            snooper.pool = shared;
+            defer snooper.deinit();
+            for (0..4) |_| snooper.capture_response(&[_]u8{ 0xF5, 0xC3 }) catch |err| {
+                result.* = err;
+                return;
+            };
+        }
+    };
+    var result: ?anyerror = null;
+    (try std.Thread.spawn(.{}, Capture.run, .{ &pool, &result })).join();
+    try std.testing.expectEqual(@as(?anyerror, null), result);
+
+    // The exited thread's buffers are in the depot, not stranded in its cache
+    const buf = try pool.acquire(2);
+    defer pool.release(buf);
+    try std.testing.expectEqual(@as(u64, 1), pool.stats().hits);
+}
+
+test "protocol snooper: write recording" {
+    var snooper = ProtocolSnooper.init(std.testing.allocator);
+    defer snooper.deinit();
+
+    try snooper.capture_response(&[_]u8{ 0xF5, 0xC3, 0xFF, 0xEF });
+    try snooper.capture_command(&[_]u8{ 0x7D, 0x40, 0x40 });
+
+    var out: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer out.deinit();
+    try snooper.write_recording(&out.writer);
+
+    var reader = try session_recorder.RecordingReader.init(out.written());
+    const first = (try reader.next()).?;
+    try std.testing.expectEqual(session_recorder.SessionEvent.EventType.response, first.event_type);
+    try std.testing.expectEqualSlices(u8, &[_]u8{ 0xF5, 0xC3, 0xFF, 0xEF }, first.data);
+    const second = (try reader.next()).?;
+    try std.testing.expectEqual(session_recorder.SessionEvent.EventType.command, second.event_type);
+    try std.testing.expect((try reader.next()) == null);
+}
@@ -0,0 +1,279 @@
+//! Read Modified / Read Modified All encoder.
+//!
+//! Builds the inbound data stream for an AID key in one pass over the
+//! screen's modified data tags (`Screen.modified`): the AID, the cursor
+//! address, then SBA + data for every field holding a tagged cell, in
+//! buffer order. Field data comes from the character plane with nulls
+//! suppressed. Nothing is allocated; `encoded_size_bound` sizes a pooled
+//! buffer for `std.Io.Writer.fixed`.
+//!
+//! On a screen built from the data stream, fields come from the
+//! start-field cells (`Screen.field_starts`): a field's data runs from
+//! the cell after its attribute to the next attribute, wrapping at the
+//! end of the buffer, and the SBA points at that first data cell. A tag
+//! on the attribute cell itself is an MDT the host preset. Screens
+//! without start-field cells but with a field table, as built through
+//! the C API, send each table field's stated extent instead.
+//!
+//! Addresses use the same 14-bit binary form the executor reads.
+const std = @import("std");
+const protocol = @import("protocol.zig");
+const screen = @import("screen.zig");
+const field = @import("field.zig");
+
+const iac: u8 = 0xFF;
+const eor: u8 = 0xEF;
+
+pub const Options = struct {
+    /// Read Modified All: short-read AIDs (PA keys, Clear) send fields too
+    read_all: bool = false,
+    /// Double IAC bytes and end with IAC EOR, ready for the socket
+    telnet: bool = false,
+};
+
+/// Largest encoding possible for this screen and field count
+pub fn encoded_size_bound(scr: *const screen.Screen, fields: *const field.FieldManager) usize {
+    const raw = 3 + scr.size() + 3 * @max(fields.fields.items.len, scr.field_starts.count());
+    // Every byte doubled in the worst case, plus IAC EOR
+    return raw * 2 + 2;
+}
+
+/// Write the inbound stream for `aid` with the cursor at `cursor`
+pub fn encode(
+    out: *std.Io.Writer,
+    scr: *const screen.Screen,
+    fields: *field.FieldManager,
+    aid: protocol.Aid,
+    cursor: u16,
+    options: Options,
+) std.Io.Writer.Error!void {
+    try emit(out, &.{@intFromEnum(aid)}, options.telnet);
+    if (aid.is_short_read() and !options.read_all) return finish(out, options.telnet);
+
+    try emit(out, &address_bytes(cursor), options.telnet);
+
+    if (scr.field_starts.findFirstSet()) |first| {
+        try emit_fields(out, scr, first, options.telnet);
+    } else if (fields.count() > 0) {
+        try emit_table_fields(out, scr, fields, options.telnet);
+    } else {
+        // Unformatted screen: all data, no SBA
+        try emit_data(out, scr.buffer, options.telnet);
+    }
+    return finish(out, options.telnet);
+}
+
+/// Tagged fields delimited by start-field cells; `first` is the lowest
+fn emit_fields(out: *std.Io.Writer, scr: *const screen.Screen, first: usize, telnet: bool) !void {
+    const size = scr.size();
+    var resume_at: usize = 0;
+    // The last field may run past the end of the buffer into the first
+    // cells; it goes out once, at its first tag
+    var wrap_sent = false;
+    var tagged = scr.modified.iterator(.{});
+    while (tagged.next()) |address| {
+        if (address < resume_at) continue;
+        const start = scr.field_start_at(address).?;
+        const next = scr.next_field_start(start).?;
+        const wraps = next <= start;
+        if (wraps) {
+            if (wrap_sent) continue;
+            wrap_sent = true;
+        }
+
+        const data_start = start + 1;
+        try emit(out, &.{@intFromEnum(protocol.OrderCode.set_buffer_address)}, telnet);
+        try emit(out, &address_bytes(@intCast(data_start % size)), telnet);
+        if (wraps) {
+            try emit_data(out, scr.buffer[data_start..], telnet);
+            try emit_data(out, scr.buffer[0..next], telnet);
+            resume_at = if (address < first) first else size;
+        } else {
+            try emit_data(out, scr.buffer[data_start..next], telnet);
+            resume_at = next;
+        }
+    }
+}
+
+/// Tagged fields of an explicit field table, each sent from its start
+fn emit_table_fields(out: *std.Io.Writer, scr: *const screen.Screen, fields: *field.FieldManager, telnet: bool) !void {
+    var resume_at: usize = 0;
+    var tagged = scr.modified.iterator(.{});
+    while (tagged.next()) |address| {
+        if (address < resume_at) continue;
+        // Tags outside any field are stray input; nothing to send
+        const f = fields.find_field(@intCast(address)) orelse continue;
+        const start: usize = f.start_address;
+        const end = @min(start + f.length, scr.size());
+        if (start >= end) continue;
+
+        try emit(out, &.{@intFromEnum(protocol.OrderCode.set_buffer_address)}, telnet);
+        try emit(out, &address_bytes(f.start_address), telnet);
+        try emit_data(out, scr.buffer[start..end], telnet);
+        resume_at = end;
+    }
+}
+
+fn address_bytes(address: u16) [2]u8 {
+    return .{ @truncate(address >> 8), @truncate(address) };
+}
+
+/// Field data without null characters
+fn emit_data(out: *std.Io.Writer, data: []const u8, telnet: bool) !void {
+    var rest = data;
+    while (rest.len > 0) {
+        const run = std.mem.indexOfScalar(u8, rest, 0) orelse rest.len;
+        try emit(out, rest[0..run], telnet);
+        rest = rest[run..];
+        while (rest.len > 0 and rest[0] == 0) rest = rest[1..];
+    }
+}
+
+fn emit(out: *std.Io.Writer, bytes: []const u8, telnet: bool) !void {
+    if (!telnet) return out.writeAll(bytes);
+    var rest = bytes;
+    while (std.mem.indexOfScalar(u8, rest, iac)) |index| {
+        try out.writeAll(rest[0 .. index + 1]);
+        try out.writeByte(iac);
+        rest = rest[index + 1 ..];
+    }
+    try out.writeAll(rest);
+}
+
+fn finish(out: *std.Io.Writer, telnet: bool) !void {
+    if (telnet) try out.writeAll(&.{ iac, eor });
+}
+
+test "read modified sends tagged fields in buffer order" {
+    const DataEntry = @import("data_entry.zig").DataEntry;
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    // Added out of order: the encoder follows addresses, not the list
+    _ = try fm.add_field(160, 4, .{});
+    _ = try fm.add_field(80, 4, .{});
+    _ = try fm.add_field(240, 4, .{});
+
+    var entry = DataEntry.init(std.testing.allocator, &fm, &scr);
+    entry.current_field_index = 0;
+    try entry.write_char('B');
+    entry.current_field_index = 1;
+    entry.field_cursor = 0;
+    try entry.write_char('A');
+    try entry.write_char('A');
+    scr.buffer[82] = 0;
+
+    var buffer: [64]u8 = undefined;
+    var out = std.Io.Writer.fixed(&buffer);
+    try encode(&out, &scr, &fm, .enter, 81, .{});
+    try std.testing.expectEqualSlices(u8, &.{
+        0x7D, 0x00, 0x51, // AID, cursor
+        0x11, 0x00, 0x50, 'A', 'A', ' ', // null at 82 suppressed
+        0x11, 0x00, 0xA0, 'B', ' ', ' ', ' ',
+    }, out.buffered());
+
+    // PA keys are short reads unless the host asked for everything
+    out = std.Io.Writer.fixed(&buffer);
+    try encode(&out, &scr, &fm, .pa1, 81, .{});
+    try std.testing.expectEqualSlices(u8, &.{0x6C}, out.buffered());
+
+    scr.reset_modified();
+    out = std.Io.Writer.fixed(&buffer);
+    try encode(&out, &scr, &fm, .enter, 81, .{});
+    try std.testing.expectEqual(@as(usize, 3), out.end);
+}
+
+test "read modified telnet framing escapes IAC" {
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+
+    // Address 0xFF: the low address byte needs escaping too
+    _ = try fm.add_field(0xFF, 2, .{});
+    scr.buffer[0xFF] = 0xFF;
+    scr.mark_modified(0xFF, 1);
+
+    var buffer: [64]u8 = undefined;
+    var out = std.Io.Writer.fixed(&buffer);
+    try encode(&out, &scr, &fm, .enter, 0, .{ .telnet = true });
+    try std.testing.expectEqualSlices(u8, &.{
+        0x7D, 0x00, 0x00, // AID, cursor
+        0x11, 0x00, 0xFF, 0xFF, // SBA with the address byte doubled
+        0xFF, 0xFF, ' ', // data
+        0xFF, 0xEF, // IAC EOR
+    }, out.buffered());
+    try std.testing.expect(out.end <= encoded_size_bound(&scr, &fm));
+}
+
+test "read modified sends field data after the attribute of executed screens" {
+    const executor = @import("executor.zig");
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+    var exec = executor.Executor.init(std.testing.allocator, &scr, &fm);
+
+    const sba = @intFromEnum(protocol.OrderCode.set_buffer_address);
+    const sf = @intFromEnum(protocol.OrderCode.start_field);
+    // Label at 80, input field at 85 (data 86..89), a field at 160 with
+    // its MDT preset (data 161..164), each closed by a protected field
+    var panel = [_]u8{
+        0x00, // WCC
+        sba,  0x00, 0x50, sf, 0x01, 'N', 'A', 'M', 'E', sf, 0x00,
+        sba,  0x00, 0x5A, sf, 0x01,
+        sba,  0x00, 0xA0, sf, 0x11,
+        sba,  0x00, 0xA5, sf, 0x01,
+    };
+    try exec.execute(.{ .code = .erase_write, .data = &panel });
+
+    // The operator types into the input field
+    try scr.write_at(86, 'J');
+    try scr.write_at(87, 'O');
+    scr.mark_modified(86, 2);
+
+    var buffer: [64]u8 = undefined;
+    var out = std.Io.Writer.fixed(&buffer);
+    try encode(&out, &scr, &fm, .enter, 88, .{});
+    try std.testing.expectEqualSlices(u8, &.{
+        0x7D, 0x00, 0x58, // AID, cursor
+        0x11, 0x00, 0x56, 'J', 'O', ' ', ' ', // typed field, no attribute byte
+        0x11, 0x00, 0xA1, ' ', ' ', ' ', ' ', // preset MDT
+    }, out.buffered());
+
+    // A Write whose WCC resets the MDTs leaves nothing to send
+    var reset = [_]u8{executor.wcc_reset_mdt};
+    try exec.execute(.{ .code = .write, .data = &reset });
+    out = std.Io.Writer.fixed(&buffer);
+    try encode(&out, &scr, &fm, .enter, 88, .{});
+    try std.testing.expectEqual(@as(usize, 3), out.end);
+}
+
+test "read modified sends a wrapping field once" {
+    const executor = @import("executor.zig");
+    var scr = try screen.Screen.init(std.testing.allocator, 2, 10);
+    defer scr.deinit();
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+    var exec = executor.Executor.init(std.testing.allocator, &scr, &fm);
+
+    // Fields at 2 and 15; the second runs on through cells 0 and 1
+    const sba = @intFromEnum(protocol.OrderCode.set_buffer_address);
+    const sf = @intFromEnum(protocol.OrderCode.start_field);
+    var panel = [_]u8{ 0x00, sba, 0x00, 0x02, sf, 0x00, sba, 0x00, 0x0F, sf, 0x00 };
+    try exec.execute(.{ .code = .erase_write, .data = &panel });
+    try scr.write_at(0, 'W');
+    try scr.write_at(17, 'Z');
+    scr.mark_modified(0, 1);
+    scr.mark_modified(17, 1);
+
+    var buffer: [32]u8 = undefined;
+    var out = std.Io.Writer.fixed(&buffer);
+    try encode(&out, &scr, &fm, .enter, 0, .{});
+    try std.testing.expectEqualSlices(u8, &.{
+        0x7D, 0x00, 0x00,
+        0x11, 0x00, 0x10, ' ', 'Z', ' ', ' ', 'W', ' ',
+    }, out.buffered());
+}
@@ -1,5 +1,46 @@
 const std = @import("std");
 const screen = @import("screen.zig");
+const zone_trace = @import("zone_trace.zig");
+const metrics_export = @import("metrics_export.zig");
+
+/// Write the cells changed after generation `since` as ANSI cursor moves
+/// followed by the new text. Control bytes are shown as spaces.
+/// Returns the number of spans written.
+pub fn write_ansi_changes(scr: *const screen.Screen, since: u32, writer: *std.Io.Writer) !usize {
+    var spans: usize = 0;
+    var changes = scr.changes_since(since);
+    while (changes.next()) |span| {
+        try writer.print("\x1B[{d};{d}H", .{ span.row + 1, span.col + 1 });
+
+        try write_printable(scr.buffer[span.address..][0..span.len], writer);
+        spans += 1;
+    }
+    return spans;
+}
+
+/// Clear the terminal and write every row, control bytes shown as spaces.
+/// Returns the number of rows written.
+pub fn write_ansi_full(scr: *const screen.Screen, writer: *std.Io.Writer) !usize {
+    try writer.writeAll("\x1B[2J");
+    for (0..scr.rows) |row| {
+        try writer.print("\x1B[{d};1H", .{row + 1});
+        try write_printable(scr.row_slice(@intCast(row)), writer);
+    }
+    return scr.rows;
+}
+
+fn write_printable(cells: []const u8, writer: *std.Io.Writer) !void {
+    var text = cells;
+    while (text.len > 0) {
+        const printable = for (text, 0..) |c, i| {
+            if (!std.ascii.isPrint(c)) break i;
+        } else text.len;
+        try writer.writeAll(text[0..printable]);
+        if (printable == text.len) break;
+        try writer.writeByte(' ');
+        text = text[printable + 1 ..];
+    }
+}
 
 /// Renderer using libxghostty
 pub const Renderer = struct {
@@ -8,6 +49,8 @@ pub const Renderer = struct {
     cursor_row: u16 = 0,
     cursor_col: u16 = 0,
     show_status: bool = true,
+    /// Screen generation already on the terminal; null forces a full repaint
+    rendered_generation: ?u32 = null,
 
     /// Initialize renderer with a screen buffer
     pub fn init(allocator: std.mem.Allocator, scr: *screen.Screen) Renderer {
@@ -19,16 +62,16 @@ pub const Renderer = struct {
 
     /// Render screen contents to stdout (placeholder for libxghostty)
     pub fn render(self: *Renderer) !void {
+        const zone = zone_trace.begin(.render);
+        defer zone.end();
+        const timer = metrics_export.start_latency(.render);
+        defer timer.stop();
         // Clear and home cursor
         std.debug.print("\x1B[2J\x1B[H", .{});
 
         // Render screen content
         for (0..self.screen.rows) |row| {
-            for (0..self.screen.cols) |col| {
-                const char = self.screen.buffer[row][col];
-                std.debug.print("{c}", .{char});
-            }
-            std.debug.print("\n", .{});
+            std.debug.print("{s}\n", .{self.screen.row_slice(@intCast(row))});
         }
 
         // Render status line if enabled
@@ -40,6 +83,29 @@ pub const Renderer = struct {
         try self.position_cursor(self.cursor_row, self.cursor_col);
     }
 
+    /// Bring the terminal up to date, repainting only cells changed since
+    /// the previous call (the first call repaints everything).
+    /// Returns the number of spans written.
+    pub fn render_changes(self: *Renderer, writer: *std.Io.Writer) !usize {
+        const zone = zone_trace.begin(.render);
+        defer zone.end();
+        const timer = metrics_export.start_latency(.render);
+        defer timer.stop();
+        const spans = if (self.rendered_generation) |since|
+            try write_ansi_changes(self.screen, since, writer)
+        else
+            try write_ansi_full(self.screen, writer);
+        self.rendered_generation = self.screen.current_generation();
+
+        try writer.print("\x1B[{d};{d}H", .{ self.cursor_row + 1, self.cursor_col + 1 });
+        return spans;
+    }
+
+    /// Forget what the terminal shows so the next `render_changes` repaints
+    pub fn invalidate(self: *Renderer) void {
+        self.rendered_generation = null;
+    }
+
     /// Set cursor position (row, col)
     pub fn set_cursor(self: *Renderer, row: u16, col: u16) void {
         self.cursor_row = row;
@@ -149,3 +215,27 @@ test "renderer status line toggle" {
     rend.set_show_status(false);
     try std.testing.expect(!rend.show_status);
 }
+
+test "renderer render_changes emits only changed cells" {
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+
+    var rend = Renderer.init(std.testing.allocator, &scr);
+
+    var full_buf: [4096]u8 = undefined;
+    var full: std.Io.Writer = .fixed(&full_buf);
+    try std.testing.expectEqual(@as(usize, 24), try rend.render_changes(&full));
+
+    _ = scr.write_run(5 * 80 + 10, "HELLO");
+
+    var delta_buf: [256]u8 = undefined;
+    var delta: std.Io.Writer = .fixed(&delta_buf);
+    try std.testing.expectEqual(@as(usize, 1), try rend.render_changes(&delta));
+    try std.testing.expectEqualStrings("\x1B[6;11HHELLO\x1B[1;1H", delta.buffered());
+
+    // Nothing changed: only the cursor is repositioned
+    var idle_buf: [64]u8 = undefined;
+    var idle: std.Io.Writer = .fixed(&idle_buf);
+    try std.testing.expectEqual(@as(usize, 0), try rend.render_changes(&idle));
+    try std.testing.expectEqualStrings("\x1B[1;1H", idle.buffered());
+}
@@ -0,0 +1,671 @@
+//! End-to-end replay benchmark (`zig build bench`).
+//!
+//! Replays captured sessions through the same pipeline a live client runs:
+//! telnet framing and order decoding (`StreamDecoder`), command parsing,
+//! execution against the screen, field indexing and incremental ANSI
+//! rendering. Each stage is timed per 3270 record and its allocations are
+//! counted, so a run reports ns/record, p50/p99 and allocations/record per
+//! stage plus overall bytes/sec.
+//!
+//! Inputs are recordings in the `SessionRecorder` binary format; protocol
+//! snooper captures can be saved in the same format with
+//! `ProtocolSnooper.write_recording`. Only host-to-terminal (`response`)
+//! events are replayed, as raw socket bytes. Without inputs a built-in
+//! fixture session is used.
+//!
+//! Usage:
+//!   zig build bench -- [--iterations N] [--save FILE] [--baseline FILE]
+//!                      [--threshold PERCENT] [recording...]
+//!
+//! `--save` writes the run as a JSON baseline; `--baseline` compares the run
+//! against one and exits with status 1 when any metric is worse by more
+//! than the threshold (default 20%).
+const std = @import("std");
+const protocol = @import("protocol.zig");
+const parse_utils = @import("parse_utils.zig");
+const command = @import("command.zig");
+const executor = @import("executor.zig");
+const field = @import("field.zig");
+const screen = @import("screen.zig");
+const renderer = @import("renderer.zig");
+const stream_decoder = @import("stream_decoder.zig");
+const zero_copy_parser = @import("zero_copy_parser.zig");
+const session_recorder = @import("session_recorder.zig");
+const allocation_tracker = @import("allocation_tracker.zig");
+const performance_regression = @import("performance_regression.zig");
+
+const RegressionResult = performance_regression.RegressionResult;
+
+pub const Stage = enum { decode, parse, execute, fields, render };
+pub const stage_count = std.enums.values(Stage).len;
+
+/// Per-stage result. Times cover the records that reached the stage;
+/// records the executor rejects (e.g. WSF or read commands) stop after
+/// `parse`.
+pub const StageResult = struct {
+    stage: Stage,
+    records: u64,
+    ns_per_record: f64,
+    p50_ns: u64,
+    p99_ns: u64,
+    allocations_per_record: f64,
+};
+
+pub const Report = struct {
+    sessions: u64,
+    records: u64,
+    bytes: u64,
+    elapsed_ns: u64,
+    bytes_per_sec: f64,
+    /// Records the decoder or executor rejected
+    skipped: u64,
+    stages: [stage_count]StageResult,
+
+    pub fn write_json(self: Report, out: *std.Io.Writer) !void {
+        try std.json.Stringify.value(self, .{ .whitespace = .indent_2 }, out);
+        try out.writeByte('\n');
+    }
+
+    pub fn write_text(self: Report, out: *std.Io.Writer) !void {
+        try out.print("Replayed {d} sessions, {d} records, {d} bytes in {d:.2} ms ({d:.2} MB/s)\n", .{
+            self.sessions,
+            self.records,
+            self.bytes,
+            @as(f64, @floatFromInt(self.elapsed_ns)) / std.time.ns_per_ms,
+            self.bytes_per_sec / 1_000_000.0,
+        });
+        if (self.skipped > 0) try out.print("Skipped records: {d}\n", .{self.skipped});
+        try out.print("\n{s:<8} {s:>9} {s:>12} {s:>10} {s:>10} {s:>12}\n", .{
+            "stage", "records", "ns/record", "p50 ns", "p99 ns", "allocs/rec",
+        });
+        for (self.stages) |s| {
+            try out.print("{s:<8} {d:>9} {d:>12.1} {d:>10} {d:>10} {d:>12.2}\n", .{
+                @tagName(s.stage),
+                s.records,
+                s.ns_per_record,
+                s.p50_ns,
+                s.p99_ns,
+                s.allocations_per_record,
+            });
+        }
+    }
+};
+
+/// Saved baseline as read back from JSON. Stages missing on either side
+/// are not compared.
+pub const Baseline = struct {
+    bytes_per_sec: f64,
+    stages: []const StageResult,
+};
+
+pub fn parse_baseline(allocator: std.mem.Allocator, json: []const u8) !std.json.Parsed(Baseline) {
+    return std.json.parseFromSlice(Baseline, allocator, json, .{ .ignore_unknown_fields = true });
+}
+
+fn classify(change_percent: f64, threshold_percent: f64) RegressionResult.RegressionStatus {
+    if (change_percent > threshold_percent) return .failure;
+    if (change_percent > threshold_percent / 2.0) return .warning;
+    return .ok;
+}
+
+/// Percent by which `current` is worse than `baseline` when higher is worse
+fn increase_percent(baseline: f64, current: f64) f64 {
+    if (baseline == 0) return if (current > 0) std.math.inf(f64) else 0;
+    return (current - baseline) / baseline * 100.0;
+}
+
+/// Append every metric of `current` that is worse than `baseline` by more
+/// than half the threshold; those past the full threshold are failures.
+pub fn compare(
+    allocator: std.mem.Allocator,
+    baseline: Baseline,
+    current: Report,
+    threshold_percent: f64,
+    results: *std.ArrayList(RegressionResult),
+) !void {
+    const Check = struct { metric: []const u8, baseline: f64, current: f64, change: f64 };
+
+    if (baseline.bytes_per_sec > 0) {
+        const change = (baseline.bytes_per_sec - current.bytes_per_sec) / baseline.bytes_per_sec * 100.0;
+        const status = classify(change, threshold_percent);
+        if (status != .ok) try results.append(allocator, .{
+            .module = "pipeline",
+            .metric = "bytes_per_sec",
+            .baseline = baseline.bytes_per_sec,
+            .current = current.bytes_per_sec,
+            .change_percent = change,
+            .status = status,
+        });
+    }
+
+    for (current.stages) |now| {
+        const then = for (baseline.stages) |s| {
+            if (s.stage == now.stage) break s;
+        } else continue;
+
+        const p99_then: f64 = @floatFromInt(then.p99_ns);
+        const p99_now: f64 = @floatFromInt(now.p99_ns);
+        const checks = [_]Check{
+            .{ .metric = "ns_per_record", .baseline = then.ns_per_record, .current = now.ns_per_record, .change = increase_percent(then.ns_per_record, now.ns_per_record) },
+            .{ .metric = "p99_ns", .baseline = p99_then, .current = p99_now, .change = increase_percent(p99_then, p99_now) },
+            .{ .metric = "allocations_per_record", .baseline = then.allocations_per_record, .current = now.allocations_per_record, .change = increase_percent(then.allocations_per_record, now.allocations_per_record) },
+        };
+        for (checks) |check| {
+            const status = classify(check.change, threshold_percent);
+            if (status == .ok) continue;
+            try results.append(allocator, .{
+                .module = @tagName(now.stage),
+                .metric = check.metric,
+                .baseline = check.baseline,
+                .current = check.current,
+                .change_percent = check.change,
+                .status = status,
+            });
+        }
+    }
+}
+
+const StageSamples = struct {
+    ns: std.ArrayList(u64) = .empty,
+    total_ns: u64 = 0,
+    allocations: u64 = 0,
+
+    fn result(self: *StageSamples, stage: Stage) StageResult {
+        const samples = self.ns.items;
+        std.mem.sort(u64, samples, {}, std.sort.asc(u64));
+        const count: f64 = @floatFromInt(@max(samples.len, 1));
+        return .{
+            .stage = stage,
+            .records = samples.len,
+            .ns_per_record = @as(f64, @floatFromInt(self.total_ns)) / count,
+            .p50_ns = if (samples.len > 0) samples[samples.len / 2] else 0,
+            .p99_ns = if (samples.len > 0) samples[samples.len * 99 / 100] else 0,
+            .allocations_per_record = @as(f64, @floatFromInt(self.allocations)) / count,
+        };
+    }
+};
+
+/// One emulated terminal driven by replayed bytes. Heap-allocated because
+/// the executor, renderer and render sink point into it.
+const Pipeline = struct {
+    /// Untracked; holds the benchmark's own bookkeeping
+    allocator: std.mem.Allocator,
+    tracker: *allocation_tracker.AllocationTracker,
+    ring: zero_copy_parser.RingBufferIO,
+    decoder: stream_decoder.StreamDecoder = .{},
+    /// Current record with telnet framing removed
+    record: std.ArrayList(u8) = .empty,
+    screen: screen.Screen,
+    fields: field.FieldManager,
+    executor: executor.Executor,
+    renderer: renderer.Renderer,
+    render_buffer: [4096]u8 = undefined,
+    sink: std.Io.Writer.Discarding,
+    stages: [stage_count]StageSamples = [_]StageSamples{.{}} ** stage_count,
+    timer: std.time.Timer,
+    mark: usize = 0,
+    /// Decode time and allocations of the record in progress, which may
+    /// span several input chunks
+    decode_ns: u64 = 0,
+    decode_allocations: usize = 0,
+    skipped: u64 = 0,
+
+    const ring_capacity = 64 * 1024;
+
+    fn create(allocator: std.mem.Allocator, tracker: *allocation_tracker.AllocationTracker) !*Pipeline {
+        const tracked = tracker.allocator();
+        const timer = try std.time.Timer.start();
+        const self = try allocator.create(Pipeline);
+        errdefer allocator.destroy(self);
+
+        self.* = .{
+            .allocator = allocator,
+            .tracker = tracker,
+            .ring = try zero_copy_parser.RingBufferIO.init(tracked, ring_capacity),
+            .screen = undefined,
+            .fields = field.FieldManager.init(tracked),
+            .executor = undefined,
+            .renderer = undefined,
+            .sink = undefined,
+            .timer = timer,
+        };
+        errdefer self.ring.deinit();
+        self.screen = try screen.Screen.init(tracked, 24, 80);
+        self.executor = executor.Executor.init(tracked, &self.screen, &self.fields);
+        self.renderer = renderer.Renderer.init(tracked, &self.screen);
+        self.sink = std.Io.Writer.Discarding.init(&self.render_buffer);
+        return self;
+    }
+
+    fn destroy(self: *Pipeline) void {
+        for (&self.stages) |*s| s.ns.deinit(self.allocator);
+        self.record.deinit(self.tracker.allocator());
+        self.fields.deinit();
+        self.screen.deinit();
+        self.ring.deinit();
+        self.allocator.destroy(self);
+    }
+
+    /// Start a new session on a blank terminal
+    fn reset(self: *Pipeline) void {
+        self.decoder.reset();
+        self.ring.clear();
+        self.record.clearRetainingCapacity();
+        self.screen.clear();
+        self.fields.reset();
+        self.executor.cursor_address = 0;
+        self.renderer.invalidate();
+        self.decode_ns = 0;
+        self.decode_allocations = 0;
+    }
+
+    fn begin(self: *Pipeline) void {
+        self.mark = self.tracker.allocations;
+        self.timer.reset();
+    }
+
+    fn end(self: *Pipeline, stage: Stage) !void {
+        const elapsed = self.timer.read();
+        try self.add_sample(stage, elapsed, self.tracker.allocations - self.mark);
+    }
+
+    fn add_sample(self: *Pipeline, stage: Stage, ns: u64, allocations: usize) !void {
+        const samples = &self.stages[@intFromEnum(stage)];
+        try samples.ns.append(self.allocator, ns);
+        samples.total_ns += ns;
+        samples.allocations += allocations;
+    }
+
+    /// Feed raw socket bytes, running every record they complete
+    fn feed(self: *Pipeline, data: []const u8) !void {
+        var rest = data;
+        while (rest.len > 0) {
+            const len = @min(rest.len, self.ring.free_space());
+            if (len == 0) return error.DecoderStalled;
+            _ = try self.ring.write(rest[0..len]);
+            rest = rest[len..];
+            try self.drain();
+        }
+    }
+
+    fn drain(self: *Pipeline) !void {
+        const tracked = self.tracker.allocator();
+        self.begin();
+        while (true) {
+            const event = self.decoder.next(&self.ring) catch |err| switch (err) {
+                error.InvalidCommandCode,
+                error.InvalidFieldLength,
+                error.TruncatedOrder,
+                error.TruncatedField,
+                => {
+                    // The decoder drops the rest of the record
+                    self.record.clearRetainingCapacity();
+                    self.skipped += 1;
+                    continue;
+                },
+                else => return err,
+            } orelse break;
+
+            switch (event) {
+                .command => |code| try self.record.append(tracked, @intFromEnum(code)),
+                .order => |order| {
+                    try self.record.append(tracked, @intFromEnum(order.code));
+                    try self.record.appendSlice(tracked, order.operands());
+                },
+                .text => |text| try self.record.appendSlice(tracked, text),
+                .end_of_record => {
+                    const ns = self.decode_ns + self.timer.read();
+                    const allocations = self.decode_allocations + (self.tracker.allocations - self.mark);
+                    self.decode_ns = 0;
+                    self.decode_allocations = 0;
+                    try self.add_sample(.decode, ns, allocations);
+
+                    try self.run_record();
+                    self.record.clearRetainingCapacity();
+                    self.begin();
+                },
+                else => {},
+            }
+        }
+        self.decode_ns += self.timer.read();
+        self.decode_allocations += self.tracker.allocations - self.mark;
+    }
+
+    fn run_record(self: *Pipeline) !void {
+        if (self.record.items.len == 0) return;
+        const tracked = self.tracker.allocator();
+
+        self.begin();
+        var parser = command.CommandParser.init(tracked);
+        var cmd = (parser.parse_command(self.record.items) catch null) orelse {
+            self.skipped += 1;
+            return;
+        };
+        try self.end(.parse);
+        defer cmd.deinit(tracked);
+
+        self.begin();
+        self.executor.execute(cmd) catch {
+            self.skipped += 1;
+            return;
+        };
+        try self.end(.execute);
+
+        // Walk the tab chain as a terminal does after a repaint
+        self.begin();
+        var stops: usize = 0;
+        if (self.fields.next_unprotected_index(0)) |first| {
+            var index = first;
+            while (stops < self.fields.count()) {
+                const f = self.fields.get_field(index).?;
+                _ = self.fields.find_field(f.start_address);
+                stops += 1;
+                index = self.fields.next_unprotected_index(f.start_address + 1) orelse break;
+                if (index == first) break;
+            }
+        }
+        std.mem.doNotOptimizeAway(stops);
+        try self.end(.fields);
+
+        self.begin();
+        _ = try self.renderer.render_changes(&self.sink.writer);
+        try self.end(.render);
+    }
+};
+
+/// Replay each recording `iterations` times on a fresh terminal
+pub fn replay(allocator: std.mem.Allocator, recordings: []const []const u8, iterations: usize) !Report {
+    var tracker = allocation_tracker.AllocationTracker.init(allocator);
+    const pipeline = try Pipeline.create(allocator, &tracker);
+    defer pipeline.destroy();
+
+    var bytes: u64 = 0;
+    var sessions: u64 = 0;
+    var clock = try std.time.Timer.start();
+    for (0..iterations) |_| {
+        for (recordings) |recording| {
+            var reader = try session_recorder.RecordingReader.init(recording);
+            pipeline.reset();
+            while (try reader.next()) |event| {
+                if (event.event_type != .response) continue;
+                try pipeline.feed(event.data);
+                bytes += event.data.len;
+            }
+            sessions += 1;
+        }
+    }
+    const elapsed_ns = clock.read();
+
+    var report = Report{
+        .sessions = sessions,
+        .records = pipeline.stages[@intFromEnum(Stage.decode)].ns.items.len,
+        .bytes = bytes,
+        .elapsed_ns = elapsed_ns,
+        .bytes_per_sec = if (elapsed_ns == 0) 0 else @as(f64, @floatFromInt(bytes)) * std.time.ns_per_s / @as(f64, @floatFromInt(elapsed_ns)),
+        .skipped = pipeline.skipped,
+        .stages = undefined,
+    };
+    for (&report.stages, &pipeline.stages, 0..) |*result, *samples, i| {
+        result.* = samples.result(@enumFromInt(i));
+    }
+    return report;
+}
+
+/// Builds host records with 3270 orders and telnet framing
+const RecordBuilder = struct {
+    allocator: std.mem.Allocator,
+    body: std.ArrayList(u8) = .empty,
+
+    fn deinit(self: *RecordBuilder) void {
+        self.body.deinit(self.allocator);
+    }
+
+    fn start(self: *RecordBuilder, code: protocol.CommandCode, wcc: u8) !void {
+        self.body.clearRetainingCapacity();
+        try self.body.appendSlice(self.allocator, &.{ @intFromEnum(code), wcc });
+    }
+
+    fn sba(self: *RecordBuilder, row: u8, col: u8) !void {
+        const address = (protocol.Address{ .row = row, .col = col }).to_bytes();
+        try self.body.append(self.allocator, @intFromEnum(protocol.OrderCode.set_buffer_address));
+        try self.body.appendSlice(self.allocator, &address);
+    }
+
+    fn sf(self: *RecordBuilder, attr: protocol.FieldAttribute) !void {
+        try self.body.append(self.allocator, @intFromEnum(protocol.OrderCode.start_field));
+        try self.body.append(self.allocator, parse_utils.encode_field_attribute(attr));
+    }
+
+    fn order(self: *RecordBuilder, code: protocol.OrderCode) !void {
+        try self.body.append(self.allocator, @intFromEnum(code));
+    }
+
+    fn text(self: *RecordBuilder, bytes: []const u8) !void {
+        try self.body.appendSlice(self.allocator, bytes);
+    }
+
+    /// The record as sent on the wire: IAC doubled, IAC EOR appended
+    fn finish(self: *RecordBuilder, out: *std.ArrayList(u8)) !void {
+        for (self.body.items) |byte| {
+            if (byte == 0xFF) try out.append(self.allocator, 0xFF);
+            try out.append(self.allocator, byte);
+        }
+        try out.appendSlice(self.allocator, &.{ 0xFF, 0xEF });
+    }
+};
+
+/// A synthetic session in the recording format: telnet negotiation, a
+/// logon panel, a menu and a stream of partial updates, with records split
+/// across reads the way TCP delivers them.
+pub fn fixture_session(allocator: std.mem.Allocator) ![]u8 {
+    var recorder = session_recorder.SessionRecorder.init(allocator);
+    defer recorder.deinit();
+    recorder.start();
+
+    var wire: std.ArrayList(u8) = .empty;
+    defer wire.deinit(allocator);
+    var b = RecordBuilder{ .allocator = allocator };
+    defer b.deinit();
+
+    // DO TERMINAL-TYPE, SB TERMINAL-TYPE SEND, DO EOR, WILL EOR, DO BINARY
+    try recorder.record(.response, &.{ 0xFF, 0xFD, 0x18, 0xFF, 0xFA, 0x18, 0x01, 0xFF, 0xF0, 0xFF, 0xFD, 0x19, 0xFF, 0xFB, 0x19, 0xFF, 0xFD, 0x00 });
+    try recorder.record(.command, &.{ 0xFF, 0xFB, 0x18, 0xFF, 0xFB, 0x19, 0xFF, 0xFB, 0x00 });
+
+    const protected = protocol.FieldAttribute{ .protected = true };
+    const bright = protocol.FieldAttribute{ .protected = true, .intensified = true };
+    const input = protocol.FieldAttribute{};
+
+    for (0..4) |screen_index| {
+        // Logon panel
+        wire.clearRetainingCapacity();
+        try b.start(.erase_write, 0xC3);
+        try b.sba(0, 25);
+        try b.sf(bright);
+        try b.text("SYSTEM LOGON");
+        for (0..8) |i| {
+            const row: u8 = @intCast(4 + i * 2);
+            try b.sba(row, 10);
+            try b.sf(protected);
+            try b.text("Field label text");
+            try b.sba(row, 30);
+            try b.sf(input);
+            if (i == 0) try b.order(.insert_cursor);
+            try b.text("                    ");
+            try b.sf(protected);
+        }
+        try b.sba(23, 1);
+        try b.sf(protected);
+        try b.text("PF1 Help  PF3 Exit  ENTER Continue");
+        try b.finish(&wire);
+        // Delivered in two reads, split mid-record
+        const split = wire.items.len / 3;
+        try recorder.record(.response, wire.items[0..split]);
+        try recorder.record(.response, wire.items[split..]);
+        try recorder.record(.command, &.{ 0x7D, 0x40, 0x40, 0x11, 0x40, 0x5A, 0xFF, 0xEF });
+
+        // Menu
+        wire.clearRetainingCapacity();
+        try b.start(.erase_write, 0xC3);
+        for (0..20) |row| {
+            try b.sba(@intCast(row + 2), 2);
+            try b.sf(if (row % 5 == 0) input else protected);
+            try b.text("Option entry description for this menu line ");
+        }
+        try b.finish(&wire);
+        try recorder.record(.response, wire.items);
+
+        // Status line and field updates, several records per read
+        wire.clearRetainingCapacity();
+        for (0..24) |update| {
+            try b.start(.write, 0xC2);
+            try b.sba(23, 40);
+            try b.text("Last update: ");
+            try b.text(&.{ @intCast('0' + update % 10), @intCast('0' + screen_index), 0xFF });
+            try b.sba(@intCast(2 + update % 20), 48);
+            try b.order(.erase_unprotected);
+            try b.text(&.{ 0x40, 0x40 });
+            try b.finish(&wire);
+        }
+        var rest = wire.items;
+        while (rest.len > 0) {
+            const len = @min(rest.len, 700);
+            try recorder.record(.response, rest[0..len]);
+            rest = rest[len..];
+        }
+    }
+
+    var out: std.Io.Writer.Allocating = .init(allocator);
+    defer out.deinit();
+    try recorder.write_to(&out.writer);
+    return out.toOwnedSlice();
+}
+
+pub fn main() !void {
+    const allocator = std.heap.smp_allocator;
+    var arena_state = std.heap.ArenaAllocator.init(allocator);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+
+    var iterations: usize = 20;
+    var threshold: f64 = 20.0;
+    var save_path: ?[]const u8 = null;
+    var baseline_path: ?[]const u8 = null;
+    var recordings: std.ArrayList([]const u8) = .empty;
+
+    var args = try std.process.argsWithAllocator(arena);
+    _ = args.skip();
+    while (args.next()) |arg| {
+        if (std.mem.eql(u8, arg, "--iterations")) {
+            iterations = try std.fmt.parseInt(usize, args.next() orelse return error.MissingArgument, 10);
+        } else if (std.mem.eql(u8, arg, "--threshold")) {
+            threshold = try std.fmt.parseFloat(f64, args.next() orelse return error.MissingArgument);
+        } else if (std.mem.eql(u8, arg, "--save")) {
+            save_path = args.next() orelse return error.MissingArgument;
+        } else if (std.mem.eql(u8, arg, "--baseline")) {
+            baseline_path = args.next() orelse return error.MissingArgument;
+        } else {
+            try recordings.append(arena, try std.fs.cwd().readFileAlloc(arena, arg, std.math.maxInt(u32)));
+        }
+    }
+    if (recordings.items.len == 0) {
+        try recordings.append(arena, try fixture_session(arena));
+    }
+
+    var stdout_buffer: [4096]u8 = undefined;
+    var stdout_writer = std.fs.File.stdout().writer(&stdout_buffer);
+    const stdout = &stdout_writer.interface;
+
+    const report = try replay(allocator, recordings.items, iterations);
+    try report.write_text(stdout);
+
+    if (save_path) |path| {
+        const file = try std.fs.cwd().createFile(path, .{});
+        defer file.close();
+        var file_buffer: [4096]u8 = undefined;
+        var file_writer = file.writer(&file_buffer);
+        try report.write_json(&file_writer.interface);
+        try file_writer.interface.flush();
+        try stdout.print("\nBaseline saved to {s}\n", .{path});
+    }
+
+    var failures: usize = 0;
+    if (baseline_path) |path| {
+        const json = try std.fs.cwd().readFileAlloc(arena, path, 1024 * 1024);
+        const baseline = try parse_baseline(arena, json);
+
+        var results: std.ArrayList(RegressionResult) = .empty;
+        try compare(arena, baseline.value, report, threshold, &results);
+
+        try stdout.print("\nCompared with {s} (threshold {d:.1}%)\n", .{ path, threshold });
+        for (results.items) |result| {
+            try stdout.print("[{s}] {s}: {s} worse by {d:.1}% ({d:.2} -> {d:.2})\n", .{
+                if (result.status == .failure) "FAIL" else "WARN",
+                result.module,
+                result.metric,
+                result.change_percent,
+                result.baseline,
+                result.current,
+            });
+            if (result.status == .failure) failures += 1;
+        }
+        try stdout.print("Summary: {d} failures, {d} warnings\n", .{ failures, results.items.len - failures });
+    }
+    try stdout.flush();
+
+    if (failures > 0) std.process.exit(1);
+}
+
+test "replay bench: fixture runs through every stage" {
+    const recording = try fixture_session(std.testing.allocator);
+    defer std.testing.allocator.free(recording);
+
+    const report = try replay(std.testing.allocator, &.{recording}, 2);
+    try std.testing.expectEqual(@as(u64, 2), report.sessions);
+    // Logon, menu and 24 updates per screen, four screens per session
+    try std.testing.expectEqual(@as(u64, 2 * 4 * 26), report.records);
+    try std.testing.expectEqual(@as(u64, 0), report.skipped);
+    for (report.stages) |s| {
+        try std.testing.expectEqual(report.records, s.records);
+        try std.testing.expect(s.p50_ns <= s.p99_ns);
+    }
+    // Parsing copies each command's data
+    try std.testing.expect(report.stages[@intFromEnum(Stage.parse)].allocations_per_record >= 1.0);
+}
+
+test "replay bench: baseline round trip and regression gating" {
+    var report = Report{
+        .sessions = 1,
+        .records = 10,
+        .bytes = 1000,
+        .elapsed_ns = 1000,
+        .bytes_per_sec = 1e9,
+        .skipped = 0,
+        .stages = undefined,
+    };
+    for (&report.stages, 0..) |*s, i| {
+        s.* = .{ .stage = @enumFromInt(i), .records = 10, .ns_per_record = 100, .p50_ns = 90, .p99_ns = 150, .allocations_per_record = 0 };
+    }
+
+    var json: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer json.deinit();
+    try report.write_json(&json.writer);
+    const baseline = try parse_baseline(std.testing.allocator, json.written());
+    defer baseline.deinit();
+    try std.testing.expectEqual(@as(usize, stage_count), baseline.value.stages.len);
+
+    var results: std.ArrayList(RegressionResult) = .empty;
+    defer results.deinit(std.testing.allocator);
+    try compare(std.testing.allocator, baseline.value, report, 20.0, &results);
+    try std.testing.expectEqual(@as(usize, 0), results.items.len);
+
+    // 30% slower execute and a new allocation in render
+    report.stages[@intFromEnum(Stage.execute)].ns_per_record = 130;
+    report.stages[@intFromEnum(Stage.render)].allocations_per_record = 1;
+    try compare(std.testing.allocator, baseline.value, report, 20.0, &results);
+    try std.testing.expectEqual(@as(usize, 2), results.items.len);
+    for (results.items) |result| {
+        try std.testing.expectEqual(RegressionResult.RegressionStatus.failure, result.status);
+    }
+    try std.testing.expectEqualStrings("execute", results.items[0].module);
+    try std.testing.expectEqualStrings("render", results.items[1].module);
+}
@@ -22,11 +22,17 @@ pub const ResourceLimits = struct {
     max_memory_bytes: u64 = 1024 * 1024 * 1024, // 1GB
     max_fields_per_screen: usize = 10000,
     max_command_queue_size: usize = 10000,
+    /// Per-session quotas enforced by `session_memory.SessionMemory`. Past
+    /// the soft quota a session sheds history and recordings; past the hard
+    /// quota its allocations fail.
+    session_memory_soft_bytes: u64 = 8 * 1024 * 1024, // 8MB
+    session_memory_hard_bytes: u64 = 16 * 1024 * 1024, // 16MB
 
     pub fn validate(self: ResourceLimits) !void {
         if (self.max_concurrent_sessions == 0) return error.InvalidInput;
         if (self.max_connections_per_endpoint == 0) return error.InvalidInput;
         if (self.max_memory_bytes == 0) return error.InvalidInput;
+        if (self.session_memory_soft_bytes > self.session_memory_hard_bytes) return error.InvalidInput;
     }
 };
 
@@ -1,4 +1,5 @@
 const std = @import("std");
+const screen = @import("screen.zig");
 
 pub const HttpMethod = enum {
     get,
@@ -12,12 +13,35 @@ pub const HttpStatus = enum(u16) {
     ok = 200,
     created = 201,
     no_content = 204,
+    not_modified = 304,
     bad_request = 400,
     unauthorized = 401,
     forbidden = 403,
     not_found = 404,
+    method_not_allowed = 405,
+    too_many_requests = 429,
+    request_header_fields_too_large = 431,
     internal_error = 500,
     service_unavailable = 503,
+
+    /// Reason phrase for the status line
+    pub fn phrase(self: HttpStatus) []const u8 {
+        return switch (self) {
+            .ok => "OK",
+            .created => "Created",
+            .no_content => "No Content",
+            .not_modified => "Not Modified",
+            .bad_request => "Bad Request",
+            .unauthorized => "Unauthorized",
+            .forbidden => "Forbidden",
+            .not_found => "Not Found",
+            .method_not_allowed => "Method Not Allowed",
+            .too_many_requests => "Too Many Requests",
+            .request_header_fields_too_large => "Request Header Fields Too Large",
+            .internal_error => "Internal Server Error",
+            .service_unavailable => "Service Unavailable",
+        };
+    }
 };
 
 pub const ApiRequest = struct {
@@ -61,6 +85,63 @@ pub const ScreenResponse = struct {
     cursor_col: u32 = 0,
 };
 
+/// Run of changed cells in a screen delta (text borrows the screen)
+pub const ScreenSpan = struct {
+    row: u16,
+    col: u16,
+    text: []const u8,
+};
+
+/// Cells changed since a generation the client already holds
+pub const ScreenDeltaResponse = struct {
+    session_id: []const u8,
+    since: ?u32,
+    /// Pass back as `since` on the next request
+    generation: u32,
+    spans: []const ScreenSpan,
+    cursor_row: u32 = 0,
+    cursor_col: u32 = 0,
+};
+
+/// Collect the spans changed after `since`; a null `since` returns every
+/// row. Free `spans` with the same allocator.
+pub fn buildScreenDelta(
+    allocator: std.mem.Allocator,
+    session_id: []const u8,
+    scr: *screen.Screen,
+    since: ?u32,
+) !ScreenDeltaResponse {
+    var spans: std.ArrayList(ScreenSpan) = .empty;
+    errdefer spans.deinit(allocator);
+
+    if (since) |generation| {
+        var changes = scr.changes_since(generation);
+        while (changes.next()) |span| {
+            try spans.append(allocator, .{
+                .row = span.row,
+                .col = span.col,
+                .text = scr.buffer[span.address..][0..span.len],
+            });
+        }
+    } else {
+        for (0..scr.rows) |row| {
+            try spans.append(allocator, .{ .row = @intCast(row), .col = 0, .text = scr.row_slice(@intCast(row)) });
+        }
+    }
+
+    return .{
+        .session_id = session_id,
+        .since = since,
+        .generation = scr.current_generation(),
+        .spans = try spans.toOwnedSlice(allocator),
+    };
+}
+
+/// Serialize a screen delta for REST responses and webhook payloads
+pub fn screenDeltaJson(allocator: std.mem.Allocator, delta: ScreenDeltaResponse) ![]u8 {
+    return std.json.Stringify.valueAlloc(allocator, delta, .{});
+}
+
 pub const ErrorResponse = struct {
     err: []const u8,
     message: []const u8,
@@ -362,3 +443,23 @@ test "rest_api: error response" {
     try testing.expect(err_resp.status == 404);
     try testing.expect(std.mem.eql(u8, err_resp.err, "SESSION_NOT_FOUND"));
 }
+
+test "rest_api: screen delta carries only changed spans" {
+    var scr = try screen.Screen.init(testing.allocator, 24, 80);
+    defer scr.deinit();
+
+    const initial = try buildScreenDelta(testing.allocator, "sess_001", &scr, null);
+    defer testing.allocator.free(initial.spans);
+    try testing.expectEqual(@as(usize, 24), initial.spans.len);
+
+    _ = scr.write_run(2 * 80 + 5, "OK");
+
+    const delta = try buildScreenDelta(testing.allocator, "sess_001", &scr, initial.generation);
+    defer testing.allocator.free(delta.spans);
+    try testing.expectEqual(@as(usize, 1), delta.spans.len);
+    try testing.expectEqualStrings("OK", delta.spans[0].text);
+
+    const json = try screenDeltaJson(testing.allocator, delta);
+    defer testing.allocator.free(json);
+    try testing.expect(std.mem.indexOf(u8, json, "\"text\":\"OK\"") != null);
+}
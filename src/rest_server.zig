@@ -0,0 +1,1157 @@
+//! Event-loop HTTP/1.1 front end for `RestAPI`.
+//!
+//! Connections are spread over a `session_reactor.ReactorGroup`, one
+//! reactor thread per worker, and are served without blocking: sockets
+//! stay open between requests (keep-alive) and pipelined requests are
+//! answered in order.
+//!
+//! Screens are serialized once per change. The thread that owns a
+//! `Screen` calls `publishScreen` after applying host data; the JSON is
+//! rebuilt only when the screen generation or cursor moved, and GETs copy
+//! the cached bytes. Each cached body has a revision, sent as the ETag,
+//! so clients can wait for the next change instead of polling:
+//!
+//!   GET    /sessions
+//!   GET    /sessions/{id}
+//!   DELETE /sessions/{id}
+//!   GET    /sessions/{id}/screen                cached ScreenResponse
+//!   GET    /sessions/{id}/screen?since={etag}   long-poll: returns once the
+//!                                                revision moves, or 304 after
+//!                                                `long_poll_timeout_ms`
+//!   GET    /sessions/{id}/screen/events         text/event-stream, one
+//!                                                event per change
+//!
+//! Usage:
+//! ```zig
+//! var server = try RestServer.init(allocator, &api, .{ .address = address });
+//! defer server.deinit();
+//! try server.start();
+//! // on the session thread, after each host write:
+//! _ = try server.publishScreen("sess_001", &scr, cursor_row, cursor_col);
+//! ```
+const std = @import("std");
+const rest_api = @import("rest_api.zig");
+const screen = @import("screen.zig");
+const session_reactor = @import("session_reactor.zig");
+
+const posix = std.posix;
+const Allocator = std.mem.Allocator;
+const HttpStatus = rest_api.HttpStatus;
+const Reactor = session_reactor.Reactor;
+const SessionHandle = session_reactor.SessionHandle;
+
+/// Largest request (head plus body) a connection buffers
+pub const max_request_bytes = 16 * 1024;
+
+/// Minimal HTTP/1.1 request parsing over a connection's input buffer
+pub const http = struct {
+    /// Parsed request; slices borrow the input buffer
+    pub const Request = struct {
+        method: ?rest_api.HttpMethod,
+        path: []const u8,
+        query: []const u8 = "",
+        keep_alive: bool,
+        authorization: ?[]const u8 = null,
+        if_none_match: ?[]const u8 = null,
+        last_event_id: ?[]const u8 = null,
+        body: []const u8 = "",
+        /// Bytes of input this request occupies
+        length: usize,
+    };
+
+    /// Parse the request at the start of `bytes`. Returns null until the
+    /// whole request (including any body) has arrived.
+    pub fn parseRequest(bytes: []const u8, max_len: usize) !?Request {
+        const head_end = std.mem.indexOf(u8, bytes, "\r\n\r\n") orelse {
+            if (bytes.len >= max_len) return error.RequestTooLarge;
+            return null;
+        };
+        var lines = std.mem.splitSequence(u8, bytes[0..head_end], "\r\n");
+
+        var parts = std.mem.splitScalar(u8, lines.first(), ' ');
+        const method = parts.next() orelse return error.MalformedRequest;
+        const target = parts.next() orelse return error.MalformedRequest;
+        const version = parts.next() orelse return error.MalformedRequest;
+        if (parts.next() != null or target.len == 0) return error.MalformedRequest;
+
+        var request = Request{
+            .method = parseMethod(method),
+            .path = target,
+            .keep_alive = if (std.mem.eql(u8, version, "HTTP/1.1"))
+                true
+            else if (std.mem.eql(u8, version, "HTTP/1.0"))
+                false
+            else
+                return error.UnsupportedVersion,
+            .length = head_end + 4,
+        };
+        if (std.mem.indexOfScalar(u8, target, '?')) |mark| {
+            request.path = target[0..mark];
+            request.query = target[mark + 1 ..];
+        }
+
+        var content_length: usize = 0;
+        while (lines.next()) |line| {
+            const colon = std.mem.indexOfScalar(u8, line, ':') orelse return error.MalformedRequest;
+            const name = line[0..colon];
+            const value = std.mem.trim(u8, line[colon + 1 ..], " \t");
+
+            if (std.ascii.eqlIgnoreCase(name, "connection")) {
+                if (std.ascii.indexOfIgnoreCase(value, "close") != null) request.keep_alive = false;
+                if (std.ascii.indexOfIgnoreCase(value, "keep-alive") != null) request.keep_alive = true;
+            } else if (std.ascii.eqlIgnoreCase(name, "content-length")) {
+                content_length = std.fmt.parseInt(usize, value, 10) catch return error.MalformedRequest;
+            } else if (std.ascii.eqlIgnoreCase(name, "transfer-encoding")) {
+                return error.UnsupportedTransferEncoding;
+            } else if (std.ascii.eqlIgnoreCase(name, "authorization")) {
+                request.authorization = value;
+            } else if (std.ascii.eqlIgnoreCase(name, "if-none-match")) {
+                request.if_none_match = value;
+            } else if (std.ascii.eqlIgnoreCase(name, "last-event-id")) {
+                request.last_event_id = value;
+            }
+        }
+
+        if (content_length > max_len - @min(max_len, request.length)) return error.RequestTooLarge;
+        if (bytes.len - request.length < content_length) return null;
+        request.body = bytes[request.length..][0..content_length];
+        request.length += content_length;
+        return request;
+    }
+
+    pub fn parseMethod(text: []const u8) ?rest_api.HttpMethod {
+        const names = [_]struct { []const u8, rest_api.HttpMethod }{
+            .{ "GET", .get },
+            .{ "POST", .post },
+            .{ "PUT", .put },
+            .{ "DELETE", .delete },
+            .{ "PATCH", .patch },
+        };
+        for (names) |entry| {
+            if (std.mem.eql(u8, text, entry[0])) return entry[1];
+        }
+        return null;
+    }
+
+    /// Value of `name` in a query string such as "since=3&x=y"
+    pub fn queryParam(query: []const u8, name: []const u8) ?[]const u8 {
+        var pairs = std.mem.splitScalar(u8, query, '&');
+        while (pairs.next()) |pair| {
+            const eq = std.mem.indexOfScalar(u8, pair, '=') orelse continue;
+            if (std.mem.eql(u8, pair[0..eq], name)) return pair[eq + 1 ..];
+        }
+        return null;
+    }
+
+    /// Revision carried by an ETag such as `"42"` (or `W/"42"`)
+    pub fn parseEtag(tag: []const u8) ?u64 {
+        var text = tag;
+        if (std.mem.startsWith(u8, text, "W/")) text = text[2..];
+        text = std.mem.trim(u8, text, "\"");
+        return std.fmt.parseInt(u64, text, 10) catch null;
+    }
+};
+
+/// Serialized ScreenResponse per session, rebuilt only when the screen
+/// changes. Each session has exactly one publisher (the thread owning its
+/// `Screen`); readers on any thread copy the cached bytes. The allocator
+/// must be thread-safe.
+pub const ScreenCache = struct {
+    allocator: Allocator,
+    /// Shared for lookups; exclusive only to add or remove sessions
+    lock: std.Thread.RwLock = .{},
+    entries: std.StringHashMapUnmanaged(*Entry) = .empty,
+
+    /// Connection parked until the next revision
+    pub const Watcher = struct {
+        reactor: *Reactor,
+        handle: SessionHandle,
+    };
+
+    pub const WatchResult = enum {
+        /// Notified through `Reactor.notify` on the next change
+        registered,
+        /// The revision already differs from `since`
+        changed,
+        /// No such session
+        missing,
+    };
+
+    const Entry = struct {
+        id: []u8,
+        mutex: std.Thread.Mutex = .{},
+        /// Cache key: the screen state `json` was built from
+        generation: u32 = 0,
+        cursor_row: u32 = 0,
+        cursor_col: u32 = 0,
+        /// Bumped on every rebuild; 0 until the first publish
+        revision: u64 = 0,
+        json: std.ArrayList(u8) = .empty,
+        watchers: std.ArrayList(Watcher) = .empty,
+        /// Publisher-only: the next body is built here without the lock
+        spare: std.ArrayList(u8) = .empty,
+        notifying: std.ArrayList(Watcher) = .empty,
+
+        fn deinit(self: *Entry, allocator: Allocator) void {
+            self.json.deinit(allocator);
+            self.watchers.deinit(allocator);
+            self.spare.deinit(allocator);
+            self.notifying.deinit(allocator);
+            allocator.free(self.id);
+        }
+    };
+
+    pub fn init(allocator: Allocator) ScreenCache {
+        return .{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *ScreenCache) void {
+        var it = self.entries.valueIterator();
+        while (it.next()) |entry| {
+            entry.*.deinit(self.allocator);
+            self.allocator.destroy(entry.*);
+        }
+        self.entries.deinit(self.allocator);
+    }
+
+    /// Start tracking a session (no-op if already tracked)
+    pub fn add(self: *ScreenCache, session_id: []const u8) !void {
+        self.lock.lock();
+        defer self.lock.unlock();
+
+        const slot = try self.entries.getOrPut(self.allocator, session_id);
+        if (slot.found_existing) return;
+        errdefer self.entries.removeByPtr(slot.key_ptr);
+
+        const entry = try self.allocator.create(Entry);
+        errdefer self.allocator.destroy(entry);
+        entry.* = .{ .id = try self.allocator.dupe(u8, session_id) };
+        slot.key_ptr.* = entry.id;
+        slot.value_ptr.* = entry;
+    }
+
+    /// Drop a session; parked watchers are woken and find it gone
+    pub fn remove(self: *ScreenCache, session_id: []const u8) void {
+        const entry = blk: {
+            self.lock.lock();
+            defer self.lock.unlock();
+            const removed = self.entries.fetchRemove(session_id) orelse return;
+            break :blk removed.value;
+        };
+        for (entry.watchers.items) |watcher| watcher.reactor.notify(watcher.handle) catch {};
+        entry.deinit(self.allocator);
+        self.allocator.destroy(entry);
+    }
+
+    /// Rebuild the cached body if the screen or cursor changed since the
+    /// last publish, then wake watchers. Returns true when rebuilt.
+    pub fn publish(
+        self: *ScreenCache,
+        session_id: []const u8,
+        scr: *screen.Screen,
+        cursor_row: u32,
+        cursor_col: u32,
+    ) !bool {
+        const generation = scr.current_generation();
+        while (true) {
+            self.lock.lockShared();
+            if (self.entries.get(session_id)) |entry| {
+                defer self.lock.unlockShared();
+                return self.refresh(entry, scr, generation, cursor_row, cursor_col);
+            }
+            self.lock.unlockShared();
+            try self.add(session_id);
+        }
+    }
+
+    fn refresh(
+        self: *ScreenCache,
+        entry: *Entry,
+        scr: *screen.Screen,
+        generation: u32,
+        cursor_row: u32,
+        cursor_col: u32,
+    ) !bool {
+        {
+            entry.mutex.lock();
+            defer entry.mutex.unlock();
+            if (entry.revision != 0 and entry.generation == generation and
+                entry.cursor_row == cursor_row and entry.cursor_col == cursor_col) return false;
+        }
+
+        // Serialize outside the lock so readers keep getting the old body
+        entry.spare.clearRetainingCapacity();
+        var out: std.Io.Writer.Allocating = .fromArrayList(self.allocator, &entry.spare);
+        const written = std.json.Stringify.value(rest_api.ScreenResponse{
+            .session_id = entry.id,
+            .screen_data = .{ .rows = scr.rows, .cols = scr.cols, .content = scr.buffer },
+            .cursor_row = cursor_row,
+            .cursor_col = cursor_col,
+        }, .{}, &out.writer);
+        entry.spare = out.toArrayList();
+        written catch return error.OutOfMemory;
+
+        {
+            entry.mutex.lock();
+            defer entry.mutex.unlock();
+            std.mem.swap(std.ArrayList(u8), &entry.json, &entry.spare);
+            entry.generation = generation;
+            entry.cursor_row = cursor_row;
+            entry.cursor_col = cursor_col;
+            entry.revision += 1;
+            std.mem.swap(std.ArrayList(Watcher), &entry.watchers, &entry.notifying);
+        }
+
+        for (entry.notifying.items) |watcher| watcher.reactor.notify(watcher.handle) catch {};
+        entry.notifying.clearRetainingCapacity();
+        return true;
+    }
+
+    /// Append the cached body to `out` and return its revision; null when
+    /// the session is unknown or not yet published
+    pub fn copyBody(self: *ScreenCache, session_id: []const u8, allocator: Allocator, out: *std.ArrayList(u8)) !?u64 {
+        self.lock.lockShared();
+        defer self.lock.unlockShared();
+        const entry = self.entries.get(session_id) orelse return null;
+
+        entry.mutex.lock();
+        defer entry.mutex.unlock();
+        if (entry.revision == 0) return null;
+        try out.appendSlice(allocator, entry.json.items);
+        return entry.revision;
+    }
+
+    /// Park `watcher` until the revision moves past `since`
+    pub fn watch(self: *ScreenCache, session_id: []const u8, since: u64, watcher: Watcher) !WatchResult {
+        self.lock.lockShared();
+        defer self.lock.unlockShared();
+        const entry = self.entries.get(session_id) orelse return .missing;
+
+        entry.mutex.lock();
+        defer entry.mutex.unlock();
+        if (entry.revision != since) return .changed;
+        for (entry.watchers.items) |existing| {
+            if (existing.reactor == watcher.reactor and std.meta.eql(existing.handle, watcher.handle)) return .registered;
+        }
+        try entry.watchers.append(self.allocator, watcher);
+        return .registered;
+    }
+
+    pub fn unwatch(self: *ScreenCache, session_id: []const u8, watcher: Watcher) void {
+        self.lock.lockShared();
+        defer self.lock.unlockShared();
+        const entry = self.entries.get(session_id) orelse return;
+
+        entry.mutex.lock();
+        defer entry.mutex.unlock();
+        for (entry.watchers.items, 0..) |existing, i| {
+            if (existing.reactor == watcher.reactor and std.meta.eql(existing.handle, watcher.handle)) {
+                _ = entry.watchers.swapRemove(i);
+                return;
+            }
+        }
+    }
+};
+
+pub const RestServer = struct {
+    pub const Options = struct {
+        address: std.net.Address = std.net.Address.initIp4(.{ 127, 0, 0, 1 }, 3270),
+        /// Reactor threads; null uses the CPU count
+        workers: ?usize = null,
+        /// How long `?since=` waits before answering 304; keep it below
+        /// `idle_timeout_ms`
+        long_poll_timeout_ms: u32 = 30000,
+        /// Keep-alive connections with no traffic are closed after this;
+        /// event streams get a comment line instead
+        idle_timeout_ms: u32 = 60000,
+        write_timeout_ms: u32 = 10000,
+        kernel_backlog: u31 = 512,
+    };
+
+    allocator: Allocator,
+    api: *rest_api.RestAPI,
+    options: Options,
+    cache: ScreenCache,
+    group: session_reactor.ReactorGroup,
+    listener: ?std.net.Server = null,
+    connections_mutex: std.Thread.Mutex = .{},
+    connections: std.DoublyLinkedList = .{},
+    connection_count: usize = 0,
+
+    pub fn init(allocator: Allocator, api: *rest_api.RestAPI, options: Options) !RestServer {
+        return .{
+            .allocator = allocator,
+            .api = api,
+            .options = options,
+            .cache = ScreenCache.init(allocator),
+            .group = try session_reactor.ReactorGroup.init(allocator, options.workers, .{
+                .read_timeout_ms = options.long_poll_timeout_ms,
+                .write_timeout_ms = options.write_timeout_ms,
+                .idle_timeout_ms = options.idle_timeout_ms,
+            }),
+        };
+    }
+
+    pub fn deinit(self: *RestServer) void {
+        self.shutdown();
+        self.group.deinit();
+        self.cache.deinit();
+    }
+
+    /// Bind, spawn the workers and start accepting; the server must not
+    /// move afterwards
+    pub fn start(self: *RestServer) !void {
+        if (self.listener != null) return error.AlreadyStarted;
+        var listener = try self.options.address.listen(.{
+            .kernel_backlog = self.options.kernel_backlog,
+            .reuse_address = true,
+            .force_nonblocking = true,
+        });
+        errdefer listener.deinit();
+
+        try self.group.start();
+        errdefer self.group.shutdown();
+        // The listener lives on the first reactor; accepted sockets are
+        // dealt round-robin across all of them
+        try self.group.reactors[0].submit(listener.stream.handle, .{
+            .context = self,
+            .on_readable = onAcceptable,
+        });
+        self.listener = listener;
+    }
+
+    /// Stop the workers and close every connection
+    pub fn shutdown(self: *RestServer) void {
+        self.group.shutdown();
+        if (self.listener) |*listener| {
+            listener.deinit();
+            self.listener = null;
+        }
+
+        self.connections_mutex.lock();
+        defer self.connections_mutex.unlock();
+        while (self.connections.popFirst()) |node| {
+            const conn: *Connection = @fieldParentPtr("node", node);
+            posix.close(conn.fd);
+            conn.deinit();
+        }
+        self.connection_count = 0;
+    }
+
+    /// Bound port (useful when listening on port 0)
+    pub fn port(self: *const RestServer) u16 {
+        const listener = self.listener orelse return self.options.address.getPort();
+        return listener.listen_address.getPort();
+    }
+
+    /// Refresh the cached screen for `session_id` and wake long-polls and
+    /// event streams if it changed. Call from the thread owning `scr`.
+    pub fn publishScreen(
+        self: *RestServer,
+        session_id: []const u8,
+        scr: *screen.Screen,
+        cursor_row: u32,
+        cursor_col: u32,
+    ) !bool {
+        return self.cache.publish(session_id, scr, cursor_row, cursor_col);
+    }
+
+    /// Close the session's screen stream; call when the session ends
+    pub fn removeScreen(self: *RestServer, session_id: []const u8) void {
+        self.cache.remove(session_id);
+    }
+
+    pub fn connectionCount(self: *RestServer) usize {
+        self.connections_mutex.lock();
+        defer self.connections_mutex.unlock();
+        return self.connection_count;
+    }
+
+    fn onAcceptable(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        const self: *RestServer = @ptrCast(@alignCast(context));
+        const listen_fd = reactor.fd_of(handle) orelse return;
+        while (true) {
+            const fd = posix.accept(listen_fd, null, null, posix.SOCK.NONBLOCK | posix.SOCK.CLOEXEC) catch |err| switch (err) {
+                error.WouldBlock => return,
+                error.ConnectionAborted => continue,
+                else => {
+                    std.log.warn("rest_server: accept failed: {s}", .{@errorName(err)});
+                    return;
+                },
+            };
+            self.openConnection(fd) catch |err| {
+                std.log.warn("rest_server: dropping connection: {s}", .{@errorName(err)});
+                posix.close(fd);
+            };
+        }
+    }
+
+    fn openConnection(self: *RestServer, fd: posix.socket_t) !void {
+        const conn = try self.allocator.create(Connection);
+        errdefer self.allocator.destroy(conn);
+        conn.* = .{ .server = self, .fd = fd };
+
+        {
+            self.connections_mutex.lock();
+            defer self.connections_mutex.unlock();
+            self.connections.append(&conn.node);
+            self.connection_count += 1;
+        }
+        errdefer self.releaseConnection(conn);
+        try self.group.submit(fd, conn.handler());
+    }
+
+    fn releaseConnection(self: *RestServer, conn: *Connection) void {
+        {
+            self.connections_mutex.lock();
+            defer self.connections_mutex.unlock();
+            self.connections.remove(&conn.node);
+            self.connection_count -= 1;
+        }
+        conn.deinit();
+    }
+};
+
+/// One client socket, owned by a single reactor thread
+const Connection = struct {
+    server: *RestServer,
+    fd: posix.socket_t,
+    reactor: *Reactor = undefined,
+    handle: SessionHandle = undefined,
+    node: std.DoublyLinkedList.Node = .{},
+
+    input: [max_request_bytes]u8 = undefined,
+    input_len: usize = 0,
+    output: std.ArrayList(u8) = .empty,
+    output_sent: usize = 0,
+    /// Response bodies are built here before the head is written
+    scratch: std.ArrayList(u8) = .empty,
+
+    mode: Mode = .requests,
+    /// Session and revision a parked request waits on
+    watch_session: std.ArrayList(u8) = .empty,
+    watch_revision: u64 = 0,
+    keep_alive: bool = true,
+    /// Close once the pending output is written
+    closing: bool = false,
+
+    const Mode = enum {
+        requests,
+        /// A `?since=` request is parked; later pipelined requests wait
+        long_poll,
+        /// Event stream; further input is ignored
+        events,
+    };
+
+    fn handler(self: *Connection) session_reactor.Handler {
+        return .{
+            .context = self,
+            .on_readable = onReadable,
+            .on_writable = onWritable,
+            .on_timeout = onTimeout,
+            .on_hangup = onHangup,
+            .on_open = onOpen,
+            .on_notify = onNotify,
+        };
+    }
+
+    fn deinit(self: *Connection) void {
+        const allocator = self.server.allocator;
+        self.output.deinit(allocator);
+        self.scratch.deinit(allocator);
+        self.watch_session.deinit(allocator);
+        allocator.destroy(self);
+    }
+
+    fn watcher(self: *Connection) ScreenCache.Watcher {
+        return .{ .reactor = self.reactor, .handle = self.handle };
+    }
+
+    /// Unregister and free; `self` is invalid afterwards
+    fn close(self: *Connection) void {
+        if (self.mode != .requests) self.server.cache.unwatch(self.watch_session.items, self.watcher());
+        self.reactor.remove(self.handle);
+        posix.close(self.fd);
+        self.server.releaseConnection(self);
+    }
+
+    fn onOpen(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        const self: *Connection = @ptrCast(@alignCast(context));
+        self.reactor = reactor;
+        self.handle = handle;
+    }
+
+    fn onReadable(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        const self: *Connection = @ptrCast(@alignCast(context));
+        const open = self.fill() catch return self.close();
+
+        switch (self.mode) {
+            .requests => self.processInput(),
+            // Pipelined requests queue up behind the parked one
+            .long_poll => {
+                if (self.input_len == self.input.len) return self.close();
+                reactor.expect_read(handle) catch {};
+            },
+            .events => self.input_len = 0,
+        }
+
+        if (!open) {
+            if (self.mode != .requests) return self.close();
+            self.closing = true;
+        }
+        self.flush();
+    }
+
+    fn onWritable(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        _ = reactor;
+        _ = handle;
+        const self: *Connection = @ptrCast(@alignCast(context));
+        self.flush();
+    }
+
+    fn onHangup(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        _ = reactor;
+        _ = handle;
+        const self: *Connection = @ptrCast(@alignCast(context));
+        self.close();
+    }
+
+    fn onTimeout(context: *anyopaque, reactor: *Reactor, handle: SessionHandle, kind: session_reactor.TimeoutKind) void {
+        const self: *Connection = @ptrCast(@alignCast(context));
+        switch (kind) {
+            .read => {
+                if (self.mode != .long_poll) return;
+                self.server.cache.unwatch(self.watch_session.items, self.watcher());
+                self.mode = .requests;
+                self.respond(.not_modified, "application/json", self.watch_revision, "") catch {
+                    self.closing = true;
+                };
+                self.processInput();
+                self.flush();
+            },
+            .write => self.close(),
+            .idle => {
+                if (self.mode != .events) return self.close();
+                // The writable event that follows re-arms the idle timer
+                self.output.appendSlice(self.server.allocator, ": keepalive\n\n") catch return self.close();
+                reactor.want_write(handle, true) catch self.close();
+            },
+        }
+    }
+
+    fn onNotify(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        _ = reactor;
+        _ = handle;
+        const self: *Connection = @ptrCast(@alignCast(context));
+        switch (self.mode) {
+            .requests => return,
+            .long_poll => self.resumeLongPoll() catch {
+                self.closing = true;
+            },
+            .events => self.pushEvents() catch {
+                self.closing = true;
+            },
+        }
+        self.flush();
+    }
+
+    /// Read until the socket would block; false once the peer closed
+    fn fill(self: *Connection) !bool {
+        while (self.input_len < self.input.len) {
+            const n = posix.read(self.fd, self.input[self.input_len..]) catch |err| switch (err) {
+                error.WouldBlock => return true,
+                else => return err,
+            };
+            if (n == 0) return false;
+            self.input_len += n;
+        }
+        return true;
+    }
+
+    /// Answer every complete request in the input buffer, in order
+    fn processInput(self: *Connection) void {
+        var consumed: usize = 0;
+        defer {
+            std.mem.copyForwards(u8, self.input[0..], self.input[consumed..self.input_len]);
+            self.input_len -= consumed;
+        }
+
+        while (self.mode == .requests and !self.closing) {
+            const pending = self.input[consumed..self.input_len];
+            const request = http.parseRequest(pending, self.input.len) catch |err| {
+                self.keep_alive = false;
+                const status: HttpStatus = if (err == error.RequestTooLarge)
+                    .request_header_fields_too_large
+                else
+                    .bad_request;
+                self.respondError(status, @errorName(err)) catch {};
+                self.closing = true;
+                consumed = self.input_len;
+                return;
+            } orelse return;
+
+            self.handleRequest(request) catch {
+                self.closing = true;
+            };
+            consumed += request.length;
+        }
+    }
+
+    fn handleRequest(self: *Connection, request: http.Request) !void {
+        const api = self.server.api;
+        self.keep_alive = request.keep_alive;
+
+        if (!api.checkAuth(request.authorization)) {
+            return self.respondError(.unauthorized, "missing or invalid credentials");
+        }
+        if (api.config.rate_limit.enabled) {
+            api.incrementRequestCount();
+            if (!api.checkRateLimit()) return self.respondError(.too_many_requests, "request limit exceeded");
+        }
+        const method = request.method orelse return self.respondError(.method_not_allowed, "unsupported method");
+
+        const prefix = "/sessions";
+        if (!std.mem.startsWith(u8, request.path, prefix)) return self.respondError(.not_found, "no such route");
+        const tail = std.mem.trimEnd(u8, request.path[prefix.len..], "/");
+        if (tail.len == 0) {
+            if (method != .get) return self.respondError(.method_not_allowed, "use GET");
+            return self.listSessions();
+        }
+        if (tail[0] != '/') return self.respondError(.not_found, "no such route");
+
+        const rest = tail[1..];
+        const slash = std.mem.indexOfScalar(u8, rest, '/');
+        const session_id = rest[0 .. slash orelse rest.len];
+        const resource = if (slash) |at| rest[at..] else "";
+
+        if (resource.len == 0) {
+            return switch (method) {
+                .get => if (api.getSession(session_id)) |session|
+                    self.respondJson(.ok, session, null)
+                else
+                    self.respondError(.not_found, "session not found"),
+                .delete => if (api.deleteSession(session_id)) blk: {
+                    self.server.cache.remove(session_id);
+                    break :blk self.respond(.no_content, "application/json", null, "");
+                } else self.respondError(.not_found, "session not found"),
+                else => self.respondError(.method_not_allowed, "use GET or DELETE"),
+            };
+        }
+        if (method != .get) return self.respondError(.method_not_allowed, "use GET");
+
+        if (std.mem.eql(u8, resource, "/screen")) {
+            if (http.queryParam(request.query, "since")) |since_text| {
+                const since = http.parseEtag(since_text) orelse return self.respondError(.bad_request, "invalid since");
+                return self.startLongPoll(session_id, since);
+            }
+            return self.sendScreen(session_id, request.if_none_match);
+        }
+        if (std.mem.eql(u8, resource, "/screen/events")) {
+            const last_seen = if (request.last_event_id) |id| http.parseEtag(id) orelse 0 else 0;
+            return self.startEvents(session_id, last_seen);
+        }
+        return self.respondError(.not_found, "no such route");
+    }
+
+    fn listSessions(self: *Connection) !void {
+        const api = self.server.api;
+        self.scratch.clearRetainingCapacity();
+        var out: std.Io.Writer.Allocating = .fromArrayList(self.server.allocator, &self.scratch);
+        defer self.scratch = out.toArrayList();
+
+        var json: std.json.Stringify = .{ .writer = &out.writer };
+        {
+            api.mutex.lock();
+            defer api.mutex.unlock();
+            json.beginArray() catch return error.OutOfMemory;
+            var it = api.sessions.valueIterator();
+            while (it.next()) |session| json.write(session.*) catch return error.OutOfMemory;
+            json.endArray() catch return error.OutOfMemory;
+        }
+        try self.respond(.ok, "application/json", null, out.written());
+    }
+
+    fn sendScreen(self: *Connection, session_id: []const u8, if_none_match: ?[]const u8) !void {
+        self.scratch.clearRetainingCapacity();
+        const revision = try self.server.cache.copyBody(session_id, self.server.allocator, &self.scratch) orelse
+            return self.respondError(.not_found, "no screen for session");
+
+        if (if_none_match) |tag| {
+            if (http.parseEtag(tag) == revision) return self.respond(.not_modified, "application/json", revision, "");
+        }
+        try self.respond(.ok, "application/json", revision, self.scratch.items);
+    }
+
+    /// Make sure a known session has a cache entry to wait on
+    fn watchSession(self: *Connection, session_id: []const u8, since: u64) !ScreenCache.WatchResult {
+        const result = try self.server.cache.watch(session_id, since, self.watcher());
+        if (result != .missing or self.server.api.getSession(session_id) == null) return result;
+        try self.server.cache.add(session_id);
+        return self.server.cache.watch(session_id, since, self.watcher());
+    }
+
+    fn startLongPoll(self: *Connection, session_id: []const u8, since: u64) !void {
+        switch (try self.watchSession(session_id, since)) {
+            .missing => return self.respondError(.not_found, "session not found"),
+            .changed => return self.sendScreen(session_id, null),
+            .registered => {},
+        }
+        self.watch_session.clearRetainingCapacity();
+        try self.watch_session.appendSlice(self.server.allocator, session_id);
+        self.watch_revision = since;
+        self.mode = .long_poll;
+        try self.reactor.expect_read(self.handle);
+    }
+
+    fn resumeLongPoll(self: *Connection) !void {
+        const session_id = self.watch_session.items;
+        switch (try self.server.cache.watch(session_id, self.watch_revision, self.watcher())) {
+            // Woken without a new revision; stay parked
+            .registered => return,
+            .missing => {
+                self.mode = .requests;
+                try self.respondError(.not_found, "session closed");
+            },
+            .changed => {
+                self.mode = .requests;
+                try self.sendScreen(session_id, null);
+            },
+        }
+        self.processInput();
+    }
+
+    fn startEvents(self: *Connection, session_id: []const u8, last_seen: u64) !void {
+        if (self.server.api.getSession(session_id) == null) return self.respondError(.not_found, "session not found");
+
+        self.watch_session.clearRetainingCapacity();
+        try self.watch_session.appendSlice(self.server.allocator, session_id);
+        self.watch_revision = last_seen;
+        self.mode = .events;
+        try self.output.appendSlice(
+            self.server.allocator,
+            "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n\r\n",
+        );
+        try self.server.cache.add(session_id);
+        try self.pushEvents();
+    }
+
+    /// Send one event per revision since the last one sent, then re-park
+    fn pushEvents(self: *Connection) !void {
+        const allocator = self.server.allocator;
+        const session_id = self.watch_session.items;
+        while (true) {
+            switch (try self.server.cache.watch(session_id, self.watch_revision, self.watcher())) {
+                .registered => return,
+                .missing => {
+                    self.closing = true;
+                    return;
+                },
+                .changed => {},
+            }
+            self.scratch.clearRetainingCapacity();
+            const revision = try self.server.cache.copyBody(session_id, allocator, &self.scratch) orelse {
+                self.closing = true;
+                return;
+            };
+            // Stringified JSON has no raw newlines, so one data line suffices
+            try self.output.print(allocator, "id: {d}\nevent: screen\ndata: ", .{revision});
+            try self.output.appendSlice(allocator, self.scratch.items);
+            try self.output.appendSlice(allocator, "\n\n");
+            self.watch_revision = revision;
+        }
+    }
+
+    fn respond(
+        self: *Connection,
+        status: HttpStatus,
+        content_type: []const u8,
+        revision: ?u64,
+        body: []const u8,
+    ) !void {
+        const allocator = self.server.allocator;
+        const out = &self.output;
+        try out.print(allocator, "HTTP/1.1 {d} {s}\r\nContent-Type: {s}\r\n", .{
+            @intFromEnum(status),
+            status.phrase(),
+            content_type,
+        });
+        if (status != .no_content) try out.print(allocator, "Content-Length: {d}\r\n", .{body.len});
+        if (revision) |value| try out.print(allocator, "ETag: \"{d}\"\r\n", .{value});
+        if (!self.keep_alive) try out.appendSlice(allocator, "Connection: close\r\n");
+        try out.appendSlice(allocator, "\r\n");
+        try out.appendSlice(allocator, body);
+        if (!self.keep_alive) self.closing = true;
+    }
+
+    fn respondJson(self: *Connection, status: HttpStatus, value: anytype, revision: ?u64) !void {
+        self.scratch.clearRetainingCapacity();
+        var out: std.Io.Writer.Allocating = .fromArrayList(self.server.allocator, &self.scratch);
+        defer self.scratch = out.toArrayList();
+        std.json.Stringify.value(value, .{}, &out.writer) catch return error.OutOfMemory;
+        try self.respond(status, "application/json", revision, out.written());
+    }
+
+    fn respondError(self: *Connection, status: HttpStatus, message: []const u8) !void {
+        try self.respondJson(status, rest_api.ErrorResponse{
+            .err = @tagName(status),
+            .message = message,
+            .status = @intFromEnum(status),
+        }, null);
+    }
+
+    /// Write pending output; the rest goes out on the next writable event.
+    /// May close (and free) the connection, so call it last.
+    fn flush(self: *Connection) void {
+        while (self.output_sent < self.output.items.len) {
+            const n = posix.write(self.fd, self.output.items[self.output_sent..]) catch |err| switch (err) {
+                error.WouldBlock => {
+                    self.reactor.want_write(self.handle, true) catch return self.close();
+                    return;
+                },
+                else => return self.close(),
+            };
+            self.output_sent += n;
+        }
+        self.output.clearRetainingCapacity();
+        self.output_sent = 0;
+        self.reactor.want_write(self.handle, false) catch {};
+        if (self.closing) self.close();
+    }
+};
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+const testing = std.testing;
+
+const TestClient = struct {
+    stream: std.net.Stream,
+    buffer: [32 * 1024]u8 = undefined,
+    len: usize = 0,
+    consumed: usize = 0,
+
+    const Response = struct {
+        status: u16,
+        head: []const u8,
+        body: []const u8,
+    };
+
+    fn connect(port: u16) !TestClient {
+        const stream = try std.net.tcpConnectToAddress(std.net.Address.initIp4(.{ 127, 0, 0, 1 }, port));
+        // Fail the test rather than hang if a response never comes
+        const timeout = posix.timeval{ .sec = 5, .usec = 0 };
+        try posix.setsockopt(stream.handle, posix.SOL.SOCKET, posix.SO.RCVTIMEO, std.mem.asBytes(&timeout));
+        return .{ .stream = stream };
+    }
+
+    fn close(self: *TestClient) void {
+        self.stream.close();
+    }
+
+    fn send(self: *TestClient, bytes: []const u8) !void {
+        try self.stream.writeAll(bytes);
+    }
+
+    fn pending(self: *TestClient) []const u8 {
+        return self.buffer[self.consumed..self.len];
+    }
+
+    fn readMore(self: *TestClient) !void {
+        if (self.consumed > 0) {
+            std.mem.copyForwards(u8, self.buffer[0..], self.pending());
+            self.len -= self.consumed;
+            self.consumed = 0;
+        }
+        const n = try self.stream.read(self.buffer[self.len..]);
+        if (n == 0) return error.EndOfStream;
+        self.len += n;
+    }
+
+    /// Next response; slices stay valid until the next call
+    fn receive(self: *TestClient) !Response {
+        while (true) {
+            const bytes = self.pending();
+            if (std.mem.indexOf(u8, bytes, "\r\n\r\n")) |head_end| {
+                const head = bytes[0..head_end];
+                var body_len: usize = 0;
+                if (std.ascii.indexOfIgnoreCase(head, "content-length: ")) |at| {
+                    const digits = head[at + "content-length: ".len ..];
+                    const end = std.mem.indexOfScalar(u8, digits, '\r') orelse digits.len;
+                    body_len = try std.fmt.parseInt(usize, digits[0..end], 10);
+                }
+                if (bytes.len >= head_end + 4 + body_len) {
+                    self.consumed += head_end + 4 + body_len;
+                    return .{
+                        .status = try std.fmt.parseInt(u16, head[9..12], 10),
+                        .head = head,
+                        .body = bytes[head_end + 4 ..][0..body_len],
+                    };
+                }
+            }
+            try self.readMore();
+        }
+    }
+
+    /// Next server-sent event block
+    fn receiveEvent(self: *TestClient) ![]const u8 {
+        while (true) {
+            const bytes = self.pending();
+            if (std.mem.indexOf(u8, bytes, "\n\n")) |end| {
+                self.consumed += end + 2;
+                return bytes[0..end];
+            }
+            try self.readMore();
+        }
+    }
+};
+
+test "rest_server: parse pipelined requests" {
+    const input = "GET /sessions/a/screen HTTP/1.1\r\nHost: x\r\nIf-None-Match: \"3\"\r\n\r\n" ++
+        "POST /sessions HTTP/1.1\r\nContent-Length: 2\r\n\r\n{}" ++
+        "GET /sessions HTTP/1.0\r\n";
+
+    const first = (try http.parseRequest(input, max_request_bytes)).?;
+    try testing.expectEqual(rest_api.HttpMethod.get, first.method.?);
+    try testing.expectEqualStrings("/sessions/a/screen", first.path);
+    try testing.expect(first.keep_alive);
+    try testing.expectEqual(@as(?u64, 3), http.parseEtag(first.if_none_match.?));
+
+    const second = (try http.parseRequest(input[first.length..], max_request_bytes)).?;
+    try testing.expectEqual(rest_api.HttpMethod.post, second.method.?);
+    try testing.expectEqualStrings("{}", second.body);
+
+    // Third request is still incomplete
+    const rest = input[first.length + second.length ..];
+    try testing.expectEqual(@as(?http.Request, null), try http.parseRequest(rest, max_request_bytes));
+
+    const closing = (try http.parseRequest("GET /s?since=7&x=1 HTTP/1.0\r\n\r\n", max_request_bytes)).?;
+    try testing.expect(!closing.keep_alive);
+    try testing.expectEqualStrings("7", http.queryParam(closing.query, "since").?);
+
+    try testing.expectError(error.RequestTooLarge, http.parseRequest("GET / HTTP/1.1\r\nX: y", 16));
+    try testing.expectError(error.MalformedRequest, http.parseRequest("GET\r\n\r\n", max_request_bytes));
+}
+
+test "rest_server: screen cache rebuilds only on change" {
+    const allocator = testing.allocator;
+    var cache = ScreenCache.init(allocator);
+    defer cache.deinit();
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+    try scr.write_char(0, 0, 'A');
+
+    try testing.expect(try cache.publish("s1", &scr, 0, 0));
+    try testing.expect(!try cache.publish("s1", &scr, 0, 0));
+
+    var body: std.ArrayList(u8) = .empty;
+    defer body.deinit(allocator);
+    try testing.expectEqual(@as(?u64, 1), try cache.copyBody("s1", allocator, &body));
+    try testing.expect(std.mem.indexOf(u8, body.items, "\"session_id\":\"s1\"") != null);
+
+    // Cursor moves count as changes too
+    try testing.expect(try cache.publish("s1", &scr, 1, 2));
+    try scr.write_char(1, 0, 'B');
+    try testing.expect(try cache.publish("s1", &scr, 1, 2));
+
+    body.clearRetainingCapacity();
+    try testing.expectEqual(@as(?u64, 3), try cache.copyBody("s1", allocator, &body));
+    try testing.expectEqual(@as(?u64, null), try cache.copyBody("missing", allocator, &body));
+}
+
+test "rest_server: keep-alive pipelining and long-poll" {
+    const allocator = testing.allocator;
+    var api = rest_api.RestAPI.init(allocator, .{});
+    defer api.deinit();
+    _ = try api.createSession(.{ .host = "mainframe", .port = 3270 }, "s1");
+
+    var server = try RestServer.init(allocator, &api, .{
+        .address = std.net.Address.initIp4(.{ 127, 0, 0, 1 }, 0),
+        .workers = 2,
+        .long_poll_timeout_ms = 200,
+    });
+    defer server.deinit();
+    try server.start();
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+    _ = scr.write_run(0, "READY");
+    _ = try server.publishScreen("s1", &scr, 0, 0);
+
+    var client = try TestClient.connect(server.port());
+    defer client.close();
+
+    // Two requests in one write come back in order on the same socket
+    try client.send("GET /sessions/s1/screen HTTP/1.1\r\n\r\nGET /sessions/s1 HTTP/1.1\r\n\r\n");
+    const screen_response = try client.receive();
+    try testing.expectEqual(@as(u16, 200), screen_response.status);
+    try testing.expect(std.mem.indexOf(u8, screen_response.head, "ETag: \"1\"") != null);
+    try testing.expect(std.mem.indexOf(u8, screen_response.body, "READY") != null);
+    const session_response = try client.receive();
+    try testing.expectEqual(@as(u16, 200), session_response.status);
+    try testing.expect(std.mem.indexOf(u8, session_response.body, "mainframe") != null);
+
+    try client.send("GET /sessions/s1/screen HTTP/1.1\r\nIf-None-Match: \"1\"\r\n\r\n");
+    try testing.expectEqual(@as(u16, 304), (try client.receive()).status);
+
+    // Nothing changes: the long-poll times out with 304
+    try client.send("GET /sessions/s1/screen?since=1 HTTP/1.1\r\n\r\n");
+    try testing.expectEqual(@as(u16, 304), (try client.receive()).status);
+
+    // A change wakes the parked request
+    try client.send("GET /sessions/s1/screen?since=1 HTTP/1.1\r\n\r\n");
+    std.Thread.sleep(20 * std.time.ns_per_ms);
+    _ = scr.write_run(80, "CHANGED");
+    _ = try server.publishScreen("s1", &scr, 1, 0);
+    const changed = try client.receive();
+    try testing.expectEqual(@as(u16, 200), changed.status);
+    try testing.expect(std.mem.indexOf(u8, changed.head, "ETag: \"2\"") != null);
+    try testing.expect(std.mem.indexOf(u8, changed.body, "CHANGED") != null);
+
+    try client.send("GET /nope HTTP/1.1\r\n\r\n");
+    try testing.expectEqual(@as(u16, 404), (try client.receive()).status);
+}
+
+test "rest_server: event stream pushes on change" {
+    const allocator = testing.allocator;
+    var api = rest_api.RestAPI.init(allocator, .{});
+    defer api.deinit();
+    _ = try api.createSession(.{ .host = "mainframe", .port = 3270 }, "s1");
+
+    var server = try RestServer.init(allocator, &api, .{
+        .address = std.net.Address.initIp4(.{ 127, 0, 0, 1 }, 0),
+        .workers = 1,
+    });
+    defer server.deinit();
+    try server.start();
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+    _ = scr.write_run(0, "FIRST");
+    _ = try server.publishScreen("s1", &scr, 0, 0);
+
+    var client = try TestClient.connect(server.port());
+    defer client.close();
+    try client.send("GET /sessions/s1/screen/events HTTP/1.1\r\n\r\n");
+
+    const head = try client.receive();
+    try testing.expectEqual(@as(u16, 200), head.status);
+    try testing.expect(std.mem.indexOf(u8, head.head, "text/event-stream") != null);
+
+    const first = try client.receiveEvent();
+    try testing.expect(std.mem.startsWith(u8, first, "id: 1\n"));
+    try testing.expect(std.mem.indexOf(u8, first, "FIRST") != null);
+
+    // Republishing an unchanged screen sends nothing; a change does
+    _ = try server.publishScreen("s1", &scr, 0, 0);
+    _ = scr.write_run(0, "SECOND");
+    _ = try server.publishScreen("s1", &scr, 0, 0);
+    const second = try client.receiveEvent();
+    try testing.expect(std.mem.startsWith(u8, second, "id: 2\n"));
+    try testing.expect(std.mem.indexOf(u8, second, "SECOND") != null);
+
+    // Ending the session closes the stream
+    server.removeScreen("s1");
+    try testing.expectError(error.EndOfStream, client.receiveEvent());
+}
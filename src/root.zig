@@ -5,6 +5,7 @@ pub const ebcdic = @import("ebcdic.zig");
 pub const protocol_snooper = @import("protocol_snooper.zig");
 pub const state_inspector = @import("state_inspector.zig");
 pub const cli_profiler = @import("cli_profiler.zig");
+pub const zone_trace = @import("zone_trace.zig");
 pub const structured_fields = @import("structured_fields.zig");
 pub const lu3_printer = @import("lu3_printer.zig");
 pub const graphics_support = @import("graphics_support.zig");
@@ -16,21 +17,31 @@ pub const performance_regression = @import("performance_regression.zig");
 pub const session_pool = @import("session_pool.zig");
 pub const session_lifecycle = @import("session_lifecycle.zig");
 pub const session_migration = @import("session_migration.zig");
+pub const session_snapshot = @import("session_snapshot.zig");
+pub const session_memory = @import("session_memory.zig");
 pub const load_balancer = @import("load_balancer.zig");
 pub const failover = @import("failover.zig");
 pub const health_checker = @import("health_checker.zig");
+pub const health_probe = @import("health_probe.zig");
 pub const audit_log = @import("audit_log.zig");
 pub const compliance = @import("compliance.zig");
 pub const rest_api = @import("rest_api.zig");
+pub const rest_server = @import("rest_server.zig");
 pub const event_webhooks = @import("event_webhooks.zig");
 pub const error_context = @import("error_context.zig");
 pub const debug_log = @import("debug_log.zig");
 pub const config_validator = @import("config_validator.zig");
 pub const advanced_allocators = @import("advanced_allocators.zig");
 pub const zero_copy_parser = @import("zero_copy_parser.zig");
+pub const stream_decoder = @import("stream_decoder.zig");
+pub const screen_waiter = @import("screen_waiter.zig");
+pub const screen_fingerprint = @import("screen_fingerprint.zig");
+pub const read_modified = @import("read_modified.zig");
+pub const session_reactor = @import("session_reactor.zig");
 pub const chaos_testing = @import("chaos_testing.zig");
 pub const c_bindings = @import("c_bindings.zig");
 pub const opentelemetry = @import("opentelemetry.zig");
+pub const span_processor = @import("span_processor.zig");
 pub const windows_console = @import("windows_console.zig");
 
 pub fn bufferedPrint() !void {
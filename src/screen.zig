@@ -1,41 +1,148 @@
 const std = @import("std");
 
-/// 3270 screen buffer management
+/// Alignment of the cell planes (one cache line)
+pub const cell_alignment = std.atomic.cache_line;
+
+/// 3270 screen buffer management.
+///
+/// Cells live in one allocation as separate planes (struct-of-arrays), each
+/// indexed by the linear buffer address `row * cols + col`:
+/// - `buffer`: character plane
+/// - `attributes`: raw field attribute byte for start-field cells (0 = none)
+/// - `colors`: extended color per cell (0 = default)
+///
+/// `modified` is the modified data tag (MDT) per cell: set by operator
+/// input, read by `read_modified.encode` and cleared with the screen.
+/// `field_starts` marks the start-field cells, so a field with attribute
+/// byte 0 still counts; a field runs from its start-field cell to the
+/// next one, wrapping at the end of the buffer.
+///
+/// Every mutation through these methods stamps the touched cells with the
+/// current generation, so consumers can ask for `changes_since` the
+/// generation they last saw. Code writing the planes directly must call
+/// `mark_dirty`.
 pub const Screen = struct {
     allocator: std.mem.Allocator,
     rows: u16,
     cols: u16,
-    buffer: [][]u8,
+    buffer: []u8,
+    attributes: []u8,
+    colors: []u8,
+    storage: []align(cell_alignment) u8,
+    /// Generation of the last change to each cell, then to each row
+    cell_generation: []u32,
+    row_generation: []u32,
+    modified: std.DynamicBitSetUnmanaged,
+    field_starts: std.DynamicBitSetUnmanaged,
+    generation: u32 = 0,
+    /// Set once the current generation has been handed out; the next
+    /// change then starts a new one
+    generation_observed: bool = false,
 
     /// Initialize a screen buffer with the given dimensions
     pub fn init(allocator: std.mem.Allocator, rows: u16, cols: u16) !Screen {
-        var buffer = try allocator.alloc([]u8, rows);
-        for (0..rows) |i| {
-            buffer[i] = try allocator.alloc(u8, cols);
-            @memset(buffer[i], ' ');
-        }
+        const cells = @as(usize, rows) * cols;
+        const stride = std.mem.alignForward(usize, cells, cell_alignment);
+        const storage = try allocator.alignedAlloc(u8, std.mem.Alignment.fromByteUnits(cell_alignment), stride * 3);
+        errdefer allocator.free(storage);
+        const stamps = try allocator.alloc(u32, cells + rows);
+        errdefer allocator.free(stamps);
+        @memset(stamps, 0);
+        var modified = try std.DynamicBitSetUnmanaged.initEmpty(allocator, cells);
+        errdefer modified.deinit(allocator);
+        const field_starts = try std.DynamicBitSetUnmanaged.initEmpty(allocator, cells);
 
-        return Screen{
+        var scr = Screen{
             .allocator = allocator,
             .rows = rows,
             .cols = cols,
-            .buffer = buffer,
+            .buffer = storage[0..cells],
+            .attributes = storage[stride..][0..cells],
+            .colors = storage[stride * 2 ..][0..cells],
+            .storage = storage,
+            .cell_generation = stamps[0..cells],
+            .row_generation = stamps[cells..],
+            .modified = modified,
+            .field_starts = field_starts,
         };
+        scr.clear();
+        return scr;
     }
 
     /// Deallocate screen buffer
     pub fn deinit(self: *Screen) void {
-        for (0..self.rows) |i| {
-            self.allocator.free(self.buffer[i]);
+        self.allocator.free(self.storage);
+        self.allocator.free(self.cell_generation.ptr[0 .. self.cell_generation.len + self.row_generation.len]);
+        self.modified.deinit(self.allocator);
+        self.field_starts.deinit(self.allocator);
+    }
+
+    /// Hand out the current generation; later changes compare newer
+    pub fn current_generation(self: *Screen) u32 {
+        self.generation_observed = true;
+        return self.generation;
+    }
+
+    /// Stamp `len` cells starting at `address` as changed
+    pub fn mark_dirty(self: *Screen, address: usize, len: usize) void {
+        if (address >= self.buffer.len or len == 0) return;
+        const count = @min(len, self.buffer.len - address);
+
+        if (self.generation_observed) {
+            self.generation +%= 1;
+            self.generation_observed = false;
         }
-        self.allocator.free(self.buffer);
+        const gen = self.generation;
+
+        @memset(self.cell_generation[address..][0..count], gen);
+        const first_row = address / self.cols;
+        const last_row = (address + count - 1) / self.cols;
+        @memset(self.row_generation[first_row .. last_row + 1], gen);
     }
 
-    /// Clear entire screen (fill with spaces)
-    pub fn clear(self: *Screen) void {
-        for (0..self.rows) |i| {
-            @memset(self.buffer[i], ' ');
+    /// True when any cell changed after `since`
+    pub fn has_changes_since(self: *const Screen, since: u32) bool {
+        for (self.row_generation) |gen| {
+            if (gen > since) return true;
         }
+        return false;
+    }
+
+    /// Iterate runs of cells changed after generation `since`
+    pub fn changes_since(self: *const Screen, since: u32) ChangeIterator {
+        return .{ .screen = self, .since = since };
+    }
+
+    /// Number of cells (rows * cols)
+    pub fn size(self: *const Screen) usize {
+        return self.buffer.len;
+    }
+
+    /// Clear entire screen (fill with spaces, drop attributes, colors and
+    /// modified data tags)
+    pub fn clear(self: *Screen) void {
+        @memset(self.buffer, ' ');
+        @memset(self.attributes, 0);
+        @memset(self.colors, 0);
+        self.modified.unsetAll();
+        self.field_starts.unsetAll();
+        self.mark_dirty(0, self.buffer.len);
+    }
+
+    /// Set the modified data tag on `len` cells from `address`
+    pub fn mark_modified(self: *Screen, address: usize, len: usize) void {
+        if (address >= self.buffer.len or len == 0) return;
+        const end = address + @min(len, self.buffer.len - address);
+        self.modified.setRangeValue(.{ .start = address, .end = end }, true);
+    }
+
+    /// Clear every modified data tag (WCC reset MDT, or after a send)
+    pub fn reset_modified(self: *Screen) void {
+        self.modified.unsetAll();
+    }
+
+    pub fn is_modified(self: *const Screen, address: usize) bool {
+        return address < self.buffer.len and self.modified.isSet(address);
     }
 
     /// Write a character at position (row, col)
@@ -43,7 +150,9 @@ pub const Screen = struct {
         if (row >= self.rows or col >= self.cols) {
             return error.OutOfBounds;
         }
-        self.buffer[row][col] = char;
+        const address = @as(usize, row) * self.cols + col;
+        self.buffer[address] = char;
+        self.mark_dirty(address, 1);
     }
 
     /// Read a character at position (row, col)
@@ -51,10 +160,193 @@ pub const Screen = struct {
         if (row >= self.rows or col >= self.cols) {
             return error.OutOfBounds;
         }
-        return self.buffer[row][col];
+        return self.buffer[@as(usize, row) * self.cols + col];
+    }
+
+    /// Write a character at a linear buffer address
+    pub fn write_at(self: *Screen, address: u16, char: u8) !void {
+        if (address >= self.buffer.len) {
+            return error.OutOfBounds;
+        }
+        self.buffer[address] = char;
+        self.mark_dirty(address, 1);
+    }
+
+    /// Read a character at a linear buffer address
+    pub fn read_at(self: *Screen, address: u16) !u8 {
+        if (address >= self.buffer.len) {
+            return error.OutOfBounds;
+        }
+        return self.buffer[address];
+    }
+
+    /// Copy a run of characters starting at a linear address.
+    /// The run is clipped at the end of the screen; returns bytes written.
+    pub fn write_run(self: *Screen, address: u16, chars: []const u8) usize {
+        if (address >= self.buffer.len) return 0;
+        const count = @min(chars.len, self.buffer.len - address);
+        @memcpy(self.buffer[address..][0..count], chars[0..count]);
+        self.mark_dirty(address, count);
+        return count;
+    }
+
+    /// Characters of one row (borrowed, valid until deinit)
+    pub fn row_slice(self: *const Screen, row: u16) []const u8 {
+        const start = @as(usize, row) * self.cols;
+        return self.buffer[start..][0..self.cols];
+    }
+
+    /// Record the raw field attribute byte at a start-field address
+    pub fn set_attribute(self: *Screen, address: u16, attr: u8) !void {
+        if (address >= self.attributes.len) {
+            return error.OutOfBounds;
+        }
+        self.attributes[address] = attr;
+        self.field_starts.set(address);
+        self.mark_dirty(address, 1);
+    }
+
+    /// Whether a field starts at `address`
+    pub fn is_field_start(self: *const Screen, address: usize) bool {
+        return address < self.buffer.len and self.field_starts.isSet(address);
+    }
+
+    /// Start-field cell of the field holding `address`: the nearest one at
+    /// or before it, wrapping at the end of the buffer. Null when the
+    /// screen is unformatted. Scans a word of cells per step.
+    pub fn field_start_at(self: *const Screen, address: usize) ?usize {
+        if (address >= self.buffer.len) return null;
+        const masks = self.field_start_masks();
+        var word = address / mask_bits;
+        const above: std.math.Log2Int(MaskInt) = @intCast(mask_bits - 1 - address % mask_bits);
+        var bits = masks[word] & (~@as(MaskInt, 0) >> above);
+        for (0..masks.len + 1) |_| {
+            if (bits != 0) return word * mask_bits + (mask_bits - 1 - @clz(bits));
+            word = if (word == 0) masks.len - 1 else word - 1;
+            bits = masks[word];
+        }
+        return null;
+    }
+
+    /// First start-field cell after `address`, wrapping; `address` itself
+    /// when it holds the only field. Null when the screen is unformatted.
+    pub fn next_field_start(self: *const Screen, address: usize) ?usize {
+        if (address >= self.buffer.len) return null;
+        const masks = self.field_start_masks();
+        const from = address + 1;
+        var word = from / mask_bits;
+        var bits: MaskInt = 0;
+        if (word < masks.len) {
+            const below: std.math.Log2Int(MaskInt) = @intCast(from % mask_bits);
+            bits = masks[word] & (~@as(MaskInt, 0) << below);
+        } else {
+            word = masks.len - 1;
+        }
+        for (0..masks.len + 1) |_| {
+            if (bits != 0) return word * mask_bits + @ctz(bits);
+            word = if (word + 1 == masks.len) 0 else word + 1;
+            bits = masks[word];
+        }
+        return null;
+    }
+
+    const MaskInt = std.DynamicBitSetUnmanaged.MaskInt;
+    const mask_bits = @bitSizeOf(MaskInt);
+
+    fn field_start_masks(self: *const Screen) []const MaskInt {
+        return self.field_starts.masks[0 .. (self.field_starts.bit_length + mask_bits - 1) / mask_bits];
+    }
+
+    /// Raw field attribute byte at address (0 when not a start-field cell)
+    pub fn get_attribute(self: *const Screen, address: u16) !u8 {
+        if (address >= self.attributes.len) {
+            return error.OutOfBounds;
+        }
+        return self.attributes[address];
+    }
+
+    /// Set the extended color of a cell
+    pub fn set_color(self: *Screen, address: u16, color: u8) !void {
+        if (address >= self.colors.len) {
+            return error.OutOfBounds;
+        }
+        self.colors[address] = color;
+        self.mark_dirty(address, 1);
+    }
+
+    /// Extended color of a cell (0 = default)
+    pub fn get_color(self: *const Screen, address: u16) !u8 {
+        if (address >= self.colors.len) {
+            return error.OutOfBounds;
+        }
+        return self.colors[address];
+    }
+
+    /// Copy every plane from a screen of the same dimensions (single memcpy)
+    pub fn copy_from(self: *Screen, other: *const Screen) !void {
+        if (self.rows != other.rows or self.cols != other.cols) {
+            return error.DimensionMismatch;
+        }
+        @memcpy(self.storage, other.storage);
+        self.modified.unsetAll();
+        var tagged = other.modified.iterator(.{});
+        while (tagged.next()) |address| self.modified.set(address);
+        self.field_starts.unsetAll();
+        var starts = other.field_starts.iterator(.{});
+        while (starts.next()) |address| self.field_starts.set(address);
+        self.mark_dirty(0, self.buffer.len);
     }
 };
 
+/// Run of changed cells; never crosses a row boundary
+pub const ChangeSpan = struct {
+    address: u16,
+    row: u16,
+    col: u16,
+    len: u16,
+};
+
+/// Walks dirty rows, skipping rows whose stamp is not newer than `since`
+pub const ChangeIterator = struct {
+    screen: *const Screen,
+    since: u32,
+    address: usize = 0,
+
+    pub fn next(self: *ChangeIterator) ?ChangeSpan {
+        const scr = self.screen;
+        const cols: usize = scr.cols;
+
+        while (self.address < scr.buffer.len) {
+            const row = self.address / cols;
+            const row_end = (row + 1) * cols;
+            if (scr.row_generation[row] <= self.since) {
+                self.address = row_end;
+                continue;
+            }
+
+            while (self.address < row_end and scr.cell_generation[self.address] <= self.since) {
+                self.address += 1;
+            }
+            if (self.address == row_end) continue;
+
+            const start = self.address;
+            while (self.address < row_end and scr.cell_generation[self.address] > self.since) {
+                self.address += 1;
+            }
+            return .{
+                .address = @intCast(start),
+                .row = @intCast(row),
+                .col = @intCast(start - row * cols),
+                .len = @intCast(self.address - start),
+            };
+        }
+        return null;
+    }
+};
+
+/// Flat screen buffer alias used by inspection tooling
+pub const ScreenBuffer = Screen;
+
 test "screen initialization" {
     var screen = try Screen.init(std.testing.allocator, 24, 80);
     defer screen.deinit();
@@ -97,3 +389,125 @@ test "out of bounds access returns error" {
     const result = screen.write_char(5, 5, 'A');
     try std.testing.expectError(error.OutOfBounds, result);
 }
+
+test "screen uses one linear buffer for all rows" {
+    var screen = try Screen.init(std.testing.allocator, 2, 3);
+    defer screen.deinit();
+
+    try screen.write_char(1, 0, 'B');
+    try std.testing.expectEqual(@as(usize, 6), screen.size());
+    try std.testing.expectEqual(@as(u8, 'B'), try screen.read_at(3));
+    try std.testing.expectEqualStrings("B  ", screen.row_slice(1));
+    try std.testing.expect(std.mem.isAligned(@intFromPtr(screen.buffer.ptr), cell_alignment));
+}
+
+test "screen write_run clips at end of buffer" {
+    var screen = try Screen.init(std.testing.allocator, 2, 3);
+    defer screen.deinit();
+
+    const written = screen.write_run(4, "XYZ");
+    try std.testing.expectEqual(@as(usize, 2), written);
+    try std.testing.expectEqualStrings(" XY", screen.row_slice(1));
+    try std.testing.expectEqual(@as(usize, 0), screen.write_run(6, "Q"));
+}
+
+test "screen attribute and color planes reset on clear" {
+    var screen = try Screen.init(std.testing.allocator, 2, 3);
+    defer screen.deinit();
+
+    try screen.set_attribute(2, 0x60);
+    try screen.set_color(2, 0xF2);
+    try std.testing.expectEqual(@as(u8, 0x60), try screen.get_attribute(2));
+    try std.testing.expectEqual(@as(u8, 0xF2), try screen.get_color(2));
+    try std.testing.expectEqual(@as(u8, ' '), try screen.read_at(2));
+
+    screen.clear();
+    try std.testing.expectEqual(@as(u8, 0), try screen.get_attribute(2));
+    try std.testing.expectEqual(@as(u8, 0), try screen.get_color(2));
+    try std.testing.expect(!screen.is_field_start(2));
+    try std.testing.expectError(error.OutOfBounds, screen.set_attribute(6, 0x60));
+}
+
+test "screen field extents wrap at the end of the buffer" {
+    var screen = try Screen.init(std.testing.allocator, 2, 80);
+    defer screen.deinit();
+    try std.testing.expectEqual(@as(?usize, null), screen.field_start_at(10));
+
+    // Attribute 0 is a field too
+    try screen.set_attribute(70, 0x00);
+    try screen.set_attribute(130, 0x01);
+    try std.testing.expectEqual(@as(?usize, 70), screen.field_start_at(70));
+    try std.testing.expectEqual(@as(?usize, 70), screen.field_start_at(129));
+    try std.testing.expectEqual(@as(?usize, 130), screen.field_start_at(159));
+    try std.testing.expectEqual(@as(?usize, 130), screen.field_start_at(5));
+    try std.testing.expectEqual(@as(?usize, 130), screen.next_field_start(70));
+    try std.testing.expectEqual(@as(?usize, 70), screen.next_field_start(130));
+    try std.testing.expectEqual(@as(?usize, 70), screen.next_field_start(159));
+}
+
+test "screen copy_from copies all planes" {
+    var source = try Screen.init(std.testing.allocator, 2, 3);
+    defer source.deinit();
+    var target = try Screen.init(std.testing.allocator, 2, 3);
+    defer target.deinit();
+
+    try source.write_at(1, 'Q');
+    try source.set_attribute(0, 0x20);
+    try target.copy_from(&source);
+
+    try std.testing.expectEqual(@as(u8, 'Q'), try target.read_at(1));
+    try std.testing.expectEqual(@as(u8, 0x20), try target.get_attribute(0));
+    try std.testing.expect(target.is_field_start(0));
+
+    var other = try Screen.init(std.testing.allocator, 3, 3);
+    defer other.deinit();
+    try std.testing.expectError(error.DimensionMismatch, other.copy_from(&source));
+}
+
+test "screen changes since a generation" {
+    var screen = try Screen.init(std.testing.allocator, 4, 10);
+    defer screen.deinit();
+
+    const seen = screen.current_generation();
+    try std.testing.expect(!screen.has_changes_since(seen));
+
+    _ = screen.write_run(12, "ABC");
+    try screen.write_char(3, 9, 'Z');
+    try std.testing.expect(screen.has_changes_since(seen));
+
+    var changes = screen.changes_since(seen);
+    const first = changes.next().?;
+    try std.testing.expectEqual(@as(u16, 1), first.row);
+    try std.testing.expectEqual(@as(u16, 2), first.col);
+    try std.testing.expectEqual(@as(u16, 3), first.len);
+    const second = changes.next().?;
+    try std.testing.expectEqual(@as(u16, 39), second.address);
+    try std.testing.expectEqual(@as(u16, 1), second.len);
+    try std.testing.expect(changes.next() == null);
+
+    // A consumer that already saw those writes only gets the new one
+    const later = screen.current_generation();
+    try screen.write_at(0, 'Q');
+    var newer = screen.changes_since(later);
+    try std.testing.expectEqual(@as(u16, 0), newer.next().?.address);
+    try std.testing.expect(newer.next() == null);
+
+    // The older consumer still sees everything since its generation
+    var count: usize = 0;
+    var older = screen.changes_since(seen);
+    while (older.next()) |_| count += 1;
+    try std.testing.expectEqual(@as(usize, 3), count);
+}
+
+test "screen run across rows splits into row spans" {
+    var screen = try Screen.init(std.testing.allocator, 3, 4);
+    defer screen.deinit();
+
+    const seen = screen.current_generation();
+    _ = screen.write_run(2, "abcdef");
+
+    var changes = screen.changes_since(seen);
+    try std.testing.expectEqual(@as(u16, 2), changes.next().?.len);
+    try std.testing.expectEqual(@as(u16, 4), changes.next().?.len);
+    try std.testing.expect(changes.next() == null);
+}
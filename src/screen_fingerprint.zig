@@ -0,0 +1,306 @@
+//! Screen fingerprints and panel templates.
+//!
+//! A fingerprint identifies which application panel is showing. It hashes
+//! the field layout (start address and attribute of every field) and the
+//! text inside protected fields, and leaves out anything the operator
+//! types. Each cell contributes on its own and the contributions are
+//! summed, so `Executor` keeps the hash current as it writes: overwriting
+//! a cell subtracts the old contribution and adds the new one. Reading the
+//! fingerprint never rescans the screen.
+//!
+//! `TemplateRegistry` maps fingerprints to named templates, whose field
+//! names resolve through `FieldManager`'s address index. Panel detection
+//! and named-field access are then hash lookups.
+const std = @import("std");
+const field = @import("field.zig");
+
+/// Addresses covered by the fingerprint (24x80)
+pub const cells = field.indexed_addresses;
+
+fn mix(value: u64) u64 {
+    // splitmix64 finalizer
+    var z = value +% 0x9E3779B97F4A7C15;
+    z = (z ^ (z >> 30)) *% 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) *% 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+fn text_hash(address: usize, byte: u8) u64 {
+    return mix(@as(u64, address) << 8 | byte);
+}
+
+fn field_hash(address: usize, attr: u8) u64 {
+    return mix(1 << 32 | @as(u64, address) << 8 | attr);
+}
+
+/// Incrementally maintained fingerprint state, owned by `Executor`
+pub const Fingerprint = struct {
+    layout: u64 = 0,
+    text: u64 = 0,
+    /// Attribute byte + 1 of the field starting at each address; 0 = none
+    field_attr: [cells]u16 = [_]u16{0} ** cells,
+    /// Cells whose character is part of `text`
+    text_cells: std.StaticBitSet(cells) = .initEmpty(),
+    /// Field start addresses in ascending order, for `protected_at`
+    starts: [cells]u16 = undefined,
+    start_count: u16 = 0,
+
+    /// Forget layout and text (Erase Write)
+    pub fn reset(self: *Fingerprint) void {
+        self.* = .{};
+    }
+
+    /// Forget text only (the screen was cleared, fields kept)
+    pub fn reset_text(self: *Fingerprint) void {
+        self.text = 0;
+        self.text_cells = .initEmpty();
+    }
+
+    /// A field starts at `address` with attribute byte `attr`
+    pub fn set_field(self: *Fingerprint, address: usize, attr: u8) void {
+        if (address >= cells) return;
+        const slot = &self.field_attr[address];
+        if (slot.* != 0) {
+            self.layout -%= field_hash(address, @intCast(slot.* - 1));
+        } else {
+            self.insert_start(@intCast(address));
+        }
+        slot.* = @as(u16, attr) + 1;
+        self.layout +%= field_hash(address, attr);
+    }
+
+    fn insert_start(self: *Fingerprint, address: u16) void {
+        // Writes usually define fields left to right, so this appends
+        var index: usize = self.start_count;
+        while (index > 0 and self.starts[index - 1] > address) : (index -= 1) {
+            self.starts[index] = self.starts[index - 1];
+        }
+        self.starts[index] = address;
+        self.start_count += 1;
+    }
+
+    /// Cell `address` changes from `old` to `new`; it counts when it lies
+    /// in a protected field. Blanks never count.
+    pub fn set_text(self: *Fingerprint, address: usize, old: u8, new: u8, protected: bool) void {
+        if (address >= cells) return;
+        if (self.text_cells.isSet(address)) {
+            self.text -%= text_hash(address, old);
+            self.text_cells.unset(address);
+        }
+        if (protected and new != ' ' and new != 0) {
+            self.text +%= text_hash(address, new);
+            self.text_cells.set(address);
+        }
+    }
+
+    /// True if no cell counts towards the text hash
+    pub fn text_clear(self: *const Fingerprint) bool {
+        return self.text_cells.count() == 0;
+    }
+
+    /// Whether `address` lies in a protected field: the nearest field
+    /// start at or before it, wrapping at the end of the buffer
+    pub fn protected_at(self: *const Fingerprint, address: usize) bool {
+        if (address >= cells or self.start_count == 0) return false;
+        const starts = self.starts[0..self.start_count];
+        // Number of starts at or before `address`
+        var low: usize = 0;
+        var high: usize = starts.len;
+        while (low < high) {
+            const mid = low + (high - low) / 2;
+            if (starts[mid] <= address) low = mid + 1 else high = mid;
+        }
+        const start = if (low > 0) starts[low - 1] else starts[starts.len - 1];
+        return is_protected(self.field_attr[start]);
+    }
+
+    fn is_protected(slot: u16) bool {
+        // Bit 0 of the attribute byte
+        return (slot - 1) & 0x01 != 0;
+    }
+
+    pub fn value(self: *const Fingerprint) u64 {
+        return mix(self.layout ^ mix(self.text));
+    }
+};
+
+/// Template field: a name for the field starting at `address`
+pub const NamedField = struct {
+    name: []const u8,
+    address: u16,
+};
+
+pub const Template = struct {
+    name: []const u8,
+    fingerprint: u64,
+    /// Field name -> start address
+    fields: std.StringHashMapUnmanaged(u16) = .empty,
+
+    /// The named field on the current screen, or null when the name is
+    /// unknown or no field starts at its address
+    pub fn field_by_name(self: *const Template, fields: *field.FieldManager, name: []const u8) ?*field.Field {
+        const address = self.fields.get(name) orelse return null;
+        const found = fields.find_field(address) orelse return null;
+        return if (found.start_address == address) found else null;
+    }
+};
+
+/// Fingerprint -> template. Templates live until the registry is freed.
+pub const TemplateRegistry = struct {
+    arena: std.heap.ArenaAllocator,
+    templates: std.AutoHashMapUnmanaged(u64, *Template) = .empty,
+    hits: u64 = 0,
+    misses: u64 = 0,
+
+    pub fn init(allocator: std.mem.Allocator) TemplateRegistry {
+        return .{ .arena = std.heap.ArenaAllocator.init(allocator) };
+    }
+
+    pub fn deinit(self: *TemplateRegistry) void {
+        self.templates.deinit(self.arena.child_allocator);
+        self.arena.deinit();
+    }
+
+    /// Add a template; names and strings are copied. A template already
+    /// registered for the fingerprint is replaced.
+    pub fn register(self: *TemplateRegistry, name: []const u8, fingerprint: u64, named: []const NamedField) !*const Template {
+        const allocator = self.arena.allocator();
+        const template = try allocator.create(Template);
+        template.* = .{ .name = try allocator.dupe(u8, name), .fingerprint = fingerprint };
+        try template.fields.ensureTotalCapacity(allocator, @intCast(named.len));
+        for (named) |entry| {
+            template.fields.putAssumeCapacity(try allocator.dupe(u8, entry.name), entry.address);
+        }
+        try self.templates.put(self.arena.child_allocator, fingerprint, template);
+        return template;
+    }
+
+    /// Template for a fingerprint, if one is registered
+    pub fn detect(self: *TemplateRegistry, fingerprint: u64) ?*const Template {
+        if (self.templates.get(fingerprint)) |template| {
+            self.hits += 1;
+            return template;
+        }
+        self.misses += 1;
+        return null;
+    }
+
+    pub fn count(self: *const TemplateRegistry) usize {
+        return self.templates.count();
+    }
+};
+
+const TestScreen = struct {
+    const screen = @import("screen.zig");
+    const executor = @import("executor.zig");
+    const protocol = @import("protocol.zig");
+
+    scr: screen.Screen,
+    fm: field.FieldManager,
+    exec: executor.Executor,
+
+    fn create(allocator: std.mem.Allocator) !*TestScreen {
+        const self = try allocator.create(TestScreen);
+        errdefer allocator.destroy(self);
+        self.scr = try screen.Screen.init(allocator, 24, 80);
+        self.fm = field.FieldManager.init(allocator);
+        self.exec = executor.Executor.init(allocator, &self.scr, &self.fm);
+        return self;
+    }
+
+    fn destroy(self: *TestScreen, allocator: std.mem.Allocator) void {
+        self.fm.deinit();
+        self.scr.deinit();
+        allocator.destroy(self);
+    }
+
+    /// Run `orders` behind a zero WCC
+    fn run(self: *TestScreen, code: protocol.CommandCode, orders: []const u8) !void {
+        var copy: [256]u8 = undefined;
+        copy[0] = 0x00;
+        @memcpy(copy[1..][0..orders.len], orders);
+        try self.exec.execute(.{ .code = code, .data = copy[0 .. orders.len + 1] });
+    }
+
+    const sba = @intFromEnum(protocol.OrderCode.set_buffer_address);
+    const sf = @intFromEnum(protocol.OrderCode.start_field);
+    /// Protected label at row 0, unprotected input field at row 1
+    const logon_panel = [_]u8{ sba, 0x00, 0x00, sf, 0x01, 'L', 'O', 'G', 'O', 'N', sba, 0x00, 0x50, sf, 0x00 };
+};
+
+test "fingerprint ignores input and tracks protected text" {
+    const allocator = std.testing.allocator;
+    const a = try TestScreen.create(allocator);
+    defer a.destroy(allocator);
+    const b = try TestScreen.create(allocator);
+    defer b.destroy(allocator);
+
+    try a.run(.erase_write, &TestScreen.logon_panel);
+    // Same panel, fields written in the opposite order
+    try b.run(.erase_write, &.{ TestScreen.sba, 0x00, 0x50, TestScreen.sf, 0x00 });
+    try b.run(.write, &.{ TestScreen.sba, 0x00, 0x00, TestScreen.sf, 0x01, 'L', 'O', 'G', 'O', 'N' });
+    try std.testing.expectEqual(a.exec.screen_fingerprint(), b.exec.screen_fingerprint());
+
+    // Text in the unprotected field does not count
+    const panel = a.exec.screen_fingerprint();
+    try a.run(.write, &.{ TestScreen.sba, 0x00, 0x51, 'U', 'S', 'E', 'R' });
+    try std.testing.expectEqual(panel, a.exec.screen_fingerprint());
+
+    // Changing protected text does, and changing it back restores the hash
+    try a.run(.write, &.{ TestScreen.sba, 0x00, 0x01, 'X' });
+    try std.testing.expect(panel != a.exec.screen_fingerprint());
+    try a.run(.write, &.{ TestScreen.sba, 0x00, 0x01, 'L' });
+    try std.testing.expectEqual(panel, a.exec.screen_fingerprint());
+
+    // Erase Write with nothing on it starts from scratch
+    try a.run(.erase_write, &.{});
+    try std.testing.expectEqual((Fingerprint{}).value(), a.exec.screen_fingerprint());
+}
+
+test "fingerprint finds the protecting field out of order and across the wrap" {
+    var fp = Fingerprint{};
+    try std.testing.expect(!fp.protected_at(5));
+
+    fp.set_field(100, 0x01);
+    fp.set_field(10, 0x00);
+    fp.set_field(1000, 0x01);
+    // Redefining a start keeps a single entry
+    fp.set_field(10, 0x00);
+    try std.testing.expectEqual(@as(u16, 3), fp.start_count);
+
+    try std.testing.expect(fp.protected_at(5)); // wraps to 1000
+    try std.testing.expect(!fp.protected_at(10));
+    try std.testing.expect(!fp.protected_at(99));
+    try std.testing.expect(fp.protected_at(100));
+    try std.testing.expect(fp.protected_at(cells - 1));
+
+    fp.set_field(10, 0x01);
+    try std.testing.expect(fp.protected_at(50));
+
+    fp.reset();
+    try std.testing.expect(!fp.protected_at(100));
+}
+
+test "template registry detects panels and resolves field names" {
+    const allocator = std.testing.allocator;
+    const session = try TestScreen.create(allocator);
+    defer session.destroy(allocator);
+    try session.run(.erase_write, &TestScreen.logon_panel);
+
+    var registry = TemplateRegistry.init(allocator);
+    defer registry.deinit();
+    _ = try registry.register("logon", session.exec.screen_fingerprint(), &.{
+        .{ .name = "userid", .address = 80 },
+        .{ .name = "title", .address = 0 },
+    });
+
+    const template = registry.detect(session.exec.screen_fingerprint()) orelse return error.TestExpectedTemplate;
+    try std.testing.expectEqualStrings("logon", template.name);
+    const userid = template.field_by_name(&session.fm, "userid") orelse return error.TestExpectedField;
+    try std.testing.expectEqual(@as(u16, 80), userid.start_address);
+    try std.testing.expect(template.field_by_name(&session.fm, "password") == null);
+
+    try session.run(.erase_write, &.{});
+    try std.testing.expect(registry.detect(session.exec.screen_fingerprint()) == null);
+    try std.testing.expectEqual(@as(u64, 1), registry.hits);
+}
@@ -1,28 +1,68 @@
 const std = @import("std");
 const screen = @import("screen.zig");
-const protocol = @import("protocol.zig");
 
-/// Screen history and scrollback management
+/// Screen history and scrollback management.
+///
+/// Every `keyframe_interval` saves a keyframe (a full copy of the buffer)
+/// is stored; the saves in between are stored as XOR/run-length deltas
+/// against the previous snapshot. Retention is bounded by a byte budget.
+/// Navigation decodes lazily into a small cache, starting from whichever
+/// cached screen or keyframe is fewest deltas away, so no lookup applies
+/// more than `keyframe_interval` deltas.
 pub const ScreenHistory = struct {
-    snapshots: std.ArrayList(ScreenSnapshot),
-    current_index: usize,
-    max_history: usize,
+    entries: std.ArrayList(Entry) = .empty,
+    /// Sequence number of entries.items[0]
+    first_sequence: u64 = 0,
+    current_index: usize = 0,
+    options: Options,
+    /// Bytes held by entries, compared against the budget
+    memory_used: usize = 0,
+    /// Copy of the most recently saved screen, the base of the next delta
+    last_saved: []u8 = &.{},
+    scratch: []u8 = &.{},
+    cache: [cache_slots]CacheSlot = [_]CacheSlot{.{}} ** cache_slots,
+    use_clock: u64 = 0,
     allocator: std.mem.Allocator,
 
+    pub const Options = struct {
+        /// Bytes of stored snapshots to retain. Past this the oldest keyframe
+        /// and its deltas are evicted; the newest keyframe group is always
+        /// kept.
+        memory_budget: usize = 256 * 1024,
+        keyframe_interval: usize = 16,
+    };
+
     pub const ScreenSnapshot = struct {
-        buffer: []u8,
+        buffer: []const u8,
         rows: u16,
         cols: u16,
         timestamp: i64,
         sequence_number: u64,
     };
 
-    /// Initialize screen history with specified capacity
-    pub fn init(allocator: std.mem.Allocator, max_history: usize) ScreenHistory {
+    const cache_slots = 4;
+
+    /// Delta op: skip:u16 len:u16 then `len` XOR bytes (little endian)
+    const op_header_len = 4;
+
+    const Entry = struct {
+        kind: enum { keyframe, delta },
+        data: []u8,
+        rows: u16,
+        cols: u16,
+        timestamp: i64,
+    };
+
+    const CacheSlot = struct {
+        buffer: []u8 = &.{},
+        snapshot: ?ScreenSnapshot = null,
+        last_used: u64 = 0,
+    };
+
+    /// Initialize an empty history
+    pub fn init(allocator: std.mem.Allocator, options: Options) ScreenHistory {
         return .{
-            .snapshots = std.ArrayList(ScreenSnapshot).init(allocator),
-            .current_index = 0,
-            .max_history = max_history,
+            .options = options,
             .allocator = allocator,
         };
     }
@@ -30,73 +70,80 @@ pub const ScreenHistory = struct {
     /// Save current screen state to history
     pub fn save_snapshot(self: *ScreenHistory, scr: *const screen.Screen) !void {
         // If we're not at the end of history, discard future entries
-        if (self.current_index < self.snapshots.items.len) {
-            for (self.current_index..self.snapshots.items.len) |i| {
-                self.allocator.free(self.snapshots.items[i].buffer);
-            }
-            self.snapshots.shrinkRetainingCapacity(self.current_index);
+        if (self.current_index + 1 < self.entries.items.len) {
+            self.truncate_after(self.current_index);
         }
 
-        // Copy screen buffer
-        const buffer_copy = try self.allocator.dupe(u8, scr.buffer);
+        const size = scr.buffer.len;
+        try self.reserve_buffers(size);
+
+        var data: ?[]u8 = null;
+        if (self.entries.getLastOrNull()) |prev| {
+            if (prev.rows == scr.rows and prev.cols == scr.cols and
+                size <= std.math.maxInt(u16) and
+                self.deltas_since_keyframe() + 1 < self.options.keyframe_interval)
+            {
+                const encoded = encode_delta(self.scratch, self.last_saved[0..size], scr.buffer);
+                if (encoded.len < size) data = try self.allocator.dupe(u8, encoded);
+            }
+        }
+        const kind: @FieldType(Entry, "kind") = if (data == null) .keyframe else .delta;
+        const stored = data orelse try self.allocator.dupe(u8, scr.buffer);
+        errdefer self.allocator.free(stored);
 
-        const snapshot = ScreenSnapshot{
-            .buffer = buffer_copy,
+        try self.entries.append(self.allocator, .{
+            .kind = kind,
+            .data = stored,
             .rows = scr.rows,
             .cols = scr.cols,
             .timestamp = std.time.milliTimestamp(),
-            .sequence_number = self.snapshots.items.len,
-        };
-
-        try self.snapshots.append(snapshot);
-        self.current_index = self.snapshots.items.len - 1;
+        });
+        @memcpy(self.last_saved[0..size], scr.buffer);
+        self.memory_used += stored.len + @sizeOf(Entry);
+        self.current_index = self.entries.items.len - 1;
 
-        // Remove old entries if exceeding max history
-        if (self.snapshots.items.len > self.max_history) {
-            const oldest = self.snapshots.orderedRemove(0);
-            self.allocator.free(oldest.buffer);
-            self.current_index -= 1;
-        }
+        self.evict_over_budget();
     }
 
-    /// Navigate to previous screen in history
+    /// Navigate to previous screen in history. The snapshot stays valid
+    /// until the next navigation or save.
     pub fn previous(self: *ScreenHistory) ?*const ScreenSnapshot {
         if (self.current_index > 0) {
             self.current_index -= 1;
-            return &self.snapshots.items[self.current_index];
+            return self.materialize(self.current_index);
         }
         return null;
     }
 
     /// Navigate to next screen in history
     pub fn next(self: *ScreenHistory) ?*const ScreenSnapshot {
-        if (self.current_index < self.snapshots.items.len - 1) {
+        if (self.current_index + 1 < self.entries.items.len) {
             self.current_index += 1;
-            return &self.snapshots.items[self.current_index];
+            return self.materialize(self.current_index);
         }
         return null;
     }
 
     /// Jump to specific history entry by index
     pub fn jump_to(self: *ScreenHistory, index: usize) ?*const ScreenSnapshot {
-        if (index < self.snapshots.items.len) {
+        if (index < self.entries.items.len) {
             self.current_index = index;
-            return &self.snapshots.items[index];
+            return self.materialize(index);
         }
         return null;
     }
 
     /// Get current snapshot
     pub fn current(self: *ScreenHistory) ?*const ScreenSnapshot {
-        if (self.snapshots.items.len > 0) {
-            return &self.snapshots.items[self.current_index];
+        if (self.entries.items.len > 0) {
+            return self.materialize(self.current_index);
         }
         return null;
     }
 
     /// Get total number of snapshots
     pub fn count(self: ScreenHistory) usize {
-        return self.snapshots.items.len;
+        return self.entries.items.len;
     }
 
     /// Get current index in history
@@ -106,23 +153,241 @@ pub const ScreenHistory = struct {
 
     /// Clear all history
     pub fn clear(self: *ScreenHistory) void {
-        for (self.snapshots.items) |snapshot| {
-            self.allocator.free(snapshot.buffer);
+        for (self.entries.items) |entry| {
+            self.allocator.free(entry.data);
         }
-        self.snapshots.clearRetainingCapacity();
+        self.entries.clearRetainingCapacity();
+        for (&self.cache) |*slot| slot.snapshot = null;
+        self.first_sequence = 0;
         self.current_index = 0;
+        self.memory_used = 0;
     }
 
     /// Deinitialize history
     pub fn deinit(self: *ScreenHistory) void {
         self.clear();
-        self.snapshots.deinit();
+        self.entries.deinit(self.allocator);
+        for (self.cache) |slot| self.allocator.free(slot.buffer);
+        self.allocator.free(self.last_saved);
+        self.allocator.free(self.scratch);
+    }
+
+    /// Grow the per-history buffers so a screen of `size` cells can be
+    /// saved and decoded without allocating during navigation
+    fn reserve_buffers(self: *ScreenHistory, size: usize) !void {
+        if (self.last_saved.len < size) {
+            self.last_saved = try self.allocator.realloc(self.last_saved, size);
+        }
+        if (self.scratch.len < 2 * size + op_header_len) {
+            self.scratch = try self.allocator.realloc(self.scratch, 2 * size + op_header_len);
+        }
+        for (&self.cache) |*slot| {
+            if (slot.buffer.len >= size) continue;
+            const buffer = try self.allocator.alloc(u8, size);
+            self.allocator.free(slot.buffer);
+            slot.* = .{ .buffer = buffer };
+        }
+    }
+
+    fn deltas_since_keyframe(self: ScreenHistory) usize {
+        var n: usize = 0;
+        var i = self.entries.items.len;
+        while (i > 0 and self.entries.items[i - 1].kind == .delta) : (i -= 1) n += 1;
+        return n;
+    }
+
+    fn cached(self: *ScreenHistory, sequence: u64) ?*CacheSlot {
+        for (&self.cache) |*slot| {
+            const snap = slot.snapshot orelse continue;
+            if (snap.sequence_number == sequence) return slot;
+        }
+        return null;
+    }
+
+    /// Least recently used slot other than `keep`
+    fn victim(self: *ScreenHistory, keep: ?*CacheSlot) *CacheSlot {
+        var best: ?*CacheSlot = null;
+        for (&self.cache) |*slot| {
+            if (keep) |k| {
+                if (slot == k) continue;
+            }
+            if (slot.snapshot == null) return slot;
+            if (best == null or slot.last_used < best.?.last_used) best = slot;
+        }
+        return best.?;
+    }
+
+    fn deltas_only(self: ScreenHistory, from: usize, to: usize) bool {
+        for (self.entries.items[from .. to + 1]) |entry| {
+            if (entry.kind != .delta) return false;
+        }
+        return true;
+    }
+
+    /// Decode entry `pos` into the cache, reusing the closest cached screen
+    fn materialize(self: *ScreenHistory, pos: usize) *const ScreenSnapshot {
+        const sequence = self.first_sequence + pos;
+        self.use_clock += 1;
+        if (self.cached(sequence)) |slot| {
+            slot.last_used = self.use_clock;
+            return &slot.snapshot.?;
+        }
+
+        const entries = self.entries.items;
+        const entry = entries[pos];
+        var keyframe = pos;
+        while (entries[keyframe].kind == .delta) keyframe -= 1;
+
+        // Cheapest base: the keyframe, a cached screen between it and `pos`
+        // (apply deltas forward), or a cached later screen reachable through
+        // deltas only (XOR deltas undo themselves, so apply them backward)
+        var base: ?*CacheSlot = null;
+        var base_pos: usize = keyframe;
+        var best_cost: usize = pos - keyframe;
+        for (&self.cache) |*slot| {
+            const snap = slot.snapshot orelse continue;
+            const at: usize = @intCast(snap.sequence_number - self.first_sequence);
+            const cost = if (at < pos) pos - at else at - pos;
+            if (cost >= best_cost) continue;
+            const reachable = if (at < pos) at >= keyframe else self.deltas_only(pos + 1, at);
+            if (!reachable) continue;
+            base = slot;
+            base_pos = at;
+            best_cost = cost;
+        }
+
+        const slot = self.victim(base);
+        const size = @as(usize, entry.rows) * entry.cols;
+        const out = slot.buffer[0..size];
+        if (base) |b| {
+            @memcpy(out, b.buffer[0..size]);
+        } else {
+            @memcpy(out, entries[keyframe].data);
+        }
+        if (base_pos <= pos) {
+            for (entries[base_pos + 1 .. pos + 1]) |e| apply_delta(out, e.data);
+        } else {
+            var i = base_pos;
+            while (i > pos) : (i -= 1) apply_delta(out, entries[i].data);
+        }
+
+        slot.snapshot = .{
+            .buffer = out,
+            .rows = entry.rows,
+            .cols = entry.cols,
+            .timestamp = entry.timestamp,
+            .sequence_number = sequence,
+        };
+        slot.last_used = self.use_clock;
+        return &slot.snapshot.?;
+    }
+
+    /// Drop entries after `pos`, making it the base of the next delta
+    fn truncate_after(self: *ScreenHistory, pos: usize) void {
+        const kept = self.materialize(pos);
+        @memcpy(self.last_saved[0..kept.buffer.len], kept.buffer);
+
+        for (self.entries.items[pos + 1 ..]) |entry| {
+            self.memory_used -= entry.data.len + @sizeOf(Entry);
+            self.allocator.free(entry.data);
+        }
+        self.entries.shrinkRetainingCapacity(pos + 1);
+
+        const last_sequence = self.first_sequence + pos;
+        for (&self.cache) |*slot| {
+            const snap = slot.snapshot orelse continue;
+            if (snap.sequence_number > last_sequence) slot.snapshot = null;
+        }
+    }
+
+    fn evict_over_budget(self: *ScreenHistory) void {
+        _ = self.trim_to(self.options.memory_budget);
+    }
+
+    /// Evict the oldest keyframe groups until at most `budget` bytes of
+    /// snapshots are held; the newest group is always kept. Used to shed
+    /// memory under a session quota. Returns the bytes released.
+    pub fn trim_to(self: *ScreenHistory, budget: usize) usize {
+        const before = self.memory_used;
+        while (self.memory_used > budget) {
+            const items = self.entries.items;
+            var end: usize = 1;
+            while (end < items.len and items[end].kind == .delta) end += 1;
+            if (end == items.len) break; // only the newest group is left
+
+            for (items[0..end]) |entry| {
+                self.memory_used -= entry.data.len + @sizeOf(Entry);
+                self.allocator.free(entry.data);
+            }
+            std.mem.copyForwards(Entry, items, items[end..]);
+            self.entries.shrinkRetainingCapacity(items.len - end);
+            self.first_sequence += end;
+            // Navigation may have been inside the evicted group
+            self.current_index -|= end;
+
+            for (&self.cache) |*slot| {
+                const snap = slot.snapshot orelse continue;
+                if (snap.sequence_number < self.first_sequence) slot.snapshot = null;
+            }
+        }
+        return before - self.memory_used;
     }
 };
 
+/// XOR/run-length encode `cur` against `prev` into `out`, which must hold
+/// 2 * cur.len + op_header_len bytes. Short unchanged gaps are folded into
+/// the surrounding literal when a new op would cost more.
+fn encode_delta(out: []u8, prev: []const u8, cur: []const u8) []u8 {
+    const header = ScreenHistory.op_header_len;
+    var len: usize = 0;
+    var resume_at: usize = 0;
+    var i: usize = 0;
+    while (i < cur.len) {
+        if (prev[i] == cur[i]) {
+            i += 1;
+            continue;
+        }
+
+        const start = i;
+        var end = i + 1;
+        i = end;
+        while (i < cur.len) : (i += 1) {
+            if (prev[i] != cur[i]) {
+                end = i + 1;
+            } else if (i - end >= header) {
+                break;
+            }
+        }
+        i = end;
+
+        std.mem.writeInt(u16, out[len..][0..2], @intCast(start - resume_at), .little);
+        std.mem.writeInt(u16, out[len + 2 ..][0..2], @intCast(end - start), .little);
+        len += header;
+        for (out[len..][0 .. end - start], prev[start..end], cur[start..end]) |*o, p, c| o.* = p ^ c;
+        len += end - start;
+        resume_at = end;
+    }
+    return out[0..len];
+}
+
+/// Apply (or, being XOR, undo) a delta in place
+fn apply_delta(buffer: []u8, delta: []const u8) void {
+    var pos: usize = 0;
+    var i: usize = 0;
+    while (i < delta.len) {
+        const skip = std.mem.readInt(u16, delta[i..][0..2], .little);
+        const len = std.mem.readInt(u16, delta[i + 2 ..][0..2], .little);
+        i += ScreenHistory.op_header_len;
+        pos += skip;
+        for (buffer[pos..][0..len], delta[i..][0..len]) |*b, x| b.* ^= x;
+        pos += len;
+        i += len;
+    }
+}
+
 // Tests
 test "screen_history: init creates empty history" {
-    var history = ScreenHistory.init(std.testing.allocator, 10);
+    var history = ScreenHistory.init(std.testing.allocator, .{});
     defer history.deinit();
 
     try std.testing.expectEqual(@as(usize, 0), history.count());
@@ -130,7 +395,7 @@ test "screen_history: init creates empty history" {
 }
 
 test "screen_history: save_snapshot stores screen data" {
-    var history = ScreenHistory.init(std.testing.allocator, 10);
+    var history = ScreenHistory.init(std.testing.allocator, .{});
     defer history.deinit();
 
     var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
@@ -146,7 +411,7 @@ test "screen_history: save_snapshot stores screen data" {
 }
 
 test "screen_history: previous navigates backward" {
-    var history = ScreenHistory.init(std.testing.allocator, 10);
+    var history = ScreenHistory.init(std.testing.allocator, .{});
     defer history.deinit();
 
     var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
@@ -168,7 +433,7 @@ test "screen_history: previous navigates backward" {
 }
 
 test "screen_history: next navigates forward" {
-    var history = ScreenHistory.init(std.testing.allocator, 10);
+    var history = ScreenHistory.init(std.testing.allocator, .{});
     defer history.deinit();
 
     var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
@@ -190,7 +455,7 @@ test "screen_history: next navigates forward" {
 }
 
 test "screen_history: jump_to goes to specific index" {
-    var history = ScreenHistory.init(std.testing.allocator, 10);
+    var history = ScreenHistory.init(std.testing.allocator, .{});
     defer history.deinit();
 
     var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
@@ -207,7 +472,7 @@ test "screen_history: jump_to goes to specific index" {
 }
 
 test "screen_history: clear removes all snapshots" {
-    var history = ScreenHistory.init(std.testing.allocator, 10);
+    var history = ScreenHistory.init(std.testing.allocator, .{});
     defer history.deinit();
 
     var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
@@ -222,22 +487,68 @@ test "screen_history: clear removes all snapshots" {
     try std.testing.expectEqual(@as(usize, 0), history.current_index_get());
 }
 
-test "screen_history: max_history enforces limit" {
-    var history = ScreenHistory.init(std.testing.allocator, 5);
+test "screen_history: memory budget evicts oldest keyframe groups" {
+    var history = ScreenHistory.init(std.testing.allocator, .{
+        .memory_budget = 3 * 1920,
+        .keyframe_interval = 4,
+    });
     defer history.deinit();
 
     var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
     defer scr.deinit();
 
-    for (0..10) |_| {
+    for (0..40) |i| {
+        try scr.write_char(@intCast(i % 24), 0, 'A' + @as(u8, @intCast(i % 26)));
+        try history.save_snapshot(&scr);
+    }
+
+    try std.testing.expect(history.memory_used <= 3 * 1920);
+    try std.testing.expect(history.count() < 40);
+    try std.testing.expectEqual(history.count() - 1, history.current_index_get());
+    try std.testing.expectEqualSlices(u8, scr.buffer, history.current().?.buffer);
+}
+
+test "screen_history: deltas decode to the saved screens" {
+    const allocator = std.testing.allocator;
+    var history = ScreenHistory.init(allocator, .{ .keyframe_interval = 8 });
+    defer history.deinit();
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+
+    var expected: [20][1920]u8 = undefined;
+    for (&expected, 0..) |*copy, i| {
+        try scr.write_char(@intCast(i), @intCast(i * 2), 'X');
+        try scr.write_char(23, 79, @intCast('a' + i));
         try history.save_snapshot(&scr);
+        copy.* = scr.buffer[0..1920].*;
     }
 
-    try std.testing.expectEqual(@as(usize, 5), history.count());
+    // Deltas are a fraction of a full copy
+    try std.testing.expect(history.memory_used < 5 * 1920);
+
+    // Walk backward (decoding through undone XOR deltas), then jump around
+    var i: usize = expected.len - 1;
+    while (history.previous()) |snap| {
+        i -= 1;
+        try std.testing.expectEqualSlices(u8, &expected[i], snap.buffer);
+    }
+    try std.testing.expectEqual(@as(usize, 0), i);
+    for ([_]usize{ 13, 2, 19, 7, 8, 15 }) |index| {
+        try std.testing.expectEqualSlices(u8, &expected[index], history.jump_to(index).?.buffer);
+    }
+
+    // Saving from the past discards the future and deltas from that screen
+    _ = history.jump_to(5);
+    try scr.write_char(0, 0, 'Z');
+    try history.save_snapshot(&scr);
+    try std.testing.expectEqual(@as(usize, 7), history.count());
+    try std.testing.expectEqualSlices(u8, &expected[5], history.jump_to(5).?.buffer);
+    try std.testing.expectEqualSlices(u8, scr.buffer, history.jump_to(6).?.buffer);
 }
 
 test "screen_history: navigating forward from past goes to current" {
-    var history = ScreenHistory.init(std.testing.allocator, 10);
+    var history = ScreenHistory.init(std.testing.allocator, .{});
     defer history.deinit();
 
     var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
@@ -0,0 +1,585 @@
+//! Wait-for-screen predicates evaluated against screen changes.
+//!
+//! Automation usually polls the whole screen for a string to learn that a
+//! transaction finished. A `ScreenWaiter` holds the conditions instead:
+//! text at a position, any of several strings anywhere, the cursor in a
+//! given field, the keyboard unlocked. Call `after_execute` after each
+//! `Executor.execute` and it checks only the cells that changed since the
+//! last call. All text goes into one Aho-Corasick automaton, so the cost
+//! of a check is one pass over the dirty cells however many strings are
+//! registered.
+//!
+//! Predicates fire once and are removed. A firing runs the notify
+//! callback, queues the id for `take_fired`, and makes `wait_fd()`
+//! readable, so a waiting thread can sleep in poll() rather than spin.
+//!
+//! Text is matched byte for byte against the screen's character plane.
+const std = @import("std");
+const posix = std.posix;
+const screen = @import("screen.zig");
+const field = @import("field.zig");
+const command = @import("command.zig");
+const executor = @import("executor.zig");
+
+pub const PredicateId = u32;
+
+/// Keyboard restore bit of the Write Control Character
+pub const wcc_keyboard_restore: u8 = 0x02;
+
+pub const Predicate = union(enum) {
+    /// `text` starts at buffer address `address`
+    text_at: struct { address: u16, text: []const u8 },
+    /// Any of the strings appears anywhere on the screen
+    any_text: []const []const u8,
+    /// The cursor is inside the field that starts at this address
+    cursor_in_field: u16,
+    /// The host has restored the keyboard
+    keyboard_unlocked,
+};
+
+/// Called on the thread that runs `after_execute`/`add`
+pub const Notify = struct {
+    context: ?*anyopaque = null,
+    func: *const fn (context: ?*anyopaque, id: PredicateId) void,
+};
+
+/// Multi-pattern matcher: a full DFA over bytes, so scanning costs one
+/// table lookup per screen cell
+pub const Matcher = struct {
+    allocator: std.mem.Allocator,
+    /// `states * 256` transitions
+    delta: []u16 = &.{},
+    /// Patterns ending at each state, failure chain included:
+    /// `outputs[output_start[s]..output_start[s + 1]]`
+    output_start: []u32 = &.{},
+    outputs: []u32 = &.{},
+    /// Length of the longest pattern
+    longest: usize = 0,
+
+    pub const Match = struct {
+        pattern: u32,
+        /// Buffer address one past the last byte of the match
+        end: usize,
+    };
+
+    pub fn init(allocator: std.mem.Allocator) Matcher {
+        return .{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *Matcher) void {
+        self.allocator.free(self.delta);
+        self.allocator.free(self.output_start);
+        self.allocator.free(self.outputs);
+        self.* = init(self.allocator);
+    }
+
+    /// Build the automaton for `patterns`; empty patterns never match
+    pub fn build(self: *Matcher, patterns: []const []const u8) !void {
+        const allocator = self.allocator;
+        var total: usize = 1;
+        for (patterns) |pattern| total += pattern.len;
+        if (total > std.math.maxInt(u16)) return error.TooManyPatterns;
+
+        // Trie; 0 doubles as "no edge" since no edge leads back to the root
+        var delta = try allocator.alloc(u16, total * 256);
+        errdefer allocator.free(delta);
+        @memset(delta, 0);
+        const own = try allocator.alloc(std.ArrayList(u32), total);
+        defer {
+            for (own) |*list| list.deinit(allocator);
+            allocator.free(own);
+        }
+        @memset(own, .empty);
+
+        var states: usize = 1;
+        var longest: usize = 0;
+        for (patterns, 0..) |pattern, index| {
+            if (pattern.len == 0) continue;
+            longest = @max(longest, pattern.len);
+            var state: usize = 0;
+            for (pattern) |byte| {
+                const edge = &delta[state * 256 + byte];
+                if (edge.* == 0) {
+                    edge.* = @intCast(states);
+                    states += 1;
+                }
+                state = edge.*;
+            }
+            try own[state].append(allocator, @intCast(index));
+        }
+
+        // Breadth-first: fill missing edges from the failure state and
+        // inherit its outputs
+        const fail = try allocator.alloc(u16, states);
+        defer allocator.free(fail);
+        const queue = try allocator.alloc(u16, states);
+        defer allocator.free(queue);
+        const order = try allocator.alloc(u16, states);
+        defer allocator.free(order);
+        fail[0] = 0;
+        order[0] = 0;
+        var head: usize = 0;
+        var tail: usize = 0;
+        var visited: usize = 1;
+        for (delta[0..256]) |next| {
+            if (next != 0) {
+                fail[next] = 0;
+                queue[tail] = next;
+                tail += 1;
+            }
+        }
+        while (head < tail) : (head += 1) {
+            const state = queue[head];
+            order[visited] = state;
+            visited += 1;
+            for (0..256) |byte| {
+                const edge = &delta[@as(usize, state) * 256 + byte];
+                const via_fail = delta[@as(usize, fail[state]) * 256 + byte];
+                if (edge.* != 0) {
+                    fail[edge.*] = via_fail;
+                    queue[tail] = edge.*;
+                    tail += 1;
+                } else {
+                    edge.* = via_fail;
+                }
+            }
+        }
+
+        const output_start = try allocator.alloc(u32, states + 1);
+        errdefer allocator.free(output_start);
+        var outputs: std.ArrayList(u32) = .empty;
+        errdefer outputs.deinit(allocator);
+        // Outputs are laid out per state id; collect them in BFS order so a
+        // state's failure outputs are final before it copies them
+        const chains = try allocator.alloc(std.ArrayList(u32), states);
+        defer {
+            for (chains) |*list| list.deinit(allocator);
+            allocator.free(chains);
+        }
+        @memset(chains, .empty);
+        for (order[0..states]) |state| {
+            try chains[state].appendSlice(allocator, own[state].items);
+            if (state != 0) try chains[state].appendSlice(allocator, chains[fail[state]].items);
+        }
+        for (0..states) |state| {
+            output_start[state] = @intCast(outputs.items.len);
+            try outputs.appendSlice(allocator, chains[state].items);
+        }
+        output_start[states] = @intCast(outputs.items.len);
+
+        delta = try allocator.realloc(delta, states * 256);
+        const flat = try outputs.toOwnedSlice(allocator);
+        self.deinit();
+        self.delta = delta;
+        self.output_start = output_start;
+        self.outputs = flat;
+        self.longest = longest;
+    }
+
+    /// Run the automaton over `text`, which starts at buffer address
+    /// `base`, calling `sink.on_match(Match)` for every occurrence
+    pub fn scan(self: *const Matcher, text: []const u8, base: usize, sink: anytype) void {
+        if (self.longest == 0) return;
+        var state: usize = 0;
+        for (text, 0..) |byte, index| {
+            state = self.delta[state * 256 + byte];
+            const first = self.output_start[state];
+            const last = self.output_start[state + 1];
+            if (first == last) continue;
+            for (self.outputs[first..last]) |pattern| {
+                sink.on_match(.{ .pattern = pattern, .end = base + index + 1 });
+            }
+        }
+    }
+};
+
+pub const ScreenWaiter = struct {
+    allocator: std.mem.Allocator,
+    screen: *screen.Screen,
+    fields: ?*field.FieldManager,
+    notify: ?Notify = null,
+    slots: std.ArrayList(Slot) = .empty,
+    /// Strings of every live predicate; indexes match `pattern_owner`
+    patterns: std.ArrayList([]const u8) = .empty,
+    pattern_owner: std.ArrayList(PatternOwner) = .empty,
+    matcher: Matcher,
+    matcher_stale: bool = false,
+    seen_generation: u32,
+    next_id: PredicateId = 1,
+    cursor: u16 = 0,
+    keyboard_locked: bool = true,
+    /// Ids fired but not yet collected with `take_fired`
+    fired_mutex: std.Thread.Mutex = .{},
+    fired: std.ArrayList(PredicateId) = .empty,
+    wake_pipe: ?[2]posix.fd_t = null,
+
+    const Slot = struct {
+        id: PredicateId,
+        predicate: Predicate,
+        /// Copies of the predicate's strings, owned by the waiter
+        storage: []u8,
+        strings: [][]const u8,
+    };
+
+    const PatternOwner = struct {
+        id: PredicateId,
+        /// Required start address for `text_at`
+        anchor: ?u16,
+    };
+
+    pub fn init(allocator: std.mem.Allocator, scr: *screen.Screen, fields: ?*field.FieldManager) ScreenWaiter {
+        return .{
+            .allocator = allocator,
+            .screen = scr,
+            .fields = fields,
+            .matcher = Matcher.init(allocator),
+            .seen_generation = scr.current_generation(),
+        };
+    }
+
+    pub fn deinit(self: *ScreenWaiter) void {
+        for (self.slots.items) |slot| self.free_slot(slot);
+        self.slots.deinit(self.allocator);
+        self.patterns.deinit(self.allocator);
+        self.pattern_owner.deinit(self.allocator);
+        self.matcher.deinit();
+        self.fired.deinit(self.allocator);
+        if (self.wake_pipe) |pipe| for (pipe) |fd| posix.close(fd);
+    }
+
+    /// Register a predicate; its strings are copied. A predicate already
+    /// true fires immediately, so check the id against `take_fired` or
+    /// the callback.
+    pub fn add(self: *ScreenWaiter, predicate: Predicate) !PredicateId {
+        const strings: []const []const u8 = switch (predicate) {
+            .text_at => |at| &.{at.text},
+            .any_text => |list| list,
+            else => &.{},
+        };
+        var bytes: usize = 0;
+        for (strings) |text| bytes += text.len;
+        if (predicate == .text_at and predicate.text_at.address >= self.screen.size()) return error.InvalidAddress;
+
+        const storage = try self.allocator.alloc(u8, bytes);
+        errdefer self.allocator.free(storage);
+        const copies = try self.allocator.alloc([]const u8, strings.len);
+        errdefer self.allocator.free(copies);
+        var offset: usize = 0;
+        for (strings, copies) |text, *copy| {
+            @memcpy(storage[offset..][0..text.len], text);
+            copy.* = storage[offset..][0..text.len];
+            offset += text.len;
+        }
+
+        const id = self.next_id;
+        var stored = predicate;
+        switch (stored) {
+            .text_at => |*at| at.text = copies[0],
+            .any_text => |*list| list.* = copies,
+            else => {},
+        }
+        try self.slots.append(self.allocator, .{ .id = id, .predicate = stored, .storage = storage, .strings = copies });
+        self.next_id +%= 1;
+        self.matcher_stale = true;
+
+        if (self.holds_now(stored)) self.fire(self.slots.items.len - 1);
+        return id;
+    }
+
+    /// Drop a predicate that has not fired; unknown ids are ignored
+    pub fn remove(self: *ScreenWaiter, id: PredicateId) void {
+        for (self.slots.items, 0..) |slot, index| {
+            if (slot.id == id) {
+                self.free_slot(self.slots.orderedRemove(index));
+                self.matcher_stale = true;
+                return;
+            }
+        }
+    }
+
+    /// Number of predicates still waiting
+    pub fn pending(self: *const ScreenWaiter) usize {
+        return self.slots.items.len;
+    }
+
+    /// Keyboard state as seen by the session; lock it when an AID key is
+    /// sent. Unlocking fires `keyboard_unlocked` predicates.
+    pub fn set_keyboard_locked(self: *ScreenWaiter, locked: bool) void {
+        self.keyboard_locked = locked;
+        if (!locked) self.fire_matching(.keyboard_unlocked, 0);
+    }
+
+    /// Evaluate after `exec` ran `cmd`. The first data byte of a write
+    /// command is its WCC; the keyboard restore bit unlocks the keyboard.
+    pub fn after_execute(self: *ScreenWaiter, exec: *const executor.Executor, cmd: command.Command) !void {
+        switch (cmd.code) {
+            .write, .erase_write, .erase_write_alt => {
+                if (cmd.data.len > 0 and cmd.data[0] & wcc_keyboard_restore != 0) self.keyboard_locked = false;
+            },
+            else => {},
+        }
+        try self.check(exec.cursor_address);
+    }
+
+    /// Evaluate against cells changed since the last check, with the
+    /// cursor at `cursor`
+    pub fn check(self: *ScreenWaiter, cursor: u16) !void {
+        self.cursor = cursor;
+        if (self.slots.items.len == 0) {
+            self.seen_generation = self.screen.current_generation();
+            return;
+        }
+        if (self.matcher_stale) try self.rebuild();
+
+        if (self.matcher.longest > 0) {
+            // Widen each dirty span so matches straddling its edges are
+            // seen, merging spans whose windows touch
+            const reach = self.matcher.longest - 1;
+            const size = self.screen.size();
+            var window_start: usize = 0;
+            var window_end: usize = 0;
+            var changes = self.screen.changes_since(self.seen_generation);
+            while (changes.next()) |span| {
+                const start = @as(usize, span.address) -| reach;
+                const end = @min(size, @as(usize, span.address) + span.len + reach);
+                if (window_end > window_start and start <= window_end) {
+                    window_end = @max(window_end, end);
+                    continue;
+                }
+                self.scan_window(window_start, window_end);
+                window_start = start;
+                window_end = end;
+            }
+            self.scan_window(window_start, window_end);
+        }
+        self.seen_generation = self.screen.current_generation();
+
+        if (!self.keyboard_locked) self.fire_matching(.keyboard_unlocked, 0);
+        self.fire_matching(.cursor_in_field, cursor);
+    }
+
+    /// Copy out fired ids, oldest first; returns how many were written
+    /// and keeps any that did not fit. Safe from any thread.
+    pub fn take_fired(self: *ScreenWaiter, out: []PredicateId) usize {
+        self.fired_mutex.lock();
+        defer self.fired_mutex.unlock();
+        const count = @min(out.len, self.fired.items.len);
+        @memcpy(out[0..count], self.fired.items[0..count]);
+        const rest = self.fired.items.len - count;
+        std.mem.copyForwards(PredicateId, self.fired.items[0..rest], self.fired.items[count..]);
+        self.fired.shrinkRetainingCapacity(rest);
+        if (self.fired.items.len == 0) self.drain_pipe();
+        return count;
+    }
+
+    /// Descriptor that is readable while fired ids wait in `take_fired`
+    pub fn wait_fd(self: *ScreenWaiter) !posix.fd_t {
+        // `fire` reads the pipe under this mutex from the host thread
+        self.fired_mutex.lock();
+        defer self.fired_mutex.unlock();
+        if (self.wake_pipe == null) {
+            self.wake_pipe = try posix.pipe2(.{ .NONBLOCK = true, .CLOEXEC = true });
+            if (self.fired.items.len > 0) self.signal_pipe();
+        }
+        return self.wake_pipe.?[0];
+    }
+
+    fn scan_window(self: *ScreenWaiter, start: usize, end: usize) void {
+        if (end <= start) return;
+        self.matcher.scan(self.screen.buffer[start..end], start, self);
+    }
+
+    /// Matcher sink
+    fn on_match(self: *ScreenWaiter, match: Matcher.Match) void {
+        const owner = self.pattern_owner.items[match.pattern];
+        const address = match.end - self.patterns.items[match.pattern].len;
+        if (owner.anchor) |anchor| {
+            if (anchor != address) return;
+        }
+        for (self.slots.items, 0..) |slot, index| {
+            if (slot.id == owner.id) {
+                self.fire(index);
+                return;
+            }
+        }
+        // Fired earlier in this scan
+    }
+
+    fn rebuild(self: *ScreenWaiter) !void {
+        self.patterns.clearRetainingCapacity();
+        self.pattern_owner.clearRetainingCapacity();
+        for (self.slots.items) |slot| {
+            const anchor: ?u16 = if (slot.predicate == .text_at) slot.predicate.text_at.address else null;
+            for (slot.strings) |text| {
+                try self.patterns.append(self.allocator, text);
+                try self.pattern_owner.append(self.allocator, .{ .id = slot.id, .anchor = anchor });
+            }
+        }
+        try self.matcher.build(self.patterns.items);
+        self.matcher_stale = false;
+    }
+
+    /// Full evaluation of one predicate, used when it is registered
+    fn holds_now(self: *const ScreenWaiter, predicate: Predicate) bool {
+        const buffer = self.screen.buffer;
+        return switch (predicate) {
+            .text_at => |at| at.text.len > 0 and std.mem.startsWith(u8, buffer[at.address..], at.text),
+            .any_text => |list| for (list) |text| {
+                if (text.len > 0 and std.mem.indexOf(u8, buffer, text) != null) break true;
+            } else false,
+            .cursor_in_field => |start| self.cursor_field_start(self.cursor) == start,
+            .keyboard_unlocked => !self.keyboard_locked,
+        };
+    }
+
+    fn cursor_field_start(self: *const ScreenWaiter, cursor: u16) ?u16 {
+        const fields = self.fields orelse return null;
+        const found = fields.find_field(cursor) orelse return null;
+        return found.start_address;
+    }
+
+    /// Fire every `keyboard_unlocked` or `cursor_in_field` predicate that
+    /// holds
+    fn fire_matching(self: *ScreenWaiter, tag: std.meta.Tag(Predicate), cursor: u16) void {
+        const field_start = if (tag == .cursor_in_field) self.cursor_field_start(cursor) orelse return else 0;
+        var index: usize = 0;
+        while (index < self.slots.items.len) {
+            const predicate = self.slots.items[index].predicate;
+            const holds = switch (predicate) {
+                .keyboard_unlocked => tag == .keyboard_unlocked,
+                .cursor_in_field => |start| tag == .cursor_in_field and start == field_start,
+                else => false,
+            };
+            if (holds) self.fire(index) else index += 1;
+        }
+    }
+
+    fn fire(self: *ScreenWaiter, index: usize) void {
+        const slot = self.slots.orderedRemove(index);
+        defer self.free_slot(slot);
+        self.matcher_stale = true;
+
+        {
+            self.fired_mutex.lock();
+            defer self.fired_mutex.unlock();
+            // Losing an id under memory pressure beats failing the check;
+            // the callback below still reports it
+            self.fired.append(self.allocator, slot.id) catch {};
+            self.signal_pipe();
+        }
+        if (self.notify) |notify| notify.func(notify.context, slot.id);
+    }
+
+    fn free_slot(self: *ScreenWaiter, slot: Slot) void {
+        self.allocator.free(slot.storage);
+        self.allocator.free(slot.strings);
+    }
+
+    fn signal_pipe(self: *ScreenWaiter) void {
+        const pipe = self.wake_pipe orelse return;
+        // A full pipe already reads as ready
+        _ = posix.write(pipe[1], &[_]u8{1}) catch {};
+    }
+
+    fn drain_pipe(self: *ScreenWaiter) void {
+        const pipe = self.wake_pipe orelse return;
+        var sink: [64]u8 = undefined;
+        while (true) {
+            const n = posix.read(pipe[0], &sink) catch return;
+            if (n < sink.len) return;
+        }
+    }
+};
+
+test "matcher finds overlapping patterns" {
+    var matcher = Matcher.init(std.testing.allocator);
+    defer matcher.deinit();
+    try matcher.build(&.{ "READY", "ADY", "", "SIGNON" });
+
+    const Collector = struct {
+        found: [8]Matcher.Match = undefined,
+        count: usize = 0,
+
+        fn on_match(self: *@This(), match: Matcher.Match) void {
+            self.found[self.count] = match;
+            self.count += 1;
+        }
+    };
+    var collector = Collector{};
+    matcher.scan("xxREADY SIGNON", 100, &collector);
+
+    try std.testing.expectEqual(@as(usize, 3), collector.count);
+    try std.testing.expectEqual(@as(u32, 0), collector.found[0].pattern);
+    try std.testing.expectEqual(@as(usize, 107), collector.found[0].end);
+    try std.testing.expectEqual(@as(u32, 1), collector.found[1].pattern);
+    try std.testing.expectEqual(@as(u32, 3), collector.found[2].pattern);
+}
+
+test "screen waiter fires on dirty regions only once" {
+    const protocol = @import("protocol.zig");
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+    var exec = executor.Executor.init(std.testing.allocator, &scr, &fm);
+
+    var waiter = ScreenWaiter.init(std.testing.allocator, &scr, &fm);
+    defer waiter.deinit();
+    const fd = try waiter.wait_fd();
+
+    const ready = try waiter.add(.{ .any_text = &.{ "READY", "COMPLETE" } });
+    const anchored = try waiter.add(.{ .text_at = .{ .address = 85, .text = "OK" } });
+    const unlocked = try waiter.add(.keyboard_unlocked);
+    try std.testing.expectEqual(@as(usize, 3), waiter.pending());
+
+    // "OK" at the wrong place and no keyboard restore in the WCC
+    var first = [_]u8{ 0x00, @intFromEnum(protocol.OrderCode.set_buffer_address), 0x00, 0x50, 'O', 'K' };
+    try exec.execute(.{ .code = .write, .data = &first });
+    try waiter.after_execute(&exec, .{ .code = .write, .data = &first });
+    var fired: [4]PredicateId = undefined;
+    try std.testing.expectEqual(@as(usize, 0), waiter.take_fired(&fired));
+
+    // A string split across two writes is still found
+    var second = [_]u8{ wcc_keyboard_restore, @intFromEnum(protocol.OrderCode.set_buffer_address), 0x00, 0x55, 'O', 'K', ' ', 'R', 'E', 'A' };
+    try exec.execute(.{ .code = .write, .data = &second });
+    try waiter.after_execute(&exec, .{ .code = .write, .data = &second });
+    var third = [_]u8{ 0x00, @intFromEnum(protocol.OrderCode.set_buffer_address), 0x00, 0x5B, 'D', 'Y' };
+    try exec.execute(.{ .code = .write, .data = &third });
+    try waiter.after_execute(&exec, .{ .code = .write, .data = &third });
+
+    var readable = [_]posix.pollfd{.{ .fd = fd, .events = posix.POLL.IN, .revents = 0 }};
+    try std.testing.expectEqual(@as(usize, 1), try posix.poll(&readable, 0));
+    try std.testing.expectEqual(@as(usize, 3), waiter.take_fired(&fired));
+    try std.testing.expectEqualSlices(PredicateId, &.{ anchored, unlocked, ready }, fired[0..3]);
+    try std.testing.expectEqual(@as(usize, 0), waiter.pending());
+    try std.testing.expectEqual(@as(usize, 0), try posix.poll(&readable, 0));
+
+    // Already on screen: fires at registration
+    _ = try waiter.add(.{ .text_at = .{ .address = 85, .text = "OK" } });
+    try std.testing.expectEqual(@as(usize, 1), waiter.take_fired(&fired));
+}
+
+test "screen waiter cursor in field and callback" {
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+    var fm = field.FieldManager.init(std.testing.allocator);
+    defer fm.deinit();
+    _ = try fm.add_field(160, 10, .{});
+
+    const Counter = struct {
+        var last: PredicateId = 0;
+        fn on_fire(context: ?*anyopaque, id: PredicateId) void {
+            _ = context;
+            last = id;
+        }
+    };
+    var waiter = ScreenWaiter.init(std.testing.allocator, &scr, &fm);
+    defer waiter.deinit();
+    waiter.notify = .{ .func = Counter.on_fire };
+
+    const in_field = try waiter.add(.{ .cursor_in_field = 160 });
+    try waiter.check(10);
+    try std.testing.expectEqual(@as(PredicateId, 0), Counter.last);
+    try waiter.check(165);
+    try std.testing.expectEqual(in_field, Counter.last);
+}
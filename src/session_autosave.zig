@@ -1,18 +1,39 @@
 const std = @import("std");
 const screen = @import("screen.zig");
+const field = @import("field.zig");
+const session_snapshot = @import("session_snapshot.zig");
+
+/// Checkpoint log inside the session directory
+pub const checkpoint_file = "checkpoint.bin";
 
 pub const AutoSaveConfig = struct {
     interval_ms: u64 = 30_000, // 30 seconds
-    max_snapshots: usize = 10,
+    /// Deltas after a full checkpoint before the next save is full again.
+    /// Bounds the log and the replay on recovery.
+    max_deltas: usize = 10,
     enabled: bool = true,
+    /// Queue limit for the checkpoint thread before it resynchronises
+    max_pending_bytes: usize = 1 << 20,
 };
 
+/// Periodic session checkpoints.
+///
+/// Each save captures only what changed since the previous one (see
+/// `session_snapshot`) and the checkpoint thread started by `start` writes
+/// it to `checkpoint.bin` and any extra sinks, such as a warm standby.
+/// Without `start`, the first save opens the log and saves are written on
+/// the caller's thread.
 pub const SessionAutoSave = struct {
     allocator: std.mem.Allocator,
     session_dir: []const u8,
     config: AutoSaveConfig,
     last_save_time: i64 = 0,
     save_count: u64 = 0,
+    /// Deltas saved since the last full checkpoint
+    delta_count: usize = 0,
+    checkpointer: session_snapshot.Checkpointer,
+    writer: session_snapshot.CheckpointWriter,
+    log: ?session_snapshot.FileSink = null,
 
     pub fn init(
         allocator: std.mem.Allocator,
@@ -32,17 +53,57 @@ pub const SessionAutoSave = struct {
             .allocator = allocator,
             .session_dir = dir_copy,
             .config = config,
+            .checkpointer = session_snapshot.Checkpointer.init(allocator),
+            .writer = session_snapshot.CheckpointWriter.init(allocator, .{
+                .max_pending_bytes = config.max_pending_bytes,
+            }),
         };
     }
 
     pub fn deinit(self: *SessionAutoSave) void {
+        self.writer.deinit();
+        if (self.log) |*log| log.close();
+        self.checkpointer.deinit();
         self.allocator.free(self.session_dir);
     }
 
+    /// Also feed checkpoints to `sink` (a `Standby`, or a `StreamSink` to a
+    /// standby node). Call before `start`.
+    pub fn add_sink(self: *SessionAutoSave, sink: session_snapshot.Sink) !void {
+        try self.writer.add_sink(sink);
+    }
+
+    /// Open the checkpoint log and start the checkpoint thread. `self` must
+    /// not move afterwards.
+    pub fn start(self: *SessionAutoSave) !void {
+        try self.open_log();
+        try self.writer.start();
+    }
+
+    /// Add the checkpoint log as a sink, once
+    fn open_log(self: *SessionAutoSave) !void {
+        if (self.log != null) return;
+        const dir = try std.fs.cwd().openDir(self.session_dir, .{});
+        self.log = .{ .dir = dir, .name = checkpoint_file };
+        errdefer {
+            self.log.?.close();
+            self.log = null;
+        }
+        try self.writer.add_sink(self.log.?.sink());
+        // The log may hold an older session; begin it with a full frame
+        self.checkpointer.request_full();
+    }
+
+    /// Wait for queued checkpoints to be written
+    pub fn flush(self: *SessionAutoSave) void {
+        self.writer.flush();
+    }
+
     /// Check if auto-save interval has elapsed and perform save if needed
     pub fn maybe_save(
         self: *SessionAutoSave,
-        scr: *const screen.Screen,
+        scr: *screen.Screen,
+        fields: ?*field.FieldManager,
         cursor_row: u16,
         cursor_col: u16,
         keyboard_locked: bool,
@@ -55,7 +116,7 @@ pub const SessionAutoSave = struct {
         const elapsed = now - self.last_save_time;
 
         if (elapsed >= @as(i64, @intCast(self.config.interval_ms))) {
-            try self.perform_save(scr, cursor_row, cursor_col, keyboard_locked);
+            try self.perform_save(scr, fields, cursor_row, cursor_col, keyboard_locked);
             self.last_save_time = now;
             return true;
         }
@@ -63,25 +124,44 @@ pub const SessionAutoSave = struct {
         return false;
     }
 
-    /// Perform immediate save
+    /// Perform immediate save: capture the changes since the last save and
+    /// queue them for the checkpoint thread
     pub fn perform_save(
         self: *SessionAutoSave,
-        _: *const screen.Screen,
-        _: u16,
-        _: u16,
-        _: bool,
+        scr: *screen.Screen,
+        fields: ?*field.FieldManager,
+        cursor_row: u16,
+        cursor_col: u16,
+        keyboard_locked: bool,
     ) !void {
-        // In a full implementation, would write screen/cursor/keyboard state to file
-        // For now, just increment the save counter
+        try self.open_log();
+        if (self.writer.take_resync() or self.delta_count >= self.config.max_deltas) {
+            self.checkpointer.request_full();
+        }
+        const frame = try self.checkpointer.capture(scr, fields, .{
+            .cursor = cursor_row * scr.cols + cursor_col,
+            .keyboard_locked = keyboard_locked,
+        });
+        const kind = (try session_snapshot.Header.parse(frame)).kind;
+        try self.writer.submit(frame);
+        self.delta_count = if (kind == .full) 0 else self.delta_count + 1;
         self.save_count += 1;
     }
 
-    /// Recover last saved session
-    pub fn recover_last_session(self: SessionAutoSave) !?void {
-        // In a full implementation, would read from session file
-        // For now, just return null
-        _ = self;
-        return null;
+    /// Rebuild the last saved session from the checkpoint log into
+    /// `standby`. Returns false when there is no log.
+    pub fn recover_last_session(self: SessionAutoSave, standby: *session_snapshot.Standby) !bool {
+        var dir = try std.fs.cwd().openDir(self.session_dir, .{});
+        defer dir.close();
+        const bytes = dir.readFileAlloc(self.allocator, checkpoint_file, std.math.maxInt(u32)) catch |err| {
+            if (err == error.FileNotFound) return false;
+            return err;
+        };
+        defer self.allocator.free(bytes);
+        if (bytes.len == 0) return false;
+
+        _ = try session_snapshot.replay(standby, bytes);
+        return true;
     }
 
     /// Enable/disable auto-save
@@ -125,6 +205,129 @@ test "session autosave save count increments" {
     try std.testing.expectEqual(@as(u64, 0), autosave.get_save_count());
 }
 
+test "session autosave checkpoints in the background and recovers" {
+    const allocator = std.testing.allocator;
+    std.fs.cwd().deleteTree("/tmp/test_session_checkpoint") catch {};
+    defer std.fs.cwd().deleteTree("/tmp/test_session_checkpoint") catch {};
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+    var standby = try session_snapshot.Standby.init(allocator, 24, 80);
+    defer standby.deinit();
+
+    var autosave = try SessionAutoSave.init(allocator, "/tmp/test_session_checkpoint", .{});
+    defer autosave.deinit();
+    try autosave.add_sink(standby.sink());
+    try autosave.start();
+
+    _ = scr.write_run(0, "READY");
+    try autosave.perform_save(&scr, null, 0, 5, false);
+    _ = scr.write_run(80, "GO");
+    try autosave.perform_save(&scr, null, 1, 2, true);
+    autosave.flush();
+    try std.testing.expectEqual(@as(u64, 2), autosave.get_save_count());
+    try std.testing.expectEqualSlices(u8, scr.buffer, standby.screen.buffer);
+
+    var recovered = try session_snapshot.Standby.init(allocator, 24, 80);
+    defer recovered.deinit();
+    try std.testing.expect(try autosave.recover_last_session(&recovered));
+    try std.testing.expectEqualSlices(u8, scr.buffer, recovered.screen.buffer);
+    try std.testing.expectEqual(@as(u16, 82), recovered.state.cursor);
+    try std.testing.expect(recovered.state.keyboard_locked);
+}
+
+test "session autosave writes the log on the caller's thread without start" {
+    const allocator = std.testing.allocator;
+    std.fs.cwd().deleteTree("/tmp/test_session_inline") catch {};
+    defer std.fs.cwd().deleteTree("/tmp/test_session_inline") catch {};
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+
+    var autosave = try SessionAutoSave.init(allocator, "/tmp/test_session_inline", .{});
+    defer autosave.deinit();
+
+    _ = scr.write_run(0, "INLINE");
+    try autosave.perform_save(&scr, null, 0, 6, false);
+
+    // Already on disk: no thread, nothing to flush
+    var recovered = try session_snapshot.Standby.init(allocator, 24, 80);
+    defer recovered.deinit();
+    try std.testing.expect(try autosave.recover_last_session(&recovered));
+    try std.testing.expectEqualSlices(u8, scr.buffer, recovered.screen.buffer);
+}
+
+test "session autosave bounds the delta chain" {
+    const allocator = std.testing.allocator;
+    std.fs.cwd().deleteTree("/tmp/test_session_deltas") catch {};
+    defer std.fs.cwd().deleteTree("/tmp/test_session_deltas") catch {};
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+
+    var autosave = try SessionAutoSave.init(allocator, "/tmp/test_session_deltas", .{ .max_deltas = 2 });
+    defer autosave.deinit();
+
+    // Full, two deltas, then full again
+    const expected = [_]usize{ 0, 1, 2, 0 };
+    for (expected, 0..) |deltas, i| {
+        _ = scr.write_run(@intCast(i), "X");
+        try autosave.perform_save(&scr, null, 0, 0, false);
+        try std.testing.expectEqual(deltas, autosave.delta_count);
+    }
+}
+
+test "session autosave streams checkpoints to a standby node" {
+    const allocator = std.testing.allocator;
+    std.fs.cwd().deleteTree("/tmp/test_session_stream") catch {};
+    defer std.fs.cwd().deleteTree("/tmp/test_session_stream") catch {};
+
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+    var standby = try session_snapshot.Standby.init(allocator, 24, 80);
+    defer standby.deinit();
+
+    const address = try std.net.Address.parseIp("127.0.0.1", 0);
+    var server = try address.listen(.{ .reuse_address = true });
+    defer server.deinit();
+
+    const Node = struct {
+        fn run(listener: *std.net.Server, replica: *session_snapshot.Standby, applied: *u64) void {
+            const connection = listener.accept() catch return;
+            defer connection.stream.close();
+            applied.* = replica.receive(connection.stream) catch 0;
+        }
+    };
+    var applied: u64 = 0;
+    var link = session_snapshot.StreamSink{ .stream = try std.net.tcpConnectToAddress(server.listen_address) };
+    const node = std.Thread.spawn(.{}, Node.run, .{ &server, &standby, &applied }) catch |err| {
+        link.stream.close();
+        return err;
+    };
+
+    {
+        // The standby sees end of stream once the autosave has drained
+        defer node.join();
+        defer link.stream.close();
+
+        var autosave = try SessionAutoSave.init(allocator, "/tmp/test_session_stream", .{});
+        defer autosave.deinit();
+        try autosave.add_sink(link.sink());
+        try autosave.start();
+
+        _ = scr.write_run(0, "PRIMARY");
+        try autosave.perform_save(&scr, null, 0, 7, false);
+        _ = scr.write_run(160, "NODE");
+        try autosave.perform_save(&scr, null, 2, 4, true);
+    }
+
+    try std.testing.expectEqual(@as(u64, 2), applied);
+    try std.testing.expect(standby.ready);
+    try std.testing.expectEqualSlices(u8, scr.buffer, standby.screen.buffer);
+    try std.testing.expectEqual(@as(u16, 164), standby.state.cursor);
+    try std.testing.expect(standby.state.keyboard_locked);
+}
+
 test "session autosave time since last save" {
     var gpa = std.heap.GeneralPurposeAllocator(.{}){};
     defer _ = gpa.deinit();
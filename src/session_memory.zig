@@ -0,0 +1,276 @@
+//! Per-session memory accounting.
+//!
+//! `SessionMemory` wraps a parent allocator the way `AllocationTracker`
+//! does. A session passes it to everything it owns that can grow: screen
+//! history, recordings and field tables. Each allocation is charged to the
+//! session's byte counter and checked against two quotas from
+//! `ResourceLimits`:
+//!
+//! - Past the soft quota the session is flagged as under pressure. At its
+//!   next safe point the session calls `shed`. The registered shedders then
+//!   trim `ScreenHistory` and flush recorder segments until usage is back
+//!   under the soft quota.
+//! - An allocation that would pass the hard quota fails with OutOfMemory,
+//!   so one runaway session cannot exhaust the node.
+//!
+//! Shedding never runs inside the allocator, because the allocation being
+//! charged may come from the structure a shedder would trim. The counters
+//! are relaxed atomics on the session's own cache line. A session is driven
+//! by one thread at a time, so the line stays in that core's cache and
+//! sessions do not contend with each other.
+//!
+//! The code that owns a session's screen history and recorder creates its
+//! `SessionMemory`, builds them on `allocator()` and calls `shed` between
+//! commands. `Client`, `SessionPool` and the reactor do not own those
+//! structures, so they do not create one; their buffers stay outside the
+//! quota.
+const std = @import("std");
+const resource_limits = @import("resource_limits.zig");
+const metrics_export = @import("metrics_export.zig");
+const screen_history = @import("screen_history.zig");
+const session_recorder = @import("session_recorder.zig");
+
+/// Something that can give memory back on request
+pub const Shedder = struct {
+    context: *anyopaque,
+    /// Release `excess` bytes, or as much as possible
+    shed_fn: *const fn (context: *anyopaque, excess: usize) void,
+
+    /// Evict the oldest history; the newest keyframe group stays
+    pub fn history(h: *screen_history.ScreenHistory) Shedder {
+        return .{ .context = h, .shed_fn = &shed_history };
+    }
+
+    /// Move in-memory records to the recorder's `segment_sink`
+    pub fn recorder(r: *session_recorder.SessionRecorder) Shedder {
+        return .{ .context = r, .shed_fn = &shed_recorder };
+    }
+
+    fn shed_history(context: *anyopaque, excess: usize) void {
+        const h: *screen_history.ScreenHistory = @ptrCast(@alignCast(context));
+        _ = h.trim_to(h.memory_used -| excess);
+    }
+
+    fn shed_recorder(context: *anyopaque, _: usize) void {
+        const r: *session_recorder.SessionRecorder = @ptrCast(@alignCast(context));
+        // On a write error the records stay; the hard quota still bounds them
+        _ = r.flush_segment() catch |err| blk: {
+            // Reported once, when the sink failed
+            if (err != error.SpillFailed) {
+                std.log.warn("session_memory: recording spill failed, records stay in memory: {s}", .{@errorName(err)});
+            }
+            break :blk 0;
+        };
+    }
+};
+
+/// Allocator wrapper charging one session's memory against its quotas
+pub const SessionMemory = struct {
+    parent_allocator: std.mem.Allocator,
+    session_id: u32,
+    soft_bytes: usize,
+    hard_bytes: usize,
+    current_bytes: std.atomic.Value(usize) align(std.atomic.cache_line) = .init(0),
+    peak_bytes: std.atomic.Value(usize) = .init(0),
+    /// Times usage crossed the soft quota
+    soft_breaches: std.atomic.Value(u64) = .init(0),
+    /// Allocations refused at the hard quota
+    quota_failures: std.atomic.Value(u64) = .init(0),
+    pressure: std.atomic.Value(bool) = .init(false),
+    /// Run in order by `shed`; allocated from the parent, not charged
+    shedders: std.ArrayList(Shedder) = .empty,
+
+    pub fn init(parent: std.mem.Allocator, session_id: u32, limits: resource_limits.ResourceLimits) SessionMemory {
+        return .{
+            .parent_allocator = parent,
+            .session_id = session_id,
+            .soft_bytes = std.math.cast(usize, limits.session_memory_soft_bytes) orelse std.math.maxInt(usize),
+            .hard_bytes = std.math.cast(usize, limits.session_memory_hard_bytes) orelse std.math.maxInt(usize),
+        };
+    }
+
+    /// Free the shedder list. Whatever is still charged belongs to its
+    /// owners, which must be freed first.
+    pub fn deinit(self: *SessionMemory) void {
+        self.shedders.deinit(self.parent_allocator);
+    }
+
+    pub fn allocator(self: *SessionMemory) std.mem.Allocator {
+        return .{
+            .ptr = self,
+            .vtable = &.{
+                .alloc = &allocFn,
+                .resize = &resizeFn,
+                .remap = &remapFn,
+                .free = &freeFn,
+            },
+        };
+    }
+
+    pub fn add_shedder(self: *SessionMemory, shedder: Shedder) !void {
+        try self.shedders.append(self.parent_allocator, shedder);
+    }
+
+    /// Bytes currently charged to the session
+    pub fn usage(self: *const SessionMemory) usize {
+        return self.current_bytes.load(.monotonic);
+    }
+
+    /// Usage went past the soft quota, or an allocation was refused,
+    /// since the last `shed`
+    pub fn under_pressure(self: *const SessionMemory) bool {
+        return self.pressure.load(.monotonic);
+    }
+
+    /// Run the shedders until usage is back under the soft quota. Call it
+    /// between commands on the session's thread, while nothing being
+    /// trimmed is in use. Returns the bytes released.
+    pub fn shed(self: *SessionMemory) usize {
+        const before = self.usage();
+        for (self.shedders.items) |shedder| {
+            const current = self.usage();
+            if (current <= self.soft_bytes) break;
+            shedder.shed_fn(shedder.context, current - self.soft_bytes);
+        }
+        self.pressure.store(self.usage() > self.soft_bytes, .monotonic);
+        return before -| self.usage();
+    }
+
+    /// Copy the session's memory figures into its metrics for export
+    pub fn export_metrics(self: *const SessionMemory, metrics: *metrics_export.SessionMetrics) void {
+        metrics.memory_bytes = self.usage();
+        metrics.memory_peak_bytes = self.peak_bytes.load(.monotonic);
+        metrics.memory_quota_failures = self.quota_failures.load(.monotonic);
+    }
+
+    /// Charge `len` bytes; false if that would pass the hard quota
+    fn charge(self: *SessionMemory, len: usize) bool {
+        const before = self.current_bytes.fetchAdd(len, .monotonic);
+        const after = before + len;
+        if (after > self.hard_bytes) {
+            _ = self.current_bytes.fetchSub(len, .monotonic);
+            _ = self.quota_failures.fetchAdd(1, .monotonic);
+            self.pressure.store(true, .monotonic);
+            return false;
+        }
+        if (after > self.soft_bytes and before <= self.soft_bytes) {
+            _ = self.soft_breaches.fetchAdd(1, .monotonic);
+            self.pressure.store(true, .monotonic);
+        }
+        _ = self.peak_bytes.fetchMax(after, .monotonic);
+        return true;
+    }
+
+    fn uncharge(self: *SessionMemory, len: usize) void {
+        _ = self.current_bytes.fetchSub(len, .monotonic);
+    }
+
+    fn allocFn(ctx: *anyopaque, len: usize, alignment: std.mem.Alignment, ret_addr: usize) ?[*]u8 {
+        const self: *SessionMemory = @ptrCast(@alignCast(ctx));
+        if (!self.charge(len)) return null;
+        return self.parent_allocator.rawAlloc(len, alignment, ret_addr) orelse {
+            self.uncharge(len);
+            return null;
+        };
+    }
+
+    fn resizeFn(ctx: *anyopaque, buf: []u8, alignment: std.mem.Alignment, new_len: usize, ret_addr: usize) bool {
+        const self: *SessionMemory = @ptrCast(@alignCast(ctx));
+        if (new_len > buf.len and !self.charge(new_len - buf.len)) return false;
+        if (!self.parent_allocator.rawResize(buf, alignment, new_len, ret_addr)) {
+            if (new_len > buf.len) self.uncharge(new_len - buf.len);
+            return false;
+        }
+        if (new_len < buf.len) self.uncharge(buf.len - new_len);
+        return true;
+    }
+
+    fn remapFn(ctx: *anyopaque, buf: []u8, alignment: std.mem.Alignment, new_len: usize, ret_addr: usize) ?[*]u8 {
+        const self: *SessionMemory = @ptrCast(@alignCast(ctx));
+        if (new_len > buf.len and !self.charge(new_len - buf.len)) return null;
+        const ptr = self.parent_allocator.rawRemap(buf, alignment, new_len, ret_addr) orelse {
+            if (new_len > buf.len) self.uncharge(new_len - buf.len);
+            return null;
+        };
+        if (new_len < buf.len) self.uncharge(buf.len - new_len);
+        return ptr;
+    }
+
+    fn freeFn(ctx: *anyopaque, buf: []u8, alignment: std.mem.Alignment, ret_addr: usize) void {
+        const self: *SessionMemory = @ptrCast(@alignCast(ctx));
+        self.parent_allocator.rawFree(buf, alignment, ret_addr);
+        self.uncharge(buf.len);
+    }
+};
+
+test "session memory charges allocations against its quotas" {
+    var memory = SessionMemory.init(std.testing.allocator, 7, .{
+        .session_memory_soft_bytes = 1024,
+        .session_memory_hard_bytes = 4096,
+    });
+    defer memory.deinit();
+    const allocator = memory.allocator();
+
+    const small = try allocator.alloc(u8, 512);
+    try std.testing.expect(!memory.under_pressure());
+    var grown: std.ArrayList(u8) = .empty;
+    try grown.appendNTimes(allocator, 'x', 1024);
+    try std.testing.expect(memory.under_pressure());
+    try std.testing.expectEqual(@as(u64, 1), memory.soft_breaches.load(.monotonic));
+
+    // Past the hard quota the allocation fails and nothing is charged
+    const before = memory.usage();
+    try std.testing.expectError(error.OutOfMemory, allocator.alloc(u8, 4096));
+    try std.testing.expectEqual(before, memory.usage());
+
+    allocator.free(small);
+    grown.deinit(allocator);
+    try std.testing.expectEqual(@as(usize, 0), memory.usage());
+
+    var metrics = metrics_export.SessionMetrics{ .session_id = memory.session_id };
+    memory.export_metrics(&metrics);
+    try std.testing.expectEqual(@as(u64, 0), metrics.memory_bytes);
+    try std.testing.expect(metrics.memory_peak_bytes >= 1536);
+    try std.testing.expectEqual(@as(u64, 1), metrics.memory_quota_failures);
+}
+
+test "session memory sheds history and recordings past the soft quota" {
+    const screen = @import("screen.zig");
+    var segments: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer segments.deinit();
+    var scr = try screen.Screen.init(std.testing.allocator, 24, 80);
+    defer scr.deinit();
+
+    var memory = SessionMemory.init(std.testing.allocator, 1, .{
+        .session_memory_soft_bytes = 12 * 1024,
+        .session_memory_hard_bytes = 1024 * 1024,
+    });
+    defer memory.deinit();
+
+    // Keyframes only, so every save holds a full screen
+    var history = screen_history.ScreenHistory.init(memory.allocator(), .{ .keyframe_interval = 1 });
+    defer history.deinit();
+    var recorder = session_recorder.SessionRecorder.init(memory.allocator());
+    defer recorder.deinit();
+    recorder.start();
+    recorder.spill_to(&segments.writer);
+    try memory.add_shedder(.history(&history));
+    try memory.add_shedder(.recorder(&recorder));
+
+    for (0..8) |_| try history.save_snapshot(&scr);
+    const payload = [_]u8{0x40} ** 4096;
+    try recorder.record(.screen_update, &payload);
+    try recorder.record(.screen_update, &payload);
+    try std.testing.expect(memory.under_pressure());
+
+    try std.testing.expect(memory.shed() > 0);
+    try std.testing.expect(memory.usage() <= memory.soft_bytes);
+    try std.testing.expect(!memory.under_pressure());
+    try std.testing.expectEqual(@as(usize, 1), history.count());
+
+    // The recording survives in the flushed segment
+    var reader = try session_recorder.RecordingReader.init(segments.written());
+    var events: usize = 0;
+    while (try reader.next()) |_| events += 1;
+    try std.testing.expectEqual(@as(usize, 2), events);
+}
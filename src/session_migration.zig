@@ -10,10 +10,17 @@
 ///
 /// try migrator.migrate(session_id, "new_host", 23);
 /// ```
+///
+/// Sessions with a warm standby (`attach_standby`) skip the state
+/// transfer: the standby has been following the session's checkpoint
+/// stream, and `restore_from_standby` copies it into the new session.
 const std = @import("std");
 const Allocator = std.mem.Allocator;
 const session_pool = @import("session_pool.zig");
 const session_lifecycle = @import("session_lifecycle.zig");
+const session_snapshot = @import("session_snapshot.zig");
+const screen = @import("screen.zig");
+const field = @import("field.zig");
 
 pub const MigrationStatus = enum {
     pending,
@@ -33,6 +40,8 @@ pub const Migration = struct {
     target_host: []const u8,
     target_port: u16,
     snapshot: session_lifecycle.SessionSnapshot,
+    /// Replica to restore from instead of transferring state
+    standby: ?*session_snapshot.Standby = null,
     status: MigrationStatus,
     error_message: ?[]const u8 = null,
     created_at: i64,
@@ -57,6 +66,8 @@ pub const SessionMigrator = struct {
     lifecycle: *session_lifecycle.LifecycleManager,
     allocator: Allocator,
     migrations: std.StringHashMap(Migration),
+    /// Session id -> warm standby; ids are owned, standbys are not
+    standbys: std.StringHashMap(*session_snapshot.Standby),
     active_migrations: u32 = 0,
     completed_migrations: u32 = 0,
     failed_migrations: u32 = 0,
@@ -72,6 +83,7 @@ pub const SessionMigrator = struct {
             .lifecycle = lifecycle,
             .allocator = allocator,
             .migrations = std.StringHashMap(Migration).init(allocator),
+            .standbys = std.StringHashMap(*session_snapshot.Standby).init(allocator),
         };
     }
 
@@ -81,6 +93,41 @@ pub const SessionMigrator = struct {
             migration.deinit();
         }
         self.migrations.deinit();
+
+        var keys = self.standbys.keyIterator();
+        while (keys.next()) |key| {
+            self.allocator.free(key.*);
+        }
+        self.standbys.deinit();
+    }
+
+    /// Use `standby` for migrations of `session_id`. The standby must be
+    /// fed the session's checkpoints and outlive the migrator.
+    pub fn attach_standby(
+        self: *SessionMigrator,
+        session_id: []const u8,
+        standby: *session_snapshot.Standby,
+    ) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const entry = try self.standbys.getOrPut(session_id);
+        if (!entry.found_existing) {
+            entry.key_ptr.* = self.allocator.dupe(u8, session_id) catch |err| {
+                self.standbys.removeByPtr(entry.key_ptr);
+                return err;
+            };
+        }
+        entry.value_ptr.* = standby;
+    }
+
+    pub fn detach_standby(self: *SessionMigrator, session_id: []const u8) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        if (self.standbys.fetchRemove(session_id)) |entry| {
+            self.allocator.free(entry.key);
+        }
     }
 
     /// Start migration of session to new endpoint
@@ -117,6 +164,7 @@ pub const SessionMigrator = struct {
             .target_host = target_host_copy,
             .target_port = target_port,
             .snapshot = snapshot,
+            .standby = self.standbys.get(session_id),
             .status = .pending,
             .created_at = std.time.milliTimestamp(),
             .allocator = self.allocator,
@@ -166,6 +214,28 @@ pub const SessionMigrator = struct {
         }
     }
 
+    /// Bring the migrated session's screen and fields up to date from its
+    /// standby and return the cursor and keyboard state. Fails with
+    /// `error.NoStandby` when the session had none; the caller then
+    /// transfers state the usual way.
+    pub fn restore_from_standby(
+        self: *SessionMigrator,
+        migration_id: []const u8,
+        scr: *screen.Screen,
+        fields: *field.FieldManager,
+    ) !session_snapshot.State {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const migration = self.migrations.getPtr(migration_id) orelse
+            return error.MigrationNotFound;
+        const standby = migration.standby orelse return error.NoStandby;
+
+        const state = try standby.restore_into(scr, fields);
+        migration.status = .state_restored;
+        return state;
+    }
+
     /// Verify session state consistency after migration
     pub fn verify_state(
         self: *SessionMigrator,
@@ -391,3 +461,40 @@ test "SessionMigrator: fail migration" {
     const s = migrator.stats();
     try testing.expectEqual(s.failed_migrations, 1);
 }
+
+test "SessionMigrator: restore from warm standby" {
+    var pool = session_pool.SessionPool.init(testing.allocator, 10);
+    defer pool.deinit();
+
+    var lifecycle = session_lifecycle.LifecycleManager.init(testing.allocator, &pool);
+    defer lifecycle.deinit();
+
+    var migrator = SessionMigrator.init(testing.allocator, &pool, &lifecycle);
+    defer migrator.deinit();
+
+    const session_id = try pool.create_session("localhost", 23, "user");
+    defer pool.destroy_session(session_id);
+
+    // Source session streams one checkpoint to its standby
+    var source = try screen.Screen.init(testing.allocator, 24, 80);
+    defer source.deinit();
+    _ = source.write_run(0, "MENU");
+    var checkpointer = session_snapshot.Checkpointer.init(testing.allocator);
+    defer checkpointer.deinit();
+    var standby = try session_snapshot.Standby.init(testing.allocator, 24, 80);
+    defer standby.deinit();
+    try standby.apply(try checkpointer.capture(&source, null, .{ .cursor = 4 }));
+    try migrator.attach_standby(session_id, &standby);
+
+    const migration_id = try migrator.migrate(session_id, "newhost", 23);
+    defer testing.allocator.free(migration_id);
+
+    var target = try screen.Screen.init(testing.allocator, 24, 80);
+    defer target.deinit();
+    var fields = field.FieldManager.init(testing.allocator);
+    defer fields.deinit();
+    const state = try migrator.restore_from_standby(migration_id, &target, &fields);
+    try testing.expectEqual(@as(u16, 4), state.cursor);
+    try testing.expectEqualSlices(u8, source.buffer, target.buffer);
+    try testing.expectEqual(migrator.get_migration(migration_id).?.status, .state_restored);
+}
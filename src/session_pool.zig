@@ -15,6 +15,7 @@
 /// try session.connect();
 /// ```
 const std = @import("std");
+const session_reactor = @import("session_reactor.zig");
 const Allocator = std.mem.Allocator;
 
 pub const SessionState = enum {
@@ -41,20 +42,35 @@ pub const ManagedSession = struct {
     created_at: i64,
     last_activity: i64,
     metadata: SessionMetadata,
+    /// Reactor registration when the session's socket is event-driven
+    io: ?session_reactor.SessionHandle = null,
 };
 
 pub const SessionPool = struct {
-    sessions: std.StringHashMap(ManagedSession),
+    /// Session map shards, selected by session-ID hash
+    pub const shard_count = 16;
+
+    const Shard = struct {
+        /// Own cache line per shard so neighbouring locks don't false-share
+        mutex: std.Thread.Mutex align(std.atomic.cache_line) = .{},
+        sessions: std.StringHashMap(ManagedSession),
+    };
+
+    shards: [shard_count]Shard,
     allocator: Allocator,
     max_sessions: u32,
     idle_timeout_ms: u64,
-    next_session_id: u32 = 1,
-    mutex: std.Thread.Mutex = .{},
+    next_session_id: std.atomic.Value(u32) = .init(1),
+    session_count: std.atomic.Value(u32) = .init(0),
 
     /// Initialize session pool with given capacity and timeout
     pub fn init(allocator: Allocator, max_sessions: u32) SessionPool {
+        var shards: [shard_count]Shard = undefined;
+        for (&shards) |*shard| {
+            shard.* = .{ .sessions = std.StringHashMap(ManagedSession).init(allocator) };
+        }
         return .{
-            .sessions = std.StringHashMap(ManagedSession).init(allocator),
+            .shards = shards,
             .allocator = allocator,
             .max_sessions = max_sessions,
             .idle_timeout_ms = 5 * 60 * 1000, // 5 minutes default
@@ -63,11 +79,26 @@ pub const SessionPool = struct {
 
     /// Deinitialize pool and cleanup all sessions
     pub fn deinit(self: *SessionPool) void {
-        var iter = self.sessions.keyIterator();
-        while (iter.next()) |key| {
-            self.allocator.free(key.*);
+        for (&self.shards) |*shard| {
+            var iter = shard.sessions.valueIterator();
+            while (iter.next()) |session| {
+                self.free_session(session.*);
+            }
+            shard.sessions.deinit();
+        }
+    }
+
+    fn shard_for(self: *SessionPool, session_id: []const u8) *Shard {
+        const hash = std.hash.Wyhash.hash(0, session_id);
+        return &self.shards[@intCast(hash % shard_count)];
+    }
+
+    fn free_session(self: *SessionPool, session: ManagedSession) void {
+        self.allocator.free(session.id);
+        self.allocator.free(session.metadata.host);
+        if (session.metadata.user) |user| {
+            self.allocator.free(user);
         }
-        self.sessions.deinit();
     }
 
     /// Create new session with metadata
@@ -78,24 +109,26 @@ pub const SessionPool = struct {
         port: u16,
         user: ?[]const u8,
     ) ![]const u8 {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        if (self.sessions.count() >= self.max_sessions) {
+        // Reserve a slot without any lock; give it back on failure
+        if (self.session_count.fetchAdd(1, .monotonic) >= self.max_sessions) {
+            _ = self.session_count.fetchSub(1, .monotonic);
             return error.PoolFull;
         }
+        errdefer _ = self.session_count.fetchSub(1, .monotonic);
 
         // Generate session ID
         const session_id = try std.fmt.allocPrint(
             self.allocator,
             "sess-{d:0>6}",
-            .{self.next_session_id},
+            .{self.next_session_id.fetchAdd(1, .monotonic)},
         );
-        self.next_session_id += 1;
+        errdefer self.allocator.free(session_id);
 
         // Copy metadata strings
         const host_copy = try self.allocator.dupe(u8, host);
+        errdefer self.allocator.free(host_copy);
         const user_copy = if (user) |u| try self.allocator.dupe(u8, u) else null;
+        errdefer if (user_copy) |u| self.allocator.free(u);
 
         const now = std.time.milliTimestamp();
         const session = ManagedSession{
@@ -111,16 +144,21 @@ pub const SessionPool = struct {
             },
         };
 
-        try self.sessions.put(session_id, session);
+        const shard = self.shard_for(session_id);
+        shard.mutex.lock();
+        defer shard.mutex.unlock();
+
+        try shard.sessions.put(session_id, session);
         return session_id;
     }
 
     /// Get session by ID
     pub fn get_session(self: *SessionPool, session_id: []const u8) ?ManagedSession {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        const shard = self.shard_for(session_id);
+        shard.mutex.lock();
+        defer shard.mutex.unlock();
 
-        return self.sessions.get(session_id);
+        return shard.sessions.get(session_id);
     }
 
     /// Update session state
@@ -129,10 +167,11 @@ pub const SessionPool = struct {
         session_id: []const u8,
         state: SessionState,
     ) !void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        const shard = self.shard_for(session_id);
+        shard.mutex.lock();
+        defer shard.mutex.unlock();
 
-        if (self.sessions.getPtr(session_id)) |session| {
+        if (shard.sessions.getPtr(session_id)) |session| {
             session.state = state;
             session.last_activity = std.time.milliTimestamp();
         } else {
@@ -142,22 +181,62 @@ pub const SessionPool = struct {
 
     /// Record activity to update last_activity timestamp
     pub fn record_activity(self: *SessionPool, session_id: []const u8) !void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        const shard = self.shard_for(session_id);
+        shard.mutex.lock();
+        defer shard.mutex.unlock();
 
-        if (self.sessions.getPtr(session_id)) |session| {
+        if (shard.sessions.getPtr(session_id)) |session| {
             session.last_activity = std.time.milliTimestamp();
         } else {
             return error.SessionNotFound;
         }
     }
 
+    /// Point a session at a different endpoint (e.g. after failover)
+    pub fn set_endpoint(
+        self: *SessionPool,
+        session_id: []const u8,
+        host: []const u8,
+        port: u16,
+    ) !void {
+        const shard = self.shard_for(session_id);
+        shard.mutex.lock();
+        defer shard.mutex.unlock();
+
+        if (shard.sessions.getPtr(session_id)) |session| {
+            const host_copy = try self.allocator.dupe(u8, host);
+            self.allocator.free(session.metadata.host);
+            session.metadata.host = host_copy;
+            session.metadata.port = port;
+        } else {
+            return error.SessionNotFound;
+        }
+    }
+
+    /// Record the reactor handle serving a session's socket
+    pub fn bind_io(
+        self: *SessionPool,
+        session_id: []const u8,
+        handle: ?session_reactor.SessionHandle,
+    ) !void {
+        const shard = self.shard_for(session_id);
+        shard.mutex.lock();
+        defer shard.mutex.unlock();
+
+        if (shard.sessions.getPtr(session_id)) |session| {
+            session.io = handle;
+        } else {
+            return error.SessionNotFound;
+        }
+    }
+
     /// Increment connection count for session
     pub fn increment_connection_count(self: *SessionPool, session_id: []const u8) !void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        const shard = self.shard_for(session_id);
+        shard.mutex.lock();
+        defer shard.mutex.unlock();
 
-        if (self.sessions.getPtr(session_id)) |session| {
+        if (shard.sessions.getPtr(session_id)) |session| {
             session.metadata.connection_count += 1;
         } else {
             return error.SessionNotFound;
@@ -166,80 +245,85 @@ pub const SessionPool = struct {
 
     /// Destroy session and free resources
     pub fn destroy_session(self: *SessionPool, session_id: []const u8) void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        if (self.sessions.fetchRemove(session_id)) |entry| {
-            self.allocator.free(entry.key);
-            self.allocator.free(entry.value.metadata.host);
-            if (entry.value.metadata.user) |user| {
-                self.allocator.free(user);
-            }
+        const shard = self.shard_for(session_id);
+        shard.mutex.lock();
+        defer shard.mutex.unlock();
+
+        if (shard.sessions.fetchRemove(session_id)) |entry| {
+            self.free_session(entry.value);
+            _ = self.session_count.fetchSub(1, .monotonic);
         }
     }
 
     /// Count active sessions
     pub fn count(self: *SessionPool) u32 {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-        return @intCast(self.sessions.count());
+        return self.session_count.load(.monotonic);
     }
 
     /// Get sessions with specific state
+    /// Shards are visited one at a time, so the result is not a snapshot.
     pub fn get_sessions_by_state(
         self: *SessionPool,
         state: SessionState,
         allocator: Allocator,
     ) ![][]const u8 {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        var result = std.ArrayList([]const u8).init(allocator);
-
-        var iter = self.sessions.valueIterator();
-        while (iter.next()) |session| {
-            if (session.state == state) {
-                try result.append(session.id);
+        var result: std.ArrayList([]const u8) = .empty;
+        errdefer result.deinit(allocator);
+
+        for (&self.shards) |*shard| {
+            shard.mutex.lock();
+            defer shard.mutex.unlock();
+
+            var iter = shard.sessions.valueIterator();
+            while (iter.next()) |session| {
+                if (session.state == state) {
+                    try result.append(allocator, session.id);
+                }
             }
         }
 
-        return result.toOwnedSlice();
+        return result.toOwnedSlice(allocator);
     }
 
     /// Get all session IDs
     pub fn all_sessions(self: *SessionPool, allocator: Allocator) ![][]const u8 {
-        self.mutex.lock();
-        defer self.mutex.unlock();
+        var result: std.ArrayList([]const u8) = .empty;
+        errdefer result.deinit(allocator);
 
-        var result = std.ArrayList([]const u8).init(allocator);
+        for (&self.shards) |*shard| {
+            shard.mutex.lock();
+            defer shard.mutex.unlock();
 
-        var iter = self.sessions.keyIterator();
-        while (iter.next()) |key| {
-            try result.append(key.*);
+            var iter = shard.sessions.keyIterator();
+            while (iter.next()) |key| {
+                try result.append(allocator, key.*);
+            }
         }
 
-        return result.toOwnedSlice();
+        return result.toOwnedSlice(allocator);
     }
 
     /// Pool statistics
+    /// Relaxed aggregate: each shard is locked only while it is counted.
     pub fn stats(self: *SessionPool) PoolStats {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-
-        var stats_result = PoolStats{
-            .total_sessions = @intCast(self.sessions.count()),
-        };
-
-        var iter = self.sessions.valueIterator();
-        while (iter.next()) |session| {
-            switch (session.state) {
-                .initializing => stats_result.initializing_count += 1,
-                .connected => stats_result.connected_count += 1,
-                .active => stats_result.active_count += 1,
-                .idle => stats_result.idle_count += 1,
-                .suspended => stats_result.suspended_count += 1,
-                .closed => stats_result.closed_count += 1,
-                .error_state => stats_result.error_count += 1,
+        var stats_result = PoolStats{};
+
+        for (&self.shards) |*shard| {
+            shard.mutex.lock();
+            defer shard.mutex.unlock();
+
+            stats_result.total_sessions += @intCast(shard.sessions.count());
+            var iter = shard.sessions.valueIterator();
+            while (iter.next()) |session| {
+                switch (session.state) {
+                    .initializing => stats_result.initializing_count += 1,
+                    .connected => stats_result.connected_count += 1,
+                    .active => stats_result.active_count += 1,
+                    .idle => stats_result.idle_count += 1,
+                    .suspended => stats_result.suspended_count += 1,
+                    .closed => stats_result.closed_count += 1,
+                    .error_state => stats_result.error_count += 1,
+                }
             }
         }
 
@@ -368,3 +452,27 @@ test "SessionPool: stats" {
     try testing.expectEqual(s.active_count, 1);
     try testing.expectEqual(s.idle_count, 1);
 }
+
+test "SessionPool: concurrent create and destroy across shards" {
+    var pool = SessionPool.init(testing.allocator, 1000);
+    defer pool.deinit();
+
+    const Worker = struct {
+        fn run(p: *SessionPool) void {
+            for (0..100) |_| {
+                const id = p.create_session("host", 23, null) catch return;
+                p.record_activity(id) catch {};
+                p.set_state(id, .active) catch {};
+                p.destroy_session(id);
+            }
+            _ = p.create_session("host", 23, "kept") catch {};
+        }
+    };
+
+    var threads: [4]std.Thread = undefined;
+    for (&threads) |*thread| thread.* = try std.Thread.spawn(.{}, Worker.run, .{&pool});
+    for (threads) |thread| thread.join();
+
+    try testing.expectEqual(@as(u32, 4), pool.count());
+    try testing.expectEqual(@as(u32, 4), pool.stats().total_sessions);
+}
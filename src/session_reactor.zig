@@ -0,0 +1,836 @@
+//! Event-driven I/O reactor for many concurrent TN3270 sessions.
+//!
+//! Each `Reactor` owns a set of non-blocking sockets, waits on them with
+//! epoll (Linux) or kqueue (macOS/BSD) and enforces read, write and idle
+//! timeouts with a hashed timer wheel, so a stuck host never blocks the
+//! caller. `ReactorGroup` runs one reactor per core and spreads sessions
+//! across them; a single process can then hold 10k+ sessions, subject to
+//! the file-descriptor limit.
+//!
+//! Usage:
+//! ```zig
+//! var group = try ReactorGroup.init(allocator, null, .{});
+//! defer group.deinit();
+//! try group.start();
+//! try group.submit_client(&client, handler);
+//! ```
+const std = @import("std");
+const builtin = @import("builtin");
+const client = @import("client.zig");
+const buffer_pool = @import("buffer_pool.zig");
+
+const posix = std.posix;
+const Allocator = std.mem.Allocator;
+
+/// Events collected per wait call
+pub const max_poll_events = 256;
+
+/// Readiness a session wants to be woken for
+pub const Interest = struct {
+    read: bool = true,
+    write: bool = false,
+};
+
+pub const TimeoutKind = enum(u2) {
+    read,
+    write,
+    idle,
+};
+
+/// Stable reference to a registered session; stale handles are ignored
+pub const SessionHandle = struct {
+    index: u32,
+    generation: u32,
+
+    fn token(self: SessionHandle) u64 {
+        return (@as(u64, self.generation) << 32) | self.index;
+    }
+
+    fn from_token(value: u64) SessionHandle {
+        return .{ .index = @truncate(value), .generation = @truncate(value >> 32) };
+    }
+};
+
+/// Session callbacks, invoked on the owning reactor's thread
+pub const Handler = struct {
+    context: *anyopaque,
+    on_readable: *const fn (context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void,
+    on_writable: ?*const fn (context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void = null,
+    on_timeout: ?*const fn (context: *anyopaque, reactor: *Reactor, handle: SessionHandle, kind: TimeoutKind) void = null,
+    on_hangup: ?*const fn (context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void = null,
+    /// Called once a session submitted from another thread is registered
+    on_open: ?*const fn (context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void = null,
+    /// Called after another thread asked for it with `Reactor.notify`
+    on_notify: ?*const fn (context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void = null,
+};
+
+/// Readiness reported by the platform poller
+pub const PollEvent = struct {
+    token: u64,
+    readable: bool = false,
+    writable: bool = false,
+    hangup: bool = false,
+};
+
+/// Platform readiness backend
+pub const Poller = switch (builtin.os.tag) {
+    .linux => EpollPoller,
+    .macos, .ios, .tvos, .watchos, .freebsd, .netbsd, .openbsd, .dragonfly => KqueuePoller,
+    else => @compileError("session_reactor requires epoll or kqueue"),
+};
+
+const EpollPoller = struct {
+    const linux = std.os.linux;
+
+    fd: posix.fd_t,
+
+    pub fn init() !EpollPoller {
+        return .{ .fd = try posix.epoll_create1(linux.EPOLL.CLOEXEC) };
+    }
+
+    pub fn deinit(self: *EpollPoller) void {
+        posix.close(self.fd);
+    }
+
+    fn event_mask(interest: Interest) u32 {
+        var mask: u32 = linux.EPOLL.RDHUP;
+        if (interest.read) mask |= linux.EPOLL.IN;
+        if (interest.write) mask |= linux.EPOLL.OUT;
+        return mask;
+    }
+
+    pub fn add(self: *EpollPoller, fd: posix.fd_t, token: u64, interest: Interest) !void {
+        var event = linux.epoll_event{ .events = event_mask(interest), .data = .{ .u64 = token } };
+        try posix.epoll_ctl(self.fd, linux.EPOLL.CTL_ADD, fd, &event);
+    }
+
+    pub fn modify(self: *EpollPoller, fd: posix.fd_t, token: u64, interest: Interest) !void {
+        var event = linux.epoll_event{ .events = event_mask(interest), .data = .{ .u64 = token } };
+        try posix.epoll_ctl(self.fd, linux.EPOLL.CTL_MOD, fd, &event);
+    }
+
+    pub fn remove(self: *EpollPoller, fd: posix.fd_t) void {
+        posix.epoll_ctl(self.fd, linux.EPOLL.CTL_DEL, fd, null) catch {};
+    }
+
+    pub fn wait(self: *EpollPoller, out: []PollEvent, timeout_ms: i32) !usize {
+        var raw: [max_poll_events]linux.epoll_event = undefined;
+        const count = posix.epoll_wait(self.fd, raw[0..@min(out.len, raw.len)], timeout_ms);
+        for (raw[0..count], out[0..count]) |event, *result| {
+            const hangup_mask = linux.EPOLL.HUP | linux.EPOLL.ERR | linux.EPOLL.RDHUP;
+            result.* = .{
+                .token = event.data.u64,
+                .readable = event.events & linux.EPOLL.IN != 0,
+                .writable = event.events & linux.EPOLL.OUT != 0,
+                .hangup = event.events & hangup_mask != 0,
+            };
+        }
+        return count;
+    }
+};
+
+const KqueuePoller = struct {
+    fd: posix.fd_t,
+
+    pub fn init() !KqueuePoller {
+        return .{ .fd = try posix.kqueue() };
+    }
+
+    pub fn deinit(self: *KqueuePoller) void {
+        posix.close(self.fd);
+    }
+
+    fn change(fd: posix.fd_t, token: u64, filter: i16, enabled: bool) posix.Kevent {
+        return .{
+            .ident = @intCast(fd),
+            .filter = filter,
+            .flags = std.c.EV.ADD | (if (enabled) std.c.EV.ENABLE else std.c.EV.DISABLE),
+            .fflags = 0,
+            .data = 0,
+            .udata = @intCast(token),
+        };
+    }
+
+    pub fn add(self: *KqueuePoller, fd: posix.fd_t, token: u64, interest: Interest) !void {
+        // Both filters are always registered; interest only toggles them
+        const changes = [_]posix.Kevent{
+            change(fd, token, std.c.EVFILT.READ, interest.read),
+            change(fd, token, std.c.EVFILT.WRITE, interest.write),
+        };
+        _ = try posix.kevent(self.fd, &changes, &.{}, null);
+    }
+
+    pub fn modify(self: *KqueuePoller, fd: posix.fd_t, token: u64, interest: Interest) !void {
+        try self.add(fd, token, interest);
+    }
+
+    pub fn remove(self: *KqueuePoller, fd: posix.fd_t) void {
+        var changes = [_]posix.Kevent{
+            change(fd, 0, std.c.EVFILT.READ, false),
+            change(fd, 0, std.c.EVFILT.WRITE, false),
+        };
+        for (&changes) |*entry| entry.flags = std.c.EV.DELETE;
+        _ = posix.kevent(self.fd, &changes, &.{}, null) catch {};
+    }
+
+    pub fn wait(self: *KqueuePoller, out: []PollEvent, timeout_ms: i32) !usize {
+        var raw: [max_poll_events]posix.Kevent = undefined;
+        const timeout: posix.timespec = .{
+            .sec = @divTrunc(timeout_ms, 1000),
+            .nsec = @rem(timeout_ms, 1000) * std.time.ns_per_ms,
+        };
+        const count = try posix.kevent(
+            self.fd,
+            &.{},
+            raw[0..@min(out.len, raw.len)],
+            if (timeout_ms < 0) null else &timeout,
+        );
+        for (raw[0..count], out[0..count]) |event, *result| {
+            result.* = .{
+                .token = @intCast(event.udata),
+                .readable = event.filter == std.c.EVFILT.READ,
+                .writable = event.filter == std.c.EVFILT.WRITE,
+                .hangup = event.flags & std.c.EV.EOF != 0,
+            };
+        }
+        return count;
+    }
+};
+
+/// Hashed timer wheel keyed by session index; O(1) schedule and cancel
+pub const TimerWheel = struct {
+    pub const slot_count = 512;
+    const none = std.math.maxInt(u32);
+
+    const Node = struct {
+        next: u32 = none,
+        prev: u32 = none,
+        expires_tick: u64 = 0,
+        armed: bool = false,
+    };
+
+    allocator: Allocator,
+    tick_ms: u32,
+    current_tick: u64,
+    heads: [slot_count]u32 = [_]u32{none} ** slot_count,
+    nodes: std.ArrayList(Node) = .empty,
+    armed_count: usize = 0,
+
+    pub fn init(allocator: Allocator, tick_ms: u32, now_ms: i64) TimerWheel {
+        return .{
+            .allocator = allocator,
+            .tick_ms = tick_ms,
+            .current_tick = tick_of(tick_ms, now_ms),
+        };
+    }
+
+    pub fn deinit(self: *TimerWheel) void {
+        self.nodes.deinit(self.allocator);
+    }
+
+    fn tick_of(tick_ms: u32, ms: i64) u64 {
+        return @intCast(@divFloor(@max(ms, 0), tick_ms));
+    }
+
+    /// Arm (or re-arm) the timer for `index` to fire at `deadline_ms`
+    pub fn schedule(self: *TimerWheel, index: u32, deadline_ms: i64) !void {
+        while (self.nodes.items.len <= index) {
+            try self.nodes.append(self.allocator, .{});
+        }
+        self.cancel(index);
+
+        // Round up so a timer never fires early
+        const deadline_tick: u64 = @intCast(@divFloor(@max(deadline_ms, 0) + self.tick_ms - 1, self.tick_ms));
+        const expires = @max(deadline_tick, self.current_tick + 1);
+        const slot: usize = @intCast(expires % slot_count);
+
+        const node = &self.nodes.items[index];
+        node.* = .{ .next = self.heads[slot], .expires_tick = expires, .armed = true };
+        if (node.next != none) self.nodes.items[node.next].prev = index;
+        self.heads[slot] = index;
+        self.armed_count += 1;
+    }
+
+    /// Disarm the timer for `index`; no-op when not armed
+    pub fn cancel(self: *TimerWheel, index: u32) void {
+        if (index >= self.nodes.items.len) return;
+        const node = &self.nodes.items[index];
+        if (!node.armed) return;
+
+        if (node.prev != none) {
+            self.nodes.items[node.prev].next = node.next;
+        } else {
+            self.heads[@intCast(node.expires_tick % slot_count)] = node.next;
+        }
+        if (node.next != none) self.nodes.items[node.next].prev = node.prev;
+        node.* = .{};
+        self.armed_count -= 1;
+    }
+
+    /// Move time forward, appending the index of every expired timer
+    pub fn advance(self: *TimerWheel, now_ms: i64, expired: *std.ArrayList(u32)) !void {
+        const target = tick_of(self.tick_ms, now_ms);
+        if (target <= self.current_tick) return;
+
+        // After a full revolution every slot has been visited once
+        const steps = @min(target - self.current_tick, slot_count);
+        var step: u64 = 1;
+        while (step <= steps) : (step += 1) {
+            const slot: usize = @intCast((self.current_tick + step) % slot_count);
+            var index = self.heads[slot];
+            while (index != none) {
+                const node = self.nodes.items[index];
+                if (node.expires_tick <= target) {
+                    self.cancel(index);
+                    try expired.append(self.allocator, index);
+                }
+                index = node.next;
+            }
+        }
+        self.current_tick = target;
+    }
+};
+
+/// Single-threaded reactor owning a set of sessions
+pub const Reactor = struct {
+    pub const Options = struct {
+        /// Time allowed for a response after `expect_read`; 0 disables
+        read_timeout_ms: u32 = 10000,
+        /// Time allowed for a socket to become writable after `want_write`; 0 disables
+        write_timeout_ms: u32 = 5000,
+        /// Time without any readiness before `on_timeout(.idle)`; 0 disables
+        idle_timeout_ms: u32 = 5 * 60 * 1000,
+        /// Timer wheel resolution
+        tick_ms: u32 = 50,
+    };
+
+    const wake_token = std.math.maxInt(u64);
+
+    const Slot = struct {
+        fd: posix.fd_t = -1,
+        generation: u32 = 0,
+        in_use: bool = false,
+        interest: Interest = .{},
+        handler: Handler = undefined,
+        /// Absolute deadlines per TimeoutKind; 0 when disarmed
+        deadlines: [3]i64 = .{ 0, 0, 0 },
+    };
+
+    const Submission = struct {
+        fd: posix.fd_t,
+        handler: Handler,
+    };
+
+    allocator: Allocator,
+    options: Options,
+    poller: Poller,
+    slots: std.ArrayList(Slot) = .empty,
+    free_slots: std.ArrayList(u32) = .empty,
+    timers: TimerWheel,
+    expired: std.ArrayList(u32) = .empty,
+    wake_pipe: [2]posix.fd_t,
+    submit_mutex: std.Thread.Mutex = .{},
+    submissions: std.ArrayList(Submission) = .empty,
+    notifications: std.ArrayList(SessionHandle) = .empty,
+    active_count: usize = 0,
+
+    pub fn init(allocator: Allocator, options: Options) !Reactor {
+        var poller = try Poller.init();
+        errdefer poller.deinit();
+
+        const wake_pipe = try posix.pipe2(.{ .NONBLOCK = true, .CLOEXEC = true });
+        errdefer for (wake_pipe) |fd| posix.close(fd);
+        try poller.add(wake_pipe[0], wake_token, .{});
+
+        return .{
+            .allocator = allocator,
+            .options = options,
+            .poller = poller,
+            .timers = TimerWheel.init(allocator, @max(options.tick_ms, 1), std.time.milliTimestamp()),
+            .wake_pipe = wake_pipe,
+        };
+    }
+
+    /// Release reactor resources; registered sockets are not closed
+    pub fn deinit(self: *Reactor) void {
+        self.poller.deinit();
+        for (self.wake_pipe) |fd| posix.close(fd);
+        self.slots.deinit(self.allocator);
+        self.free_slots.deinit(self.allocator);
+        self.timers.deinit();
+        self.expired.deinit(self.allocator);
+        self.submissions.deinit(self.allocator);
+        self.notifications.deinit(self.allocator);
+    }
+
+    /// Register a non-blocking socket on the reactor's own thread
+    pub fn register(self: *Reactor, fd: posix.fd_t, handler: Handler) !SessionHandle {
+        const index: u32 = if (self.free_slots.pop()) |free| free else blk: {
+            try self.slots.append(self.allocator, .{});
+            break :blk @intCast(self.slots.items.len - 1);
+        };
+        errdefer self.free_slots.append(self.allocator, index) catch {};
+
+        const slot = &self.slots.items[index];
+        const generation = slot.generation;
+        slot.* = .{ .fd = fd, .generation = generation, .in_use = true, .handler = handler };
+        errdefer slot.in_use = false;
+        const handle = SessionHandle{ .index = index, .generation = generation };
+
+        try self.poller.add(fd, handle.token(), slot.interest);
+        errdefer self.poller.remove(fd);
+
+        if (self.options.idle_timeout_ms != 0) {
+            try self.arm(index, .idle, self.options.idle_timeout_ms);
+        }
+        self.active_count += 1;
+        return handle;
+    }
+
+    /// Hand a socket to this reactor from any thread; it is registered on
+    /// the next loop iteration and announced through `Handler.on_open`.
+    pub fn submit(self: *Reactor, fd: posix.fd_t, handler: Handler) !void {
+        {
+            self.submit_mutex.lock();
+            defer self.submit_mutex.unlock();
+            try self.submissions.append(self.allocator, .{ .fd = fd, .handler = handler });
+        }
+        self.wake();
+    }
+
+    /// Run `Handler.on_notify` for `handle` on the reactor's thread; safe to
+    /// call from any thread. Handles closed in the meantime are skipped.
+    pub fn notify(self: *Reactor, handle: SessionHandle) !void {
+        {
+            self.submit_mutex.lock();
+            defer self.submit_mutex.unlock();
+            try self.notifications.append(self.allocator, handle);
+        }
+        self.wake();
+    }
+
+    /// Interrupt a blocking `poll_once` from any thread
+    pub fn wake(self: *Reactor) void {
+        // A full pipe already guarantees a pending wakeup
+        _ = posix.write(self.wake_pipe[1], &[_]u8{1}) catch {};
+    }
+
+    /// Unregister a session; the socket itself stays open
+    pub fn remove(self: *Reactor, handle: SessionHandle) void {
+        const slot = self.slot_for(handle) orelse return;
+        self.poller.remove(slot.fd);
+        self.timers.cancel(handle.index);
+        slot.in_use = false;
+        slot.generation +%= 1;
+        self.active_count -= 1;
+        self.free_slots.append(self.allocator, handle.index) catch {};
+    }
+
+    /// Socket behind a live handle
+    pub fn fd_of(self: *Reactor, handle: SessionHandle) ?posix.fd_t {
+        const slot = self.slot_for(handle) orelse return null;
+        return slot.fd;
+    }
+
+    /// Arm the read timeout, e.g. after sending a request that expects a reply
+    pub fn expect_read(self: *Reactor, handle: SessionHandle) !void {
+        if (self.slot_for(handle) == null or self.options.read_timeout_ms == 0) return;
+        try self.arm(handle.index, .read, self.options.read_timeout_ms);
+    }
+
+    /// Toggle write interest; while enabled the write timeout is armed
+    pub fn want_write(self: *Reactor, handle: SessionHandle, enabled: bool) !void {
+        const slot = self.slot_for(handle) orelse return error.SessionNotFound;
+        if (slot.interest.write != enabled) {
+            slot.interest.write = enabled;
+            try self.poller.modify(slot.fd, handle.token(), slot.interest);
+        }
+        if (enabled and self.options.write_timeout_ms != 0) {
+            try self.arm(handle.index, .write, self.options.write_timeout_ms);
+        } else {
+            try self.disarm(handle.index, .write);
+        }
+    }
+
+    /// Wait for readiness up to `timeout_ms` (negative waits indefinitely),
+    /// dispatch callbacks and fire due timers. Returns the events handled.
+    pub fn poll_once(self: *Reactor, timeout_ms: i32) !usize {
+        var wait_ms = timeout_ms;
+        if (self.timers.armed_count > 0) {
+            const tick: i32 = @intCast(self.timers.tick_ms);
+            wait_ms = if (wait_ms < 0) tick else @min(wait_ms, tick);
+        }
+
+        var events: [max_poll_events]PollEvent = undefined;
+        const count = try self.poller.wait(&events, wait_ms);
+        for (events[0..count]) |event| {
+            if (event.token == wake_token) {
+                try self.drain_submissions();
+            } else {
+                self.dispatch(event);
+            }
+        }
+
+        try self.fire_timers(std.time.milliTimestamp());
+        return count;
+    }
+
+    /// Run until `stop` is set. A thread that runs a reactor outside a
+    /// `ReactorGroup` calls `SharedBufferPool.releaseThreadCache` before
+    /// it exits.
+    pub fn run(self: *Reactor, stop: *const std.atomic.Value(bool)) !void {
+        while (!stop.load(.acquire)) {
+            _ = try self.poll_once(-1);
+        }
+    }
+
+    fn slot_for(self: *Reactor, handle: SessionHandle) ?*Slot {
+        if (handle.index >= self.slots.items.len) return null;
+        const slot = &self.slots.items[handle.index];
+        if (!slot.in_use or slot.generation != handle.generation) return null;
+        return slot;
+    }
+
+    fn arm(self: *Reactor, index: u32, kind: TimeoutKind, timeout_ms: u32) !void {
+        self.slots.items[index].deadlines[@intFromEnum(kind)] = std.time.milliTimestamp() + timeout_ms;
+        try self.reschedule(index);
+    }
+
+    fn disarm(self: *Reactor, index: u32, kind: TimeoutKind) !void {
+        const deadline = &self.slots.items[index].deadlines[@intFromEnum(kind)];
+        if (deadline.* == 0) return;
+        deadline.* = 0;
+        try self.reschedule(index);
+    }
+
+    /// Keep one wheel entry per session, at its earliest deadline
+    fn reschedule(self: *Reactor, index: u32) !void {
+        var earliest: i64 = 0;
+        for (self.slots.items[index].deadlines) |deadline| {
+            if (deadline != 0 and (earliest == 0 or deadline < earliest)) earliest = deadline;
+        }
+        if (earliest == 0) {
+            self.timers.cancel(index);
+        } else {
+            try self.timers.schedule(index, earliest);
+        }
+    }
+
+    fn drain_submissions(self: *Reactor) !void {
+        var scratch: [64]u8 = undefined;
+        while (true) {
+            _ = posix.read(self.wake_pipe[0], &scratch) catch break;
+        }
+
+        var pending: std.ArrayList(Submission) = .empty;
+        var notified: std.ArrayList(SessionHandle) = .empty;
+        {
+            self.submit_mutex.lock();
+            defer self.submit_mutex.unlock();
+            std.mem.swap(std.ArrayList(Submission), &pending, &self.submissions);
+            std.mem.swap(std.ArrayList(SessionHandle), &notified, &self.notifications);
+        }
+        defer pending.deinit(self.allocator);
+        defer notified.deinit(self.allocator);
+
+        for (pending.items) |submission| {
+            const handle = self.register(submission.fd, submission.handler) catch |err| {
+                std.log.warn("session_reactor: dropping fd {d}: {s}", .{ submission.fd, @errorName(err) });
+                continue;
+            };
+            if (submission.handler.on_open) |on_open| on_open(submission.handler.context, self, handle);
+        }
+
+        for (notified.items) |handle| {
+            const slot = self.slot_for(handle) orelse continue;
+            if (slot.handler.on_notify) |on_notify| on_notify(slot.handler.context, self, handle);
+        }
+    }
+
+    fn dispatch(self: *Reactor, event: PollEvent) void {
+        const handle = SessionHandle.from_token(event.token);
+        const index = handle.index;
+
+        // Any readiness counts as activity
+        if (self.slot_for(handle) == null) return;
+        if (self.options.idle_timeout_ms != 0) {
+            self.arm(index, .idle, self.options.idle_timeout_ms) catch {};
+        }
+
+        if (event.readable) {
+            const slot = self.slot_for(handle) orelse return;
+            self.disarm(index, .read) catch {};
+            slot.handler.on_readable(slot.handler.context, self, handle);
+        }
+        if (event.writable) {
+            const slot = self.slot_for(handle) orelse return;
+            self.disarm(index, .write) catch {};
+            if (slot.handler.on_writable) |on_writable| on_writable(slot.handler.context, self, handle);
+        }
+        if (event.hangup and !event.readable) {
+            const slot = self.slot_for(handle) orelse return;
+            if (slot.handler.on_hangup) |on_hangup| on_hangup(slot.handler.context, self, handle);
+        }
+    }
+
+    fn fire_timers(self: *Reactor, now_ms: i64) !void {
+        self.expired.clearRetainingCapacity();
+        try self.timers.advance(now_ms, &self.expired);
+
+        for (self.expired.items) |index| {
+            const slot = &self.slots.items[index];
+            if (!slot.in_use) continue;
+            const handle = SessionHandle{ .index = index, .generation = slot.generation };
+
+            for (std.enums.values(TimeoutKind)) |kind| {
+                const current = self.slot_for(handle) orelse break;
+                const deadline = &current.deadlines[@intFromEnum(kind)];
+                if (deadline.* == 0 or deadline.* > now_ms) continue;
+
+                deadline.* = 0;
+                if (current.handler.on_timeout) |on_timeout| on_timeout(current.handler.context, self, handle, kind);
+            }
+
+            if (self.slot_for(handle) != null) try self.reschedule(index);
+        }
+    }
+};
+
+/// One reactor thread per core, with sessions assigned round-robin
+pub const ReactorGroup = struct {
+    allocator: Allocator,
+    reactors: []Reactor,
+    threads: []std.Thread = &.{},
+    stop: std.atomic.Value(bool) = .init(false),
+    next_reactor: std.atomic.Value(usize) = .init(0),
+
+    /// Create `thread_count` reactors (null uses the CPU count)
+    pub fn init(allocator: Allocator, thread_count: ?usize, options: Reactor.Options) !ReactorGroup {
+        const count = @max(thread_count orelse (std.Thread.getCpuCount() catch 1), 1);
+        const reactors = try allocator.alloc(Reactor, count);
+        errdefer allocator.free(reactors);
+
+        var initialized: usize = 0;
+        errdefer for (reactors[0..initialized]) |*reactor| reactor.deinit();
+        while (initialized < count) : (initialized += 1) {
+            reactors[initialized] = try Reactor.init(allocator, options);
+        }
+
+        return .{ .allocator = allocator, .reactors = reactors };
+    }
+
+    /// Stop threads (if running) and release all reactors
+    pub fn deinit(self: *ReactorGroup) void {
+        self.shutdown();
+        for (self.reactors) |*reactor| reactor.deinit();
+        self.allocator.free(self.reactors);
+    }
+
+    /// Spawn one thread per reactor; the group must not move afterwards
+    pub fn start(self: *ReactorGroup) !void {
+        if (self.threads.len != 0) return error.AlreadyStarted;
+        self.stop.store(false, .release);
+
+        const threads = try self.allocator.alloc(std.Thread, self.reactors.len);
+        var spawned: usize = 0;
+        errdefer {
+            self.stop.store(true, .release);
+            for (self.reactors[0..spawned], threads[0..spawned]) |*reactor, thread| {
+                reactor.wake();
+                thread.join();
+            }
+            self.allocator.free(threads);
+        }
+        while (spawned < threads.len) : (spawned += 1) {
+            threads[spawned] = try std.Thread.spawn(.{}, run_reactor, .{ &self.reactors[spawned], &self.stop });
+        }
+        self.threads = threads;
+    }
+
+    /// Signal every reactor to stop and join their threads
+    pub fn shutdown(self: *ReactorGroup) void {
+        if (self.threads.len == 0) return;
+        self.stop.store(true, .release);
+        for (self.reactors) |*reactor| reactor.wake();
+        for (self.threads) |thread| thread.join();
+        self.allocator.free(self.threads);
+        self.threads = &.{};
+    }
+
+    /// Hand a non-blocking socket to the next reactor
+    pub fn submit(self: *ReactorGroup, fd: posix.fd_t, handler: Handler) !void {
+        const index = self.next_reactor.fetchAdd(1, .monotonic) % self.reactors.len;
+        try self.reactors[index].submit(fd, handler);
+    }
+
+    /// Switch a connected client to non-blocking mode and submit its socket
+    pub fn submit_client(self: *ReactorGroup, tn_client: *client.Client, handler: Handler) !void {
+        const fd = tn_client.socket_fd() orelse return error.NotConnected;
+        try tn_client.set_nonblocking(true);
+        try self.submit(fd, handler);
+    }
+
+    fn run_reactor(reactor: *Reactor, stop: *const std.atomic.Value(bool)) void {
+        // The thread's sessions share its buffer magazines; they go back
+        // to the pool once, as the thread exits
+        defer if (buffer_pool.global()) |pool| pool.releaseThreadCache() else |_| {};
+        reactor.run(stop) catch |err| {
+            std.log.err("session_reactor: reactor loop failed: {s}", .{@errorName(err)});
+        };
+    }
+};
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+const TestSession = struct {
+    reads: std.atomic.Value(u32) = .init(0),
+    timeouts: [3]u32 = .{ 0, 0, 0 },
+    opened: std.atomic.Value(u32) = .init(0),
+    notified: u32 = 0,
+
+    fn handler(self: *TestSession) Handler {
+        return .{
+            .context = self,
+            .on_readable = on_readable,
+            .on_timeout = on_timeout,
+            .on_open = on_open,
+            .on_notify = on_notify,
+        };
+    }
+
+    fn on_readable(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        const self: *TestSession = @ptrCast(@alignCast(context));
+        var buffer: [64]u8 = undefined;
+        _ = posix.read(reactor.fd_of(handle).?, &buffer) catch {};
+        _ = self.reads.fetchAdd(1, .release);
+    }
+
+    fn on_timeout(context: *anyopaque, reactor: *Reactor, handle: SessionHandle, kind: TimeoutKind) void {
+        _ = reactor;
+        _ = handle;
+        const self: *TestSession = @ptrCast(@alignCast(context));
+        self.timeouts[@intFromEnum(kind)] += 1;
+    }
+
+    fn on_open(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        _ = reactor;
+        _ = handle;
+        const self: *TestSession = @ptrCast(@alignCast(context));
+        _ = self.opened.fetchAdd(1, .release);
+    }
+
+    fn on_notify(context: *anyopaque, reactor: *Reactor, handle: SessionHandle) void {
+        _ = reactor;
+        _ = handle;
+        const self: *TestSession = @ptrCast(@alignCast(context));
+        self.notified += 1;
+    }
+};
+
+test "timer wheel: schedule, cancel and advance" {
+    var wheel = TimerWheel.init(std.testing.allocator, 10, 0);
+    defer wheel.deinit();
+
+    var expired: std.ArrayList(u32) = .empty;
+    defer expired.deinit(std.testing.allocator);
+
+    try wheel.schedule(1, 25);
+    try wheel.schedule(2, 40);
+    try wheel.schedule(3, 40);
+    // Beyond one revolution, in the same slot as tick 3
+    try wheel.schedule(4, (TimerWheel.slot_count + 3) * 10);
+    wheel.cancel(3);
+
+    try wheel.advance(20, &expired);
+    try std.testing.expectEqual(@as(usize, 0), expired.items.len);
+
+    try wheel.advance(45, &expired);
+    try std.testing.expectEqualSlices(u32, &.{ 1, 2 }, expired.items);
+    try std.testing.expectEqual(@as(usize, 1), wheel.armed_count);
+
+    expired.clearRetainingCapacity();
+    try wheel.advance((TimerWheel.slot_count + 3) * 10, &expired);
+    try std.testing.expectEqualSlices(u32, &.{4}, expired.items);
+    try std.testing.expectEqual(@as(usize, 0), wheel.armed_count);
+}
+
+test "reactor: readable dispatch and read timeout" {
+    var reactor = try Reactor.init(std.testing.allocator, .{
+        .read_timeout_ms = 20,
+        .idle_timeout_ms = 0,
+        .tick_ms = 5,
+    });
+    defer reactor.deinit();
+
+    const pipe = try posix.pipe2(.{ .NONBLOCK = true });
+    defer for (pipe) |fd| posix.close(fd);
+
+    var session = TestSession{};
+    const handle = try reactor.register(pipe[0], session.handler());
+
+    _ = try posix.write(pipe[1], "x");
+    _ = try reactor.poll_once(100);
+    try std.testing.expectEqual(@as(u32, 1), session.reads.load(.acquire));
+
+    // No reply arrives: the read timeout fires without blocking the loop
+    try reactor.expect_read(handle);
+    const started = std.time.milliTimestamp();
+    while (session.timeouts[@intFromEnum(TimeoutKind.read)] == 0) {
+        _ = try reactor.poll_once(100);
+        try std.testing.expect(std.time.milliTimestamp() - started < 2000);
+    }
+
+    reactor.remove(handle);
+    try std.testing.expectEqual(@as(usize, 0), reactor.active_count);
+    try std.testing.expectEqual(@as(?posix.fd_t, null), reactor.fd_of(handle));
+}
+
+test "reactor: notify from another thread" {
+    var reactor = try Reactor.init(std.testing.allocator, .{ .idle_timeout_ms = 0 });
+    defer reactor.deinit();
+
+    const pipe = try posix.pipe2(.{ .NONBLOCK = true });
+    defer for (pipe) |fd| posix.close(fd);
+
+    var session = TestSession{};
+    const handle = try reactor.register(pipe[0], session.handler());
+
+    const thread = try std.Thread.spawn(.{}, Reactor.notify, .{ &reactor, handle });
+    thread.join();
+    _ = try reactor.poll_once(100);
+    try std.testing.expectEqual(@as(u32, 1), session.notified);
+
+    // Notifications for a removed session are dropped
+    try reactor.notify(handle);
+    reactor.remove(handle);
+    _ = try reactor.poll_once(100);
+    try std.testing.expectEqual(@as(u32, 1), session.notified);
+}
+
+test "reactor group: sessions submitted across threads" {
+    var group = try ReactorGroup.init(std.testing.allocator, 2, .{ .idle_timeout_ms = 0 });
+    defer group.deinit();
+    try group.start();
+
+    var pipes: [4][2]posix.fd_t = undefined;
+    var sessions = [_]TestSession{.{}} ** 4;
+    for (&pipes, &sessions) |*pipe, *session| {
+        pipe.* = try posix.pipe2(.{ .NONBLOCK = true });
+        try group.submit(pipe[0], session.handler());
+    }
+    defer for (pipes) |pipe| for (pipe) |fd| posix.close(fd);
+
+    for (&sessions) |*session| {
+        while (session.opened.load(.acquire) == 0) std.Thread.yield() catch {};
+    }
+    for (pipes) |pipe| _ = try posix.write(pipe[1], "x");
+    for (&sessions) |*session| {
+        while (session.reads.load(.acquire) == 0) std.Thread.yield() catch {};
+    }
+
+    group.shutdown();
+    try std.testing.expectEqual(@as(usize, 2), group.reactors[0].active_count);
+    try std.testing.expectEqual(@as(usize, 2), group.reactors[1].active_count);
+}
@@ -5,7 +5,7 @@ pub const SessionEvent = struct {
     event_type: EventType,
     data: []const u8,
 
-    pub const EventType = enum {
+    pub const EventType = enum(u8) {
         command,
         response,
         keyboard_input,
@@ -13,13 +13,174 @@ pub const SessionEvent = struct {
     };
 };
 
+/// Binary recording format (append-only):
+///
+///   header:  "Z3RL" version:u8
+///   record:  delta_ms:uleb128 event_type:u8 len:uleb128 data[len]
+///
+/// Timestamps are stored as deltas from the previous record, so a file can
+/// be appended to indefinitely and read back without an index.
+pub const format = struct {
+    pub const magic = "Z3RL";
+    pub const version: u8 = 1;
+    pub const header = magic ++ [_]u8{version};
+
+    /// Longest possible record prefix: two 64-bit varints and the type byte.
+    pub const max_prefix_len = 10 + 1 + 10;
+
+    fn put_varint(buf: []u8, value: u64) usize {
+        var v = value;
+        var i: usize = 0;
+        while (v >= 0x80) : (i += 1) {
+            buf[i] = @as(u8, @truncate(v)) | 0x80;
+            v >>= 7;
+        }
+        buf[i] = @truncate(v);
+        return i + 1;
+    }
+
+    fn get_varint(bytes: []const u8, pos: *usize) !u64 {
+        var value: u64 = 0;
+        var shift: u32 = 0;
+        while (pos.* < bytes.len) {
+            const byte = bytes[pos.*];
+            pos.* += 1;
+            if (shift > 63) return error.InvalidRecording;
+            value |= @as(u64, byte & 0x7F) << @intCast(shift);
+            if (byte & 0x80 == 0) return value;
+            shift += 7;
+        }
+        return error.TruncatedRecord;
+    }
+
+    /// Encode a record prefix into `buf` and return it.
+    pub fn encode_prefix(
+        buf: *[max_prefix_len]u8,
+        delta_ms: u64,
+        event_type: SessionEvent.EventType,
+        data_len: usize,
+    ) []const u8 {
+        var len = put_varint(buf, delta_ms);
+        buf[len] = @intFromEnum(event_type);
+        len += 1;
+        len += put_varint(buf[len..], data_len);
+        return buf[0..len];
+    }
+
+    /// Decode the record at `pos.*`, advancing past it. `data` borrows from
+    /// `bytes`.
+    pub fn decode_record(bytes: []const u8, pos: *usize) !struct {
+        delta_ms: u64,
+        event_type: SessionEvent.EventType,
+        data: []const u8,
+    } {
+        const delta_ms = try get_varint(bytes, pos);
+        if (pos.* >= bytes.len) return error.TruncatedRecord;
+        const event_type = std.meta.intToEnum(SessionEvent.EventType, bytes[pos.*]) catch
+            return error.InvalidRecording;
+        pos.* += 1;
+        const data_len = try get_varint(bytes, pos);
+        if (data_len > bytes.len - pos.*) return error.TruncatedRecord;
+        const data = bytes[pos.*..][0..@intCast(data_len)];
+        pos.* += data.len;
+        return .{ .delta_ms = delta_ms, .event_type = event_type, .data = data };
+    }
+};
+
+/// Zero-copy reader over a recording in the binary format. Events borrow
+/// their data from the underlying bytes.
+pub const RecordingReader = struct {
+    bytes: []const u8,
+    pos: usize = format.header.len,
+    timestamp: u64 = 0,
+
+    pub fn init(bytes: []const u8) !RecordingReader {
+        if (bytes.len < format.header.len or !std.mem.startsWith(u8, bytes, format.magic)) {
+            return error.InvalidRecording;
+        }
+        if (bytes[format.magic.len] != format.version) return error.UnsupportedVersion;
+        return .{ .bytes = bytes };
+    }
+
+    /// Next event, or null at the end. A partially written final record
+    /// (e.g. after a crash) yields error.TruncatedRecord.
+    pub fn next(self: *RecordingReader) !?SessionEvent {
+        if (self.pos >= self.bytes.len) return null;
+        const record = try format.decode_record(self.bytes, &self.pos);
+        self.timestamp += record.delta_ms;
+        return .{
+            .timestamp = self.timestamp,
+            .event_type = record.event_type,
+            .data = record.data,
+        };
+    }
+
+    pub fn reset(self: *RecordingReader) void {
+        self.pos = format.header.len;
+        self.timestamp = 0;
+    }
+};
+
+/// A recording file mapped read-only for replay.
+pub const MappedRecording = struct {
+    bytes: []align(std.heap.page_size_min) const u8,
+
+    pub fn open(path: []const u8) !MappedRecording {
+        const file = try std.fs.cwd().openFile(path, .{});
+        defer file.close();
+
+        const size = try file.getEndPos();
+        if (size < format.header.len) return error.InvalidRecording;
+
+        const bytes = try std.posix.mmap(
+            null,
+            @intCast(size),
+            std.posix.PROT.READ,
+            .{ .TYPE = .PRIVATE },
+            file.handle,
+            0,
+        );
+        return .{ .bytes = bytes };
+    }
+
+    pub fn close(self: *MappedRecording) void {
+        std.posix.munmap(self.bytes);
+    }
+
+    pub fn reader(self: MappedRecording) !RecordingReader {
+        return RecordingReader.init(self.bytes);
+    }
+};
+
 pub const SessionRecorder = struct {
     allocator: std.mem.Allocator,
-    events_buffer: ?[]SessionEvent = null,
+    /// In-memory mode: records in the binary format, back to back.
+    log: std.ArrayList(u8) = .empty,
+    /// In-memory mode: where each record starts and its absolute timestamp.
+    index: std.ArrayList(IndexEntry) = .empty,
+    /// Streaming mode: records go straight to this writer and nothing is
+    /// retained.
+    sink: ?*std.Io.Writer = null,
+    /// In-memory mode: where `flush_segment` moves the records when the
+    /// session is short of memory (set with `spill_to`). Null keeps
+    /// everything in memory.
+    segment_sink: ?*std.Io.Writer = null,
+    /// The header has been written to `segment_sink`
+    segment_started: bool = false,
+    /// A flush failed partway, so the sink holds an unknown prefix of the
+    /// records; nothing more is written there until the next `spill_to`
+    segment_poisoned: bool = false,
+    /// Events moved to `segment_sink`; `index` starts after them
+    flushed_events: usize = 0,
     events_len: usize = 0,
-    events_capacity: usize = 0,
+    last_timestamp: u64 = 0,
     start_time: i64 = 0,
 
+    const IndexEntry = struct {
+        offset: usize,
+        timestamp: u64,
+    };
+
     pub fn init(allocator: std.mem.Allocator) SessionRecorder {
         return .{
             .allocator = allocator,
@@ -27,18 +188,28 @@ pub const SessionRecorder = struct {
     }
 
     pub fn deinit(self: *SessionRecorder) void {
-        if (self.events_buffer) |buffer| {
-            for (buffer[0..self.events_len]) |event| {
-                self.allocator.free(event.data);
-            }
-            self.allocator.free(buffer);
-        }
+        self.log.deinit(self.allocator);
+        self.index.deinit(self.allocator);
     }
 
     /// Start recording session
     pub fn start(self: *SessionRecorder) void {
         self.start_time = std.time.milliTimestamp();
         self.events_len = 0;
+        self.flushed_events = 0;
+        self.last_timestamp = 0;
+        self.log.clearRetainingCapacity();
+        self.index.clearRetainingCapacity();
+    }
+
+    /// Write the file header to `out` and send every later event there
+    /// instead of keeping it in memory. Memory use stays bounded by the
+    /// writer's buffer however long the session runs; replay the output
+    /// with RecordingReader or MappedRecording.
+    pub fn stream_to(self: *SessionRecorder, out: *std.Io.Writer) !void {
+        try out.writeAll(format.header);
+        self.sink = out;
+        self.last_timestamp = 0;
     }
 
     /// Record an event
@@ -52,38 +223,78 @@ pub const SessionRecorder = struct {
             @intCast(@max(0, now - self.start_time))
         else
             0;
+        // The wall clock can step backwards; recorded time never does.
+        const timestamp = @max(elapsed, self.last_timestamp);
+
+        var prefix_buf: [format.max_prefix_len]u8 = undefined;
+        const prefix = format.encode_prefix(&prefix_buf, timestamp - self.last_timestamp, event_type, data.len);
+
+        if (self.sink) |out| {
+            try out.writeAll(prefix);
+            try out.writeAll(data);
+        } else {
+            try self.index.ensureUnusedCapacity(self.allocator, 1);
+            try self.log.ensureUnusedCapacity(self.allocator, prefix.len + data.len);
+            self.index.appendAssumeCapacity(.{ .offset = self.log.items.len, .timestamp = timestamp });
+            self.log.appendSliceAssumeCapacity(prefix);
+            self.log.appendSliceAssumeCapacity(data);
+        }
 
-        const data_copy = try self.allocator.dupe(u8, data);
-        errdefer self.allocator.free(data_copy);
+        self.last_timestamp = timestamp;
+        self.events_len += 1;
+    }
 
-        const event = SessionEvent{
-            .timestamp = elapsed,
-            .event_type = event_type,
-            .data = data_copy,
-        };
+    /// Write the in-memory recording to `out` in the binary file format.
+    /// Once records were flushed to a spill sink the rest do not form a
+    /// recording on their own (their first delta is relative), so this
+    /// fails with error.RecordingSpilled; replay the sink instead.
+    pub fn write_to(self: SessionRecorder, out: *std.Io.Writer) !void {
+        if (self.flushed_events > 0) return error.RecordingSpilled;
+        try out.writeAll(format.header);
+        try out.writeAll(self.log.items);
+    }
 
-        if (self.events_capacity == 0) {
-            // First allocation
-            const new_capacity = 16;
-            const buffer = try self.allocator.alloc(SessionEvent, new_capacity);
-            self.events_buffer = buffer;
-            self.events_capacity = new_capacity;
-            self.events_len = 0;
-        }
+    /// Make `out` the destination of `flush_segment`. Everything flushed
+    /// there forms one recording: a header, then every flushed record in
+    /// order.
+    pub fn spill_to(self: *SessionRecorder, out: *std.Io.Writer) void {
+        self.segment_sink = out;
+        self.segment_started = false;
+        self.segment_poisoned = false;
+    }
 
-        if (self.events_len >= self.events_capacity) {
-            // Grow capacity
-            const new_capacity = self.events_capacity * 2;
-            const new_buffer = try self.allocator.alloc(SessionEvent, new_capacity);
-            @memcpy(new_buffer[0..self.events_len], self.events_buffer.?[0..self.events_len]);
-            self.allocator.free(self.events_buffer.?);
-            self.events_buffer = new_buffer;
-            self.events_capacity = new_capacity;
+    /// Append the in-memory records to `segment_sink` and free them. The
+    /// first flush into a sink writes the header and makes the first delta
+    /// absolute; later flushes continue the delta chain, so the sink
+    /// replays as a single recording. Returns the bytes released.
+    ///
+    /// If a write fails the records stay in memory and the sink is
+    /// poisoned: writing them again after a partial write would corrupt
+    /// the stream, so later flushes fail with error.SpillFailed until
+    /// `spill_to` names a new sink.
+    pub fn flush_segment(self: *SessionRecorder) !usize {
+        const out = self.segment_sink orelse return 0;
+        if (self.segment_poisoned) return error.SpillFailed;
+        if (self.index.items.len == 0) return 0;
+        errdefer self.segment_poisoned = true;
+
+        var pos: usize = 0;
+        if (!self.segment_started) {
+            const first = format.decode_record(self.log.items, &pos) catch unreachable;
+            var prefix_buf: [format.max_prefix_len]u8 = undefined;
+            try out.writeAll(format.header);
+            try out.writeAll(format.encode_prefix(&prefix_buf, self.index.items[0].timestamp, first.event_type, first.data.len));
+            try out.writeAll(first.data);
         }
-
-        // Append event
-        self.events_buffer.?[self.events_len] = event;
-        self.events_len += 1;
+        try out.writeAll(self.log.items[pos..]);
+        try out.flush();
+        self.segment_started = true;
+
+        self.flushed_events += self.index.items.len;
+        const released = self.log.capacity + self.index.capacity * @sizeOf(IndexEntry);
+        self.log.clearAndFree(self.allocator);
+        self.index.clearAndFree(self.allocator);
+        return released;
     }
 
     /// Get number of recorded events
@@ -91,12 +302,22 @@ pub const SessionRecorder = struct {
         return self.events_len;
     }
 
-    /// Get event by index
+    /// Get event by index, counting from the start of the recording. The
+    /// data borrows from the recorder and stays valid until the next
+    /// `record`. Streamed events and events moved out by `flush_segment`
+    /// are not retained and return null.
     pub fn get_event(self: SessionRecorder, index: usize) ?SessionEvent {
-        if (index < self.events_len and self.events_buffer != null) {
-            return self.events_buffer.?[index];
-        }
-        return null;
+        if (index < self.flushed_events) return null;
+        if (index - self.flushed_events >= self.index.items.len) return null;
+
+        const entry = self.index.items[index - self.flushed_events];
+        var pos = entry.offset;
+        const decoded = format.decode_record(self.log.items, &pos) catch unreachable;
+        return .{
+            .timestamp = entry.timestamp,
+            .event_type = decoded.event_type,
+            .data = decoded.data,
+        };
     }
 };
 
@@ -181,3 +402,131 @@ test "session recorder get nonexistent event" {
     try std.testing.expect(recorder.get_event(0) == null);
     try std.testing.expect(recorder.get_event(100) == null);
 }
+
+test "session recorder binary round trip" {
+    var recorder = SessionRecorder.init(std.testing.allocator);
+    defer recorder.deinit();
+
+    recorder.start();
+    try recorder.record(.command, "cmd1");
+    try recorder.record(.response, &[_]u8{ 0xF5, 0xC3, 0x11, 0x40, 0x40 });
+    try recorder.record(.keyboard_input, "");
+
+    var buf: [128]u8 = undefined;
+    var out: std.Io.Writer = .fixed(&buf);
+    try recorder.write_to(&out);
+
+    var reader = try RecordingReader.init(out.buffered());
+    for (0..3) |i| {
+        const expected = recorder.get_event(i).?;
+        const event = (try reader.next()).?;
+        try std.testing.expectEqual(expected.event_type, event.event_type);
+        try std.testing.expectEqual(expected.timestamp, event.timestamp);
+        try std.testing.expectEqualSlices(u8, expected.data, event.data);
+    }
+    try std.testing.expect(try reader.next() == null);
+
+    // A torn final record is reported, not misread.
+    var torn = try RecordingReader.init(out.buffered()[0 .. out.end - 2]);
+    _ = try torn.next();
+    try std.testing.expectError(error.TruncatedRecord, torn.next());
+    try std.testing.expectError(error.InvalidRecording, RecordingReader.init("Z3"));
+}
+
+test "session recorder flushes segments into one replayable stream" {
+    var spill: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer spill.deinit();
+
+    var recorder = SessionRecorder.init(std.testing.allocator);
+    defer recorder.deinit();
+    recorder.start();
+    recorder.spill_to(&spill.writer);
+
+    try recorder.record(.command, "cmd1");
+    try std.testing.expect(try recorder.flush_segment() > 0);
+    try std.testing.expectEqual(@as(usize, 0), try recorder.flush_segment());
+
+    // Five seconds later
+    recorder.start_time -= 5000;
+    try recorder.record(.response, "resp1");
+    _ = try recorder.flush_segment();
+    try recorder.record(.keyboard_input, "key1");
+
+    // Indices count from the start of the recording
+    try std.testing.expectEqual(@as(usize, 3), recorder.event_count());
+    try std.testing.expect(recorder.get_event(0) == null);
+    try std.testing.expect(recorder.get_event(1) == null);
+    try std.testing.expectEqualStrings("key1", recorder.get_event(2).?.data);
+    try std.testing.expect(recorder.get_event(3) == null);
+
+    var reader = try RecordingReader.init(spill.written());
+    try std.testing.expectEqualStrings("cmd1", (try reader.next()).?.data);
+    const event = (try reader.next()).?;
+    try std.testing.expectEqualStrings("resp1", event.data);
+    try std.testing.expect(event.timestamp >= 5000);
+    try std.testing.expect(try reader.next() == null);
+
+    // What is left in memory is not a recording on its own
+    var buffer: [64]u8 = undefined;
+    var out = std.Io.Writer.fixed(&buffer);
+    try std.testing.expectError(error.RecordingSpilled, recorder.write_to(&out));
+}
+
+test "session recorder stops spilling into a sink after a failed write" {
+    var recorder = SessionRecorder.init(std.testing.allocator);
+    defer recorder.deinit();
+    recorder.start();
+
+    // Room for the header and part of the records only
+    var small: [12]u8 = undefined;
+    var sink = std.Io.Writer.fixed(&small);
+    recorder.spill_to(&sink);
+    try recorder.record(.command, "cmd1");
+    try recorder.record(.response, "resp1");
+    try std.testing.expectError(error.WriteFailed, recorder.flush_segment());
+
+    // The records stay and the half-written sink is left alone
+    const written = sink.end;
+    try std.testing.expectEqual(@as(usize, 2), recorder.index.items.len);
+    try std.testing.expectError(error.SpillFailed, recorder.flush_segment());
+    try std.testing.expectEqual(written, sink.end);
+
+    // A fresh sink gets the whole recording
+    var spill: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer spill.deinit();
+    recorder.spill_to(&spill.writer);
+    try std.testing.expect(try recorder.flush_segment() > 0);
+    var reader = try RecordingReader.init(spill.written());
+    try std.testing.expectEqualStrings("cmd1", (try reader.next()).?.data);
+    try std.testing.expectEqualStrings("resp1", (try reader.next()).?.data);
+    try std.testing.expect(try reader.next() == null);
+}
+
+test "session recorder streams to a mapped file" {
+    const path = "/tmp/test_session_recording.z3rl";
+    {
+        const file = try std.fs.cwd().createFile(path, .{});
+        defer file.close();
+        var file_buf: [256]u8 = undefined;
+        var file_writer = file.writer(&file_buf);
+
+        // Streaming mode never allocates.
+        var recorder = SessionRecorder.init(std.testing.failing_allocator);
+        defer recorder.deinit();
+        recorder.start();
+        try recorder.stream_to(&file_writer.interface);
+        for (0..1000) |_| try recorder.record(.screen_update, "SCREEN DATA");
+        try file_writer.interface.flush();
+        try std.testing.expectEqual(@as(usize, 1000), recorder.event_count());
+        try std.testing.expect(recorder.get_event(0) == null);
+    }
+
+    var mapped = try MappedRecording.open(path);
+    defer mapped.close();
+    var reader = try mapped.reader();
+    var count: usize = 0;
+    while (try reader.next()) |event| : (count += 1) {
+        try std.testing.expectEqualStrings("SCREEN DATA", event.data);
+    }
+    try std.testing.expectEqual(@as(usize, 1000), count);
+}
@@ -0,0 +1,804 @@
+//! Binary session snapshots and incremental checkpoints.
+//!
+//! A frame is a 32-byte header followed by a body:
+//!
+//! ```text
+//! "Z3S" version  kind  flags  sequence  rows  cols  cursor  timestamp  body_len  crc32
+//!   3      1      1     1       4        2     2     2        8          4        4
+//! ```
+//!
+//! Integers are little-endian and the CRC covers the body. The body holds
+//! cell spans (address, length, then that many characters, attribute bytes
+//! and colors), the field table when the `fields` flag is set, and the
+//! modified data tags as runs. A full frame carries one span covering the
+//! screen and always includes the field table. A delta frame carries only
+//! the spans `Screen.changes_since` reports since the previous frame, and
+//! includes the field table only when the layout changed.
+//!
+//! `Checkpointer` builds frames on the session thread; that is only a
+//! copy of the changed cells. `CheckpointWriter` hands them to sinks on a
+//! background thread, so file writes and network sends stay off the
+//! session thread. Sinks are the checkpoint log (`FileSink`), a socket to
+//! a warm-standby node (`StreamSink`) and an in-process replica
+//! (`Standby`). A standby that has applied the stream already holds the
+//! session state when failover happens.
+const std = @import("std");
+const screen = @import("screen.zig");
+const field = @import("field.zig");
+const protocol = @import("protocol.zig");
+
+pub const header_len = 32;
+/// Largest frame `Standby.receive` accepts from a peer
+pub const max_frame_len = 16 << 20;
+const magic = "Z3S";
+const version: u8 = 1;
+
+const flag_keyboard_locked: u8 = 0x01;
+const flag_fields: u8 = 0x02;
+
+pub const Kind = enum(u8) {
+    full = 0,
+    delta = 1,
+};
+
+/// Session state outside the screen planes
+pub const State = struct {
+    cursor: u16 = 0,
+    keyboard_locked: bool = false,
+};
+
+pub const Header = struct {
+    kind: Kind,
+    sequence: u32,
+    rows: u16,
+    cols: u16,
+    state: State,
+    has_fields: bool,
+    timestamp: i64,
+    body_len: u32,
+    checksum: u32,
+
+    /// Parse and check a header; the body is not checked here
+    pub fn parse(bytes: []const u8) !Header {
+        if (bytes.len < header_len) return error.InvalidSnapshot;
+        if (!std.mem.eql(u8, bytes[0..3], magic) or bytes[3] != version) return error.InvalidSnapshot;
+        const kind: Kind = switch (bytes[4]) {
+            0 => .full,
+            1 => .delta,
+            else => return error.InvalidSnapshot,
+        };
+        const flags = bytes[5];
+        return .{
+            .kind = kind,
+            .sequence = std.mem.readInt(u32, bytes[6..10], .little),
+            .rows = std.mem.readInt(u16, bytes[10..12], .little),
+            .cols = std.mem.readInt(u16, bytes[12..14], .little),
+            .state = .{
+                .cursor = std.mem.readInt(u16, bytes[14..16], .little),
+                .keyboard_locked = flags & flag_keyboard_locked != 0,
+            },
+            .has_fields = flags & flag_fields != 0,
+            .timestamp = std.mem.readInt(i64, bytes[16..24], .little),
+            .body_len = std.mem.readInt(u32, bytes[24..28], .little),
+            .checksum = std.mem.readInt(u32, bytes[28..32], .little),
+        };
+    }
+};
+
+/// Length of the frame starting at `bytes`, or null when not even the
+/// header is there. Lets a reader split a log or socket stream.
+pub fn frame_len(bytes: []const u8) ?usize {
+    const header = Header.parse(bytes) catch return null;
+    return header_len + @as(usize, header.body_len);
+}
+
+/// Hash of the field layout, to tell whether a delta must carry it
+fn layout_hash(fields: *field.FieldManager) u64 {
+    var hasher = std.hash.Wyhash.init(0);
+    for (fields.fields.items) |f| {
+        var entry: [5]u8 = undefined;
+        std.mem.writeInt(u16, entry[0..2], f.start_address, .little);
+        std.mem.writeInt(u16, entry[2..4], f.length, .little);
+        entry[4] = @bitCast(f.attribute);
+        hasher.update(&entry);
+    }
+    return hasher.final();
+}
+
+/// Builds frames for one session. Each call to `capture` covers the
+/// changes since the previous one; the first is a full snapshot.
+pub const Checkpointer = struct {
+    allocator: std.mem.Allocator,
+    /// Reused between captures; the returned frame is a view into it
+    frame: std.ArrayList(u8) = .empty,
+    since: u32 = 0,
+    sequence: u32 = 0,
+    rows: u16 = 0,
+    cols: u16 = 0,
+    layout: ?u64 = null,
+    need_full: bool = true,
+
+    pub fn init(allocator: std.mem.Allocator) Checkpointer {
+        return .{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *Checkpointer) void {
+        self.frame.deinit(self.allocator);
+    }
+
+    /// Make the next capture a full snapshot (a sink lost frames)
+    pub fn request_full(self: *Checkpointer) void {
+        self.need_full = true;
+    }
+
+    /// Frame for the current state, valid until the next capture. `fields`
+    /// may be null when the caller tracks no field table. On error nothing
+    /// is consumed and the next capture covers the same changes.
+    pub fn capture(
+        self: *Checkpointer,
+        scr: *screen.Screen,
+        fields: ?*field.FieldManager,
+        state: State,
+    ) ![]const u8 {
+        const full = self.need_full or scr.rows != self.rows or scr.cols != self.cols;
+        const generation = scr.current_generation();
+
+        self.frame.clearRetainingCapacity();
+        try self.frame.appendNTimes(self.allocator, 0, header_len);
+
+        const span_count_at = self.frame.items.len;
+        try self.put(u16, 0);
+        var spans: u16 = 0;
+        if (full) {
+            try self.put_span(scr, 0, scr.size());
+            spans = 1;
+        } else {
+            var changes = scr.changes_since(self.since);
+            while (changes.next()) |span| {
+                try self.put_span(scr, span.address, span.len);
+                spans += 1;
+            }
+        }
+        std.mem.writeInt(u16, self.frame.items[span_count_at..][0..2], spans, .little);
+
+        var layout = self.layout;
+        var flags: u8 = if (state.keyboard_locked) flag_keyboard_locked else 0;
+        if (fields) |fm| {
+            const hash = layout_hash(fm);
+            if (full or layout == null or layout.? != hash) {
+                flags |= flag_fields;
+                try self.put(u16, @intCast(fm.fields.items.len));
+                for (fm.fields.items) |f| {
+                    try self.put(u16, f.start_address);
+                    try self.put(u16, f.length);
+                    try self.frame.append(self.allocator, @bitCast(f.attribute));
+                }
+                layout = hash;
+            }
+        }
+
+        try self.put_modified(scr);
+
+        const body = self.frame.items[header_len..];
+        const header = self.frame.items[0..header_len];
+        @memcpy(header[0..3], magic);
+        header[3] = version;
+        header[4] = @intFromEnum(if (full) Kind.full else Kind.delta);
+        header[5] = flags;
+        std.mem.writeInt(u32, header[6..10], self.sequence, .little);
+        std.mem.writeInt(u16, header[10..12], scr.rows, .little);
+        std.mem.writeInt(u16, header[12..14], scr.cols, .little);
+        std.mem.writeInt(u16, header[14..16], state.cursor, .little);
+        std.mem.writeInt(i64, header[16..24], std.time.milliTimestamp(), .little);
+        std.mem.writeInt(u32, header[24..28], @intCast(body.len), .little);
+        std.mem.writeInt(u32, header[28..32], std.hash.Crc32.hash(body), .little);
+
+        self.since = generation;
+        self.sequence +%= 1;
+        self.rows = scr.rows;
+        self.cols = scr.cols;
+        self.layout = layout;
+        self.need_full = false;
+        return self.frame.items;
+    }
+
+    fn put(self: *Checkpointer, comptime T: type, value: T) !void {
+        var bytes: [@sizeOf(T)]u8 = undefined;
+        std.mem.writeInt(T, &bytes, value, .little);
+        try self.frame.appendSlice(self.allocator, &bytes);
+    }
+
+    fn put_span(self: *Checkpointer, scr: *const screen.Screen, address: usize, len: usize) !void {
+        try self.put(u16, @intCast(address));
+        try self.put(u16, @intCast(len));
+        try self.frame.ensureUnusedCapacity(self.allocator, len * 3);
+        self.frame.appendSliceAssumeCapacity(scr.buffer[address..][0..len]);
+        self.frame.appendSliceAssumeCapacity(scr.attributes[address..][0..len]);
+        self.frame.appendSliceAssumeCapacity(scr.colors[address..][0..len]);
+    }
+
+    /// Modified data tags as (start, length) runs; always the whole set,
+    /// since tags are cleared as well as set
+    fn put_modified(self: *Checkpointer, scr: *const screen.Screen) !void {
+        const count_at = self.frame.items.len;
+        try self.put(u16, 0);
+        var runs: u16 = 0;
+        var start: usize = 0;
+        var len: usize = 0;
+        var tagged = scr.modified.iterator(.{});
+        while (tagged.next()) |address| {
+            if (len > 0 and address == start + len) {
+                len += 1;
+                continue;
+            }
+            if (len > 0) {
+                try self.put(u16, @intCast(start));
+                try self.put(u16, @intCast(len));
+                runs += 1;
+            }
+            start = address;
+            len = 1;
+        }
+        if (len > 0) {
+            try self.put(u16, @intCast(start));
+            try self.put(u16, @intCast(len));
+            runs += 1;
+        }
+        std.mem.writeInt(u16, self.frame.items[count_at..][0..2], runs, .little);
+    }
+};
+
+/// Receives frames on the checkpoint thread, in capture order
+pub const Sink = struct {
+    context: *anyopaque,
+    func: *const fn (context: *anyopaque, frame: []const u8) anyerror!void,
+};
+
+/// Delivers frames to sinks on a background thread.
+///
+/// Frames are copied into a queue bounded by `max_pending_bytes`. When it
+/// overflows, the queue is dropped and `take_resync` reports true, so the
+/// owner captures a full snapshot next; a sink error does the same. Sinks
+/// are added before `start`. Without a running thread, `submit` delivers
+/// on the caller's thread.
+pub const CheckpointWriter = struct {
+    allocator: std.mem.Allocator,
+    options: Options,
+    sinks: std.ArrayList(Sink) = .empty,
+    mutex: std.Thread.Mutex = .{},
+    /// Signalled when frames arrive, and when the queue drains
+    changed: std.Thread.Condition = .{},
+    pending: std.ArrayList([]u8) = .empty,
+    pending_bytes: usize = 0,
+    /// A batch is being delivered with the mutex released
+    busy: bool = false,
+    thread: ?std.Thread = null,
+    stopping: bool = false,
+    resync: std.atomic.Value(bool) = .init(false),
+    frames_written: u64 = 0,
+    frames_dropped: u64 = 0,
+    sink_failures: u64 = 0,
+
+    pub const Options = struct {
+        max_pending_bytes: usize = 1 << 20,
+    };
+
+    pub fn init(allocator: std.mem.Allocator, options: Options) CheckpointWriter {
+        return .{ .allocator = allocator, .options = options };
+    }
+
+    /// Stops the thread after the queue drains, then frees it
+    pub fn deinit(self: *CheckpointWriter) void {
+        self.stop();
+        for (self.pending.items) |frame| self.allocator.free(frame);
+        self.pending.deinit(self.allocator);
+        self.sinks.deinit(self.allocator);
+    }
+
+    pub fn add_sink(self: *CheckpointWriter, sink: Sink) !void {
+        std.debug.assert(self.thread == null);
+        try self.sinks.append(self.allocator, sink);
+    }
+
+    pub fn start(self: *CheckpointWriter) !void {
+        if (self.thread != null) return;
+        self.stopping = false;
+        self.thread = try std.Thread.spawn(.{}, writer_loop, .{self});
+    }
+
+    /// Deliver what is queued, then join the thread
+    pub fn stop(self: *CheckpointWriter) void {
+        const thread = self.thread orelse return;
+        self.mutex.lock();
+        self.stopping = true;
+        self.changed.broadcast();
+        self.mutex.unlock();
+        thread.join();
+        self.thread = null;
+    }
+
+    /// Queue a copy of `frame`
+    pub fn submit(self: *CheckpointWriter, frame: []const u8) !void {
+        if (self.thread == null) {
+            self.deliver(frame);
+            self.mutex.lock();
+            self.frames_written += 1;
+            self.mutex.unlock();
+            return;
+        }
+
+        const copy = try self.allocator.dupe(u8, frame);
+        errdefer self.allocator.free(copy);
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        if (self.pending_bytes + copy.len > self.options.max_pending_bytes) {
+            // Sinks cannot keep up; later deltas would be useless without
+            // these, so drop them all and resynchronise with a full frame
+            self.frames_dropped += self.pending.items.len + 1;
+            self.drop_pending();
+            self.resync.store(true, .release);
+            self.allocator.free(copy);
+            return;
+        }
+        try self.pending.append(self.allocator, copy);
+        self.pending_bytes += copy.len;
+        self.changed.broadcast();
+    }
+
+    /// True once after frames were lost; capture a full snapshot next
+    pub fn take_resync(self: *CheckpointWriter) bool {
+        return self.resync.swap(false, .acq_rel);
+    }
+
+    /// Wait until every queued frame reached the sinks
+    pub fn flush(self: *CheckpointWriter) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (self.thread != null and (self.pending.items.len > 0 or self.busy)) {
+            self.changed.wait(&self.mutex);
+        }
+    }
+
+    fn drop_pending(self: *CheckpointWriter) void {
+        for (self.pending.items) |frame| self.allocator.free(frame);
+        self.pending.clearRetainingCapacity();
+        self.pending_bytes = 0;
+    }
+
+    fn deliver(self: *CheckpointWriter, frame: []const u8) void {
+        for (self.sinks.items) |sink| {
+            sink.func(sink.context, frame) catch {
+                _ = @atomicRmw(u64, &self.sink_failures, .Add, 1, .monotonic);
+                self.resync.store(true, .release);
+            };
+        }
+    }
+
+    fn writer_loop(self: *CheckpointWriter) void {
+        var batch: std.ArrayList([]u8) = .empty;
+        defer batch.deinit(self.allocator);
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        while (true) {
+            while (self.pending.items.len == 0 and !self.stopping) self.changed.wait(&self.mutex);
+            if (self.pending.items.len == 0) return;
+
+            // Swap the queue out so submit never waits on a sink
+            std.mem.swap(std.ArrayList([]u8), &batch, &self.pending);
+            self.pending_bytes = 0;
+            self.busy = true;
+            self.mutex.unlock();
+
+            for (batch.items) |frame| {
+                self.deliver(frame);
+                self.allocator.free(frame);
+            }
+            const delivered = batch.items.len;
+            batch.clearRetainingCapacity();
+
+            self.mutex.lock();
+            self.frames_written += delivered;
+            self.busy = false;
+            self.changed.broadcast();
+        }
+    }
+};
+
+/// Checkpoint log: deltas are appended, so the file is always one
+/// snapshot followed by the changes since. A full frame goes to a
+/// temporary file that is synced and renamed over the log, so a crash
+/// leaves either the old log or the new one, never neither.
+pub const FileSink = struct {
+    /// Directory holding the log; owned by the sink
+    dir: std.fs.Dir,
+    /// Log file name in `dir`; must outlive the sink
+    name: []const u8,
+    /// The log, open for appending; opened by the first frame
+    file: ?std.fs.File = null,
+
+    pub fn sink(self: *FileSink) Sink {
+        return .{ .context = self, .func = write };
+    }
+
+    /// Close the log and the directory
+    pub fn close(self: *FileSink) void {
+        if (self.file) |file| file.close();
+        self.file = null;
+        self.dir.close();
+    }
+
+    fn write(context: *anyopaque, frame: []const u8) anyerror!void {
+        const self: *FileSink = @ptrCast(@alignCast(context));
+        const header = try Header.parse(frame);
+        if (header.kind == .full) return self.replace(frame);
+
+        const file = self.file orelse blk: {
+            const opened = try self.dir.createFile(self.name, .{ .truncate = false });
+            errdefer opened.close();
+            try opened.seekFromEnd(0);
+            self.file = opened;
+            break :blk opened;
+        };
+        try file.writeAll(frame);
+    }
+
+    /// Start a new log holding only `frame`
+    fn replace(self: *FileSink, frame: []const u8) !void {
+        var name_buffer: [std.fs.max_path_bytes]u8 = undefined;
+        const temp_name = try std.fmt.bufPrint(&name_buffer, "{s}.tmp", .{self.name});
+        const temp = try self.dir.createFile(temp_name, .{});
+        errdefer {
+            temp.close();
+            self.dir.deleteFile(temp_name) catch {};
+        }
+        try temp.writeAll(frame);
+        try temp.sync();
+        try self.dir.rename(temp_name, self.name);
+        // Make the rename itself durable
+        std.posix.fsync(self.dir.fd) catch {};
+
+        // Later deltas append to the new log through the same handle
+        if (self.file) |old| old.close();
+        self.file = temp;
+    }
+};
+
+/// Frames to a warm-standby node. Frames are self-delimiting (see
+/// `frame_len`); the peer feeds the connection to `Standby.receive`.
+pub const StreamSink = struct {
+    stream: std.net.Stream,
+
+    pub fn sink(self: *StreamSink) Sink {
+        return .{ .context = self, .func = write };
+    }
+
+    fn write(context: *anyopaque, frame: []const u8) anyerror!void {
+        const self: *StreamSink = @ptrCast(@alignCast(context));
+        try self.stream.writeAll(frame);
+    }
+};
+
+/// Replica of a session built from frames, ready to take over on failover.
+/// `apply` runs on the checkpoint thread and `restore_into` on the
+/// failover path, so both lock.
+pub const Standby = struct {
+    allocator: std.mem.Allocator,
+    mutex: std.Thread.Mutex = .{},
+    screen: screen.Screen,
+    fields: field.FieldManager,
+    state: State = .{},
+    /// Sequence number of the last frame applied
+    sequence: u32 = 0,
+    timestamp: i64 = 0,
+    /// False until a full frame arrives, and after a bad or missing frame
+    ready: bool = false,
+    frames_applied: u64 = 0,
+
+    pub fn init(allocator: std.mem.Allocator, rows: u16, cols: u16) !Standby {
+        return .{
+            .allocator = allocator,
+            .screen = try screen.Screen.init(allocator, rows, cols),
+            .fields = field.FieldManager.init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *Standby) void {
+        self.fields.deinit();
+        self.screen.deinit();
+    }
+
+    pub fn sink(self: *Standby) Sink {
+        return .{ .context = self, .func = apply_frame };
+    }
+
+    fn apply_frame(context: *anyopaque, frame: []const u8) anyerror!void {
+        const self: *Standby = @ptrCast(@alignCast(context));
+        try self.apply(frame);
+    }
+
+    /// Apply one frame. A delta must follow the last frame applied;
+    /// otherwise `error.SequenceGap` and nothing changes until a full frame.
+    pub fn apply(self: *Standby, frame: []const u8) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const header = try Header.parse(frame);
+        if (frame.len != header_len + @as(usize, header.body_len)) return error.InvalidSnapshot;
+        const body = frame[header_len..];
+        if (std.hash.Crc32.hash(body) != header.checksum) return error.ChecksumMismatch;
+
+        if (header.kind == .delta) {
+            if (!self.ready or header.sequence != self.sequence +% 1) {
+                self.ready = false;
+                return error.SequenceGap;
+            }
+            if (header.rows != self.screen.rows or header.cols != self.screen.cols) {
+                self.ready = false;
+                return error.InvalidSnapshot;
+            }
+        } else if (header.rows != self.screen.rows or header.cols != self.screen.cols) {
+            const resized = try screen.Screen.init(self.allocator, header.rows, header.cols);
+            self.screen.deinit();
+            self.screen = resized;
+        }
+
+        // From here a bad body leaves the replica half-updated
+        self.ready = false;
+        var reader = std.Io.Reader.fixed(body);
+        self.apply_body(&reader, header) catch |err| return switch (err) {
+            error.OutOfMemory => err,
+            else => error.InvalidSnapshot,
+        };
+
+        self.state = header.state;
+        self.sequence = header.sequence;
+        self.timestamp = header.timestamp;
+        self.ready = true;
+        self.frames_applied += 1;
+    }
+
+    /// Peer side of a `StreamSink`: apply frames read from `stream` until
+    /// the sender closes it, and return how many were applied. A frame the
+    /// replica rejects is skipped; it stays not ready until the next full
+    /// frame. A header that does not parse ends the stream with
+    /// `error.InvalidSnapshot`, since frame boundaries are lost.
+    pub fn receive(self: *Standby, stream: std.net.Stream) !u64 {
+        var frame: std.ArrayList(u8) = .empty;
+        defer frame.deinit(self.allocator);
+        var applied: u64 = 0;
+
+        while (true) {
+            try frame.resize(self.allocator, header_len);
+            if (!try read_full(stream, frame.items)) return applied;
+            const len = frame_len(frame.items) orelse return error.InvalidSnapshot;
+            if (len > max_frame_len) return error.InvalidSnapshot;
+            try frame.resize(self.allocator, len);
+            if (!try read_full(stream, frame.items[header_len..])) return error.EndOfStream;
+
+            self.apply(frame.items) catch |err| switch (err) {
+                error.OutOfMemory => return err,
+                else => continue,
+            };
+            applied += 1;
+        }
+    }
+
+    fn apply_body(self: *Standby, reader: *std.Io.Reader, header: Header) !void {
+        const scr = &self.screen;
+        const spans = try reader.takeInt(u16, .little);
+        for (0..spans) |_| {
+            const address = try reader.takeInt(u16, .little);
+            const len = try reader.takeInt(u16, .little);
+            if (@as(usize, address) + len > scr.size()) return error.InvalidSnapshot;
+            @memcpy(scr.buffer[address..][0..len], try reader.take(len));
+            @memcpy(scr.attributes[address..][0..len], try reader.take(len));
+            @memcpy(scr.colors[address..][0..len], try reader.take(len));
+            scr.mark_dirty(address, len);
+        }
+
+        if (header.has_fields) {
+            self.fields.reset();
+            const count = try reader.takeInt(u16, .little);
+            for (0..count) |_| {
+                const start = try reader.takeInt(u16, .little);
+                const length = try reader.takeInt(u16, .little);
+                const attr: protocol.FieldAttribute = @bitCast(try reader.takeByte());
+                _ = try self.fields.add_field(start, length, attr);
+            }
+        }
+
+        scr.reset_modified();
+        const runs = try reader.takeInt(u16, .little);
+        for (0..runs) |_| {
+            const start = try reader.takeInt(u16, .little);
+            const len = try reader.takeInt(u16, .little);
+            scr.mark_modified(start, len);
+        }
+        if (reader.seek != reader.end) return error.InvalidSnapshot;
+    }
+
+    /// Copy the replica into a session's screen and field table (same
+    /// dimensions) and return the cursor and keyboard state
+    pub fn restore_into(self: *Standby, scr: *screen.Screen, fields: *field.FieldManager) !State {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        if (!self.ready) return error.StandbyNotReady;
+
+        try scr.copy_from(&self.screen);
+        fields.reset();
+        // Frames carry attribute bytes but not which cells start a field;
+        // the field table does
+        scr.field_starts.unsetAll();
+        for (self.fields.fields.items) |f| {
+            _ = try fields.add_field(f.start_address, f.length, f.attribute);
+            if (f.start_address < scr.size()) scr.field_starts.set(f.start_address);
+        }
+        fields.rebuild_tab_index();
+        return self.state;
+    }
+};
+
+/// Fill `buffer` from `stream`; false when the peer closed before the
+/// first byte
+fn read_full(stream: std.net.Stream, buffer: []u8) !bool {
+    var filled: usize = 0;
+    while (filled < buffer.len) {
+        const bytes_read = try stream.read(buffer[filled..]);
+        if (bytes_read == 0) {
+            if (filled == 0) return false;
+            return error.EndOfStream;
+        }
+        filled += bytes_read;
+    }
+    return true;
+}
+
+/// Apply a checkpoint log (or any concatenation of frames) to `standby`
+/// and return how many frames were applied. A torn frame at the end, as
+/// left by a crash mid-write, ends the replay.
+pub fn replay(standby: *Standby, bytes: []const u8) !usize {
+    var rest = bytes;
+    var applied: usize = 0;
+    while (frame_len(rest)) |len| {
+        if (len > rest.len) break;
+        standby.apply(rest[0..len]) catch |err| {
+            if (applied == 0) return err;
+            break;
+        };
+        rest = rest[len..];
+        applied += 1;
+    }
+    if (applied == 0) return error.InvalidSnapshot;
+    return applied;
+}
+
+test "checkpoints carry only changes and rebuild the session" {
+    const allocator = std.testing.allocator;
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+    var fm = field.FieldManager.init(allocator);
+    defer fm.deinit();
+    var checkpointer = Checkpointer.init(allocator);
+    defer checkpointer.deinit();
+    var standby = try Standby.init(allocator, 24, 80);
+    defer standby.deinit();
+
+    _ = try fm.add_field(0, 6, .{ .protected = true });
+    _ = try fm.add_field(80, 8, .{});
+    _ = scr.write_run(1, "LOGON");
+    const full = try checkpointer.capture(&scr, &fm, .{ .cursor = 81 });
+    try std.testing.expectEqual(Kind.full, (try Header.parse(full)).kind);
+    try std.testing.expect(full.len > scr.size() * 3);
+    try standby.apply(full);
+
+    // Typing two characters costs one span, no field table
+    _ = scr.write_run(81, "AB");
+    scr.mark_modified(81, 2);
+    const delta = try checkpointer.capture(&scr, &fm, .{ .cursor = 83, .keyboard_locked = true });
+    const header = try Header.parse(delta);
+    try std.testing.expectEqual(Kind.delta, header.kind);
+    try std.testing.expect(!header.has_fields);
+    try std.testing.expectEqual(@as(usize, header_len + 2 + 4 + 2 * 3 + 2 + 4), delta.len);
+    try standby.apply(delta);
+
+    var target = try screen.Screen.init(allocator, 24, 80);
+    defer target.deinit();
+    var target_fields = field.FieldManager.init(allocator);
+    defer target_fields.deinit();
+    const state = try standby.restore_into(&target, &target_fields);
+    try std.testing.expectEqual(@as(u16, 83), state.cursor);
+    try std.testing.expect(state.keyboard_locked);
+    try std.testing.expectEqualSlices(u8, scr.buffer, target.buffer);
+    try std.testing.expect(target.is_modified(82) and !target.is_modified(83));
+    try std.testing.expectEqual(@as(usize, 2), target_fields.count());
+    try std.testing.expect(target_fields.find_field(0).?.attribute.protected);
+
+    // A lost delta is detected; the standby waits for a full frame
+    _ = scr.write_run(84, "C");
+    _ = try checkpointer.capture(&scr, &fm, .{});
+    _ = scr.write_run(85, "D");
+    try std.testing.expectError(error.SequenceGap, standby.apply(try checkpointer.capture(&scr, &fm, .{})));
+    try std.testing.expectError(error.StandbyNotReady, standby.restore_into(&target, &target_fields));
+    checkpointer.request_full();
+    try standby.apply(try checkpointer.capture(&scr, &fm, .{}));
+    try std.testing.expectEqualSlices(u8, scr.buffer, standby.screen.buffer);
+}
+
+test "checkpoint log replaces itself on a full frame" {
+    const allocator = std.testing.allocator;
+    var tmp = std.testing.tmpDir(.{});
+    defer tmp.cleanup();
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+    var checkpointer = Checkpointer.init(allocator);
+    defer checkpointer.deinit();
+
+    var log = FileSink{ .dir = try tmp.dir.openDir(".", .{}), .name = "checkpoint.bin" };
+    defer log.close();
+    const sink = log.sink();
+
+    _ = scr.write_run(0, "OLD");
+    try sink.func(sink.context, try checkpointer.capture(&scr, null, .{}));
+    _ = scr.write_run(0, "NEW");
+    const delta = try checkpointer.capture(&scr, null, .{});
+    try sink.func(sink.context, delta);
+    const first_len = (try tmp.dir.statFile("checkpoint.bin")).size;
+
+    // The new snapshot takes the old log's place; no temporary is left
+    checkpointer.request_full();
+    const full = try checkpointer.capture(&scr, null, .{});
+    try sink.func(sink.context, full);
+    try std.testing.expectEqual(@as(u64, full.len), (try tmp.dir.statFile("checkpoint.bin")).size);
+    try std.testing.expect(first_len > full.len);
+    try std.testing.expectError(error.FileNotFound, tmp.dir.statFile("checkpoint.bin.tmp"));
+
+    var standby = try Standby.init(allocator, 24, 80);
+    defer standby.deinit();
+    const bytes = try tmp.dir.readFileAlloc(allocator, "checkpoint.bin", 1 << 20);
+    defer allocator.free(bytes);
+    try std.testing.expectEqual(@as(usize, 1), try replay(&standby, bytes));
+    try std.testing.expectEqualStrings("NEW", standby.screen.buffer[0..3]);
+}
+
+test "checkpoint writer feeds sinks off the caller's thread" {
+    const allocator = std.testing.allocator;
+    var scr = try screen.Screen.init(allocator, 24, 80);
+    defer scr.deinit();
+    var checkpointer = Checkpointer.init(allocator);
+    defer checkpointer.deinit();
+    var standby = try Standby.init(allocator, 24, 80);
+    defer standby.deinit();
+
+    var log: std.ArrayList(u8) = .empty;
+    defer log.deinit(allocator);
+    const Log = struct {
+        fn append(context: *anyopaque, frame: []const u8) anyerror!void {
+            const list: *std.ArrayList(u8) = @ptrCast(@alignCast(context));
+            try list.appendSlice(std.testing.allocator, frame);
+        }
+    };
+
+    var writer = CheckpointWriter.init(allocator, .{});
+    defer writer.deinit();
+    try writer.add_sink(standby.sink());
+    try writer.add_sink(.{ .context = &log, .func = Log.append });
+    try writer.start();
+
+    for (0..10) |i| {
+        try scr.write_at(@intCast(i * 7), 'A' + @as(u8, @intCast(i)));
+        try writer.submit(try checkpointer.capture(&scr, null, .{ .cursor = @intCast(i) }));
+    }
+    writer.flush();
+    try std.testing.expectEqual(@as(u64, 10), writer.frames_written);
+    try std.testing.expect(!writer.take_resync());
+    try std.testing.expectEqualSlices(u8, scr.buffer, standby.screen.buffer);
+    try std.testing.expectEqual(@as(u16, 9), standby.state.cursor);
+
+    // The log replays to the same state; a torn tail is ignored
+    var recovered = try Standby.init(allocator, 24, 80);
+    defer recovered.deinit();
+    try std.testing.expectEqual(@as(usize, 9), try replay(&recovered, log.items[0 .. log.items.len - 3]));
+    try std.testing.expectEqual(@as(u16, 8), recovered.state.cursor);
+}
@@ -0,0 +1,691 @@
+//! Batched, sampled span export pipeline for 3270 transactions.
+//!
+//! Spans live in a fixed pool of records allocated once at init, so
+//! starting and ending a span never touches the heap. Sampling happens at
+//! both ends of a span:
+//! - head: a deterministic per-trace decision from the trace id, so every
+//!   span of a trace agrees
+//! - tail: when the span ends, errored spans and spans slower than
+//!   `slow_threshold_ns` are kept even if the head decision dropped them,
+//!   and so is the rest of their trace. Until the local root span ends,
+//!   its unsampled descendants wait in the pool, parked on the root. When
+//!   it ends they are all exported if any span of the trace was kept, and
+//!   freed otherwise. A child that outlives its root decides alone.
+//!
+//! Kept spans go onto a lock-free queue. A background exporter drains the
+//! queue in batches, encodes them as OTLP/JSON and hands each payload to a
+//! Transport, which is OTLP/HTTP by default. When the pool runs dry,
+//! start_span returns a no-op span and counts the drop rather than
+//! blocking the session thread.
+
+const std = @import("std");
+
+pub const max_name_len = 64;
+pub const max_attributes = 8;
+pub const max_string_len = 48;
+
+pub const Status = enum(u8) {
+    unset = 0,
+    ok = 1,
+    err = 2,
+};
+
+/// String kept inline in the record; longer values are truncated
+pub const InlineString = struct {
+    bytes: [max_string_len]u8 = undefined,
+    len: u8 = 0,
+
+    pub fn init(value: []const u8) InlineString {
+        var s = InlineString{};
+        s.len = @intCast(@min(value.len, max_string_len));
+        @memcpy(s.bytes[0..s.len], value[0..s.len]);
+        return s;
+    }
+
+    pub fn slice(self: *const InlineString) []const u8 {
+        return self.bytes[0..self.len];
+    }
+};
+
+pub const AttributeValue = union(enum) {
+    string: InlineString,
+    int: i64,
+    float: f64,
+    bool: bool,
+};
+
+pub const Attribute = struct {
+    /// Must outlive the export, in practice a string literal
+    key: []const u8,
+    value: AttributeValue,
+};
+
+/// Pooled span storage
+pub const SpanRecord = struct {
+    trace_id: [16]u8,
+    span_id: [8]u8,
+    parent_span_id: ?[8]u8,
+    name: [max_name_len]u8,
+    name_len: u8,
+    start_time_ns: u64,
+    end_time_ns: u64,
+    status: Status,
+    head_sampled: bool,
+    attributes: [max_attributes]Attribute,
+    attribute_count: u8,
+    /// Record index of the trace's local root, and its `trace_state`
+    /// generation when the root started
+    root: u32,
+    root_generation: u32,
+    /// Next parked span on the root's list, index + 1 (0 = end)
+    deferred_next: u32,
+    /// Used while this record is a local root: generation (upper 32 bits),
+    /// `trace_keep`, and index + 1 of the first parked span. Survives
+    /// reuse of the record, so late children of an ended root see the
+    /// generation move on.
+    trace_state: std.atomic.Value(u64),
+};
+
+/// Some span of the trace was kept, so every span of it is
+const trace_keep: u64 = 1 << 31;
+const trace_head_mask: u64 = trace_keep - 1;
+
+/// Where encoded batches go
+pub const Transport = struct {
+    context: *anyopaque,
+    send: *const fn (context: *anyopaque, payload: []const u8) anyerror!void,
+};
+
+/// POSTs OTLP/JSON to a collector, e.g. http://localhost:4318/v1/traces
+pub const OtlpHttpTransport = struct {
+    client: std.http.Client,
+    url: []const u8,
+
+    pub fn init(allocator: std.mem.Allocator, url: []const u8) OtlpHttpTransport {
+        return .{
+            .client = .{ .allocator = allocator },
+            .url = url,
+        };
+    }
+
+    pub fn deinit(self: *OtlpHttpTransport) void {
+        self.client.deinit();
+    }
+
+    pub fn transport(self: *OtlpHttpTransport) Transport {
+        return .{ .context = self, .send = send };
+    }
+
+    fn send(context: *anyopaque, payload: []const u8) anyerror!void {
+        const self: *OtlpHttpTransport = @ptrCast(@alignCast(context));
+        const result = try self.client.fetch(.{
+            .location = .{ .url = self.url },
+            .method = .POST,
+            .payload = payload,
+            .headers = .{ .content_type = .{ .override = "application/json" } },
+        });
+        if (result.status.class() != .success) return error.ExportRejected;
+    }
+};
+
+pub const Options = struct {
+    /// Span records in the pool
+    capacity: u32 = 2048,
+    /// Fraction of traces kept by head sampling
+    sample_ratio: f64 = 0.05,
+    /// Spans at least this slow are always kept
+    slow_threshold_ns: u64 = 500 * std.time.ns_per_ms,
+    max_batch: u32 = 256,
+    export_interval_ms: u32 = 1000,
+    service_name: []const u8 = "zig-3270",
+};
+
+pub const Stats = struct {
+    started: u64,
+    exported: u64,
+    sampled_out: u64,
+    dropped: u64,
+    export_failures: u64,
+};
+
+/// Lock-free stack of free record indices. The head packs an ABA tag in
+/// the upper half and index + 1 (0 = empty) in the lower half.
+const FreeList = struct {
+    head: std.atomic.Value(u64) = .init(0),
+    next: []std.atomic.Value(u32),
+
+    fn pop(self: *FreeList) ?u32 {
+        var head = self.head.load(.acquire);
+        while (true) {
+            const slot: u32 = @truncate(head);
+            if (slot == 0) return null;
+            const tag = head >> 32;
+            const next = self.next[slot - 1].load(.monotonic);
+            const new_head = ((tag + 1) << 32) | next;
+            head = self.head.cmpxchgWeak(head, new_head, .acquire, .acquire) orelse return slot - 1;
+        }
+    }
+
+    fn push(self: *FreeList, index: u32) void {
+        var head = self.head.load(.monotonic);
+        while (true) {
+            self.next[index].store(@truncate(head), .monotonic);
+            const new_head = (((head >> 32) + 1) << 32) | (index + 1);
+            head = self.head.cmpxchgWeak(head, new_head, .release, .monotonic) orelse return;
+        }
+    }
+};
+
+/// Bounded MPSC queue of record indices, sized to the pool so a push can
+/// never find it full
+const ExportQueue = struct {
+    sequence: []std.atomic.Value(usize),
+    items: []u32,
+    mask: usize,
+    enqueue_pos: std.atomic.Value(usize) align(std.atomic.cache_line) = .init(0),
+    dequeue_pos: usize align(std.atomic.cache_line) = 0,
+
+    fn push(self: *ExportQueue, index: u32) void {
+        const pos = self.enqueue_pos.fetchAdd(1, .monotonic);
+        const slot = pos & self.mask;
+        // Spins only if the consumer has not yet released this slot
+        while (self.sequence[slot].load(.acquire) != pos) std.atomic.spinLoopHint();
+        self.items[slot] = index;
+        self.sequence[slot].store(pos + 1, .release);
+    }
+
+    fn pop(self: *ExportQueue) ?u32 {
+        const slot = self.dequeue_pos & self.mask;
+        if (self.sequence[slot].load(.acquire) != self.dequeue_pos + 1) return null;
+        const index = self.items[slot];
+        self.sequence[slot].store(self.dequeue_pos + self.items.len, .release);
+        self.dequeue_pos += 1;
+        return index;
+    }
+};
+
+/// Handle to an in-flight span. A span from an exhausted pool has no
+/// record and ignores every call.
+pub const Span = struct {
+    processor: *SpanProcessor,
+    record: ?*SpanRecord,
+
+    pub fn set_attribute(self: Span, key: []const u8, value: AttributeValue) void {
+        const rec = self.record orelse return;
+        if (rec.attribute_count == max_attributes) return;
+        rec.attributes[rec.attribute_count] = .{ .key = key, .value = value };
+        rec.attribute_count += 1;
+    }
+
+    pub fn set_string(self: Span, key: []const u8, value: []const u8) void {
+        self.set_attribute(key, .{ .string = .init(value) });
+    }
+
+    pub fn set_status(self: Span, status: Status) void {
+        if (self.record) |rec| rec.status = status;
+    }
+
+    pub fn end(self: *Span) void {
+        const rec = self.record orelse return;
+        self.record = null;
+        rec.end_time_ns = now_ns();
+        self.processor.finish(rec);
+    }
+};
+
+pub const SpanProcessor = struct {
+    allocator: std.mem.Allocator,
+    options: Options,
+    transport: Transport,
+    records: []SpanRecord,
+    free: FreeList,
+    queue: ExportQueue,
+    /// Head sampling threshold over the first 8 trace id bytes
+    sample_threshold: u64,
+
+    /// Exporter state
+    batch: []u32,
+    payload: std.Io.Writer.Allocating,
+    thread: ?std.Thread = null,
+    wakeup: std.Thread.ResetEvent = .{},
+    stopping: std.atomic.Value(bool) = .init(false),
+    pending: std.atomic.Value(u32) = .init(0),
+
+    started: std.atomic.Value(u64) = .init(0),
+    exported: std.atomic.Value(u64) = .init(0),
+    sampled_out: std.atomic.Value(u64) = .init(0),
+    dropped: std.atomic.Value(u64) = .init(0),
+    export_failures: std.atomic.Value(u64) = .init(0),
+
+    pub fn init(allocator: std.mem.Allocator, options: Options, transport: Transport) !SpanProcessor {
+        const capacity = std.math.ceilPowerOfTwo(u32, @max(options.capacity, 2)) catch return error.OutOfMemory;
+
+        const records = try allocator.alloc(SpanRecord, capacity);
+        errdefer allocator.free(records);
+        const next = try allocator.alloc(std.atomic.Value(u32), capacity);
+        errdefer allocator.free(next);
+        const sequence = try allocator.alloc(std.atomic.Value(usize), capacity);
+        errdefer allocator.free(sequence);
+        const items = try allocator.alloc(u32, capacity);
+        errdefer allocator.free(items);
+        const batch = try allocator.alloc(u32, @max(options.max_batch, 1));
+        errdefer allocator.free(batch);
+
+        var free = FreeList{ .next = next };
+        for (0..capacity) |i| {
+            next[i] = .init(0);
+            records[i].trace_state = .init(0);
+            free.push(@intCast(i));
+        }
+        for (sequence, 0..) |*s, i| s.* = .init(i);
+
+        const ratio = std.math.clamp(options.sample_ratio, 0, 1);
+        return .{
+            .allocator = allocator,
+            .options = options,
+            .transport = transport,
+            .records = records,
+            .free = free,
+            .queue = .{ .sequence = sequence, .items = items, .mask = capacity - 1 },
+            .sample_threshold = if (ratio >= 1)
+                std.math.maxInt(u64)
+            else
+                @intFromFloat(ratio * @as(f64, @floatFromInt(std.math.maxInt(u64)))),
+            .batch = batch,
+            .payload = .init(allocator),
+        };
+    }
+
+    /// Spawn the exporter thread. The processor must not move afterwards.
+    pub fn start(self: *SpanProcessor) !void {
+        if (self.thread != null) return error.AlreadyStarted;
+        self.thread = try std.Thread.spawn(.{}, export_loop, .{self});
+    }
+
+    /// Stop the exporter after it has sent every queued span
+    pub fn shutdown(self: *SpanProcessor) void {
+        const thread = self.thread orelse return;
+        self.stopping.store(true, .release);
+        self.wakeup.set();
+        thread.join();
+        self.thread = null;
+    }
+
+    pub fn deinit(self: *SpanProcessor) void {
+        self.shutdown();
+        self.payload.deinit();
+        self.allocator.free(self.batch);
+        self.allocator.free(self.queue.items);
+        self.allocator.free(self.queue.sequence);
+        self.allocator.free(self.free.next);
+        self.allocator.free(self.records);
+    }
+
+    /// Start a span, as a child of `parent` when given
+    pub fn start_span(self: *SpanProcessor, name: []const u8, parent: ?*const Span) Span {
+        _ = self.started.fetchAdd(1, .monotonic);
+        const index = self.free.pop() orelse {
+            _ = self.dropped.fetchAdd(1, .monotonic);
+            return .{ .processor = self, .record = null };
+        };
+        const rec = &self.records[index];
+
+        const parent_record = if (parent) |p| p.record else null;
+        if (parent_record) |p| {
+            rec.trace_id = p.trace_id;
+            rec.parent_span_id = p.span_id;
+            rec.root = p.root;
+            rec.root_generation = p.root_generation;
+        } else {
+            std.crypto.random.bytes(&rec.trace_id);
+            rec.parent_span_id = null;
+            rec.root = index;
+            rec.root_generation = @intCast(rec.trace_state.load(.monotonic) >> 32);
+        }
+        std.crypto.random.bytes(&rec.span_id);
+
+        rec.name_len = @intCast(@min(name.len, max_name_len));
+        @memcpy(rec.name[0..rec.name_len], name[0..rec.name_len]);
+        rec.status = .unset;
+        rec.attribute_count = 0;
+        rec.head_sampled = std.mem.readInt(u64, rec.trace_id[0..8], .big) < self.sample_threshold or
+            self.sample_threshold == std.math.maxInt(u64);
+        rec.start_time_ns = now_ns();
+        return .{ .processor = self, .record = rec };
+    }
+
+    fn finish(self: *SpanProcessor, rec: *SpanRecord) void {
+        const index: u32 = @intCast((@intFromPtr(rec) - @intFromPtr(self.records.ptr)) / @sizeOf(SpanRecord));
+        // The head decision covers the whole trace
+        if (rec.head_sampled) return self.enqueue(index);
+
+        const slow = rec.end_time_ns -| rec.start_time_ns >= self.options.slow_threshold_ns;
+        const keep = slow or rec.status == .err;
+        if (rec.root == index) return self.finish_trace(rec, index, keep);
+
+        // Park on the root until the trace's fate is known, or flag the
+        // trace as kept
+        const root = &self.records[rec.root];
+        var state = root.trace_state.load(.acquire);
+        while (state >> 32 == rec.root_generation) {
+            if (state & trace_keep != 0) return self.enqueue(index);
+            const next = if (keep) state | trace_keep else (state & ~trace_head_mask) | (index + 1);
+            rec.deferred_next = @intCast(state & trace_head_mask);
+            state = root.trace_state.cmpxchgWeak(state, next, .acq_rel, .acquire) orelse {
+                if (keep) self.enqueue(index);
+                return;
+            };
+        }
+
+        // The root has ended already
+        if (keep) self.enqueue(index) else self.discard(index);
+    }
+
+    /// A local root ended: close its trace and settle the parked spans
+    fn finish_trace(self: *SpanProcessor, rec: *SpanRecord, index: u32, keep_root: bool) void {
+        // From here on, late children see a new generation and decide alone
+        const closed = @as(u64, rec.root_generation +% 1) << 32;
+        const state = rec.trace_state.swap(closed, .acq_rel);
+        const keep = keep_root or state & trace_keep != 0;
+
+        var next: u32 = @intCast(state & trace_head_mask);
+        while (next != 0) {
+            const parked = next - 1;
+            next = self.records[parked].deferred_next;
+            if (keep) self.enqueue(parked) else self.discard(parked);
+        }
+        if (keep) self.enqueue(index) else self.discard(index);
+    }
+
+    fn enqueue(self: *SpanProcessor, index: u32) void {
+        self.queue.push(index);
+        if (self.pending.fetchAdd(1, .monotonic) +% 1 == self.options.max_batch) self.wakeup.set();
+    }
+
+    fn discard(self: *SpanProcessor, index: u32) void {
+        _ = self.sampled_out.fetchAdd(1, .monotonic);
+        self.free.push(index);
+    }
+
+    pub fn stats(self: *const SpanProcessor) Stats {
+        return .{
+            .started = self.started.load(.monotonic),
+            .exported = self.exported.load(.monotonic),
+            .sampled_out = self.sampled_out.load(.monotonic),
+            .dropped = self.dropped.load(.monotonic),
+            .export_failures = self.export_failures.load(.monotonic),
+        };
+    }
+
+    fn export_loop(self: *SpanProcessor) void {
+        const interval_ns = @as(u64, self.options.export_interval_ms) * std.time.ns_per_ms;
+        while (true) {
+            self.wakeup.reset();
+            const stopping = self.stopping.load(.acquire);
+            const sent = self.export_batch();
+            if (stopping and sent == 0) break;
+            if (sent < self.batch.len) self.wakeup.timedWait(interval_ns) catch {};
+        }
+    }
+
+    /// Exporter only: send up to one batch. Returns the number of spans
+    /// taken off the queue.
+    pub fn export_batch(self: *SpanProcessor) usize {
+        var count: usize = 0;
+        while (count < self.batch.len) : (count += 1) {
+            self.batch[count] = self.queue.pop() orelse break;
+        }
+        if (count == 0) return 0;
+        _ = self.pending.fetchSub(@intCast(count), .monotonic);
+
+        const indices = self.batch[0..count];
+        self.payload.clearRetainingCapacity();
+        if (encode_otlp(&self.payload.writer, self.options.service_name, self.records, indices)) {
+            if (self.transport.send(self.transport.context, self.payload.written())) {
+                _ = self.exported.fetchAdd(count, .monotonic);
+            } else |err| {
+                std.log.warn("span export failed: {s}", .{@errorName(err)});
+                _ = self.export_failures.fetchAdd(count, .monotonic);
+            }
+        } else |_| {
+            _ = self.export_failures.fetchAdd(count, .monotonic);
+        }
+
+        for (indices) |index| self.free.push(index);
+        return count;
+    }
+};
+
+fn now_ns() u64 {
+    return @intCast(std.time.nanoTimestamp());
+}
+
+/// Encode spans as an OTLP/JSON ExportTraceServiceRequest
+pub fn encode_otlp(
+    out: *std.Io.Writer,
+    service_name: []const u8,
+    records: []const SpanRecord,
+    indices: []const u32,
+) std.Io.Writer.Error!void {
+    try out.writeAll("{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\",\"value\":{\"stringValue\":");
+    try std.json.Stringify.encodeJsonString(service_name, .{}, out);
+    try out.writeAll("}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"zig-3270\"},\"spans\":[");
+
+    for (indices, 0..) |index, i| {
+        const rec = &records[index];
+        if (i > 0) try out.writeByte(',');
+
+        try out.print("{{\"traceId\":\"{s}\",\"spanId\":\"{s}\",", .{
+            &std.fmt.bytesToHex(rec.trace_id, .lower),
+            &std.fmt.bytesToHex(rec.span_id, .lower),
+        });
+        if (rec.parent_span_id) |parent| {
+            try out.print("\"parentSpanId\":\"{s}\",", .{&std.fmt.bytesToHex(parent, .lower)});
+        }
+        try out.writeAll("\"name\":");
+        try std.json.Stringify.encodeJsonString(rec.name[0..rec.name_len], .{}, out);
+        try out.print(",\"kind\":1,\"startTimeUnixNano\":\"{d}\",\"endTimeUnixNano\":\"{d}\",\"attributes\":[", .{
+            rec.start_time_ns,
+            rec.end_time_ns,
+        });
+
+        for (rec.attributes[0..rec.attribute_count], 0..) |*attr, a| {
+            if (a > 0) try out.writeByte(',');
+            try out.writeAll("{\"key\":");
+            try std.json.Stringify.encodeJsonString(attr.key, .{}, out);
+            try out.writeAll(",\"value\":{");
+            switch (attr.value) {
+                .string => |*s| {
+                    try out.writeAll("\"stringValue\":");
+                    try std.json.Stringify.encodeJsonString(s.slice(), .{}, out);
+                },
+                .int => |v| try out.print("\"intValue\":\"{d}\"", .{v}),
+                .float => |v| {
+                    // JSON has no NaN or Infinity; the proto3 JSON mapping
+                    // spells them as strings
+                    if (std.math.isNan(v)) {
+                        try out.writeAll("\"doubleValue\":\"NaN\"");
+                    } else if (std.math.isInf(v)) {
+                        try out.writeAll(if (v > 0) "\"doubleValue\":\"Infinity\"" else "\"doubleValue\":\"-Infinity\"");
+                    } else {
+                        try out.print("\"doubleValue\":{d}", .{v});
+                    }
+                },
+                .bool => |v| try out.print("\"boolValue\":{}", .{v}),
+            }
+            try out.writeAll("}}");
+        }
+        try out.print("],\"status\":{{\"code\":{d}}}}}", .{@intFromEnum(rec.status)});
+    }
+
+    try out.writeAll("]}]}]}");
+}
+
+// Tests
+
+const CaptureTransport = struct {
+    allocator: std.mem.Allocator,
+    payloads: std.ArrayList([]u8) = .empty,
+    mutex: std.Thread.Mutex = .{},
+
+    fn transport(self: *CaptureTransport) Transport {
+        return .{ .context = self, .send = send };
+    }
+
+    fn send(context: *anyopaque, payload: []const u8) anyerror!void {
+        const self: *CaptureTransport = @ptrCast(@alignCast(context));
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        try self.payloads.append(self.allocator, try self.allocator.dupe(u8, payload));
+    }
+
+    fn deinit(self: *CaptureTransport) void {
+        for (self.payloads.items) |p| self.allocator.free(p);
+        self.payloads.deinit(self.allocator);
+    }
+};
+
+test "span processor tail sampling keeps errored and slow spans" {
+    const allocator = std.testing.allocator;
+    var capture = CaptureTransport{ .allocator = allocator };
+    defer capture.deinit();
+
+    var processor = try SpanProcessor.init(allocator, .{
+        .capacity = 16,
+        .sample_ratio = 0,
+        .slow_threshold_ns = 1_000 * std.time.ns_per_s,
+    }, capture.transport());
+    defer processor.deinit();
+
+    var fast = processor.start_span("tn3270.transaction", null);
+    fast.end();
+
+    var failed = processor.start_span("tn3270.transaction", null);
+    failed.set_string("tn3270.aid", "enter");
+    failed.set_attribute("tn3270.bytes", .{ .int = 1920 });
+    failed.set_status(.err);
+    var child = processor.start_span("tn3270.parse", &failed);
+    child.end();
+    failed.end();
+
+    var slow = processor.start_span("tn3270.transaction", null);
+    slow.record.?.start_time_ns -= 2_000 * std.time.ns_per_s;
+    slow.end();
+
+    // The unsampled child is exported with its errored parent
+    try std.testing.expectEqual(@as(usize, 3), processor.export_batch());
+    const stats = processor.stats();
+    try std.testing.expectEqual(@as(u64, 4), stats.started);
+    try std.testing.expectEqual(@as(u64, 1), stats.sampled_out);
+    try std.testing.expectEqual(@as(u64, 3), stats.exported);
+
+    const payload = capture.payloads.items[0];
+    try std.testing.expectEqual(@as(usize, 3), std.mem.count(u8, payload, "\"spanId\""));
+    try std.testing.expectEqual(@as(usize, 1), std.mem.count(u8, payload, "\"parentSpanId\""));
+    try std.testing.expect(std.mem.indexOf(u8, payload, "{\"key\":\"tn3270.aid\",\"value\":{\"stringValue\":\"enter\"}}") != null);
+    try std.testing.expect(std.mem.indexOf(u8, payload, "\"status\":{\"code\":2}") != null);
+
+    const parsed = try std.json.parseFromSlice(std.json.Value, allocator, payload, .{});
+    parsed.deinit();
+}
+
+test "span processor tail sampling keeps the trace of an errored child" {
+    const allocator = std.testing.allocator;
+    var capture = CaptureTransport{ .allocator = allocator };
+    defer capture.deinit();
+
+    var processor = try SpanProcessor.init(allocator, .{
+        .capacity = 16,
+        .sample_ratio = 0,
+        .slow_threshold_ns = 1_000 * std.time.ns_per_s,
+    }, capture.transport());
+    defer processor.deinit();
+
+    // A fast trace is dropped whole, its child parked until the root ends
+    var quiet = processor.start_span("tn3270.transaction", null);
+    var quiet_child = processor.start_span("tn3270.parse", &quiet);
+    quiet_child.end();
+    try std.testing.expectEqual(@as(u64, 0), processor.stats().sampled_out);
+    quiet.end();
+    try std.testing.expectEqual(@as(u64, 2), processor.stats().sampled_out);
+
+    var root = processor.start_span("tn3270.transaction", null);
+    root.set_attribute("tn3270.ratio", .{ .float = std.math.nan(f64) });
+    root.set_attribute("tn3270.limit", .{ .float = -std.math.inf(f64) });
+    var parse = processor.start_span("tn3270.parse", &root);
+    parse.end();
+    var execute = processor.start_span("tn3270.execute", &root);
+    execute.set_status(.err);
+    execute.end();
+    var late = processor.start_span("tn3270.render", &root);
+    root.end();
+
+    // A child ending after its root decides alone
+    late.end();
+
+    try std.testing.expectEqual(@as(usize, 3), processor.export_batch());
+    try std.testing.expectEqual(@as(u64, 3), processor.stats().sampled_out);
+
+    // Non-finite doubles use the proto3 JSON strings
+    const payload = capture.payloads.items[0];
+    try std.testing.expect(std.mem.indexOf(u8, payload, "\"doubleValue\":\"NaN\"") != null);
+    try std.testing.expect(std.mem.indexOf(u8, payload, "\"doubleValue\":\"-Infinity\"") != null);
+    const parsed = try std.json.parseFromSlice(std.json.Value, allocator, payload, .{});
+    parsed.deinit();
+}
+
+test "span processor pool exhaustion yields no-op spans" {
+    const allocator = std.testing.allocator;
+    var capture = CaptureTransport{ .allocator = allocator };
+    defer capture.deinit();
+
+    var processor = try SpanProcessor.init(allocator, .{ .capacity = 2, .sample_ratio = 1 }, capture.transport());
+    defer processor.deinit();
+
+    var a = processor.start_span("a", null);
+    var b = processor.start_span("b", null);
+    var c = processor.start_span("c", null);
+    try std.testing.expect(c.record == null);
+    c.set_status(.err);
+    c.end();
+    a.end();
+    b.end();
+
+    // Records come back to the pool once exported
+    try std.testing.expectEqual(@as(usize, 2), processor.export_batch());
+    var d = processor.start_span("d", null);
+    try std.testing.expect(d.record != null);
+    d.end();
+    try std.testing.expectEqual(@as(u64, 1), processor.stats().dropped);
+}
+
+test "span processor background exporter drains on shutdown" {
+    const allocator = std.testing.allocator;
+    var capture = CaptureTransport{ .allocator = allocator };
+    defer capture.deinit();
+
+    var processor = try SpanProcessor.init(allocator, .{
+        .capacity = 256,
+        .sample_ratio = 1,
+        .max_batch = 32,
+    }, capture.transport());
+    defer processor.deinit();
+    try processor.start();
+
+    const Worker = struct {
+        fn run(p: *SpanProcessor) void {
+            for (0..100) |_| {
+                var span = p.start_span("tn3270.transaction", null);
+                span.end();
+            }
+        }
+    };
+    var threads: [4]std.Thread = undefined;
+    for (&threads) |*t| t.* = try std.Thread.spawn(.{}, Worker.run, .{&processor});
+    for (threads) |t| t.join();
+    processor.shutdown();
+
+    const stats = processor.stats();
+    try std.testing.expectEqual(@as(u64, 400), stats.started);
+    try std.testing.expectEqual(stats.started - stats.dropped, stats.exported);
+}
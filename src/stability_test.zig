@@ -2,6 +2,7 @@
 /// Tests system stability under sustained load, extended operations, and resource cleanup
 const std = @import("std");
 const testing = std.testing;
+const session_recorder = @import("session_recorder.zig");
 
 /// Statistics for a stability test run
 pub const StabilityStats = struct {
@@ -347,3 +348,37 @@ test "stability: multiple allocators independent operation" {
 
     try testing.expect(buf1.ptr != buf2.ptr);
 }
+
+test "stability: long streamed recording replays in bounded memory" {
+    const path = "/tmp/stability_recording.z3rl";
+    const screen = [_]u8{0x40} ** 1920;
+
+    {
+        const file = try std.fs.cwd().createFile(path, .{});
+        defer file.close();
+        var file_buf: [4096]u8 = undefined;
+        var file_writer = file.writer(&file_buf);
+
+        // Recording allocates nothing: the writer's buffer is the only memory.
+        var recorder = session_recorder.SessionRecorder.init(testing.failing_allocator);
+        defer recorder.deinit();
+        recorder.start();
+        try recorder.stream_to(&file_writer.interface);
+
+        for (0..20_000) |i| {
+            try recorder.record(if (i % 2 == 0) .keyboard_input else .response, if (i % 2 == 0) "K" else &screen);
+        }
+        try file_writer.interface.flush();
+    }
+
+    var mapped = try session_recorder.MappedRecording.open(path);
+    defer mapped.close();
+    var reader = try mapped.reader();
+
+    var stats = StabilityStats{};
+    while (try reader.next()) |event| {
+        if (event.event_type == .response) try testing.expectEqual(screen.len, event.data.len);
+        stats.total_commands += 1;
+    }
+    try testing.expectEqual(@as(usize, 20_000), stats.total_commands);
+}
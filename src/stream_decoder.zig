@@ -0,0 +1,483 @@
+//! Incremental TN3270 data-stream decoder.
+//!
+//! Consumes arbitrary TCP fragments from a `zero_copy_parser.RingBufferIO`
+//! and resolves telnet IAC escaping, EOR record framing and 3270 orders in
+//! a single resumable state machine. Text is returned as slices borrowed
+//! from the ring; a record split across reads is decoded piecewise and is
+//! never reassembled into a temporary buffer. Write Structured Field
+//! records are split into field headers and payload chunks the same way,
+//! so negotiation traffic is decoded without allocating.
+const std = @import("std");
+const protocol = @import("protocol.zig");
+const parse_utils = @import("parse_utils.zig");
+const zero_copy_parser = @import("zero_copy_parser.zig");
+const client = @import("client.zig");
+const structured_fields = @import("structured_fields.zig");
+const zone_trace = @import("zone_trace.zig");
+
+const RingBufferIO = zero_copy_parser.RingBufferIO;
+
+const iac = @intFromEnum(client.TelnetCommand.iac);
+const eor = @intFromEnum(client.TelnetCommand.eor);
+const sb = @intFromEnum(client.TelnetCommand.sb);
+const se = @intFromEnum(client.TelnetCommand.se);
+const will = @intFromEnum(client.TelnetCommand.will);
+const dont = @intFromEnum(client.TelnetCommand.dont);
+
+/// Bytes that end a text run: IAC and every order code
+const run_terminators = blk: {
+    var table = [_]bool{false} ** 256;
+    table[iac] = true;
+    for (std.enums.values(protocol.OrderCode)) |code| {
+        table[@intFromEnum(code)] = true;
+    }
+    break :blk table;
+};
+
+/// Operand bytes following each order code
+pub fn operand_length(code: protocol.OrderCode) u2 {
+    return switch (code) {
+        .set_buffer_address, .set_attribute, .erase_unprotected => 2,
+        .start_field, .graphic_escape => 1,
+        .insert_cursor, .program_tab => 0,
+    };
+}
+
+/// Order with its operands copied inline (at most two bytes)
+pub const Order = struct {
+    code: protocol.OrderCode,
+    operand_bytes: [2]u8 = .{ 0, 0 },
+    operand_len: u2 = 0,
+
+    pub fn operands(self: *const Order) []const u8 {
+        return self.operand_bytes[0..self.operand_len];
+    }
+};
+
+/// Decoded stream event
+/// Slices borrow from the ring and stay valid until its next write.
+pub const Event = union(enum) {
+    /// First byte of a record
+    command: protocol.CommandCode,
+    order: Order,
+    /// Run of character data between orders
+    text: []const u8,
+    /// IAC EOR: the current record is complete
+    end_of_record,
+    /// Telnet command outside subnegotiation; option is set for WILL/WONT/DO/DONT
+    telnet: struct { command: u8, option: ?u8 = null },
+    /// Chunk of IAC SB ... IAC SE payload (option byte included)
+    subnegotiation: []const u8,
+    subnegotiation_end,
+    /// Header of the next structured field in a WSF record
+    structured_field: structured_fields.StructuredFieldHeader,
+    /// Chunk of the current structured field's payload. When one chunk
+    /// carries the whole payload, `structured_fields.decode_payload` gives
+    /// its typed form in place.
+    field_data: []const u8,
+};
+
+/// Resumable decoder state; holds no buffers of its own
+pub const StreamDecoder = struct {
+    telnet_state: TelnetState = .data,
+    record_state: RecordState = .command,
+    negotiation_command: u8 = 0,
+    pending: ?Order = null,
+    field_header: [3]u8 = undefined,
+    field_header_len: u2 = 0,
+    /// Payload bytes left in the current structured field
+    field_remaining: u16 = 0,
+
+    const TelnetState = enum { data, iac, option, subnegotiation, subnegotiation_iac };
+    const RecordState = enum { command, orders, structured_fields, discard };
+
+    pub fn init() StreamDecoder {
+        return .{};
+    }
+
+    /// Drop any partially decoded record or telnet sequence
+    pub fn reset(self: *StreamDecoder) void {
+        self.* = .{};
+    }
+
+    /// Decode the next event from the ring, consuming its bytes.
+    /// Returns null when more input is needed. `error.InvalidCommandCode`
+    /// and `error.InvalidFieldLength` skip the rest of the record;
+    /// `error.TruncatedOrder` and `error.TruncatedField` report an EOR that
+    /// arrived before an order's operands or a field's payload. Decoding
+    /// may continue after any of them.
+    pub fn next(self: *StreamDecoder, ring: *RingBufferIO) !?Event {
+        const zone = zone_trace.begin(.decode);
+        defer zone.end();
+        while (true) {
+            const view = (try ring.get_read_view()) orelse return null;
+            const bytes = view.data();
+
+            switch (self.telnet_state) {
+                .data => {
+                    if (bytes[0] == iac) {
+                        try ring.advance_read(1);
+                        self.telnet_state = .iac;
+                        continue;
+                    }
+                    if (try self.take_data(ring, bytes, false)) |event| return event;
+                },
+                .iac => {
+                    const byte = bytes[0];
+                    if (byte == iac) {
+                        // Escaped 0xFF: the second IAC is the data byte itself
+                        self.telnet_state = .data;
+                        if (try self.take_data(ring, bytes, true)) |event| return event;
+                        continue;
+                    }
+
+                    try ring.advance_read(1);
+                    switch (byte) {
+                        eor => {
+                            self.telnet_state = .data;
+                            self.record_state = .command;
+                            if (self.pending != null) {
+                                self.pending = null;
+                                return error.TruncatedOrder;
+                            }
+                            if (self.field_header_len > 0 or self.field_remaining > 0) {
+                                self.field_header_len = 0;
+                                self.field_remaining = 0;
+                                return error.TruncatedField;
+                            }
+                            return .end_of_record;
+                        },
+                        sb => self.telnet_state = .subnegotiation,
+                        will...dont => {
+                            self.negotiation_command = byte;
+                            self.telnet_state = .option;
+                        },
+                        else => {
+                            self.telnet_state = .data;
+                            return .{ .telnet = .{ .command = byte } };
+                        },
+                    }
+                },
+                .option => {
+                    try ring.advance_read(1);
+                    self.telnet_state = .data;
+                    return .{ .telnet = .{ .command = self.negotiation_command, .option = bytes[0] } };
+                },
+                .subnegotiation => {
+                    const run = std.mem.indexOfScalar(u8, bytes, iac) orelse bytes.len;
+                    if (run == 0) {
+                        try ring.advance_read(1);
+                        self.telnet_state = .subnegotiation_iac;
+                        continue;
+                    }
+                    try ring.advance_read(run);
+                    return .{ .subnegotiation = bytes[0..run] };
+                },
+                .subnegotiation_iac => {
+                    try ring.advance_read(1);
+                    switch (bytes[0]) {
+                        iac => {
+                            self.telnet_state = .subnegotiation;
+                            return .{ .subnegotiation = bytes[0..1] };
+                        },
+                        se => {
+                            self.telnet_state = .data;
+                            return .subnegotiation_end;
+                        },
+                        else => {
+                            // Malformed subnegotiation; resynchronise on the command
+                            self.telnet_state = .data;
+                            return .{ .telnet = .{ .command = bytes[0] } };
+                        },
+                    }
+                },
+            }
+        }
+    }
+
+    /// Consume 3270 data bytes from the front of `bytes`. `escaped` marks a
+    /// lone 0xFF produced by IAC IAC, which is always data.
+    fn take_data(self: *StreamDecoder, ring: *RingBufferIO, bytes: []const u8, escaped: bool) !?Event {
+        switch (self.record_state) {
+            .command => {
+                try ring.advance_read(1);
+                const code = parse_utils.parse_command_code(bytes[0]) catch {
+                    self.record_state = .discard;
+                    return error.InvalidCommandCode;
+                };
+                self.record_state = if (code == .write_structured_field) .structured_fields else .orders;
+                return .{ .command = code };
+            },
+            .structured_fields => {
+                if (self.field_remaining > 0) {
+                    const limit = @min(bytes.len, self.field_remaining);
+                    const run = if (escaped) 1 else std.mem.indexOfScalar(u8, bytes[0..limit], iac) orelse limit;
+                    try ring.advance_read(run);
+                    self.field_remaining -= @intCast(run);
+                    return .{ .field_data = bytes[0..run] };
+                }
+
+                // Headers are three bytes and may straddle fragments
+                try ring.advance_read(1);
+                self.field_header[self.field_header_len] = bytes[0];
+                self.field_header_len += 1;
+                if (self.field_header_len < self.field_header.len) return null;
+
+                self.field_header_len = 0;
+                const header = structured_fields.StructuredFieldHeader.from_buffer(&self.field_header).?;
+                if (header.length < self.field_header.len) {
+                    self.record_state = .discard;
+                    return error.InvalidFieldLength;
+                }
+                self.field_remaining = header.payload_len();
+                return .{ .structured_field = header };
+            },
+            .discard => {
+                const run = if (escaped) 1 else std.mem.indexOfScalar(u8, bytes, iac) orelse bytes.len;
+                try ring.advance_read(run);
+                return null;
+            },
+            .orders => {
+                if (self.pending) |*order| {
+                    try ring.advance_read(1);
+                    order.operand_bytes[order.operand_len] = bytes[0];
+                    order.operand_len += 1;
+                    if (order.operand_len < operand_length(order.code)) return null;
+
+                    const complete = order.*;
+                    self.pending = null;
+                    return .{ .order = complete };
+                }
+
+                if (!escaped and run_terminators[bytes[0]]) {
+                    try ring.advance_read(1);
+                    const order = Order{ .code = @enumFromInt(bytes[0]) };
+                    if (operand_length(order.code) == 0) return .{ .order = order };
+                    self.pending = order;
+                    return null;
+                }
+
+                var run: usize = 1;
+                if (!escaped) {
+                    while (run < bytes.len and !run_terminators[bytes[run]]) run += 1;
+                }
+                try ring.advance_read(run);
+                return .{ .text = bytes[0..run] };
+            },
+        }
+    }
+};
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+const TestEvent = union(enum) {
+    command: protocol.CommandCode,
+    order: Order,
+    text: []const u8,
+    end_of_record,
+    telnet: u8,
+};
+
+/// Feed `input` in `fragment`-sized writes and flatten the resulting events,
+/// merging adjacent text runs (fragmentation may split them).
+fn decode_fragmented(allocator: std.mem.Allocator, input: []const u8, fragment: usize) !struct {
+    events: std.ArrayList(TestEvent),
+    text: std.ArrayList(u8),
+} {
+    var ring = try RingBufferIO.init(allocator, 8);
+    defer ring.deinit();
+
+    var decoder = StreamDecoder.init();
+    var events: std.ArrayList(TestEvent) = .empty;
+    errdefer events.deinit(allocator);
+    var text: std.ArrayList(u8) = .empty;
+    errdefer text.deinit(allocator);
+
+    var offset: usize = 0;
+    while (offset < input.len) {
+        const end = @min(offset + fragment, input.len);
+        _ = try ring.write(input[offset..end]);
+        offset = end;
+
+        while (try decoder.next(&ring)) |event| {
+            switch (event) {
+                .command => |code| try events.append(allocator, .{ .command = code }),
+                .order => |order| try events.append(allocator, .{ .order = order }),
+                .text => |run| {
+                    const last = events.items.len;
+                    if (last == 0 or events.items[last - 1] != .text) {
+                        try events.append(allocator, .{ .text = "" });
+                    }
+                    try text.appendSlice(allocator, run);
+                },
+                .end_of_record => try events.append(allocator, .end_of_record),
+                .telnet => |t| try events.append(allocator, .{ .telnet = t.command }),
+                .subnegotiation, .subnegotiation_end, .structured_field, .field_data => {},
+            }
+        }
+    }
+
+    return .{ .events = events, .text = text };
+}
+
+test "stream decoder: record split across every byte boundary" {
+    const allocator = std.testing.allocator;
+    const record = [_]u8{
+        @intFromEnum(protocol.CommandCode.erase_write),
+        0x11, 0x00, 0x50, // SBA row 1
+        0x1D, 0x20, // SF protected
+        'A',  'B',
+        0xFF, 0xFF, // escaped 0xFF data byte
+        'C',
+        0x13, // IC
+        0xFF, 0xEF, // IAC EOR
+    };
+
+    var fragment: usize = 1;
+    while (fragment <= 7) : (fragment += 1) {
+        var result = try decode_fragmented(allocator, &record, fragment);
+        defer result.events.deinit(allocator);
+        defer result.text.deinit(allocator);
+
+        const events = result.events.items;
+        try std.testing.expectEqual(@as(usize, 6), events.len);
+        try std.testing.expectEqual(protocol.CommandCode.erase_write, events[0].command);
+        try std.testing.expectEqual(protocol.OrderCode.set_buffer_address, events[1].order.code);
+        try std.testing.expectEqualSlices(u8, &.{ 0x00, 0x50 }, events[1].order.operands());
+        try std.testing.expectEqual(protocol.OrderCode.start_field, events[2].order.code);
+        try std.testing.expectEqualSlices(u8, &.{0x20}, events[2].order.operands());
+        try std.testing.expect(events[3] == .text);
+        try std.testing.expectEqual(protocol.OrderCode.insert_cursor, events[4].order.code);
+        try std.testing.expect(events[5] == .end_of_record);
+        try std.testing.expectEqualSlices(u8, &.{ 'A', 'B', 0xFF, 'C' }, result.text.items);
+    }
+}
+
+test "stream decoder: text is borrowed from the ring" {
+    var ring = try RingBufferIO.init(std.testing.allocator, 32);
+    defer ring.deinit();
+
+    _ = try ring.write(&.{ @intFromEnum(protocol.CommandCode.write), 'H', 'I', 0xFF, 0xEF });
+
+    var decoder = StreamDecoder.init();
+    try std.testing.expect((try decoder.next(&ring)).? == .command);
+
+    const event = (try decoder.next(&ring)).?;
+    try std.testing.expectEqualStrings("HI", event.text);
+    try std.testing.expectEqual(@intFromPtr(&ring.buffer[1]), @intFromPtr(event.text.ptr));
+
+    try std.testing.expect((try decoder.next(&ring)).? == .end_of_record);
+    try std.testing.expectEqual(@as(?Event, null), try decoder.next(&ring));
+}
+
+test "stream decoder: telnet negotiation and subnegotiation" {
+    var ring = try RingBufferIO.init(std.testing.allocator, 32);
+    defer ring.deinit();
+
+    // IAC DO TERMINAL-TYPE, IAC SB 24 1 IAC SE
+    _ = try ring.write(&.{ 0xFF, 0xFD, 24, 0xFF, 0xFA, 24, 1, 0xFF, 0xF0 });
+
+    var decoder = StreamDecoder.init();
+    const negotiation = (try decoder.next(&ring)).?;
+    try std.testing.expectEqual(@as(u8, 0xFD), negotiation.telnet.command);
+    try std.testing.expectEqual(@as(?u8, 24), negotiation.telnet.option);
+
+    const payload = (try decoder.next(&ring)).?;
+    try std.testing.expectEqualSlices(u8, &.{ 24, 1 }, payload.subnegotiation);
+    try std.testing.expect((try decoder.next(&ring)).? == .subnegotiation_end);
+}
+
+test "stream decoder: invalid command skips to end of record" {
+    var ring = try RingBufferIO.init(std.testing.allocator, 32);
+    defer ring.deinit();
+
+    _ = try ring.write(&.{ 0x99, 'x', 0x11, 0xFF, 0xEF, @intFromEnum(protocol.CommandCode.write) });
+
+    var decoder = StreamDecoder.init();
+    try std.testing.expectError(error.InvalidCommandCode, decoder.next(&ring));
+    try std.testing.expect((try decoder.next(&ring)).? == .end_of_record);
+    try std.testing.expectEqual(protocol.CommandCode.write, (try decoder.next(&ring)).?.command);
+}
+
+test "stream decoder: eor inside order operands" {
+    var ring = try RingBufferIO.init(std.testing.allocator, 32);
+    defer ring.deinit();
+
+    _ = try ring.write(&.{ @intFromEnum(protocol.CommandCode.write), 0x11, 0x00, 0xFF, 0xEF });
+
+    var decoder = StreamDecoder.init();
+    _ = try decoder.next(&ring);
+    try std.testing.expectError(error.TruncatedOrder, decoder.next(&ring));
+    try std.testing.expectEqual(@as(?Event, null), try decoder.next(&ring));
+}
+
+test "stream decoder: structured fields split across fragments" {
+    const allocator = std.testing.allocator;
+    const record = [_]u8{
+        @intFromEnum(protocol.CommandCode.write_structured_field),
+        0x0B, 0x00, 0x06, 0x01, 0x02, 0x03, // color pair
+        0x15, 0x00, 0x06, 0x01, 0xFF, 0xFF, 0x37, // font, code page 0xFF37 (IAC doubled)
+        0xFF, 0xEF, // IAC EOR
+    };
+
+    var fragment: usize = 1;
+    while (fragment <= 7) : (fragment += 1) {
+        var ring = try RingBufferIO.init(allocator, 8);
+        defer ring.deinit();
+
+        var decoder = StreamDecoder.init();
+        var headers: [2]structured_fields.StructuredFieldHeader = undefined;
+        var header_count: usize = 0;
+        var payload: [6]u8 = undefined;
+        var payload_len: usize = 0;
+        var records: usize = 0;
+
+        var offset: usize = 0;
+        while (offset < record.len) {
+            const end = @min(offset + fragment, record.len);
+            _ = try ring.write(record[offset..end]);
+            offset = end;
+
+            while (try decoder.next(&ring)) |event| {
+                switch (event) {
+                    .command => |code| try std.testing.expectEqual(protocol.CommandCode.write_structured_field, code),
+                    .structured_field => |header| {
+                        headers[header_count] = header;
+                        header_count += 1;
+                    },
+                    .field_data => |chunk| {
+                        @memcpy(payload[payload_len..][0..chunk.len], chunk);
+                        payload_len += chunk.len;
+                    },
+                    .end_of_record => records += 1,
+                    else => return error.TestUnexpectedResult,
+                }
+            }
+        }
+
+        try std.testing.expectEqual(@as(usize, 1), records);
+        try std.testing.expectEqual(@as(usize, 2), header_count);
+        try std.testing.expectEqual(structured_fields.StructuredFieldType.define_color_pair, headers[0].field_type);
+        try std.testing.expectEqual(structured_fields.StructuredFieldType.font, headers[1].field_type);
+        try std.testing.expectEqualSlices(u8, &.{ 0x01, 0x02, 0x03, 0x01, 0xFF, 0x37 }, payload[0..payload_len]);
+
+        const font = try structured_fields.decode_payload(headers[1].field_type, payload[3..payload_len]);
+        try std.testing.expectEqual(@as(u16, 0xFF37), font.font.code_page);
+    }
+}
+
+test "stream decoder: eor inside a structured field" {
+    var ring = try RingBufferIO.init(std.testing.allocator, 32);
+    defer ring.deinit();
+
+    _ = try ring.write(&.{ @intFromEnum(protocol.CommandCode.write_structured_field), 0x0B, 0x00, 0x06, 0x01, 0xFF, 0xEF });
+
+    var decoder = StreamDecoder.init();
+    _ = try decoder.next(&ring);
+    try std.testing.expect((try decoder.next(&ring)).? == .structured_field);
+    try std.testing.expectEqualSlices(u8, &.{0x01}, (try decoder.next(&ring)).?.field_data);
+    try std.testing.expectError(error.TruncatedField, decoder.next(&ring));
+    try std.testing.expectEqual(@as(?Event, null), try decoder.next(&ring));
+}
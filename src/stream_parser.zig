@@ -2,6 +2,8 @@ const std = @import("std");
 const parser = @import("parser.zig");
 const command = @import("command.zig");
 const protocol = @import("protocol.zig");
+const zone_trace = @import("zone_trace.zig");
+const metrics_export = @import("metrics_export.zig");
 
 /// Parses 3270 data streams
 pub const StreamParser = struct {
@@ -19,6 +21,10 @@ pub const StreamParser = struct {
 
     /// Parse next command from stream
     pub fn next_command(self: *StreamParser) !?command.Command {
+        const zone = zone_trace.begin(.parse);
+        defer zone.end();
+        const timer = metrics_export.start_latency(.parse);
+        defer timer.stop();
         if (!self.parser.has_more()) {
             return null;
         }
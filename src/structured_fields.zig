@@ -49,7 +49,7 @@ pub const DataStreamAttribute = struct {
         reverse = 0x05,
         underline = 0x06,
         invalid = 0xFF,
-        _ = undefined,
+        _,
     },
     value: u8 = 0,
 
@@ -129,17 +129,17 @@ pub const ColorPalette = struct {
     pub fn init(allocator: std.mem.Allocator, palette_id: u8) ColorPalette {
         return .{
             .palette_id = palette_id,
-            .entries = std.ArrayList(ColorPaletteEntry).init(allocator),
+            .entries = .empty,
             .allocator = allocator,
         };
     }
 
     pub fn deinit(self: *ColorPalette) void {
-        self.entries.deinit();
+        self.entries.deinit(self.allocator);
     }
 
     pub fn add_entry(self: *ColorPalette, color_id: u8, r: u8, g: u8, b: u8) !void {
-        try self.entries.append(.{
+        try self.entries.append(self.allocator, .{
             .color_id = color_id,
             .r = r,
             .g = g,
@@ -155,6 +155,28 @@ pub const ColorPaletteEntry = struct {
     b: u8,
 };
 
+/// Color palette read in place from a field payload: the palette id, then
+/// four bytes (id, r, g, b) per entry. The allocation-free counterpart of
+/// ColorPalette.
+pub const PaletteView = struct {
+    palette_id: u8,
+    entry_bytes: []const u8,
+
+    pub fn from_buffer(buffer: []const u8) ?PaletteView {
+        if (buffer.len < 1 or (buffer.len - 1) % 4 != 0) return null;
+        return .{ .palette_id = buffer[0], .entry_bytes = buffer[1..] };
+    }
+
+    pub fn len(self: PaletteView) usize {
+        return self.entry_bytes.len / 4;
+    }
+
+    pub fn entry(self: PaletteView, index: usize) ColorPaletteEntry {
+        const bytes = self.entry_bytes[index * 4 ..][0..4];
+        return .{ .color_id = bytes[0], .r = bytes[1], .g = bytes[2], .b = bytes[3] };
+    }
+};
+
 /// Image specification for WSF
 pub const ImageSpec = struct {
     image_id: u8,
@@ -162,7 +184,7 @@ pub const ImageSpec = struct {
         monochrome = 0x00,
         rgb = 0x01,
         indexed = 0x02,
-        _ = undefined,
+        _,
     } = .monochrome,
     width: u16 = 0,
     height: u16 = 0,
@@ -234,6 +256,98 @@ pub const StructuredFieldHeader = struct {
 
         return MIN_LENGTH;
     }
+
+    /// Payload bytes following the header
+    pub fn payload_len(self: StructuredFieldHeader) u16 {
+        return self.length -| MIN_LENGTH;
+    }
+};
+
+/// Typed content of a structured field, decoded in place
+pub const FieldValue = union(enum) {
+    color_palette: PaletteView,
+    highlighting: DataStreamAttribute,
+    font: FontSpec,
+    image: ImageSpec,
+    color_pair: ColorPair,
+    extended_field: ExtendedFieldAttribute,
+    validation_rule: FieldValidationRule,
+    seal_unseal: SealUnseal,
+    transparency: Transparency,
+    character_set: CharacterSet,
+    /// No typed form (or an unknown type); read the payload directly
+    other,
+};
+
+/// One structured field borrowed from the input. Nothing beyond the
+/// header is looked at until `decode`.
+pub const FieldView = struct {
+    field_type: StructuredFieldType,
+    /// The whole field, header included
+    bytes: []const u8,
+
+    /// Total field length from the header
+    pub fn length(self: FieldView) usize {
+        return self.bytes.len;
+    }
+
+    pub fn payload(self: FieldView) []const u8 {
+        return self.bytes[StructuredFieldHeader.MIN_LENGTH..];
+    }
+
+    /// Decode the payload into its typed form without allocating
+    pub fn decode(self: FieldView) !FieldValue {
+        return decode_payload(self.field_type, self.payload());
+    }
+};
+
+/// Decode a payload of the given field type. Also usable on a payload
+/// delivered by the stream decoder as a single `field_data` chunk.
+pub fn decode_payload(field_type: StructuredFieldType, data: []const u8) !FieldValue {
+    return switch (field_type) {
+        .color_attribute => .{ .color_palette = PaletteView.from_buffer(data) orelse return error.InvalidColorPalette },
+        .extended_highlighting => .{ .highlighting = DataStreamAttribute.from_buffer(data) orelse return error.InvalidAttribute },
+        .font => .{ .font = FontSpec.from_buffer(data) orelse return error.InvalidFont },
+        .image => .{ .image = ImageSpec.from_buffer(data) orelse return error.InvalidImage },
+        .define_color_pair => .{ .color_pair = ColorPair.from_buffer(data) orelse return error.InvalidColorPair },
+        .extended_field_attributes => .{ .extended_field = ExtendedFieldAttribute.from_buffer(data) orelse return error.InvalidExtendedAttribute },
+        .field_validation => .{ .validation_rule = FieldValidationRule.from_buffer(data) orelse return error.InvalidValidationRule },
+        .seal_unseal => .{ .seal_unseal = SealUnseal.from_buffer(data) orelse return error.InvalidSealUnseal },
+        .transparency => .{ .transparency = Transparency.from_buffer(data) orelse return error.InvalidTransparency },
+        .character_set => .{ .character_set = CharacterSet.from_buffer(data) orelse return error.InvalidCharacterSet },
+        else => .other,
+    };
+}
+
+/// Lazy iterator over the structured fields of a WSF record body.
+/// Yields views into the input and never allocates.
+pub const FieldIterator = struct {
+    bytes: []const u8,
+    pos: usize = 0,
+
+    pub fn init(bytes: []const u8) FieldIterator {
+        return .{ .bytes = bytes };
+    }
+
+    /// Next field, or null at the end. A field running past the input is
+    /// error.IncompleteField; a length shorter than the header is
+    /// error.InvalidFieldLength. Either leaves the iterator where it was.
+    pub fn next(self: *FieldIterator) !?FieldView {
+        const rest = self.bytes[self.pos..];
+        if (rest.len == 0) return null;
+
+        const header = StructuredFieldHeader.from_buffer(rest) orelse return error.IncompleteField;
+        if (header.length < StructuredFieldHeader.MIN_LENGTH) return error.InvalidFieldLength;
+        if (header.length > rest.len) return error.IncompleteField;
+
+        self.pos += header.length;
+        return .{ .field_type = header.field_type, .bytes = rest[0..header.length] };
+    }
+
+    /// Bytes not yet iterated
+    pub fn remaining(self: FieldIterator) []const u8 {
+        return self.bytes[self.pos..];
+    }
 };
 
 /// Color Pair Definition
@@ -279,15 +393,13 @@ pub const FieldValidationRule = struct {
     pub fn from_buffer(buffer: []const u8) ?FieldValidationRule {
         if (buffer.len < 1) return null;
 
-        const rule_type = switch (buffer[0]) {
-            0x01 => return .{ .rule_type = .mandatory },
-            0x02 => return .{ .rule_type = .optional },
-            0x03 => return .{ .rule_type = .trigger },
-            0x04 => return .{ .rule_type = .numeric },
-            else => return null,
+        return switch (buffer[0]) {
+            0x01 => .{ .rule_type = .mandatory },
+            0x02 => .{ .rule_type = .optional },
+            0x03 => .{ .rule_type = .trigger },
+            0x04 => .{ .rule_type = .numeric },
+            else => null,
         };
-
-        return rule_type;
     }
 };
 
@@ -397,6 +509,7 @@ pub const StructuredField = union(enum) {
 
         // Check we have enough data for the full field
         if (buffer.len < header.length) return error.IncompleteField;
+        if (header.length < StructuredFieldHeader.MIN_LENGTH) return error.InvalidFieldLength;
 
         const field_data = if (buffer.len > 3) buffer[3..header.length] else &.{};
 
@@ -459,25 +572,19 @@ pub const StructuredFieldParser = struct {
         return try StructuredField.parse(self.allocator, buffer);
     }
 
-    /// Parse multiple structured fields from buffer
+    /// Parse multiple structured fields from buffer into owned values.
+    /// Use FieldIterator instead when the fields need not outlive `buffer`.
     pub fn parse_fields(self: StructuredFieldParser, buffer: []const u8) !std.ArrayList(StructuredField) {
-        var fields = std.ArrayList(StructuredField).init(self.allocator);
-        var offset: usize = 0;
-
-        while (offset < buffer.len) {
-            if (try self.parse_field(buffer[offset..])) |field| {
-                try fields.append(field);
-
-                // Get length from header
-                if (offset + 3 <= buffer.len) {
-                    const len = (@as(u16, buffer[offset + 1]) << 8) | buffer[offset + 2];
-                    offset += len;
-                } else {
-                    break;
-                }
-            } else {
-                break;
-            }
+        var fields: std.ArrayList(StructuredField) = .empty;
+        errdefer {
+            for (fields.items) |*field| field.deinit(self.allocator);
+            fields.deinit(self.allocator);
+        }
+
+        var iter = FieldIterator.init(buffer);
+        while (try iter.next()) |view| {
+            const field = (try self.parse_field(view.bytes)).?;
+            try fields.append(self.allocator, field);
         }
 
         return fields;
@@ -500,7 +607,7 @@ test "structured field type enum" {
 }
 
 test "structured field header from buffer" {
-    var buffer: [4]u8 = .{ 0x01, 0x00, 0x05, 0x42 };
+    const buffer: [4]u8 = .{ 0x01, 0x00, 0x05, 0x42 };
     const header = StructuredFieldHeader.from_buffer(&buffer);
 
     try std.testing.expect(header != null);
@@ -526,7 +633,7 @@ test "structured field header to buffer" {
 }
 
 test "color pair from buffer" {
-    var buffer: [3]u8 = .{ 0x01, 0x02, 0x03 };
+    const buffer: [3]u8 = .{ 0x01, 0x02, 0x03 };
     const pair = ColorPair.from_buffer(&buffer);
 
     try std.testing.expect(pair != null);
@@ -538,19 +645,19 @@ test "color pair from buffer" {
 }
 
 test "seal unseal from buffer" {
-    var buffer: [3]u8 = .{ 0x00, 0x05, 0x0A };
+    const buffer: [3]u8 = .{ 0x00, 0x05, 0x0A };
     const seal = SealUnseal.from_buffer(&buffer);
 
     try std.testing.expect(seal != null);
     if (seal) |s| {
-        try std.testing.expectEqual(SealUnseal.operation.seal, s.operation);
+        try std.testing.expectEqual(.seal, s.operation);
         try std.testing.expectEqual(@as(u8, 0x05), s.field_address.row);
         try std.testing.expectEqual(@as(u8, 0x0A), s.field_address.col);
     }
 }
 
 test "transparency from buffer" {
-    var buffer: [2]u8 = .{ 0x01, 0x05 };
+    const buffer: [2]u8 = .{ 0x01, 0x05 };
     const trans = Transparency.from_buffer(&buffer);
 
     try std.testing.expect(trans != null);
@@ -561,22 +668,22 @@ test "transparency from buffer" {
 }
 
 test "character set from buffer" {
-    var buffer: [3]u8 = .{ 0x02, 0x04, 0x37 };
+    const buffer: [3]u8 = .{ 0x02, 0x04, 0x37 };
     const charset = CharacterSet.from_buffer(&buffer);
 
     try std.testing.expect(charset != null);
     if (charset) |cs| {
-        try std.testing.expectEqual(CharacterSet.set_id.ebcdic, cs.set_id);
+        try std.testing.expectEqual(.ebcdic, cs.set_id);
         try std.testing.expectEqual(@as(u16, 0x0437), cs.code_page);
     }
 }
 
 test "structured field parser color pair" {
-    var allocator = std.testing.allocator;
-    var parser = StructuredFieldParser.init(allocator);
+    const allocator = std.testing.allocator;
+    const parser = StructuredFieldParser.init(allocator);
 
     // Color pair field: type=0x0B, length=0x0006, pair_id=0x01, fg=0x02, bg=0x03
-    var buffer: [6]u8 = .{ 0x0B, 0x00, 0x06, 0x01, 0x02, 0x03 };
+    const buffer: [6]u8 = .{ 0x0B, 0x00, 0x06, 0x01, 0x02, 0x03 };
 
     const field = try parser.parse_field(&buffer);
     try std.testing.expect(field != null);
@@ -590,11 +697,11 @@ test "structured field parser color pair" {
 }
 
 test "structured field parser unknown field" {
-    var allocator = std.testing.allocator;
-    var parser = StructuredFieldParser.init(allocator);
+    const allocator = std.testing.allocator;
+    const parser = StructuredFieldParser.init(allocator);
 
     // Unknown field type
-    var buffer: [5]u8 = .{ 0xFF, 0x00, 0x05, 0xAA, 0xBB };
+    const buffer: [5]u8 = .{ 0xFF, 0x00, 0x05, 0xAA, 0xBB };
 
     const field = try parser.parse_field(&buffer);
     try std.testing.expect(field != null);
@@ -609,38 +716,38 @@ test "structured field parser unknown field" {
 }
 
 test "structured field parser multiple fields" {
-    var allocator = std.testing.allocator;
-    var parser = StructuredFieldParser.init(allocator);
+    const allocator = std.testing.allocator;
+    const parser = StructuredFieldParser.init(allocator);
 
     // Two color pair fields
-    var buffer: [12]u8 = .{
+    const buffer: [12]u8 = .{
         0x0B, 0x00, 0x06, 0x01, 0x02, 0x03, // First color pair
         0x0B, 0x00, 0x06, 0x04, 0x05, 0x06, // Second color pair
     };
 
-    const fields = try parser.parse_fields(&buffer);
+    var fields = try parser.parse_fields(&buffer);
     defer {
         for (fields.items) |*f| {
             f.deinit(allocator);
         }
-        fields.deinit();
+        fields.deinit(allocator);
     }
 
     try std.testing.expectEqual(@as(usize, 2), fields.items.len);
 }
 
 test "validation rule from buffer" {
-    var buffer: [1]u8 = .{0x01};
+    const buffer: [1]u8 = .{0x01};
     const rule = FieldValidationRule.from_buffer(&buffer);
 
     try std.testing.expect(rule != null);
     if (rule) |r| {
-        try std.testing.expectEqual(FieldValidationRule.rule_type.mandatory, r.rule_type);
+        try std.testing.expectEqual(.mandatory, r.rule_type);
     }
 }
 
 test "extended field attribute from buffer" {
-    var buffer: [2]u8 = .{ 0x01, 0x42 };
+    const buffer: [2]u8 = .{ 0x01, 0x42 };
     const attr = ExtendedFieldAttribute.from_buffer(&buffer);
 
     try std.testing.expect(attr != null);
@@ -688,34 +795,34 @@ test "structured field header buffer roundtrip" {
 }
 
 test "data stream attribute foreground color from buffer" {
-    var buffer: [2]u8 = .{ 0x01, 0x05 };
+    const buffer: [2]u8 = .{ 0x01, 0x05 };
     const attr = DataStreamAttribute.from_buffer(&buffer);
 
     try std.testing.expect(attr != null);
     if (attr) |a| {
-        try std.testing.expectEqual(DataStreamAttribute.attribute_type.foreground_color, a.attribute_type);
+        try std.testing.expectEqual(.foreground_color, a.attribute_type);
         try std.testing.expectEqual(@as(u8, 0x05), a.value);
     }
 }
 
 test "data stream attribute background color from buffer" {
-    var buffer: [2]u8 = .{ 0x02, 0x07 };
+    const buffer: [2]u8 = .{ 0x02, 0x07 };
     const attr = DataStreamAttribute.from_buffer(&buffer);
 
     try std.testing.expect(attr != null);
     if (attr) |a| {
-        try std.testing.expectEqual(DataStreamAttribute.attribute_type.background_color, a.attribute_type);
+        try std.testing.expectEqual(.background_color, a.attribute_type);
         try std.testing.expectEqual(@as(u8, 0x07), a.value);
     }
 }
 
 test "data stream attribute intensity from buffer" {
-    var buffer: [2]u8 = .{ 0x03, 0x01 };
+    const buffer: [2]u8 = .{ 0x03, 0x01 };
     const attr = DataStreamAttribute.from_buffer(&buffer);
 
     try std.testing.expect(attr != null);
     if (attr) |a| {
-        try std.testing.expectEqual(DataStreamAttribute.attribute_type.intensity, a.attribute_type);
+        try std.testing.expectEqual(.intensity, a.attribute_type);
     }
 }
 
@@ -738,7 +845,7 @@ test "data stream attribute to buffer roundtrip" {
 }
 
 test "font spec from buffer minimal" {
-    var buffer: [1]u8 = .{0x05};
+    const buffer: [1]u8 = .{0x05};
     const font = FontSpec.from_buffer(&buffer);
 
     try std.testing.expect(font != null);
@@ -749,7 +856,7 @@ test "font spec from buffer minimal" {
 }
 
 test "font spec from buffer full" {
-    var buffer: [5]u8 = .{ 0x01, 0x04, 0x37, 0x10, 0x08 };
+    const buffer: [5]u8 = .{ 0x01, 0x04, 0x37, 0x10, 0x08 };
     const font = FontSpec.from_buffer(&buffer);
 
     try std.testing.expect(font != null);
@@ -762,7 +869,7 @@ test "font spec from buffer full" {
 }
 
 test "color palette initialization" {
-    var allocator = std.testing.allocator;
+    const allocator = std.testing.allocator;
     var palette = ColorPalette.init(allocator, 0x01);
     defer palette.deinit();
 
@@ -775,26 +882,62 @@ test "color palette initialization" {
 }
 
 test "image spec from buffer monochrome" {
-    var buffer: [1]u8 = .{0x01};
+    const buffer: [1]u8 = .{0x01};
     const img = ImageSpec.from_buffer(&buffer);
 
     try std.testing.expect(img != null);
     if (img) |i| {
         try std.testing.expectEqual(@as(u8, 0x01), i.image_id);
-        try std.testing.expectEqual(ImageSpec.format.monochrome, i.format);
+        try std.testing.expectEqual(.monochrome, i.format);
     }
 }
 
 test "image spec from buffer rgb full" {
-    var buffer: [10]u8 = .{ 0x02, 0x01, 0x02, 0x00, 0x03, 0x00, 0x00, 0x00, 0x04, 0x00 };
+    const buffer: [10]u8 = .{ 0x02, 0x01, 0x02, 0x00, 0x03, 0x00, 0x00, 0x00, 0x04, 0x00 };
     const img = ImageSpec.from_buffer(&buffer);
 
     try std.testing.expect(img != null);
     if (img) |i| {
         try std.testing.expectEqual(@as(u8, 0x02), i.image_id);
-        try std.testing.expectEqual(ImageSpec.format.rgb, i.format);
+        try std.testing.expectEqual(.rgb, i.format);
         try std.testing.expectEqual(@as(u16, 0x0200), i.width);
         try std.testing.expectEqual(@as(u16, 0x0300), i.height);
         try std.testing.expectEqual(@as(u32, 0x00000400), i.data_length);
     }
 }
+
+test "field iterator yields views borrowed from the input" {
+    const wsf = [_]u8{
+        0x0B, 0x00, 0x06, 0x01, 0x02, 0x03, // color pair
+        0x10, 0x00, 0x0C, 0x07, 0x00, 0xFF, 0xFF, 0xFF, 0x01, 0x00, 0x00, 0x00, // palette, 2 entries
+        0x03, 0x00, 0x03, // erase/reset, no payload
+    };
+
+    var iter = FieldIterator.init(&wsf);
+
+    const pair = (try iter.next()).?;
+    try std.testing.expectEqual(StructuredFieldType.define_color_pair, pair.field_type);
+    try std.testing.expectEqual(@as(usize, 6), pair.length());
+    try std.testing.expectEqual(@intFromPtr(&wsf[3]), @intFromPtr(pair.payload().ptr));
+    try std.testing.expectEqual(@as(u8, 0x02), (try pair.decode()).color_pair.foreground);
+
+    const palette = (try (try iter.next()).?.decode()).color_palette;
+    try std.testing.expectEqual(@as(u8, 0x07), palette.palette_id);
+    try std.testing.expectEqual(@as(usize, 2), palette.len());
+    try std.testing.expectEqual(@as(u8, 0xFF), palette.entry(0).g);
+    try std.testing.expectEqual(@as(u8, 0x01), palette.entry(1).color_id);
+
+    const reset = (try iter.next()).?;
+    try std.testing.expectEqual(@as(usize, 0), reset.payload().len);
+    try std.testing.expect((try reset.decode()) == .other);
+    try std.testing.expectEqual(@as(?FieldView, null), try iter.next());
+}
+
+test "field iterator rejects bad lengths without advancing" {
+    var short = FieldIterator.init(&.{ 0x0B, 0x00, 0x06, 0x01 });
+    try std.testing.expectError(error.IncompleteField, short.next());
+    try std.testing.expectEqual(@as(usize, 4), short.remaining().len);
+
+    var zero = FieldIterator.init(&.{ 0x0B, 0x00, 0x00 });
+    try std.testing.expectError(error.InvalidFieldLength, zero.next());
+}
@@ -46,82 +46,218 @@ pub const NegotiationState = enum {
     failed,
 };
 
-/// Telnet protocol handler with enhanced negotiation
+/// Per-option state on one side of the connection (RFC 1143, without the
+/// queue bit: we never change our mind mid-negotiation)
+pub const OptionState = enum(u2) {
+    no,
+    yes,
+    /// We asked and are waiting for the answer
+    want_yes,
+};
+
+/// TN3270E option (RFC 2355). Declined: the data path does not handle the
+/// TN3270E record header, so hosts fall back to plain TN3270.
+pub const tn3270e_option: u8 = 40;
+pub const end_of_record_option: u8 = 25;
+
+/// Terminal-type subnegotiation verbs
+const ttype_is: u8 = 0;
+const ttype_send: u8 = 1;
+
+/// Telnet protocol handler with enhanced negotiation.
+///
+/// The client opens with every TN3270 option it wants in one burst
+/// (`write_opening`), so the host's DO/WILL requests arrive already
+/// answered. `feed` then processes host responses as they come, writing
+/// all replies for one read into a single buffer, and stops where the
+/// 3270 data stream begins.
 pub const TelnetNegotiator = struct {
     allocator: std.mem.Allocator,
     state: NegotiationState = .initial,
-    remote_options: std.AutoHashMap(u8, bool),
-    local_options: std.AutoHashMap(u8, bool),
+    /// What the host does (its WILL/WONT)
+    remote_options: [256]OptionState = [_]OptionState{.no} ** 256,
+    /// What we do (our WILL/WONT)
+    local_options: [256]OptionState = [_]OptionState{.no} ** 256,
+    terminal_type: []const u8 = "IBM-3278-2-E",
+    terminal_type_sent: bool = false,
     negotiation_timeout: u32 = 5000, // milliseconds
     max_retries: u32 = 3,
     retry_count: u32 = 0,
 
+    /// Longest reply `feed` writes for one host sequence
+    pub const max_reply_len = 3 + 2 + 40 + 2;
+
     pub fn init(allocator: std.mem.Allocator) TelnetNegotiator {
         return TelnetNegotiator{
             .allocator = allocator,
-            .remote_options = std.AutoHashMap(u8, bool).init(allocator),
-            .local_options = std.AutoHashMap(u8, bool).init(allocator),
         };
     }
 
     pub fn deinit(self: *TelnetNegotiator) void {
-        self.remote_options.deinit();
-        self.local_options.deinit();
+        _ = self;
     }
 
-    /// Build standard TN3270 negotiation sequence
-    pub fn build_tn3270_negotiation(self: *TelnetNegotiator, allocator: std.mem.Allocator) ![]u8 {
-        var buffer = std.ArrayList(u8).init(allocator);
-        defer buffer.deinit();
-
-        // Request binary transmission
-        try self.add_option_will(&buffer, @intFromEnum(TelnetOption.transmit_binary));
-
-        // Request suppress go-ahead
-        try self.add_option_will(&buffer, @intFromEnum(TelnetOption.suppress_go_ahead));
-
-        // Request echo (for line editing)
-        try self.add_option_dont(&buffer, @intFromEnum(TelnetOption.echo));
+    /// Options we are willing to enable on our side
+    fn supports_local(option: u8) bool {
+        return option == @intFromEnum(TelnetOption.transmit_binary) or
+            option == @intFromEnum(TelnetOption.terminal_type) or
+            option == end_of_record_option;
+    }
 
-        // Request terminal type negotiation
-        try self.add_option_will(&buffer, @intFromEnum(TelnetOption.terminal_type));
+    /// Options we are willing to let the host enable
+    fn supports_remote(option: u8) bool {
+        return option == @intFromEnum(TelnetOption.transmit_binary) or
+            option == @intFromEnum(TelnetOption.suppress_go_ahead) or
+            option == end_of_record_option;
+    }
 
-        // Send negotiation
+    /// Write the whole TN3270 request in one go: we will do terminal type,
+    /// EOR and binary, and ask the host to do EOR and binary.
+    pub fn write_opening(self: *TelnetNegotiator, out: *std.Io.Writer) !void {
+        const wanted_local = [_]u8{
+            @intFromEnum(TelnetOption.terminal_type),
+            end_of_record_option,
+            @intFromEnum(TelnetOption.transmit_binary),
+        };
+        for (wanted_local) |option| {
+            try out.writeAll(&.{ @intFromEnum(TelnetCommand.iac), @intFromEnum(TelnetCommand.will), option });
+            self.local_options[option] = .want_yes;
+        }
+        const wanted_remote = [_]u8{ end_of_record_option, @intFromEnum(TelnetOption.transmit_binary) };
+        for (wanted_remote) |option| {
+            try out.writeAll(&.{ @intFromEnum(TelnetCommand.iac), @intFromEnum(TelnetCommand.do_cmd), option });
+            self.remote_options[option] = .want_yes;
+        }
         self.state = .sent_options;
-        return buffer.toOwnedSlice();
     }
 
-    /// Parse telnet response
-    pub fn parse_response(self: *TelnetNegotiator, data: []const u8) !void {
-        var i: usize = 0;
-        while (i < data.len) {
-            if (data[i] != @intFromEnum(TelnetCommand.iac)) {
-                i += 1;
-                continue;
-            }
+    /// Build standard TN3270 negotiation sequence
+    pub fn build_tn3270_negotiation(self: *TelnetNegotiator, allocator: std.mem.Allocator) ![]u8 {
+        var out: std.Io.Writer.Allocating = .init(allocator);
+        defer out.deinit();
+        try self.write_opening(&out.writer);
+        return out.toOwnedSlice();
+    }
 
-            if (i + 2 >= data.len) break;
+    pub const FeedResult = struct {
+        /// Bytes handled. The rest is an incomplete sequence (feed it again
+        /// with more input) or, when `data_started`, the 3270 data stream.
+        consumed: usize,
+        data_started: bool = false,
+    };
+
+    /// Process host negotiation, writing replies to `replies`. Stops early
+    /// when `replies` has less than `max_reply_len` free, so a fixed
+    /// buffer can be flushed and the rest fed again.
+    pub fn feed(self: *TelnetNegotiator, data: []const u8, replies: *std.Io.Writer) !FeedResult {
+        const iac = @intFromEnum(TelnetCommand.iac);
+        var pos: usize = 0;
+        while (pos < data.len) {
+            if (replies.buffer.len - replies.end < max_reply_len) break;
 
-            const cmd = data[i + 1];
-            const opt = data[i + 2];
+            if (data[pos] != iac) return .{ .consumed = pos, .data_started = true };
+            if (pos + 1 >= data.len) break;
 
+            const cmd = data[pos + 1];
             switch (cmd) {
-                @intFromEnum(TelnetCommand.will) => {
-                    try self.remote_options.put(opt, true);
+                // Escaped 0xFF: data
+                iac => return .{ .consumed = pos, .data_started = true },
+                @intFromEnum(TelnetCommand.will),
+                @intFromEnum(TelnetCommand.wont),
+                @intFromEnum(TelnetCommand.do_cmd),
+                @intFromEnum(TelnetCommand.dont),
+                => {
+                    if (pos + 2 >= data.len) break;
+                    try self.handle_option(cmd, data[pos + 2], replies);
+                    pos += 3;
                 },
-                @intFromEnum(TelnetCommand.wont) => {
-                    try self.remote_options.put(opt, false);
+                @intFromEnum(TelnetCommand.sb) => {
+                    const end = std.mem.indexOfPos(u8, data, pos + 2, &.{ iac, @intFromEnum(TelnetCommand.se) }) orelse break;
+                    try self.handle_subnegotiation(data[pos + 2 .. end], replies);
+                    pos = end + 2;
                 },
-                @intFromEnum(TelnetCommand.do_cmd) => {
-                    try self.local_options.put(opt, true);
+                else => pos += 2,
+            }
+            if (self.state == .sent_options or self.state == .initial) self.state = .received_response;
+            if (self.is_complete()) self.state = .negotiated;
+        }
+        return .{ .consumed = pos };
+    }
+
+    fn handle_option(self: *TelnetNegotiator, cmd: u8, option: u8, replies: *std.Io.Writer) !void {
+        const iac = @intFromEnum(TelnetCommand.iac);
+        switch (cmd) {
+            @intFromEnum(TelnetCommand.do_cmd) => switch (self.local_options[option]) {
+                .yes => {},
+                .want_yes => self.local_options[option] = .yes,
+                .no => if (supports_local(option)) {
+                    self.local_options[option] = .yes;
+                    try replies.writeAll(&.{ iac, @intFromEnum(TelnetCommand.will), option });
+                } else {
+                    try replies.writeAll(&.{ iac, @intFromEnum(TelnetCommand.wont), option });
                 },
-                @intFromEnum(TelnetCommand.dont) => {
-                    try self.local_options.put(opt, false);
+            },
+            @intFromEnum(TelnetCommand.dont) => {
+                if (self.local_options[option] == .yes) {
+                    try replies.writeAll(&.{ iac, @intFromEnum(TelnetCommand.wont), option });
+                }
+                self.local_options[option] = .no;
+            },
+            @intFromEnum(TelnetCommand.will) => switch (self.remote_options[option]) {
+                .yes => {},
+                .want_yes => self.remote_options[option] = .yes,
+                .no => if (supports_remote(option)) {
+                    self.remote_options[option] = .yes;
+                    try replies.writeAll(&.{ iac, @intFromEnum(TelnetCommand.do_cmd), option });
+                } else {
+                    try replies.writeAll(&.{ iac, @intFromEnum(TelnetCommand.dont), option });
                 },
-                else => {},
-            }
+            },
+            @intFromEnum(TelnetCommand.wont) => {
+                if (self.remote_options[option] == .yes) {
+                    try replies.writeAll(&.{ iac, @intFromEnum(TelnetCommand.dont), option });
+                }
+                self.remote_options[option] = .no;
+            },
+            else => unreachable,
+        }
+    }
+
+    fn handle_subnegotiation(self: *TelnetNegotiator, payload: []const u8, replies: *std.Io.Writer) !void {
+        if (payload.len < 2) return;
+        if (payload[0] != @intFromEnum(TelnetOption.terminal_type) or payload[1] != ttype_send) return;
+
+        const iac = @intFromEnum(TelnetCommand.iac);
+        const name = self.terminal_type[0..@min(self.terminal_type.len, 40)];
+        try replies.writeAll(&.{ iac, @intFromEnum(TelnetCommand.sb), @intFromEnum(TelnetOption.terminal_type), ttype_is });
+        try replies.writeAll(name);
+        try replies.writeAll(&.{ iac, @intFromEnum(TelnetCommand.se) });
+        self.terminal_type_sent = true;
+    }
 
-            i += 3;
+    /// Binary and EOR agreed both ways, and the terminal type sent unless
+    /// the host refused it
+    pub fn is_complete(self: *const TelnetNegotiator) bool {
+        const binary = @intFromEnum(TelnetOption.transmit_binary);
+        const ttype = @intFromEnum(TelnetOption.terminal_type);
+        return self.local_options[binary] == .yes and self.remote_options[binary] == .yes and
+            self.local_options[end_of_record_option] == .yes and self.remote_options[end_of_record_option] == .yes and
+            (self.terminal_type_sent or self.local_options[ttype] == .no);
+    }
+
+    /// Record the host's option responses without replying
+    pub fn parse_response(self: *TelnetNegotiator, data: []const u8) !void {
+        var discard_buffer: [max_reply_len]u8 = undefined;
+        var remaining = data;
+        while (remaining.len > 0) {
+            var replies = std.Io.Writer.fixed(&discard_buffer);
+            const result = try self.feed(remaining, &replies);
+            if (result.consumed == 0) {
+                // Skip a data byte or an incomplete sequence
+                remaining = remaining[1..];
+                continue;
+            }
+            remaining = remaining[result.consumed..];
         }
 
         self.state = .negotiated;
@@ -130,45 +266,25 @@ pub const TelnetNegotiator = struct {
     /// Check if negotiation succeeded
     pub fn is_negotiated(self: *TelnetNegotiator) bool {
         return self.state == .negotiated and
-            self.remote_options.contains(@intFromEnum(TelnetOption.transmit_binary));
+            self.remote_options[@intFromEnum(TelnetOption.transmit_binary)] == .yes;
     }
 
     /// Get negotiation status
     pub fn status(self: *TelnetNegotiator) NegotiationStatus {
         return NegotiationStatus{
             .state = self.state,
-            .remote_options_count = self.remote_options.count(),
-            .local_options_count = self.local_options.count(),
+            .remote_options_count = count_enabled(&self.remote_options),
+            .local_options_count = count_enabled(&self.local_options),
             .succeeded = self.is_negotiated(),
         };
     }
 
-    fn add_option_will(self: *TelnetNegotiator, buffer: *std.ArrayList(u8), option: u8) !void {
-        try buffer.append(@intFromEnum(TelnetCommand.iac));
-        try buffer.append(@intFromEnum(TelnetCommand.will));
-        try buffer.append(option);
-        try self.local_options.put(option, true);
-    }
-
-    fn add_option_wont(self: *TelnetNegotiator, buffer: *std.ArrayList(u8), option: u8) !void {
-        try buffer.append(@intFromEnum(TelnetCommand.iac));
-        try buffer.append(@intFromEnum(TelnetCommand.wont));
-        try buffer.append(option);
-        try self.local_options.put(option, false);
-    }
-
-    fn add_option_do(self: *TelnetNegotiator, buffer: *std.ArrayList(u8), option: u8) !void {
-        try buffer.append(@intFromEnum(TelnetCommand.iac));
-        try buffer.append(@intFromEnum(TelnetCommand.do_cmd));
-        try buffer.append(option);
-        try self.remote_options.put(option, true);
-    }
-
-    fn add_option_dont(self: *TelnetNegotiator, buffer: *std.ArrayList(u8), option: u8) !void {
-        try buffer.append(@intFromEnum(TelnetCommand.iac));
-        try buffer.append(@intFromEnum(TelnetCommand.dont));
-        try buffer.append(option);
-        try self.remote_options.put(option, false);
+    fn count_enabled(options: *const [256]OptionState) usize {
+        var count: usize = 0;
+        for (options) |state| {
+            if (state != .no) count += 1;
+        }
+        return count;
     }
 };
 
@@ -184,17 +300,16 @@ pub const RejectionHandler = struct {
     allocator: std.mem.Allocator,
     rejection_count: u32 = 0,
     max_rejections: u32 = 5,
-    fallback_options: std.ArrayList(u8),
+    fallback_options: std.ArrayList(u8) = .empty,
 
     pub fn init(allocator: std.mem.Allocator) RejectionHandler {
         return RejectionHandler{
             .allocator = allocator,
-            .fallback_options = std.ArrayList(u8).init(allocator),
         };
     }
 
     pub fn deinit(self: *RejectionHandler) void {
-        self.fallback_options.deinit();
+        self.fallback_options.deinit(self.allocator);
     }
 
     /// Handle option rejection and suggest fallback
@@ -304,3 +419,38 @@ test "rejection handler: too many rejections" {
     const result = handler.handle_rejection(@intFromEnum(TelnetOption.terminal_type));
     try std.testing.expectError(error.TooManyRejections, result);
 }
+
+test "telnet negotiation: pipelined responses and data start" {
+    var negotiator = TelnetNegotiator.init(std.testing.allocator);
+    defer negotiator.deinit();
+
+    var opening_buffer: [64]u8 = undefined;
+    var opening = std.Io.Writer.fixed(&opening_buffer);
+    try negotiator.write_opening(&opening);
+    try std.testing.expectEqual(@as(usize, 15), opening.end);
+
+    // Host requests everything at once, declines nothing, then paints a screen
+    const host = [_]u8{
+        0xFF, 0xFD, 0x18, // DO TERMINAL-TYPE
+        0xFF, 0xFD, 0x28, // DO TN3270E
+        0xFF, 0xFD, 0x19, 0xFF, 0xFB, 0x19, // DO EOR, WILL EOR
+        0xFF, 0xFD, 0x00, 0xFF, 0xFB, 0x00, // DO BINARY, WILL BINARY
+        0xFF, 0xFA, 0x18, 0x01, 0xFF, // SB TERMINAL-TYPE SEND IAC (SE in next read)
+    };
+    var reply_buffer: [256]u8 = undefined;
+    var replies = std.Io.Writer.fixed(&reply_buffer);
+    const first = try negotiator.feed(&host, &replies);
+    try std.testing.expectEqual(host.len - 5, first.consumed);
+    try std.testing.expect(!first.data_started);
+    // Only TN3270E needs an answer; the rest was pre-answered
+    try std.testing.expectEqualSlices(u8, &.{ 0xFF, 0xFC, 0x28 }, replies.buffered());
+
+    const rest = [_]u8{ 0xFF, 0xFA, 0x18, 0x01, 0xFF, 0xF0, 0xF5, 0xC3, 0xFF, 0xEF };
+    replies = std.Io.Writer.fixed(&reply_buffer);
+    const second = try negotiator.feed(&rest, &replies);
+    try std.testing.expect(second.data_started);
+    try std.testing.expectEqual(@as(usize, 6), second.consumed);
+    try std.testing.expectEqualSlices(u8, "\xFF\xFA\x18\x00IBM-3278-2-E\xFF\xF0", replies.buffered());
+    try std.testing.expect(negotiator.is_complete());
+    try std.testing.expectEqual(NegotiationState.negotiated, negotiator.state);
+}
@@ -1,5 +1,6 @@
 const std = @import("std");
 const screen = @import("screen.zig");
+const renderer = @import("renderer.zig");
 
 /// Terminal rendering with ANSI escape sequences
 /// Future: integrate libxghostty for advanced rendering
@@ -8,6 +9,8 @@ pub const Terminal = struct {
     screen: *screen.Screen,
     cursor_row: u16,
     cursor_col: u16,
+    /// Screen generation already drawn by `render_changes`
+    rendered_generation: ?u32 = null,
 
     pub fn init(allocator: std.mem.Allocator, scr: *screen.Screen) Terminal {
         return Terminal{
@@ -58,17 +61,25 @@ pub const Terminal = struct {
         std.debug.print("\x1B[2J\x1B[H", .{});
 
         for (0..self.screen.rows) |row| {
-            for (0..self.screen.cols) |col| {
-                const char = self.screen.buffer[row][col];
-                std.debug.print("{c}", .{char});
-            }
-            std.debug.print("\n", .{});
+            std.debug.print("{s}\n", .{self.screen.row_slice(@intCast(row))});
         }
 
         // Move cursor to current position
         std.debug.print("\x1B[{};{}H", .{ self.cursor_row + 1, self.cursor_col + 1 });
     }
 
+    /// Draw only the cells changed since the last `render_changes` to
+    /// `writer`; the first call repaints the whole screen there
+    pub fn render_changes(self: *Terminal, writer: *std.Io.Writer) !void {
+        if (self.rendered_generation) |since| {
+            _ = try renderer.write_ansi_changes(self.screen, since, writer);
+        } else {
+            _ = try renderer.write_ansi_full(self.screen, writer);
+        }
+        try writer.print("\x1B[{d};{d}H", .{ self.cursor_row + 1, self.cursor_col + 1 });
+        self.rendered_generation = self.screen.current_generation();
+    }
+
     /// Clear entire screen
     pub fn clear(self: *Terminal) void {
         self.screen.clear();
@@ -154,3 +165,23 @@ test "terminal clear" {
     try std.testing.expectEqual(@as(u8, ' '), char);
     try std.testing.expectEqual(@as(u16, 0), term.cursor_row);
 }
+
+test "terminal render_changes repaints the first frame into the writer" {
+    var scr = try screen.Screen.init(std.testing.allocator, 2, 4);
+    defer scr.deinit();
+
+    var term = Terminal.init(std.testing.allocator, &scr);
+    try term.write_string("AB");
+    scr.buffer[5] = 0; // a NUL cell must not reach the terminal
+
+    var buffer: [128]u8 = undefined;
+    var out = std.Io.Writer.fixed(&buffer);
+    try term.render_changes(&out);
+    try std.testing.expectEqualStrings("\x1B[2J\x1B[1;1HAB  \x1B[2;1H    \x1B[1;3H", out.buffered());
+
+    // Later calls send only what changed
+    out = std.Io.Writer.fixed(&buffer);
+    try term.write_char('C');
+    try term.render_changes(&out);
+    try std.testing.expectEqualStrings("\x1B[1;3HC\x1B[1;4H", out.buffered());
+}
@@ -91,9 +91,12 @@ pub const RingBufferIO = struct {
     }
 
     /// Write data to ring buffer
+    /// Never overwrites unread bytes, so views handed out by
+    /// `get_read_view` stay valid until the reader advances past them.
     pub fn write(self: *Self, data: []const u8) !usize {
         if (data.len == 0) return 0;
         if (data.len > self.capacity) return error.BufferTooSmall;
+        if (data.len > self.free_space()) return error.BufferFull;
 
         var written: usize = 0;
 
@@ -117,6 +120,26 @@ pub const RingBufferIO = struct {
         return written;
     }
 
+    /// Get contiguous free space for writing in place (e.g. a socket read)
+    /// Follow with `advance_write` for the bytes actually filled.
+    pub fn get_write_slice(self: *Self) []u8 {
+        const free = self.free_space();
+        const until_end = self.capacity - self.write_pos;
+        return self.buffer[self.write_pos .. self.write_pos + @min(free, until_end)];
+    }
+
+    /// Commit bytes filled through `get_write_slice`
+    pub fn advance_write(self: *Self, count: usize) !void {
+        if (count > self.free_space()) {
+            return error.AdvanceTooFar;
+        }
+
+        self.write_pos += count;
+        if (self.write_pos >= self.capacity) {
+            self.write_pos -= self.capacity;
+        }
+    }
+
     /// Advance read position
     pub fn advance_read(self: *Self, count: usize) !void {
         const available = self.available();
@@ -163,9 +186,15 @@ pub const RingBufferIO = struct {
         }
     }
 
+    /// Get bytes that can be written without overwriting unread data
+    /// One slot stays empty so a full buffer is distinguishable from an empty one.
+    pub fn free_space(self: Self) usize {
+        return self.capacity - 1 - self.available();
+    }
+
     /// Check if buffer is full
     pub fn is_full(self: Self) bool {
-        return self.available() == self.capacity;
+        return self.free_space() == 0;
     }
 
     /// Clear buffer
@@ -194,7 +223,7 @@ pub const ZeroCopyParser = struct {
         }
 
         const code = try view.peek(0);
-        return std.meta.intToEnum(protocol.CommandCode, code) catch |err| {
+        return std.meta.intToEnum(protocol.CommandCode, code) catch {
             return error.InvalidCommandCode;
         };
     }
@@ -222,7 +251,7 @@ pub const ZeroCopyParser = struct {
         }
 
         const byte = try view.peek(0);
-        return std.meta.intToEnum(protocol.FieldAttribute, byte) catch |err| {
+        return std.meta.intToEnum(protocol.FieldAttribute, byte) catch {
             return error.InvalidFieldAttribute;
         };
     }
@@ -272,13 +301,13 @@ pub const StreamingZeroCopyParser = struct {
         return .{
             .allocator = allocator,
             .buffer = try RingBufferIO.init(allocator, buffer_size),
-            .parsed_elements = std.ArrayList(ParsedElement).init(allocator),
+            .parsed_elements = .empty,
         };
     }
 
     /// Deallocate parser
     pub fn deinit(self: *Self) void {
-        self.parsed_elements.deinit();
+        self.parsed_elements.deinit(self.allocator);
         self.buffer.deinit();
     }
 
@@ -321,7 +350,7 @@ pub const StreamingZeroCopyParser = struct {
     /// Parse all available data
     pub fn parse_all(self: *Self) !void {
         while (try self.parse_next()) |elem| {
-            try self.parsed_elements.append(elem);
+            try self.parsed_elements.append(self.allocator, elem);
         }
     }
 
@@ -342,7 +371,7 @@ pub const StreamingZeroCopyParser = struct {
 
 test "buffer view: creation and slicing" {
     const data = "Hello, World!";
-    var view = BufferView.init(data);
+    const view = BufferView.init(data);
 
     try std.testing.expectEqual(@as(usize, 13), view.len());
     try std.testing.expectEqualSlices(u8, data, view.data());
@@ -381,30 +410,20 @@ test "ring buffer io: write and read view" {
 }
 
 test "zero copy parser: command code parsing" {
-    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
-    defer _ = gpa.deinit();
-
-    const parser = ZeroCopyParser.init(gpa.allocator());
-
     // Create a buffer with a valid command code
-    const data = [_]u8{ 0xF1, 0x00, 0x00 }; // WriteCommand
-    var view = BufferView.init(&data);
+    const data = [_]u8{ 0x01, 0x00, 0x00 }; // Write
+    const view = BufferView.init(&data);
 
-    const cmd = try parser.parse_command_code(view);
+    const cmd = try ZeroCopyParser.parse_command_code(view);
     try std.testing.expectEqual(protocol.CommandCode.write, cmd);
 }
 
 test "zero copy parser: address parsing" {
-    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
-    defer _ = gpa.deinit();
-
-    const parser = ZeroCopyParser.init(gpa.allocator());
-
     // Address for position (0, 0) -> offset 0x0000
     const data = [_]u8{ 0x00, 0x00 };
-    var view = BufferView.init(&data);
+    const view = BufferView.init(&data);
 
-    const addr = try parser.parse_address(view);
+    const addr = try ZeroCopyParser.parse_address(view);
     try std.testing.expectEqual(@as(u8, 0), addr.row);
     try std.testing.expectEqual(@as(u8, 0), addr.col);
 }
@@ -421,14 +440,28 @@ test "streaming zero copy parser: feed and parse" {
 }
 
 test "zero copy parser: text extraction" {
-    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
-    defer _ = gpa.deinit();
-
-    const parser = ZeroCopyParser.init(gpa.allocator());
-
     const data = "Hello, World!";
-    var view = BufferView.init(data);
+    const view = BufferView.init(data);
 
-    const text_view = try parser.parse_text(view, 5);
+    const text_view = try ZeroCopyParser.parse_text(view, 5);
     try std.testing.expectEqualSlices(u8, "Hello", text_view.data());
 }
+
+test "ring buffer io: write slice and unread data protection" {
+    var rb = try RingBufferIO.init(std.testing.allocator, 8);
+    defer rb.deinit();
+
+    _ = try rb.write("abcdef");
+    try rb.advance_read(4);
+
+    // Free space wraps: the contiguous slice runs to the end of storage
+    const slice = rb.get_write_slice();
+    try std.testing.expectEqual(@as(usize, 2), slice.len);
+    @memcpy(slice, "gh");
+    try rb.advance_write(slice.len);
+
+    _ = try rb.write("ij");
+    try std.testing.expect(rb.is_full());
+    try std.testing.expectError(error.BufferFull, rb.write("k"));
+    try std.testing.expectEqual(@as(usize, 7), rb.available());
+}
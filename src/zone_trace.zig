@@ -0,0 +1,292 @@
+//! Zone tracing for live sessions.
+//!
+//! Zones are the members of `Zone`, so a zone's ID is a compile-time
+//! constant: no name is hashed or looked up when a zone is entered. Each
+//! thread records begin/end events into its own ring of `ring_capacity`
+//! events. The owning thread is the only writer, so recording is a clock
+//! read and two relaxed stores, with no lock and no shared cache line.
+//! When tracing is off, `begin` costs one atomic load.
+//!
+//! `write_chrome_trace` dumps every ring as Chrome trace JSON, which
+//! Perfetto (ui.perfetto.dev) and chrome://tracing both open. A dump may
+//! run while threads keep recording. Events overwritten during the copy
+//! are left out. Full rings keep the newest events.
+//!
+//! Usage:
+//! ```zig
+//! zone_trace.enable();
+//! {
+//!     const zone = zone_trace.begin(.execute);
+//!     defer zone.end();
+//!     try executor.execute(cmd);
+//! }
+//! try zone_trace.write_chrome_trace_file(allocator, "session.trace.json");
+//! ```
+//!
+//! The CLI does the same with `--trace <PATH>` (see `cli.zig`).
+const std = @import("std");
+
+/// Instrumented zones. Add a member to add a zone; IDs are the tag values.
+pub const Zone = enum(u8) {
+    client_read,
+    client_write,
+    decode,
+    parse,
+    execute,
+    render,
+    audit_log,
+    audit_commit,
+};
+
+/// Events kept per thread (8 bytes each)
+pub const ring_capacity = 1 << 14;
+
+const Phase = enum(u1) { begin, end };
+
+/// One event word: nanoseconds since the trace epoch in the high 48 bits
+/// (about 78 hours), then the zone, then the phase
+fn pack(ns: u64, zone: Zone, phase: Phase) u64 {
+    return ns << 16 | @as(u64, @intFromEnum(zone)) << 1 | @intFromEnum(phase);
+}
+
+const Ring = struct {
+    events: [ring_capacity]std.atomic.Value(u64),
+    /// Events ever recorded; the next one goes to `head % ring_capacity`
+    head: std.atomic.Value(usize) = .init(0),
+    /// Events before this index were discarded by `reset`
+    floor: std.atomic.Value(usize) = .init(0),
+    thread_id: std.Thread.Id,
+    next: ?*Ring = null,
+
+    fn push(self: *Ring, zone: Zone, phase: Phase) void {
+        const now = std.time.Instant.now() catch return;
+        const head = self.head.load(.monotonic);
+        self.events[head % ring_capacity].store(pack(now.since(epoch), zone, phase), .monotonic);
+        self.head.store(head + 1, .release);
+    }
+};
+
+var enabled = std.atomic.Value(bool).init(false);
+var epoch: std.time.Instant = undefined;
+var epoch_set = false;
+/// Guards `rings` and `epoch_set`; taken once per thread and by dumps
+var rings_mutex: std.Thread.Mutex = .{};
+var rings: ?*Ring = null;
+threadlocal var local_ring: ?*Ring = null;
+
+/// Start recording. The first call fixes the trace epoch.
+pub fn enable() void {
+    rings_mutex.lock();
+    defer rings_mutex.unlock();
+    if (!epoch_set) {
+        epoch = std.time.Instant.now() catch return;
+        epoch_set = true;
+    }
+    enabled.store(true, .release);
+}
+
+/// Stop recording; zones already entered still record their end
+pub fn disable() void {
+    enabled.store(false, .release);
+}
+
+pub fn is_enabled() bool {
+    return enabled.load(.acquire);
+}
+
+/// Drop every recorded event
+pub fn reset() void {
+    rings_mutex.lock();
+    defer rings_mutex.unlock();
+    var ring = rings;
+    while (ring) |r| : (ring = r.next) r.floor.store(r.head.load(.acquire), .release);
+}
+
+/// An entered zone; `end` records its exit
+pub const Span = struct {
+    ring: ?*Ring,
+    zone: Zone,
+
+    pub inline fn end(self: Span) void {
+        if (self.ring) |ring| ring.push(self.zone, .end);
+    }
+};
+
+/// Enter `zone` on the calling thread
+pub inline fn begin(comptime zone: Zone) Span {
+    if (!enabled.load(.acquire)) return .{ .ring = null, .zone = zone };
+    const ring = local_ring orelse register_thread() orelse return .{ .ring = null, .zone = zone };
+    ring.push(zone, .begin);
+    return .{ .ring = ring, .zone = zone };
+}
+
+/// Give the calling thread a ring. Rings live for the rest of the
+/// process, so a dump still shows threads that have exited.
+fn register_thread() ?*Ring {
+    const ring = std.heap.smp_allocator.create(Ring) catch return null;
+    ring.* = .{ .events = undefined, .thread_id = std.Thread.getCurrentId() };
+
+    rings_mutex.lock();
+    defer rings_mutex.unlock();
+    ring.next = rings;
+    rings = ring;
+    local_ring = ring;
+    return ring;
+}
+
+pub const TraceStats = struct {
+    threads: usize = 0,
+    /// Events currently held in the rings
+    events: u64 = 0,
+    /// Events lost because a ring wrapped
+    overwritten: u64 = 0,
+};
+
+pub fn stats() TraceStats {
+    rings_mutex.lock();
+    defer rings_mutex.unlock();
+    var result: TraceStats = .{};
+    var ring = rings;
+    while (ring) |r| : (ring = r.next) {
+        const head = r.head.load(.acquire);
+        const recorded = head - @min(head, r.floor.load(.acquire));
+        result.threads += 1;
+        result.events += @min(recorded, ring_capacity);
+        result.overwritten += recorded -| ring_capacity;
+    }
+    return result;
+}
+
+/// Write every ring as a Chrome trace JSON object. `allocator` provides
+/// one ring-sized scratch copy for the duration of the call.
+pub fn write_chrome_trace(allocator: std.mem.Allocator, out: *std.Io.Writer) !void {
+    const scratch = try allocator.alloc(u64, ring_capacity);
+    defer allocator.free(scratch);
+
+    rings_mutex.lock();
+    defer rings_mutex.unlock();
+
+    try out.writeAll("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    var first = true;
+    var ring = rings;
+    while (ring) |r| : (ring = r.next) {
+        const events = copy_ring(r, scratch);
+        // A wrapped ring can start inside a zone; skip ends with no begin
+        var depth: usize = 0;
+        for (events) |event| {
+            const phase: Phase = @enumFromInt(@as(u1, @truncate(event)));
+            if (phase == .end) {
+                if (depth == 0) continue;
+                depth -= 1;
+            } else {
+                depth += 1;
+            }
+            const zone = std.meta.intToEnum(Zone, @as(u8, @truncate(event >> 1))) catch continue;
+            const ns = event >> 16;
+            if (!first) try out.writeByte(',');
+            first = false;
+            try out.print("{{\"name\":\"{s}\",\"cat\":\"zig3270\",\"ph\":\"{s}\",\"ts\":{d}.{d:0>3},\"pid\":1,\"tid\":{d}}}", .{
+                @tagName(zone),
+                if (phase == .begin) "B" else "E",
+                ns / 1000,
+                ns % 1000,
+                r.thread_id,
+            });
+        }
+    }
+    try out.writeAll("]}\n");
+}
+
+/// `write_chrome_trace` into a new file at `path`
+pub fn write_chrome_trace_file(allocator: std.mem.Allocator, path: []const u8) !void {
+    var file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+
+    var buffer: [64 * 1024]u8 = undefined;
+    var file_writer = file.writer(&buffer);
+    try write_chrome_trace(allocator, &file_writer.interface);
+    try file_writer.interface.flush();
+}
+
+/// Copy the live part of a ring that its thread may still be writing
+fn copy_ring(ring: *Ring, scratch: []u64) []const u64 {
+    const head = ring.head.load(.acquire);
+    const start = @max(ring.floor.load(.acquire), head -| ring_capacity);
+    // Acquire loads keep the re-read of head below after every copied
+    // slot; Zig has no standalone fence to do it in one place
+    for (scratch[0 .. head - start], start..) |*slot, index| {
+        slot.* = ring.events[index % ring_capacity].load(.acquire);
+    }
+    // Anything at or below the slot the writer may have been filling
+    // meanwhile is suspect
+    const after = ring.head.load(.acquire);
+    const valid_from = @min(head, @max(start, (after + 1) -| ring_capacity));
+    return scratch[valid_from - start .. head - start];
+}
+
+test "zones record per-thread events and export Chrome trace JSON" {
+    enable();
+    defer disable();
+    reset();
+
+    {
+        const outer = begin(.execute);
+        defer outer.end();
+        const inner = begin(.render);
+        inner.end();
+    }
+
+    const Worker = struct {
+        fn run() void {
+            for (0..3) |_| {
+                const zone = begin(.parse);
+                zone.end();
+            }
+        }
+    };
+    const thread = try std.Thread.spawn(.{}, Worker.run, .{});
+    thread.join();
+
+    var buffer: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer buffer.deinit();
+    try write_chrome_trace(std.testing.allocator, &buffer.writer);
+    const json = buffer.written();
+
+    const parsed = try std.json.parseFromSlice(std.json.Value, std.testing.allocator, json, .{});
+    defer parsed.deinit();
+    const events = parsed.value.object.get("traceEvents").?.array.items;
+    try std.testing.expectEqual(@as(usize, 4 + 6), events.len);
+    try std.testing.expectEqual(@as(usize, 3), std.mem.count(u8, json, "\"name\":\"parse\",\"cat\":\"zig3270\",\"ph\":\"B\""));
+    try std.testing.expect(std.mem.indexOf(u8, json, "\"name\":\"render\"") != null);
+
+    // Disabled zones record nothing
+    disable();
+    const before = stats().events;
+    begin(.decode).end();
+    try std.testing.expectEqual(before, stats().events);
+}
+
+test "wrapped rings keep the newest events" {
+    enable();
+    defer disable();
+    reset();
+
+    const Worker = struct {
+        fn run() void {
+            const outer = begin(.client_read);
+            for (0..ring_capacity) |_| begin(.decode).end();
+            outer.end();
+        }
+    };
+    const thread = try std.Thread.spawn(.{}, Worker.run, .{});
+    thread.join();
+
+    const s = stats();
+    try std.testing.expect(s.overwritten >= 2);
+
+    var buffer: std.Io.Writer.Allocating = .init(std.testing.allocator);
+    defer buffer.deinit();
+    try write_chrome_trace(std.testing.allocator, &buffer.writer);
+    // The outer begin was overwritten, so its end is dropped too
+    try std.testing.expect(std.mem.indexOf(u8, buffer.written(), "client_read") == null);
+}